@@ -0,0 +1,47 @@
+#include <cassert>
+#include <cmath>
+#include "AudioResampler.h"
+
+void CAudioResampler::Reset()
+{
+	m_position = 0;
+	m_lastFrame[0] = 0;
+	m_lastFrame[1] = 0;
+}
+
+void CAudioResampler::Resample(const int16* input, uint32 sampleCount, float ratio, std::vector<int16>& output)
+{
+	assert(ratio > 0);
+	assert((sampleCount % 2) == 0);
+	output.clear();
+
+	int32 frameCount = sampleCount / 2;
+	if(frameCount == 0) return;
+
+	double step = 1.0 / static_cast<double>(ratio);
+	output.reserve(static_cast<size_t>(std::ceil(frameCount * ratio) + 1) * 2);
+
+	auto getSample =
+	    [&](int32 frameIndex, uint32 channel) {
+		    return (frameIndex < 0) ? m_lastFrame[channel] : input[(frameIndex * 2) + channel];
+	    };
+
+	double position = m_position;
+	while(position < (frameCount - 1))
+	{
+		int32 frameIndex = static_cast<int32>(std::floor(position));
+		float alpha = static_cast<float>(position - frameIndex);
+		for(uint32 channel = 0; channel < 2; channel++)
+		{
+			float sample0 = getSample(frameIndex, channel);
+			float sample1 = getSample(frameIndex + 1, channel);
+			float result = sample0 + ((sample1 - sample0) * alpha);
+			output.push_back(static_cast<int16>(std::lround(result)));
+		}
+		position += step;
+	}
+
+	m_position = position - frameCount;
+	m_lastFrame[0] = input[(frameCount - 1) * 2 + 0];
+	m_lastFrame[1] = input[(frameCount - 1) * 2 + 1];
+}
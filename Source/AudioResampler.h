@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include "Types.h"
+
+//Linear interpolation resampler for interleaved stereo samples. Meant for small ratio
+//adjustments (ie.: to keep the sound output queue at a steady depth), state is kept
+//between calls so that consecutive buffers join without discontinuities.
+class CAudioResampler
+{
+public:
+	void Reset();
+
+	//Ratio is the output rate over the input rate, output is replaced with the resampled data
+	void Resample(const int16*, uint32, float, std::vector<int16>&);
+
+private:
+	//Position of the next output frame relative to the start of the next input buffer,
+	//-1 designates the last frame of the previous buffer
+	double m_position = 0;
+	int16 m_lastFrame[2] = {};
+};
@@ -3,6 +3,7 @@
 #include "offsetof_def.h"
 #include "MipsJitter.h"
 #include "Jitter_CodeGenFactory.h"
+#include "BlockCodeCache.h"
 
 #if defined(AOT_BUILD_CACHE) || defined(AOT_USE_CACHE)
 #define AOT_ENABLED
@@ -79,24 +80,7 @@ void CBasicBlock::Compile()
 #ifndef AOT_USE_CACHE
 
 	Framework::CMemStream stream;
-	{
-		static
-#ifdef AOT_BUILD_CACHE
-		    thread_local
-#endif
-		    CMipsJitter* jitter = nullptr;
-		if(jitter == nullptr)
-		{
-			Jitter::CCodeGen* codeGen = Jitter::CreateCodeGen();
-			jitter = new CMipsJitter(codeGen);
-		}
-
-		jitter->GetCodeGen()->SetExternalSymbolReferencedHandler([&](auto symbol, auto offset, auto refType) { this->HandleExternalFunctionReference(symbol, offset, refType); });
-		jitter->SetStream(&stream);
-		jitter->Begin();
-		CompileRange(jitter);
-		jitter->End();
-	}
+	CompileToStream(stream, nullptr);
 
 	m_function = CMemoryFunction(stream.GetBuffer(), stream.GetSize());
 
@@ -186,6 +170,112 @@ void CBasicBlock::Compile()
 #endif
 }
 
+void CBasicBlock::Compile(CBlockCodeCache& codeCache, const AOT_BLOCK_KEY& key)
+{
+#ifdef BLOCK_CODE_CACHE_SUPPORTED
+	assert(!IsEmpty());
+
+	if(LoadFromCodeCache(codeCache, key))
+	{
+		return;
+	}
+
+	Framework::CMemStream stream;
+	BlockCodeRelocationArray relocations;
+	bool relocatable = CompileToStream(stream, &relocations);
+
+	m_function = CMemoryFunction(stream.GetBuffer(), stream.GetSize());
+
+	if(relocatable && IsCodeCacheable() &&
+	   !CBlockCodeCache::HasUnrelocatedPointers(stream.GetBuffer(), static_cast<uint32>(stream.GetSize()), relocations,
+	                                            &m_context, sizeof(CMIPS)))
+	{
+		codeCache.AppendBlock(key, stream.GetBuffer(), static_cast<uint32>(stream.GetSize()), std::move(relocations));
+	}
+#else
+	Compile();
+#endif
+}
+
+#ifndef AOT_USE_CACHE
+
+//Returns false if some of the code's external references can't be relocated
+bool CBasicBlock::CompileToStream(Framework::CMemStream& stream, BlockCodeRelocationArray* relocations)
+{
+	//Blocks can be compiled from multiple threads (AOT cache builder, background compiler)
+	static thread_local std::unique_ptr<CMipsJitter> jitter;
+	if(!jitter)
+	{
+		Jitter::CCodeGen* codeGen = Jitter::CreateCodeGen();
+		jitter = std::make_unique<CMipsJitter>(codeGen);
+	}
+
+	bool relocatable = true;
+	jitter->GetCodeGen()->SetExternalSymbolReferencedHandler(
+	    [&](auto symbol, auto offset, auto refType) {
+		    this->HandleExternalFunctionReference(symbol, offset, refType);
+#ifdef BLOCK_CODE_CACHE_SUPPORTED
+		    if(relocations)
+		    {
+			    BLOCK_CODE_RELOCATION relocation;
+			    relocation.offset = offset;
+			    relocation.refType = static_cast<uint32>(refType);
+			    if((refType != Jitter::CCodeGen::SYMBOL_REF_TYPE::NATIVE_POINTER) ||
+			       !CBlockCodeCache::MakeSymbolOffset(symbol, relocation.symbolOffset))
+			    {
+				    relocatable = false;
+			    }
+			    relocations->push_back(relocation);
+		    }
+#endif
+	    });
+	jitter->SetStream(&stream);
+	jitter->ResetConstantStats();
+	jitter->SetFastMemoryEnabled(m_fastMemoryEnabled);
+	jitter->Begin();
+	CompileRange(jitter.get());
+	jitter->End();
+	m_constantStats = jitter->GetConstantStats();
+
+	if(jitter->HasHostPointers())
+	{
+		relocatable = false;
+	}
+
+	return relocatable;
+}
+
+bool CBasicBlock::LoadFromCodeCache(CBlockCodeCache& codeCache, const AOT_BLOCK_KEY& key)
+{
+#ifdef BLOCK_CODE_CACHE_SUPPORTED
+	auto cachedBlock = codeCache.FindBlock(key);
+	if(!cachedBlock) return false;
+
+	auto code = cachedBlock->code;
+	for(const auto& relocation : cachedBlock->relocations)
+	{
+		assert((relocation.offset + sizeof(uintptr_t)) <= code.size());
+		auto refType = static_cast<Jitter::CCodeGen::SYMBOL_REF_TYPE>(relocation.refType);
+		assert(refType == Jitter::CCodeGen::SYMBOL_REF_TYPE::NATIVE_POINTER);
+		auto symbol = CBlockCodeCache::ResolveSymbolOffset(relocation.symbolOffset);
+		*reinterpret_cast<uintptr_t*>(code.data() + relocation.offset) = symbol;
+		HandleExternalFunctionReference(symbol, relocation.offset, refType);
+	}
+
+	m_function = CMemoryFunction(code.data(), code.size());
+	return true;
+#else
+	return false;
+#endif
+}
+
+#endif //!AOT_USE_CACHE
+
+bool CBasicBlock::IsCodeCacheable() const
+{
+	return true;
+}
+
 void CBasicBlock::CompileRange(CMipsJitter* jitter)
 {
 	if(IsEmpty())
@@ -213,11 +303,15 @@ void CBasicBlock::CompileRange(CMipsJitter* jitter)
 		return target == m_begin;
 	}();
 
+	CMipsConstantAnalysis constantAnalysis;
+	constantAnalysis.Analyze(m_context, m_begin, m_end);
+
 	CompileProlog(jitter);
 	jitter->MarkFirstBlockLabel();
 
 	for(uint32 address = m_begin; address <= m_end; address += 4)
 	{
+		jitter->SetKnownGprState(&constantAnalysis.GetState(address));
 		m_context.m_pArch->CompileInstruction(
 		    address,
 		    jitter,
@@ -225,6 +319,7 @@ void CBasicBlock::CompileRange(CMipsJitter* jitter)
 		//Sanity check
 		assert(jitter->IsStackEmpty());
 	}
+	jitter->SetKnownGprState(nullptr);
 
 	jitter->MarkLastBlockLabel();
 	CompileEpilog(jitter, loopsOnItself);
@@ -249,10 +344,22 @@ void CBasicBlock::CompileProlog(CMipsJitter* jitter)
 }
 
 void CBasicBlock::CompileEpilog(CMipsJitter* jitter, bool loopsOnItself)
+{
+	CompileBlockEnd(jitter);
+	CompileExit(jitter, m_begin, m_end, loopsOnItself);
+}
+
+void CBasicBlock::CompileBlockEnd(CMipsJitter*)
+{
+}
+
+//Emits code leaving the block after executing instructions in [exitBegin, exitEnd].
+//PC is expected to still hold the block's begin address at this point.
+void CBasicBlock::CompileExit(CMipsJitter* jitter, uint32 exitBegin, uint32 exitEnd, bool loopsOnItself)
 {
 	//Update cycle quota
 	jitter->PushRel(offsetof(CMIPS, m_State.cycleQuota));
-	jitter->PushCst(((m_end - m_begin) / 4) + 1);
+	jitter->PushCst(((exitEnd - exitBegin) / 4) + 1);
 	jitter->Sub();
 	jitter->PullRel(offsetof(CMIPS, m_State.cycleQuota));
 
@@ -304,7 +411,7 @@ void CBasicBlock::CompileEpilog(CMipsJitter* jitter, bool loopsOnItself)
 	jitter->Else();
 	{
 		jitter->PushRel(offsetof(CMIPS, m_State.nPC));
-		jitter->PushCst(m_end - m_begin + 4);
+		jitter->PushCst(exitEnd - m_begin + 4);
 		jitter->Add();
 		jitter->PullRel(offsetof(CMIPS, m_State.nPC));
 
@@ -372,6 +479,31 @@ void CBasicBlock::SetRecycleCount(uint32 recycleCount)
 	m_recycleCount = recycleCount;
 }
 
+uint32 CBasicBlock::CountExecution()
+{
+	return ++m_executionCount;
+}
+
+uint32 CBasicBlock::GetExecutionCount() const
+{
+	return m_executionCount;
+}
+
+const CMipsJitter::CONSTANT_STATS& CBasicBlock::GetConstantStats() const
+{
+	return m_constantStats;
+}
+
+bool CBasicBlock::IsFastMemoryEnabled() const
+{
+	return m_fastMemoryEnabled;
+}
+
+void CBasicBlock::SetFastMemoryEnabled(bool fastMemoryEnabled)
+{
+	m_fastMemoryEnabled = fastMemoryEnabled;
+}
+
 bool CBasicBlock::HasLinkSlot(LINK_SLOT linkSlot) const
 {
 	return m_linkBlockTrampolineOffset[linkSlot] != INVALID_LINK_SLOT;
@@ -444,6 +576,7 @@ void CBasicBlock::HandleExternalFunctionReference(uintptr_t symbol, uint32 offse
 
 void CBasicBlock::CopyFunctionFrom(const std::shared_ptr<CBasicBlock>& other)
 {
+	m_fastMemoryEnabled = other->m_fastMemoryEnabled;
 #ifndef AOT_USE_CACHE
 	m_function = other->m_function.CreateInstance();
 	std::copy(std::begin(other->m_linkBlockTrampolineOffset), std::end(other->m_linkBlockTrampolineOffset), m_linkBlockTrampolineOffset);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vector>
 #include "MIPS.h"
 #include "MemoryFunction.h"
 #ifdef AOT_BUILD_CACHE
@@ -38,6 +39,13 @@ namespace Jitter
 	class CJitter;
 };
 
+namespace Framework
+{
+	class CMemStream;
+};
+
+class CBlockCodeCache;
+
 extern "C"
 {
 	void EmptyBlockHandler(CMIPS*);
@@ -60,6 +68,16 @@ struct BLOCK_OUT_LINK
 	bool live;         //live if linked to another block, otherwise, link is pending
 };
 
+//Reference to an external symbol made by generated code, used to relocate code stored in a block code cache
+struct BLOCK_CODE_RELOCATION
+{
+	uint32 offset = 0;
+	uint32 refType = 0;
+	int64 symbolOffset = 0;
+};
+
+typedef std::vector<BLOCK_CODE_RELOCATION> BlockCodeRelocationArray;
+
 //Block outgoing links map (key: target link address, value: struct describing link status)
 typedef std::multimap<uint32, BLOCK_OUT_LINK> BlockOutLinkMap;
 
@@ -74,7 +92,9 @@ public:
 	virtual ~CBasicBlock() = default;
 	void Execute();
 	void Compile();
+	void Compile(CBlockCodeCache&, const AOT_BLOCK_KEY&);
 	virtual void CompileRange(CMipsJitter*);
+	virtual bool IsCodeCacheable() const;
 
 	uint32 GetBeginAddress() const;
 	uint32 GetEndAddress() const;
@@ -84,6 +104,21 @@ public:
 	uint32 GetRecycleCount() const;
 	void SetRecycleCount(uint32);
 
+	//Counts how many times the block was entered from the dispatcher
+	uint32 CountExecution();
+	uint32 GetExecutionCount() const;
+
+	//Results of constant propagation done while compiling the block
+	const CMipsJitter::CONSTANT_STATS& GetConstantStats() const;
+
+	//Blocks that access I/O areas are compiled with regular memory accesses instead of fast memory ones
+	bool IsFastMemoryEnabled() const;
+	void SetFastMemoryEnabled(bool);
+
+	//Code specific to the block's type that runs right after its last instruction. Super blocks
+	//emit it for each of their segments, using the block the segment was made from.
+	virtual void CompileBlockEnd(CMipsJitter*);
+
 	bool HasLinkSlot(LINK_SLOT) const;
 	BlockOutLinkPointer GetOutLink(LINK_SLOT) const;
 	void SetOutLink(LINK_SLOT, BlockOutLinkPointer);
@@ -105,8 +140,13 @@ protected:
 
 	virtual void CompileProlog(CMipsJitter*);
 	virtual void CompileEpilog(CMipsJitter*, bool);
+	void CompileExit(CMipsJitter*, uint32, uint32, bool);
 
 private:
+#ifndef AOT_USE_CACHE
+	bool CompileToStream(Framework::CMemStream&, BlockCodeRelocationArray*);
+	bool LoadFromCodeCache(CBlockCodeCache&, const AOT_BLOCK_KEY&);
+#endif
 	void HandleExternalFunctionReference(uintptr_t, uint32, Jitter::CCodeGen::SYMBOL_REF_TYPE);
 
 #ifdef DEBUGGER_INCLUDED
@@ -126,6 +166,9 @@ private:
 	void (*m_function)(void*);
 #endif
 	uint32 m_recycleCount = 0;
+	uint32 m_executionCount = 0;
+	bool m_fastMemoryEnabled = true;
+	CMipsJitter::CONSTANT_STATS m_constantStats;
 	BlockOutLinkPointer m_outLinks[LINK_SLOT_MAX];
 	uint32 m_linkBlockTrampolineOffset[LINK_SLOT_MAX];
 #ifdef _DEBUG
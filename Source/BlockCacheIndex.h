@@ -0,0 +1,200 @@
+#pragma once
+
+#include <vector>
+#include "Types.h"
+#include "uint128.h"
+
+//Open addressed hash table used by executors to find previously compiled blocks
+//from the hash of their contents. Capacity is bounded: once full, entries are
+//evicted using a clock (second chance) policy. Multiple values can be stored
+//for the same key (ie.: same code found at different addresses).
+template <typename ValueType>
+class CBlockCacheIndex
+{
+public:
+	struct KEY
+	{
+		uint128 hash;
+		uint32 size = 0;
+
+		bool operator==(const KEY& rhs) const
+		{
+			return (size == rhs.size) && (hash == rhs.hash);
+		}
+	};
+
+	struct STATS
+	{
+		uint32 hitCount = 0;
+		uint32 missCount = 0;
+		uint32 evictionCount = 0;
+	};
+
+	enum
+	{
+		DEFAULT_MAX_ENTRIES = 0x8000,
+	};
+
+	explicit CBlockCacheIndex(uint32 maxEntries = DEFAULT_MAX_ENTRIES)
+	{
+		//Keep load factor under 50% to keep probe sequences short
+		m_maxEntries = 1;
+		while(m_maxEntries < maxEntries)
+		{
+			m_maxEntries <<= 1;
+		}
+		m_slots.resize(m_maxEntries * 2);
+		m_slotMask = static_cast<uint32>(m_slots.size() - 1);
+	}
+
+	//Returns a value stored for that key that satisfies the predicate. If none does,
+	//returns any value stored for that key. Returns nullptr if key isn't present.
+	template <typename PredicateType>
+	const ValueType* Find(const KEY& key, const PredicateType& predicate)
+	{
+		SLOT* firstMatch = nullptr;
+		for(uint32 index = GetHomeIndex(key);; index = (index + 1) & m_slotMask)
+		{
+			auto& slot = m_slots[index];
+			if(!slot.occupied) break;
+			if(!(slot.key == key)) continue;
+			if(predicate(slot.value))
+			{
+				firstMatch = &slot;
+				break;
+			}
+			if(!firstMatch)
+			{
+				firstMatch = &slot;
+			}
+		}
+		if(!firstMatch)
+		{
+			m_stats.missCount++;
+			return nullptr;
+		}
+		m_stats.hitCount++;
+		firstMatch->referenced = true;
+		return &firstMatch->value;
+	}
+
+	const ValueType* Find(const KEY& key)
+	{
+		return Find(key, [](const ValueType&) { return true; });
+	}
+
+	void Insert(const KEY& key, ValueType value)
+	{
+		if(m_entryCount == m_maxEntries)
+		{
+			EvictEntry();
+		}
+		uint32 homeIndex = GetHomeIndex(key);
+		uint32 index = homeIndex;
+		while(m_slots[index].occupied)
+		{
+			index = (index + 1) & m_slotMask;
+		}
+		auto& slot = m_slots[index];
+		slot.key = key;
+		slot.value = std::move(value);
+		slot.homeIndex = homeIndex;
+		slot.occupied = true;
+		//New entries start unreferenced, blocks that are only ever created once are the first to go
+		slot.referenced = false;
+		m_entryCount++;
+	}
+
+	void Clear()
+	{
+		for(auto& slot : m_slots)
+		{
+			slot = SLOT();
+		}
+		m_entryCount = 0;
+		m_clockHand = 0;
+	}
+
+	uint32 GetEntryCount() const
+	{
+		return m_entryCount;
+	}
+
+	uint32 GetMaxEntries() const
+	{
+		return m_maxEntries;
+	}
+
+	const STATS& GetStats() const
+	{
+		return m_stats;
+	}
+
+	void ResetStats()
+	{
+		m_stats = STATS();
+	}
+
+private:
+	struct SLOT
+	{
+		KEY key;
+		ValueType value = ValueType();
+		uint32 homeIndex = 0;
+		bool occupied = false;
+		bool referenced = false;
+	};
+
+	uint32 GetHomeIndex(const KEY& key) const
+	{
+		//Key is already a good hash, just fold it
+		uint64 hash = key.hash.nD0 ^ (static_cast<uint64>(key.size) * 0x9E3779B97F4A7C15ULL);
+		hash ^= (hash >> 32);
+		return static_cast<uint32>(hash) & m_slotMask;
+	}
+
+	void EvictEntry()
+	{
+		while(1)
+		{
+			uint32 index = m_clockHand;
+			m_clockHand = (m_clockHand + 1) & m_slotMask;
+			auto& slot = m_slots[index];
+			if(!slot.occupied) continue;
+			if(slot.referenced)
+			{
+				slot.referenced = false;
+				continue;
+			}
+			RemoveSlot(index);
+			m_stats.evictionCount++;
+			break;
+		}
+	}
+
+	//Backward shift deletion, keeps probe sequences intact without needing tombstones
+	void RemoveSlot(uint32 holeIndex)
+	{
+		for(uint32 index = (holeIndex + 1) & m_slotMask;; index = (index + 1) & m_slotMask)
+		{
+			auto& slot = m_slots[index];
+			if(!slot.occupied) break;
+			uint32 homeDistance = (index - slot.homeIndex) & m_slotMask;
+			uint32 holeDistance = (index - holeIndex) & m_slotMask;
+			if(homeDistance >= holeDistance)
+			{
+				m_slots[holeIndex] = std::move(slot);
+				holeIndex = index;
+			}
+		}
+		m_slots[holeIndex] = SLOT();
+		m_entryCount--;
+	}
+
+	std::vector<SLOT> m_slots;
+	uint32 m_slotMask = 0;
+	uint32 m_maxEntries = 0;
+	uint32 m_entryCount = 0;
+	uint32 m_clockHand = 0;
+	STATS m_stats;
+};
@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include "BlockCodeCache.h"
+#include "AppConfig.h"
+#include "PathUtils.h"
+#include "StdStreamUtils.h"
+#include "Log.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#define LOG_NAME ("blockcodecache")
+
+#define CACHE_PATH ("blockcache/")
+
+#define CACHE_MAGIC (0x43424A50) //'PJBC'
+#define CACHE_VERSION (2)
+
+#ifdef PLAY_VERSION
+#define CACHE_BUILD_TAG PLAY_VERSION
+#else
+#define CACHE_BUILD_TAG ""
+#endif
+
+//All symbols referenced by generated code are stored relative to this one
+static uintptr_t GetAnchorSymbol()
+{
+	return reinterpret_cast<uintptr_t>(&EmptyBlockHandler);
+}
+
+static const void* GetSymbolModuleBase(uintptr_t symbol)
+{
+#if defined(_WIN32)
+	HMODULE module = NULL;
+	BOOL result = GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+	                                 reinterpret_cast<LPCSTR>(symbol), &module);
+	return result ? module : nullptr;
+#else
+	Dl_info info = {};
+	int result = dladdr(reinterpret_cast<void*>(symbol), &info);
+	return (result != 0) ? info.dli_fbase : nullptr;
+#endif
+}
+
+static void ReadExact(Framework::CStream& stream, void* buffer, uint64 size)
+{
+	if(stream.Read(buffer, size) != size)
+	{
+		throw std::runtime_error("Unexpected end of block code cache file.");
+	}
+}
+
+CBlockCodeCache::CBlockCodeCache(const fs::path& path, uint32 codeGenOptions)
+    : m_path(path)
+    , m_codeGenOptions(codeGenOptions)
+{
+	Load();
+	m_writerThread = std::thread([this]() { WriterThreadProc(); });
+}
+
+CBlockCodeCache::~CBlockCodeCache()
+{
+	{
+		std::lock_guard<std::mutex> writerLock(m_writerMutex);
+		m_writerEnd = true;
+	}
+	m_writerCondition.notify_all();
+	m_writerThread.join();
+}
+
+fs::path CBlockCodeCache::GetCacheDirectoryPath()
+{
+	return CAppConfig::GetInstance().GetBasePath() / fs::path(CACHE_PATH);
+}
+
+uint32 CBlockCodeCache::GetCodeGenOptions(const CMIPS& context)
+{
+	uint32 options = 0;
+	if(context.m_fastMemoryBase != nullptr)
+	{
+		options |= CODEGEN_OPTION_FASTMEMORY;
+	}
+	//Static memory accesses and handler calls are resolved using these at compile time
+	if(context.m_pageLookup != nullptr)
+	{
+		options |= CODEGEN_OPTION_PAGELOOKUP;
+	}
+	if(context.m_pAddrTranslator == &CMIPS::TranslateAddress64)
+	{
+		options |= CODEGEN_OPTION_TRANSLATEADDRESS64;
+	}
+#ifdef DEBUGGER_INCLUDED
+	options |= CODEGEN_OPTION_DEBUGGER;
+#endif
+	return options;
+}
+
+const CBlockCodeCache::BLOCK* CBlockCodeCache::FindBlock(const AOT_BLOCK_KEY& key) const
+{
+	auto blockIterator = m_blocks.find(key);
+	if(blockIterator == std::end(m_blocks)) return nullptr;
+	return &blockIterator->second;
+}
+
+void CBlockCodeCache::AppendBlock(const AOT_BLOCK_KEY& key, const void* code, uint32 codeSize, RelocationArray relocations)
+{
+	if(m_blocks.find(key) != std::end(m_blocks)) return;
+
+	BLOCK block;
+	block.code = std::vector<uint8>(reinterpret_cast<const uint8*>(code), reinterpret_cast<const uint8*>(code) + codeSize);
+	block.relocations = std::move(relocations);
+
+	//Map nodes are never removed, writer thread can safely refer to them
+	auto blockIterator = m_blocks.emplace(key, std::move(block)).first;
+
+	{
+		std::lock_guard<std::mutex> writerLock(m_writerMutex);
+		m_pendingBlocks.emplace_back(key, &blockIterator->second);
+	}
+	m_writerCondition.notify_one();
+}
+
+bool CBlockCodeCache::MakeSymbolOffset(uintptr_t symbol, int64& symbolOffset)
+{
+	//We can only relocate symbols that live in the same module as the anchor,
+	//other modules could be loaded at a different relative position next time
+	static const void* anchorModuleBase = GetSymbolModuleBase(GetAnchorSymbol());
+	if(anchorModuleBase == nullptr) return false;
+	if(GetSymbolModuleBase(symbol) != anchorModuleBase) return false;
+	symbolOffset = static_cast<int64>(symbol) - static_cast<int64>(GetAnchorSymbol());
+	return true;
+}
+
+uintptr_t CBlockCodeCache::ResolveSymbolOffset(int64 symbolOffset)
+{
+	return static_cast<uintptr_t>(static_cast<int64>(GetAnchorSymbol()) + symbolOffset);
+}
+
+bool CBlockCodeCache::HasUnrelocatedPointers(const uint8* code, uint32 codeSize, const RelocationArray& relocations,
+                                             const void* context, size_t contextSize)
+{
+	//Code generators only report symbols they reference through calls and jumps. Make sure
+	//none of those symbols, nor anything inside the execution context, also appear as plain values.
+	std::vector<uintptr_t> symbols;
+	std::vector<uint32> relocationOffsets;
+	for(const auto& relocation : relocations)
+	{
+		symbols.push_back(ResolveSymbolOffset(relocation.symbolOffset));
+		relocationOffsets.push_back(relocation.offset);
+	}
+	symbols.push_back(reinterpret_cast<uintptr_t>(&EmptyBlockHandler));
+	symbols.push_back(reinterpret_cast<uintptr_t>(&NextBlockTrampoline));
+	symbols.push_back(reinterpret_cast<uintptr_t>(&BranchBlockTrampoline));
+
+	auto contextStart = reinterpret_cast<uintptr_t>(context);
+	auto contextEnd = contextStart + contextSize;
+	for(uint32 offset = 0; (offset + sizeof(uintptr_t)) <= codeSize; offset++)
+	{
+		if(std::find(relocationOffsets.begin(), relocationOffsets.end(), offset) != relocationOffsets.end()) continue;
+		uintptr_t value = 0;
+		memcpy(&value, code + offset, sizeof(uintptr_t));
+		if((value >= contextStart) && (value < contextEnd)) return true;
+		if(std::find(symbols.begin(), symbols.end(), value) != symbols.end()) return true;
+	}
+	return false;
+}
+
+void CBlockCodeCache::Load()
+{
+	bool needsRewrite = true;
+	if(fs::exists(m_path))
+	{
+		try
+		{
+			auto stream = Framework::CreateInputStdStream(m_path.native());
+			if(IsHeaderValid(stream))
+			{
+				needsRewrite = false;
+				while(1)
+				{
+					AOT_BLOCK_KEY key = {};
+					auto readSize = stream.Read(&key, sizeof(key));
+					if(readSize == 0) break;
+					if(readSize != sizeof(key))
+					{
+						throw std::runtime_error("Truncated block key.");
+					}
+					uint32 codeSize = stream.Read32();
+					uint32 relocationCount = stream.Read32();
+					BLOCK block;
+					block.relocations.resize(relocationCount);
+					for(auto& relocation : block.relocations)
+					{
+						relocation.offset = stream.Read32();
+						relocation.refType = stream.Read32();
+						ReadExact(stream, &relocation.symbolOffset, sizeof(relocation.symbolOffset));
+					}
+					block.code.resize(codeSize);
+					ReadExact(stream, block.code.data(), codeSize);
+					m_blocks.emplace(key, std::move(block));
+				}
+			}
+			else
+			{
+				CLog::GetInstance().Print(LOG_NAME, "Discarding stale block code cache '%s'.\r\n", m_path.string().c_str());
+			}
+		}
+		catch(const std::exception& exception)
+		{
+			//File was probably truncated, keep what we could read and rewrite it
+			CLog::GetInstance().Warn(LOG_NAME, "Failed to load block code cache '%s': %s\r\n", m_path.string().c_str(), exception.what());
+			needsRewrite = true;
+		}
+	}
+
+	uint32 loadedBlockCount = static_cast<uint32>(m_blocks.size());
+
+	if(needsRewrite)
+	{
+		try
+		{
+			Framework::PathUtils::EnsurePathExists(m_path.parent_path());
+			auto stream = Framework::CreateOutputStdStream(m_path.native());
+			WriteHeader(stream);
+			for(const auto& blockPair : m_blocks)
+			{
+				WriteBlock(stream, blockPair.first, blockPair.second);
+			}
+		}
+		catch(const std::exception& exception)
+		{
+			CLog::GetInstance().Warn(LOG_NAME, "Failed to create block code cache '%s': %s\r\n", m_path.string().c_str(), exception.what());
+		}
+	}
+
+	CLog::GetInstance().Print(LOG_NAME, "Loaded %d blocks from '%s'.\r\n", loadedBlockCount, m_path.string().c_str());
+}
+
+void CBlockCodeCache::WriterThreadProc()
+{
+	while(1)
+	{
+		std::deque<PendingBlock> pendingBlocks;
+		bool end = false;
+		{
+			std::unique_lock<std::mutex> writerLock(m_writerMutex);
+			m_writerCondition.wait(writerLock, [this]() { return m_writerEnd || !m_pendingBlocks.empty(); });
+			pendingBlocks.swap(m_pendingBlocks);
+			end = m_writerEnd;
+		}
+
+		if(!pendingBlocks.empty())
+		{
+			try
+			{
+				auto stream = Framework::CreateUpdateExistingStdStream(m_path.native());
+				stream.Seek(0, Framework::STREAM_SEEK_END);
+				for(const auto& pendingBlock : pendingBlocks)
+				{
+					WriteBlock(stream, pendingBlock.first, *pendingBlock.second);
+				}
+			}
+			catch(const std::exception& exception)
+			{
+				CLog::GetInstance().Warn(LOG_NAME, "Failed to append to block code cache '%s': %s\r\n", m_path.string().c_str(), exception.what());
+			}
+		}
+
+		if(end) break;
+	}
+}
+
+void CBlockCodeCache::WriteBlock(Framework::CStream& stream, const AOT_BLOCK_KEY& key, const BLOCK& block)
+{
+	stream.Write(&key, sizeof(key));
+	stream.Write32(static_cast<uint32>(block.code.size()));
+	stream.Write32(static_cast<uint32>(block.relocations.size()));
+	for(const auto& relocation : block.relocations)
+	{
+		stream.Write32(relocation.offset);
+		stream.Write32(relocation.refType);
+		stream.Write(&relocation.symbolOffset, sizeof(relocation.symbolOffset));
+	}
+	stream.Write(block.code.data(), block.code.size());
+}
+
+bool CBlockCodeCache::IsHeaderValid(Framework::CStream& stream) const
+{
+	if(stream.Read32() != CACHE_MAGIC) return false;
+	if(stream.Read32() != CACHE_VERSION) return false;
+	if(stream.Read32() != sizeof(uintptr_t)) return false;
+	if(stream.Read32() != m_codeGenOptions) return false;
+
+	//Relative position of a few symbols changes when the executable is rebuilt
+	int64 trampolineOffset = 0;
+	ReadExact(stream, &trampolineOffset, sizeof(trampolineOffset));
+	if(trampolineOffset != (static_cast<int64>(reinterpret_cast<uintptr_t>(&NextBlockTrampoline)) - static_cast<int64>(GetAnchorSymbol()))) return false;
+
+	uint32 buildTagSize = stream.Read32();
+	if(buildTagSize != strlen(CACHE_BUILD_TAG)) return false;
+	std::vector<char> buildTag(buildTagSize);
+	ReadExact(stream, buildTag.data(), buildTagSize);
+	return memcmp(buildTag.data(), CACHE_BUILD_TAG, buildTagSize) == 0;
+}
+
+void CBlockCodeCache::WriteHeader(Framework::CStream& stream) const
+{
+	stream.Write32(CACHE_MAGIC);
+	stream.Write32(CACHE_VERSION);
+	stream.Write32(sizeof(uintptr_t));
+	stream.Write32(m_codeGenOptions);
+	int64 trampolineOffset = static_cast<int64>(reinterpret_cast<uintptr_t>(&NextBlockTrampoline)) - static_cast<int64>(GetAnchorSymbol());
+	stream.Write(&trampolineOffset, sizeof(trampolineOffset));
+	uint32 buildTagSize = static_cast<uint32>(strlen(CACHE_BUILD_TAG));
+	stream.Write32(buildTagSize);
+	stream.Write(CACHE_BUILD_TAG, buildTagSize);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "filesystem_def.h"
+#include "Types.h"
+#include "BasicBlock.h"
+
+#if !defined(AOT_USE_CACHE) && !defined(__EMSCRIPTEN__)
+#define BLOCK_CODE_CACHE_SUPPORTED
+#endif
+
+//Persistent storage for compiled basic block code. Blocks are keyed the same way
+//AOT blocks are (category, hash of block contents and size). External symbols
+//referenced by the generated code are stored relative to an anchor symbol
+//and relocated when a block is loaded back.
+class CBlockCodeCache
+{
+public:
+	typedef BLOCK_CODE_RELOCATION RELOCATION;
+	typedef BlockCodeRelocationArray RelocationArray;
+
+	struct BLOCK
+	{
+		std::vector<uint8> code;
+		RelocationArray relocations;
+	};
+
+	//Settings that change the code generated for a block. Cache files
+	//written under different settings are discarded.
+	enum CODEGEN_OPTION : uint32
+	{
+		CODEGEN_OPTION_FASTMEMORY = 0x01,
+		CODEGEN_OPTION_PAGELOOKUP = 0x02,
+		CODEGEN_OPTION_TRANSLATEADDRESS64 = 0x04,
+		CODEGEN_OPTION_DEBUGGER = 0x08,
+	};
+
+	CBlockCodeCache(const fs::path&, uint32 codeGenOptions);
+	virtual ~CBlockCodeCache();
+
+	static fs::path GetCacheDirectoryPath();
+	static uint32 GetCodeGenOptions(const CMIPS&);
+
+	const BLOCK* FindBlock(const AOT_BLOCK_KEY&) const;
+	void AppendBlock(const AOT_BLOCK_KEY&, const void*, uint32, RelocationArray);
+
+	static bool MakeSymbolOffset(uintptr_t, int64&);
+	static uintptr_t ResolveSymbolOffset(int64);
+
+	//Checks that code doesn't embed any known host pointer outside of its relocations
+	static bool HasUnrelocatedPointers(const uint8*, uint32, const RelocationArray&, const void*, size_t);
+
+private:
+	typedef std::map<AOT_BLOCK_KEY, BLOCK> BlockMap;
+	typedef std::pair<AOT_BLOCK_KEY, const BLOCK*> PendingBlock;
+
+	void Load();
+	void WriterThreadProc();
+	static void WriteBlock(Framework::CStream&, const AOT_BLOCK_KEY&, const BLOCK&);
+	bool IsHeaderValid(Framework::CStream&) const;
+	void WriteHeader(Framework::CStream&) const;
+
+	fs::path m_path;
+	uint32 m_codeGenOptions = 0;
+	BlockMap m_blocks;
+
+	std::thread m_writerThread;
+	std::mutex m_writerMutex;
+	std::condition_variable m_writerCondition;
+	std::deque<PendingBlock> m_pendingBlocks;
+	bool m_writerEnd = false;
+};
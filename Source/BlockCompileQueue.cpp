@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cassert>
+#include "BlockCompileQueue.h"
+
+CBlockCompileQueue::CBlockCompileQueue()
+{
+	m_workerThread = std::thread([this]() { WorkerThreadProc(); });
+}
+
+CBlockCompileQueue::~CBlockCompileQueue()
+{
+	{
+		std::lock_guard<std::mutex> jobsLock(m_jobsMutex);
+		m_workerEnd = true;
+		for(const auto& job : m_jobs)
+		{
+			job->state = JOB_STATE_CANCELLED;
+		}
+		m_jobs.clear();
+	}
+	m_jobQueuedCondition.notify_all();
+	m_workerThread.join();
+}
+
+CBlockCompileQueue::JobPtr CBlockCompileQueue::QueueJob(CompileFunction compileFunction)
+{
+	auto job = std::make_shared<JOB>();
+	job->compileFunction = std::move(compileFunction);
+	job->queueTime = std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> jobsLock(m_jobsMutex);
+		m_jobs.push_back(job);
+		m_maxQueueDepth = std::max<uint32>(m_maxQueueDepth, static_cast<uint32>(m_jobs.size()));
+	}
+	m_jobQueuedCondition.notify_one();
+	return job;
+}
+
+bool CBlockCompileQueue::CancelJob(const JobPtr& job)
+{
+	uint32 expectedState = JOB_STATE_QUEUED;
+	if(job->state.compare_exchange_strong(expectedState, JOB_STATE_CANCELLED))
+	{
+		//Worker thread will skip the job when it gets to it
+		return true;
+	}
+	return (expectedState == JOB_STATE_CANCELLED);
+}
+
+void CBlockCompileQueue::WaitForJob(const JobPtr& job)
+{
+	std::unique_lock<std::mutex> jobsLock(m_jobsMutex);
+	m_jobDoneCondition.wait(jobsLock, [&]() {
+		uint32 state = job->state;
+		return (state == JOB_STATE_DONE) || (state == JOB_STATE_CANCELLED);
+	});
+}
+
+uint32 CBlockCompileQueue::GetQueueDepth() const
+{
+	std::lock_guard<std::mutex> jobsLock(m_jobsMutex);
+	return static_cast<uint32>(m_jobs.size());
+}
+
+uint32 CBlockCompileQueue::GetMaxQueueDepth() const
+{
+	std::lock_guard<std::mutex> jobsLock(m_jobsMutex);
+	return m_maxQueueDepth;
+}
+
+void CBlockCompileQueue::ResetMaxQueueDepth()
+{
+	std::lock_guard<std::mutex> jobsLock(m_jobsMutex);
+	m_maxQueueDepth = static_cast<uint32>(m_jobs.size());
+}
+
+void CBlockCompileQueue::WorkerThreadProc()
+{
+	while(1)
+	{
+		JobPtr job;
+		{
+			std::unique_lock<std::mutex> jobsLock(m_jobsMutex);
+			m_jobQueuedCondition.wait(jobsLock, [this]() { return m_workerEnd || !m_jobs.empty(); });
+			if(m_workerEnd) break;
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		uint32 expectedState = JOB_STATE_QUEUED;
+		if(!job->state.compare_exchange_strong(expectedState, JOB_STATE_COMPILING))
+		{
+			assert(expectedState == JOB_STATE_CANCELLED);
+			continue;
+		}
+
+		job->compileFunction();
+		job->compileFunction = CompileFunction();
+		job->latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - job->queueTime).count();
+
+		{
+			std::lock_guard<std::mutex> jobsLock(m_jobsMutex);
+			job->state = JOB_STATE_DONE;
+		}
+		m_jobDoneCondition.notify_all();
+	}
+}
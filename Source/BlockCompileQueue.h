@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "Types.h"
+
+#if !defined(AOT_BUILD_CACHE) && !defined(AOT_USE_CACHE) && !defined(__EMSCRIPTEN__)
+#define BLOCK_COMPILE_QUEUE_SUPPORTED
+#endif
+
+//Runs block compilation jobs on a worker thread
+class CBlockCompileQueue
+{
+public:
+	enum JOB_STATE : uint32
+	{
+		JOB_STATE_QUEUED,
+		JOB_STATE_COMPILING,
+		JOB_STATE_DONE,
+		JOB_STATE_CANCELLED,
+	};
+
+	typedef std::function<void()> CompileFunction;
+	typedef std::chrono::steady_clock::time_point TimePoint;
+
+	struct JOB
+	{
+		CompileFunction compileFunction;
+		std::atomic<uint32> state = {JOB_STATE_QUEUED};
+		TimePoint queueTime;
+		uint64 latency = 0; //Time between queueing and completion in nanoseconds
+	};
+	typedef std::shared_ptr<JOB> JobPtr;
+
+	CBlockCompileQueue();
+	virtual ~CBlockCompileQueue();
+
+	JobPtr QueueJob(CompileFunction);
+
+	//Returns true if the job was removed before it started running
+	bool CancelJob(const JobPtr&);
+	void WaitForJob(const JobPtr&);
+
+	uint32 GetQueueDepth() const;
+	uint32 GetMaxQueueDepth() const;
+	void ResetMaxQueueDepth();
+
+private:
+	void WorkerThreadProc();
+
+	std::thread m_workerThread;
+	mutable std::mutex m_jobsMutex;
+	std::condition_variable m_jobQueuedCondition;
+	std::condition_variable m_jobDoneCondition;
+	std::deque<JobPtr> m_jobs;
+	uint32 m_maxQueueDepth = 0;
+	bool m_workerEnd = false;
+};
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include "EventScheduler.h"
+
+CEventScheduler::EventId CEventScheduler::RegisterEvent(EventHandler handler)
+{
+	EVENT event;
+	event.handler = std::move(handler);
+	m_events.push_back(std::move(event));
+	return static_cast<EventId>(m_events.size() - 1);
+}
+
+void CEventScheduler::Schedule(EventId eventId, int64 delay)
+{
+	assert(delay >= 0);
+	SetDeadline(eventId, m_currentTime + delay);
+}
+
+void CEventScheduler::ScheduleNext(EventId eventId, int64 period)
+{
+	assert(period > 0);
+	SetDeadline(eventId, m_events[eventId].deadline + period);
+}
+
+void CEventScheduler::Cancel(EventId eventId)
+{
+	if(!IsScheduled(eventId)) return;
+	RemoveFromHeap(eventId);
+}
+
+void CEventScheduler::CancelAll()
+{
+	for(auto eventId : m_heap)
+	{
+		m_events[eventId].heapIndex = INVALID_HEAP_INDEX;
+	}
+	m_heap.clear();
+}
+
+bool CEventScheduler::IsScheduled(EventId eventId) const
+{
+	assert(eventId < m_events.size());
+	return m_events[eventId].heapIndex != INVALID_HEAP_INDEX;
+}
+
+int64 CEventScheduler::GetTicksUntil(EventId eventId) const
+{
+	assert(IsScheduled(eventId));
+	return m_events[eventId].deadline - m_currentTime;
+}
+
+int64 CEventScheduler::GetTicksUntilNextEvent() const
+{
+	if(m_heap.empty()) return std::numeric_limits<int64>::max();
+	return std::max<int64>(m_events[m_heap[0]].deadline - m_currentTime, 0);
+}
+
+void CEventScheduler::AdvanceTime(int64 ticks)
+{
+	m_currentTime += ticks;
+}
+
+uint32 CEventScheduler::DispatchDueEvents()
+{
+	uint32 dispatchCount = 0;
+	while(!m_heap.empty())
+	{
+		EventId eventId = m_heap[0];
+		if(m_events[eventId].deadline > m_currentTime) break;
+		//Handlers usually schedule their event again, take it out first
+		RemoveFromHeap(eventId);
+		m_events[eventId].handler();
+		dispatchCount++;
+	}
+	return dispatchCount;
+}
+
+bool CEventScheduler::IsEarlier(EventId eventId1, EventId eventId2) const
+{
+	const auto& event1 = m_events[eventId1];
+	const auto& event2 = m_events[eventId2];
+	if(event1.deadline != event2.deadline) return event1.deadline < event2.deadline;
+	return eventId1 < eventId2;
+}
+
+void CEventScheduler::SetDeadline(EventId eventId, int64 deadline)
+{
+	auto& event = m_events[eventId];
+	event.deadline = deadline;
+	if(event.heapIndex == INVALID_HEAP_INDEX)
+	{
+		event.heapIndex = static_cast<uint32>(m_heap.size());
+		m_heap.push_back(eventId);
+		SiftUp(event.heapIndex);
+	}
+	else
+	{
+		SiftUp(event.heapIndex);
+		SiftDown(event.heapIndex);
+	}
+}
+
+void CEventScheduler::RemoveFromHeap(EventId eventId)
+{
+	uint32 index = m_events[eventId].heapIndex;
+	assert(index != INVALID_HEAP_INDEX);
+	uint32 lastIndex = static_cast<uint32>(m_heap.size() - 1);
+	if(index != lastIndex)
+	{
+		SwapHeapItems(index, lastIndex);
+	}
+	m_heap.pop_back();
+	m_events[eventId].heapIndex = INVALID_HEAP_INDEX;
+	if(index < m_heap.size())
+	{
+		SiftUp(index);
+		SiftDown(index);
+	}
+}
+
+void CEventScheduler::SiftUp(uint32 index)
+{
+	while(index != 0)
+	{
+		uint32 parentIndex = (index - 1) / 2;
+		if(!IsEarlier(m_heap[index], m_heap[parentIndex])) break;
+		SwapHeapItems(index, parentIndex);
+		index = parentIndex;
+	}
+}
+
+void CEventScheduler::SiftDown(uint32 index)
+{
+	uint32 heapSize = static_cast<uint32>(m_heap.size());
+	while(1)
+	{
+		uint32 earliestIndex = index;
+		uint32 leftIndex = (index * 2) + 1;
+		uint32 rightIndex = (index * 2) + 2;
+		if((leftIndex < heapSize) && IsEarlier(m_heap[leftIndex], m_heap[earliestIndex])) earliestIndex = leftIndex;
+		if((rightIndex < heapSize) && IsEarlier(m_heap[rightIndex], m_heap[earliestIndex])) earliestIndex = rightIndex;
+		if(earliestIndex == index) break;
+		SwapHeapItems(index, earliestIndex);
+		index = earliestIndex;
+	}
+}
+
+void CEventScheduler::SwapHeapItems(uint32 index1, uint32 index2)
+{
+	std::swap(m_heap[index1], m_heap[index2]);
+	m_events[m_heap[index1]].heapIndex = index1;
+	m_events[m_heap[index2]].heapIndex = index2;
+}
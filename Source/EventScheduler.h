@@ -0,0 +1,61 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "Types.h"
+
+//Keeps track of the next deadline of timed events registered with it. Time is counted
+//in ticks of the CPU driving the machine: the driver asks for the amount of ticks it can
+//run until the next deadline, runs that many and then dispatches the events that are due.
+//Events that aren't scheduled don't cost anything.
+class CEventScheduler
+{
+public:
+	typedef uint32 EventId;
+	typedef std::function<void()> EventHandler;
+
+	//Events registered first are dispatched first when they share a deadline
+	EventId RegisterEvent(EventHandler);
+
+	//Schedules an event relative to the current time, replaces any previous deadline
+	void Schedule(EventId, int64);
+
+	//Schedules an event relative to its last deadline, keeps periodic events from drifting
+	void ScheduleNext(EventId, int64);
+
+	void Cancel(EventId);
+	void CancelAll();
+
+	bool IsScheduled(EventId) const;
+	int64 GetTicksUntil(EventId) const;
+	int64 GetTicksUntilNextEvent() const;
+
+	void AdvanceTime(int64);
+
+	//Runs handlers of events that are due, returns the amount of events dispatched
+	uint32 DispatchDueEvents();
+
+private:
+	enum
+	{
+		INVALID_HEAP_INDEX = ~0U,
+	};
+
+	struct EVENT
+	{
+		EventHandler handler;
+		int64 deadline = 0;
+		uint32 heapIndex = INVALID_HEAP_INDEX;
+	};
+
+	bool IsEarlier(EventId, EventId) const;
+	void SetDeadline(EventId, int64);
+	void RemoveFromHeap(EventId);
+	void SiftUp(uint32);
+	void SiftDown(uint32);
+	void SwapHeapItems(uint32, uint32);
+
+	std::vector<EVENT> m_events;
+	std::vector<EventId> m_heap;
+	int64 m_currentTime = 0;
+};
@@ -0,0 +1,478 @@
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include "FastMemoryArena.h"
+#include "MemoryUtils.h"
+
+#ifdef FAST_MEMORY_SUPPORTED
+#include <cpuid.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+#define ARENA_SIZE (0x100000000ULL)
+
+#ifdef FAST_MEMORY_SUPPORTED
+
+namespace
+{
+	//Memory access performed by a faulting host instruction
+	struct HOST_ACCESS
+	{
+		bool isWrite = false;
+		uint32 size = 0;         //Size of the memory operand
+		uint32 registerSize = 0; //Size of the register written by loads
+		bool signExtend = false;
+		bool hasImmediate = false;
+		uint64 immediate = 0;
+		uint32 reg = 0;
+		bool highByteReg = false; //AH, CH, DH or BH
+		uint32 length = 0;
+	};
+
+	//Access redirected by the signal handler, waiting for the thunk to complete it
+	struct PENDING_ACCESS
+	{
+		HOST_ACCESS access;
+		CMIPS* context = nullptr;
+		uint32 address = 0;
+		uint64 resumeAddress = 0;
+		CFastMemoryArena::AccessCompletedCallback callback = nullptr;
+	};
+
+	thread_local PENDING_ACCESS g_pendingAccess;
+
+	//The thunk's frame holds the general purpose registers in encoding order (RAX to R15),
+	//followed by the flags and the address execution resumes at
+	enum
+	{
+		THUNK_FRAME_FLAGS = 16,
+		THUNK_FRAME_RESUME = 17,
+	};
+}
+
+extern "C" void FastMemoryArena_AccessThunk();
+extern "C" void FastMemoryArena_CompleteAccess(uint64*);
+
+//Entered in place of the faulting instruction once the signal handler returns. Skips the
+//red zone of the generated code, saves every register (including vector state, proxies can
+//end up in library code that uses any of them), completes the access and resumes after the
+//faulting instruction.
+asm(R"(
+	.text
+	.p2align 4
+	.type FastMemoryArena_AccessThunk, @function
+FastMemoryArena_AccessThunk:
+	lea -136(%rsp), %rsp
+	pushfq
+	push %r15
+	push %r14
+	push %r13
+	push %r12
+	push %r11
+	push %r10
+	push %r9
+	push %r8
+	push %rdi
+	push %rsi
+	push %rbp
+	push %rsp
+	push %rbx
+	push %rdx
+	push %rcx
+	push %rax
+	mov %rsp, %rbx
+	sub $4096, %rsp
+	and $-64, %rsp
+	xor %eax, %eax
+	mov $8, %ecx
+1:
+	movq %rax, 504(%rsp, %rcx, 8)
+	dec %ecx
+	jnz 1b
+	mov $0xFF, %eax
+	xor %edx, %edx
+	xsave (%rsp)
+	mov %rbx, %rdi
+	call FastMemoryArena_CompleteAccess@PLT
+	mov $0xFF, %eax
+	xor %edx, %edx
+	xrstor (%rsp)
+	mov %rbx, %rsp
+	pop %rax
+	pop %rcx
+	pop %rdx
+	pop %rbx
+	lea 8(%rsp), %rsp
+	pop %rbp
+	pop %rsi
+	pop %rdi
+	pop %r8
+	pop %r9
+	pop %r10
+	pop %r11
+	pop %r12
+	pop %r13
+	pop %r14
+	pop %r15
+	popfq
+	ret $128
+	.size FastMemoryArena_AccessThunk, .-FastMemoryArena_AccessThunk
+)");
+
+//Decodes the MOV family instructions emitted by the code generator for memory accesses
+static bool DecodeHostAccess(const uint8* code, HOST_ACCESS& access)
+{
+	const uint8* start = code;
+
+	bool operandSize16 = false;
+	uint8 rex = 0;
+	if(*code == 0x66)
+	{
+		operandSize16 = true;
+		code++;
+	}
+	if((*code & 0xF0) == 0x40)
+	{
+		rex = *code;
+		code++;
+	}
+	bool rexW = (rex & 0x08) != 0;
+	uint32 operandSize = rexW ? 8 : (operandSize16 ? 2 : 4);
+	uint32 immediateSize = 0;
+	bool byteRegOperand = false;
+	bool opcodeExtension = false;
+
+	uint8 opcode = *code++;
+	switch(opcode)
+	{
+	case 0x88:
+		//MOV r/m8, r8
+		access.isWrite = true;
+		access.size = 1;
+		byteRegOperand = true;
+		break;
+	case 0x89:
+		//MOV r/m, r
+		access.isWrite = true;
+		access.size = operandSize;
+		break;
+	case 0x8A:
+		//MOV r8, r/m8
+		access.size = 1;
+		access.registerSize = 1;
+		byteRegOperand = true;
+		break;
+	case 0x8B:
+		//MOV r, r/m
+		access.size = operandSize;
+		access.registerSize = operandSize;
+		break;
+	case 0x63:
+		//MOVSXD r64, r/m32
+		if(!rexW) return false;
+		access.size = 4;
+		access.registerSize = 8;
+		access.signExtend = true;
+		break;
+	case 0xC6:
+		//MOV r/m8, imm8
+		access.isWrite = true;
+		access.size = 1;
+		immediateSize = 1;
+		opcodeExtension = true;
+		break;
+	case 0xC7:
+		//MOV r/m, imm16/imm32
+		access.isWrite = true;
+		access.size = operandSize;
+		immediateSize = (operandSize == 2) ? 2 : 4;
+		opcodeExtension = true;
+		break;
+	case 0x0F:
+		opcode = *code++;
+		switch(opcode)
+		{
+		case 0xB6:
+		case 0xBE:
+			//MOVZX/MOVSX r, r/m8
+			access.size = 1;
+			break;
+		case 0xB7:
+		case 0xBF:
+			//MOVZX/MOVSX r, r/m16
+			access.size = 2;
+			break;
+		default:
+			return false;
+		}
+		access.registerSize = operandSize;
+		access.signExtend = (opcode == 0xBE) || (opcode == 0xBF);
+		break;
+	default:
+		return false;
+	}
+
+	uint8 modRm = *code++;
+	uint32 mod = (modRm >> 6) & 0x03;
+	uint32 reg = (modRm >> 3) & 0x07;
+	uint32 rm = (modRm >> 0) & 0x07;
+	if(mod == 3) return false;
+	if(opcodeExtension && (reg != 0)) return false;
+	if(rm == 4)
+	{
+		uint8 sib = *code++;
+		if((mod == 0) && ((sib & 0x07) == 5))
+		{
+			code += 4;
+		}
+	}
+	else if((mod == 0) && (rm == 5))
+	{
+		//RIP relative, can't point inside the arena
+		return false;
+	}
+	if(mod == 1)
+	{
+		code += 1;
+	}
+	else if(mod == 2)
+	{
+		code += 4;
+	}
+
+	if(immediateSize != 0)
+	{
+		int32 immediate = 0;
+		switch(immediateSize)
+		{
+		case 1:
+			immediate = static_cast<int8>(*code);
+			break;
+		case 2:
+		{
+			int16 value = 0;
+			memcpy(&value, code, sizeof(int16));
+			immediate = value;
+		}
+		break;
+		case 4:
+			memcpy(&immediate, code, sizeof(int32));
+			break;
+		}
+		access.hasImmediate = true;
+		access.immediate = static_cast<uint64>(static_cast<int64>(immediate));
+		code += immediateSize;
+	}
+
+	//Without a REX prefix, byte registers 4 to 7 are the high bytes of the first 4 registers
+	if(byteRegOperand && (rex == 0) && (reg >= 4))
+	{
+		access.highByteReg = true;
+		reg -= 4;
+	}
+	access.reg = reg | (((rex & 0x04) != 0) ? 0x08 : 0);
+	access.length = static_cast<uint32>(code - start);
+	return true;
+}
+
+CFastMemoryArena::CFastMemoryArena()
+{
+	//The access thunk saves vector state with XSAVE
+	unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+	if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || ((ecx & bit_OSXSAVE) == 0))
+	{
+		throw std::runtime_error("Fast memory requires XSAVE support.");
+	}
+	void* base = mmap(nullptr, ARENA_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if(base == MAP_FAILED)
+	{
+		throw std::runtime_error("Failed to reserve fast memory region.");
+	}
+	m_base = reinterpret_cast<uint8*>(base);
+}
+
+CFastMemoryArena::~CFastMemoryArena()
+{
+	//Unmapping the whole region also unmaps every view inside of it
+	munmap(m_base, ARENA_SIZE);
+	for(const auto& block : m_blocks)
+	{
+		close(block.fd);
+	}
+}
+
+CFastMemoryArena::ViewArray CFastMemoryArena::MapMemory(uint32 size, const AddressArray& addresses)
+{
+	BLOCK block;
+	block.size = size;
+	block.fd = memfd_create("fastmem", MFD_CLOEXEC);
+	if(block.fd < 0)
+	{
+		throw std::runtime_error("Failed to create fast memory block.");
+	}
+	if(ftruncate(block.fd, size) < 0)
+	{
+		close(block.fd);
+		throw std::runtime_error("Failed to allocate fast memory block.");
+	}
+	for(auto address : addresses)
+	{
+		assert((static_cast<uint64>(address) + size) <= ARENA_SIZE);
+		void* view = mmap(m_base + address, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, block.fd, 0);
+		if(view == MAP_FAILED)
+		{
+			close(block.fd);
+			throw std::runtime_error("Failed to map fast memory block.");
+		}
+		block.views.push_back(reinterpret_cast<uint8*>(view));
+	}
+	m_blocks.push_back(block);
+	return block.views;
+}
+
+bool CFastMemoryArena::RedirectAccess(void* hostContext, CMIPS* context, uint32 address, AccessCompletedCallback callback)
+{
+	auto userContext = reinterpret_cast<ucontext_t*>(hostContext);
+	auto& registers = userContext->uc_mcontext.gregs;
+
+	PENDING_ACCESS pendingAccess;
+	if(!DecodeHostAccess(reinterpret_cast<const uint8*>(registers[REG_RIP]), pendingAccess.access))
+	{
+		return false;
+	}
+	pendingAccess.context = context;
+	pendingAccess.address = address;
+	pendingAccess.resumeAddress = static_cast<uint64>(registers[REG_RIP]) + pendingAccess.access.length;
+	pendingAccess.callback = callback;
+	g_pendingAccess = pendingAccess;
+
+	registers[REG_RIP] = reinterpret_cast<greg_t>(&FastMemoryArena_AccessThunk);
+	return true;
+}
+
+extern "C" void FastMemoryArena_CompleteAccess(uint64* frame)
+{
+	//Proxies can fault again (code invalidation), take everything needed before calling them
+	auto pendingAccess = g_pendingAccess;
+	const auto& access = pendingAccess.access;
+	auto context = pendingAccess.context;
+	auto address = pendingAccess.address;
+
+	uint64& hostRegister = frame[access.reg];
+	uint64 registerValue = hostRegister;
+
+	if(access.isWrite)
+	{
+		uint64 value = access.hasImmediate ? access.immediate : registerValue;
+		if(access.highByteReg)
+		{
+			value >>= 8;
+		}
+		switch(access.size)
+		{
+		case 1:
+			MemoryUtils_SetByteProxy(context, static_cast<uint8>(value), address);
+			break;
+		case 2:
+			MemoryUtils_SetHalfProxy(context, static_cast<uint16>(value), address);
+			break;
+		case 4:
+			MemoryUtils_SetWordProxy(context, static_cast<uint32>(value), address);
+			break;
+		case 8:
+			MemoryUtils_SetDoubleProxy(context, value, address);
+			break;
+		}
+	}
+	else
+	{
+		uint64 value = 0;
+		switch(access.size)
+		{
+		case 1:
+			value = MemoryUtils_GetByteProxy(context, address);
+			if(access.signExtend) value = static_cast<int64>(static_cast<int8>(value));
+			break;
+		case 2:
+			value = MemoryUtils_GetHalfProxy(context, address);
+			if(access.signExtend) value = static_cast<int64>(static_cast<int16>(value));
+			break;
+		case 4:
+			value = MemoryUtils_GetWordProxy(context, address);
+			if(access.signExtend) value = static_cast<int64>(static_cast<int32>(value));
+			break;
+		case 8:
+			value = MemoryUtils_GetDoubleProxy(context, address);
+			break;
+		}
+		switch(access.registerSize)
+		{
+		case 1:
+			if(access.highByteReg)
+			{
+				registerValue = (registerValue & ~0xFF00ULL) | ((value & 0xFF) << 8);
+			}
+			else
+			{
+				registerValue = (registerValue & ~0xFFULL) | (value & 0xFF);
+			}
+			break;
+		case 2:
+			registerValue = (registerValue & ~0xFFFFULL) | (value & 0xFFFF);
+			break;
+		case 4:
+			//32-bit operations clear the upper part of the register
+			registerValue = static_cast<uint32>(value);
+			break;
+		case 8:
+			registerValue = value;
+			break;
+		}
+		hostRegister = registerValue;
+	}
+
+	frame[THUNK_FRAME_RESUME] = pendingAccess.resumeAddress;
+	if(pendingAccess.callback)
+	{
+		pendingAccess.callback(context, address);
+	}
+}
+
+#else
+
+CFastMemoryArena::CFastMemoryArena()
+{
+	throw std::runtime_error("Fast memory is not supported on this platform.");
+}
+
+CFastMemoryArena::~CFastMemoryArena()
+{
+}
+
+CFastMemoryArena::ViewArray CFastMemoryArena::MapMemory(uint32, const AddressArray&)
+{
+	return ViewArray();
+}
+
+bool CFastMemoryArena::RedirectAccess(void*, CMIPS*, uint32, AccessCompletedCallback)
+{
+	return false;
+}
+
+#endif
+
+uint8* CFastMemoryArena::GetBase() const
+{
+	return m_base;
+}
+
+bool CFastMemoryArena::GetGuestAddress(const void* ptr, uint32& address) const
+{
+	if(!m_base) return false;
+	auto offset = reinterpret_cast<const uint8*>(ptr) - m_base;
+	if((offset < 0) || (static_cast<uint64>(offset) >= ARENA_SIZE)) return false;
+	address = static_cast<uint32>(offset);
+	return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include "Types.h"
+
+#if defined(__linux__) && defined(__x86_64__) && !defined(AOT_BUILD_CACHE) && !defined(AOT_USE_CACHE)
+#define FAST_MEMORY_SUPPORTED
+#endif
+
+class CMIPS;
+
+//Host region covering the whole 32-bit guest address space. Guest memory blocks are
+//mapped at their guest addresses (mirrors are aliases of the same backing memory),
+//allowing generated code to access memory with a single load/store relative to the
+//region's base. Everything else is left inaccessible: accesses there fault and are
+//emulated through the guest's memory map by the fault handler.
+class CFastMemoryArena
+{
+public:
+	typedef std::vector<uint32> AddressArray;
+	typedef std::vector<uint8*> ViewArray;
+
+	CFastMemoryArena();
+	virtual ~CFastMemoryArena();
+
+	CFastMemoryArena(const CFastMemoryArena&) = delete;
+	CFastMemoryArena& operator=(const CFastMemoryArena&) = delete;
+
+	//Creates a memory block and maps it at every guest address given, returns a view for each one
+	ViewArray MapMemory(uint32, const AddressArray&);
+
+	uint8* GetBase() const;
+	bool GetGuestAddress(const void*, uint32&) const;
+
+	//Called once a faulting access has been completed, outside of signal context
+	typedef void (*AccessCompletedCallback)(CMIPS*, uint32);
+
+	//Makes the host instruction that faulted inside the region resume in a thunk that
+	//performs the access through the context's memory proxies. Device handlers can't run
+	//in signal context, the thunk only runs once the signal handler has returned. Returns
+	//false if the instruction can't be decoded, in which case the fault must be treated as a crash.
+	static bool RedirectAccess(void*, CMIPS*, uint32, AccessCompletedCallback);
+
+private:
+	struct BLOCK
+	{
+		int fd = -1;
+		uint32 size = 0;
+		ViewArray views;
+	};
+
+	uint8* m_base = nullptr;
+	std::vector<BLOCK> m_blocks;
+};
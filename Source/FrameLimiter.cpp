@@ -6,15 +6,14 @@
 #include <Windows.h>
 #endif
 
+//Sleeping isn't precise enough to hit deadlines, sleep until we're close and spin for the rest
+static const auto g_spinDuration = std::chrono::microseconds(1500);
+
 CFrameLimiter::CFrameLimiter()
 {
 #ifdef _WIN32
 	timeBeginPeriod(1);
 #endif
-	for(uint32 i = 0; i < MAX_FRAMETIMES; i++)
-	{
-		m_frameTimes[i] = std::chrono::microseconds(0);
-	}
 }
 
 CFrameLimiter::~CFrameLimiter()
@@ -27,7 +26,6 @@ CFrameLimiter::~CFrameLimiter()
 void CFrameLimiter::BeginFrame()
 {
 	assert(!m_frameStarted);
-	m_lastFrameTime = std::chrono::high_resolution_clock::now();
 	m_frameStarted = true;
 }
 
@@ -35,48 +33,38 @@ void CFrameLimiter::EndFrame()
 {
 	assert(m_frameStarted);
 
-	//Add current frame time to array
-	{
-		auto currentFrameTime = std::chrono::high_resolution_clock::now();
-		auto frameDuration = std::chrono::duration_cast<std::chrono::microseconds>(currentFrameTime - m_lastFrameTime);
-		m_frameTimes[m_frameTimeIndex++] = frameDuration;
-		m_frameTimeIndex %= MAX_FRAMETIMES;
-	}
-
-	//Compute average frame time
-	std::chrono::microseconds averageFrameTime = std::chrono::microseconds(0);
-	for(uint32 i = 0; i < MAX_FRAMETIMES; i++)
+	auto currentTime = Clock::now();
+	if(m_minFrameDuration.count() == 0)
 	{
-		averageFrameTime += m_frameTimes[i];
+		m_hasFrameDeadline = false;
 	}
-	averageFrameTime /= MAX_FRAMETIMES;
-
-	if(averageFrameTime < m_minFrameDuration)
+	else
 	{
-		auto delay = m_minFrameDuration - averageFrameTime;
-#ifdef _WIN32
+		auto frameDuration = std::chrono::duration_cast<Clock::duration>(m_minFrameDuration * m_frameDurationScale);
+		if(!m_hasFrameDeadline)
 		{
-			LARGE_INTEGER ft = {};
-			ft.QuadPart = -static_cast<int64>(delay.count() * 10);
-
-			HANDLE timer = CreateWaitableTimer(NULL, TRUE, NULL);
-			SetWaitableTimer(timer, &ft, 0, NULL, NULL, 0);
-			WaitForSingleObject(timer, INFINITE);
-			CloseHandle(timer);
+			m_frameDeadline = currentTime;
+			m_hasFrameDeadline = true;
 		}
-#elif defined(__APPLE__)
-		//Sleeping for the whole delay on macOS/iOS doesn't provide a good enough resolution
-		auto currentTime = std::chrono::high_resolution_clock::now();
-		auto targetTime = currentTime + delay;
-		while(currentTime < targetTime)
+		//Keep track of deadlines instead of frame times to avoid accumulating sleep errors
+		m_frameDeadline += frameDuration;
+		if(currentTime > (m_frameDeadline + (frameDuration * MAX_LATE_FRAMES)))
 		{
-			std::this_thread::sleep_for(std::chrono::microseconds(250));
-			currentTime = std::chrono::high_resolution_clock::now();
+			//Too late to catch up, start over from now
+			m_frameDeadline = currentTime;
+		}
+		else
+		{
+			WaitUntil(m_frameDeadline);
+			currentTime = Clock::now();
 		}
-#else
-		std::this_thread::sleep_for(delay);
-#endif
 	}
+
+	if(m_lastFrameEndTime != TimePoint())
+	{
+		m_lastFrameDuration = std::chrono::duration_cast<std::chrono::microseconds>(currentTime - m_lastFrameEndTime);
+	}
+	m_lastFrameEndTime = currentTime;
 	m_frameStarted = false;
 }
 
@@ -90,4 +78,29 @@ void CFrameLimiter::SetFrameRate(uint32 fps)
 	{
 		m_minFrameDuration = std::chrono::microseconds(1000000 / fps);
 	}
+	m_hasFrameDeadline = false;
+}
+
+void CFrameLimiter::SetFrameDurationScale(float frameDurationScale)
+{
+	assert(frameDurationScale > 0);
+	m_frameDurationScale = frameDurationScale;
+}
+
+uint32 CFrameLimiter::GetLastFrameDuration() const
+{
+	return static_cast<uint32>(m_lastFrameDuration.count());
+}
+
+void CFrameLimiter::WaitUntil(const TimePoint& targetTime)
+{
+	auto currentTime = Clock::now();
+	if((targetTime - currentTime) > g_spinDuration)
+	{
+		std::this_thread::sleep_until(targetTime - g_spinDuration);
+	}
+	while(Clock::now() < targetTime)
+	{
+		std::this_thread::yield();
+	}
 }
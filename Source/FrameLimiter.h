@@ -14,18 +14,29 @@ public:
 
 	void SetFrameRate(uint32);
 
+	//Stretches or shrinks the frame duration (ie.: to follow another clock), 1 is nominal
+	void SetFrameDurationScale(float);
+
+	//Time between the last two frame ends, in microseconds
+	uint32 GetLastFrameDuration() const;
+
 private:
-	typedef std::chrono::high_resolution_clock::time_point TimePoint;
+	typedef std::chrono::steady_clock Clock;
+	typedef Clock::time_point TimePoint;
 
 	enum
 	{
-		MAX_FRAMETIMES = 4,
+		//Deadlines that are late by more than this amount of frames are dropped
+		MAX_LATE_FRAMES = 2,
 	};
 
-	std::chrono::microseconds m_frameTimes[MAX_FRAMETIMES];
-	uint32 m_frameTimeIndex = 0;
+	static void WaitUntil(const TimePoint&);
 
 	std::chrono::microseconds m_minFrameDuration = std::chrono::microseconds(0);
+	float m_frameDurationScale = 1.0f;
 	bool m_frameStarted = false;
-	TimePoint m_lastFrameTime;
+	bool m_hasFrameDeadline = false;
+	TimePoint m_frameDeadline;
+	TimePoint m_lastFrameEndTime;
+	std::chrono::microseconds m_lastFrameDuration = std::chrono::microseconds(0);
 };
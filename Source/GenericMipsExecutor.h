@@ -1,8 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <unordered_set>
+#include <unordered_map>
+#include <chrono>
 #include "MIPS.h"
 #include "BasicBlock.h"
+#include "BlockCodeCache.h"
+#include "BlockCompileQueue.h"
+#include "SuperBlock.h"
+#include "xxhash.h"
 
 #include "BlockLookupOneWay.h"
 #include "BlockLookupTwoWay.h"
@@ -32,6 +39,19 @@ public:
 		RECYCLE_NOLINK_THRESHOLD = 16,
 	};
 
+	enum
+	{
+		MAX_SPECULATIVE_BLOCKS = 128,
+		SPECULATION_DEPTH = 2,
+	};
+
+	enum
+	{
+		SUPER_BLOCK_HOTNESS_THRESHOLD = 64,
+		MAX_SUPER_BLOCK_SEGMENTS = 8,
+		MAX_SUPER_BLOCK_INSTRUCTIONS = 512,
+	};
+
 	CGenericMipsExecutor(CMIPS& context, uint32 maxAddress, BLOCK_CATEGORY blockCategory)
 	    : m_emptyBlock(std::make_shared<CBasicBlock>(context, MIPS_INVALID_PC, MIPS_INVALID_PC, blockCategory))
 	    , m_context(context)
@@ -67,6 +87,12 @@ public:
 		{
 			uint32 address = m_context.m_State.nPC & m_addressMask;
 			auto block = m_blockLookup.FindBlockAt(address);
+#ifdef SUPER_BLOCK_SUPPORTED
+			if(m_superBlocksEnabled && (block->CountExecution() == SUPER_BLOCK_HOTNESS_THRESHOLD))
+			{
+				block = FormSuperBlock(block);
+			}
+#endif
 			block->Execute();
 		}
 		m_context.m_State.nHasException &= ~MIPS_EXECUTION_STATUS_QUOTADONE;
@@ -88,8 +114,10 @@ public:
 
 	void Reset() override
 	{
+		DiscardSpeculativeBlocks();
 		m_blockLookup.Clear();
 		m_blocks.clear();
+		m_superBlocks.clear();
 		m_blockOutLinks.clear();
 #ifdef DEBUGGER_INCLUDED
 		m_mustBreak = false;
@@ -107,6 +135,54 @@ public:
 		ClearActiveBlocksInRangeInternal(start, end, currentBlock);
 	}
 
+	void SetBlockCodeCache(std::shared_ptr<CBlockCodeCache> blockCodeCache) override
+	{
+		//Background compiler might be using the current cache
+		std::lock_guard<std::mutex> compileLock(m_compileMutex);
+		m_blockCodeCache.swap(blockCodeCache);
+	}
+
+	void SetBackgroundCompileEnabled(bool enabled) override
+	{
+#ifdef BLOCK_COMPILE_QUEUE_SUPPORTED
+		if(enabled == (m_compileQueue != nullptr)) return;
+		DiscardSpeculativeBlocks();
+		m_compileQueue.reset();
+		if(enabled)
+		{
+			m_compileQueue = std::make_unique<CBlockCompileQueue>();
+		}
+#endif
+	}
+
+	void SetSuperBlocksEnabled(bool enabled) override
+	{
+#ifdef SUPER_BLOCK_SUPPORTED
+		//Super block formation only knows about MIPS branches
+		m_superBlocksEnabled = enabled && (instructionSize == 4);
+#endif
+	}
+
+	BLOCK_COMPILE_STATS GetBlockCompileStats() const override
+	{
+		auto stats = m_compileStats;
+		if(m_compileQueue)
+		{
+			stats.queueDepth = m_compileQueue->GetQueueDepth();
+			stats.maxQueueDepth = m_compileQueue->GetMaxQueueDepth();
+		}
+		return stats;
+	}
+
+	void ResetBlockCompileStats() override
+	{
+		m_compileStats = BLOCK_COMPILE_STATS();
+		if(m_compileQueue)
+		{
+			m_compileQueue->ResetMaxQueueDepth();
+		}
+	}
+
 #ifdef DEBUGGER_INCLUDED
 	bool MustBreak() const override
 	{
@@ -127,6 +203,15 @@ public:
 protected:
 	typedef std::unordered_set<BasicBlockPtr> BlockStore;
 
+	//Block compiled by the background compiler before execution reached it
+	struct SPECULATIVE_BLOCK
+	{
+		BasicBlockPtr block;
+		std::vector<uint32> instructions;
+		CBlockCompileQueue::JobPtr job;
+	};
+	typedef std::unordered_map<uint32, SPECULATIVE_BLOCK> SpeculativeBlockMap;
+
 	bool HasBlockAt(uint32 address) const
 	{
 		auto block = m_blockLookup.FindBlockAt(address);
@@ -137,6 +222,8 @@ protected:
 	{
 		assert(!HasBlockAt(start));
 		auto block = BlockFactory(m_context, start, end);
+		//Speculative block might not have been used by the factory
+		DiscardSpeculativeBlock(start);
 		ResetBlockOutLinks(block.get());
 		m_blockLookup.AddBlock(block.get());
 		m_blocks.insert(std::move(block));
@@ -150,13 +237,325 @@ protected:
 		}
 	}
 
+	virtual BasicBlockPtr MakeBasicBlock(uint32 start, uint32 end)
+	{
+		return std::make_shared<CBasicBlock>(m_context, start, end, m_blockCategory);
+	}
+
 	virtual BasicBlockPtr BlockFactory(CMIPS& context, uint32 start, uint32 end)
 	{
-		auto result = std::make_shared<CBasicBlock>(context, start, end, m_blockCategory);
-		result->Compile();
+		bool hasBreakpoint = context.HasBreakpointInRange(start, end);
+		AOT_BLOCK_KEY blockKey = {};
+		if(!hasBreakpoint && (m_blockCodeCache || m_compileQueue))
+		{
+			uint32 blockSize = (end - start) + 4;
+			std::vector<uint32> blockMemory(blockSize / 4);
+			for(uint32 address = start; address <= end; address += 4)
+			{
+				blockMemory[(address - start) / 4] = context.m_pMemoryMap->GetInstruction(address);
+			}
+			if(auto result = TakeSpeculativeBlock(start, end, blockMemory.data(), blockSize))
+			{
+				return result;
+			}
+			blockKey = MakeBlockKey(blockMemory.data(), blockSize);
+		}
+		auto result = MakeBasicBlock(start, end);
+		CompileBlock(result.get(), blockKey, !hasBreakpoint);
 		return result;
 	}
 
+	//Compiles a block on the emulation thread
+	void CompileBlock(CBasicBlock* block, const AOT_BLOCK_KEY& blockKey, bool useCodeCache)
+	{
+		auto compileStart = std::chrono::steady_clock::now();
+		CompileBlockLocked(block, blockKey, useCodeCache);
+		uint64 compileTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - compileStart).count();
+		m_compileStats.compiledBlockCount++;
+		m_compileStats.compileTime += compileTime;
+		m_compileStats.maxCompileTime = std::max(m_compileStats.maxCompileTime, compileTime);
+		AccumulateConstantStats(block);
+	}
+
+	void AccumulateConstantStats(const CBasicBlock* block)
+	{
+		const auto& constantStats = block->GetConstantStats();
+		m_compileStats.constantFoldedInstructionCount += constantStats.foldedInstructionCount;
+		m_compileStats.constantResolvedAccessCount += constantStats.resolvedAccessCount;
+		m_compileStats.constantHandlerCallCount += constantStats.handlerCallCount;
+	}
+
+	//Instruction compilers keep state while compiling, background compiler
+	//and emulation thread can't compile for the same context at the same time
+	void CompileBlockLocked(CBasicBlock* block, const AOT_BLOCK_KEY& blockKey, bool useCodeCache)
+	{
+		std::lock_guard<std::mutex> compileLock(m_compileMutex);
+		if(useCodeCache && m_blockCodeCache)
+		{
+			block->Compile(*m_blockCodeCache, blockKey);
+		}
+		else
+		{
+			block->Compile();
+		}
+	}
+
+	//Queues blocks that are likely to be executed next to the background compiler
+	void QueueSpeculativeBlock(uint32 startAddress, uint32 depth)
+	{
+		if(!m_compileQueue) return;
+		if(depth == 0) return;
+		startAddress &= m_addressMask;
+		if(HasBlockAt(startAddress)) return;
+		if(m_speculativeBlocks.find(startAddress) != std::end(m_speculativeBlocks)) return;
+		if(m_speculativeBlocks.size() >= MAX_SPECULATIVE_BLOCKS)
+		{
+			//Drop compiled blocks that were never claimed
+			for(auto blockIterator = std::begin(m_speculativeBlocks); blockIterator != std::end(m_speculativeBlocks);)
+			{
+				if(blockIterator->second.job->state == CBlockCompileQueue::JOB_STATE_DONE)
+				{
+					blockIterator = m_speculativeBlocks.erase(blockIterator);
+				}
+				else
+				{
+					blockIterator++;
+				}
+			}
+			if(m_speculativeBlocks.size() >= MAX_SPECULATIVE_BLOCKS) return;
+		}
+
+		auto instructionMap = m_context.m_pMemoryMap->GetInstructionMap(startAddress);
+		if(!instructionMap || (instructionMap->nType != CMemoryMap::MEMORYMAP_TYPE_MEMORY)) return;
+
+		uint32 endAddress = MIPS_INVALID_PC;
+		uint32 branchAddress = MIPS_INVALID_PC;
+		FindBlockRange(startAddress, endAddress, branchAddress);
+		if(m_context.m_pMemoryMap->GetInstructionMap(endAddress) != instructionMap) return;
+		if(m_context.HasBreakpointInRange(startAddress, endAddress)) return;
+
+		uint32 blockSize = (endAddress - startAddress) + 4;
+		SPECULATIVE_BLOCK speculativeBlock;
+		speculativeBlock.instructions.resize(blockSize / 4);
+		for(uint32 address = startAddress; address <= endAddress; address += 4)
+		{
+			speculativeBlock.instructions[(address - startAddress) / 4] = m_context.m_pMemoryMap->GetInstruction(address);
+		}
+		auto blockKey = MakeBlockKey(speculativeBlock.instructions.data(), blockSize);
+		auto block = MakeBasicBlock(startAddress, endAddress);
+		speculativeBlock.block = block;
+		//Block is compiled from the instructions it's keyed and validated with, not from live memory
+		speculativeBlock.job = m_compileQueue->QueueJob(
+		    [this, block, blockKey, instructions = speculativeBlock.instructions]() {
+			    CMemoryMap::CInstructionSnapshotScope instructionSnapshot(block->GetBeginAddress(), instructions);
+			    CompileBlockLocked(block.get(), blockKey, true);
+		    });
+		m_speculativeBlocks.emplace(startAddress, std::move(speculativeBlock));
+
+		QueueSpeculativeBlock(endAddress + 4, depth - 1);
+		if(branchAddress != MIPS_INVALID_PC)
+		{
+			QueueSpeculativeBlock(branchAddress, depth - 1);
+		}
+	}
+
+	//Returns the speculative block compiled for this range, if it's still valid
+	BasicBlockPtr TakeSpeculativeBlock(uint32 start, uint32 end, const void* blockMemory, uint32 blockSize)
+	{
+		auto blockIterator = m_speculativeBlocks.find(start);
+		if(blockIterator == std::end(m_speculativeBlocks)) return BasicBlockPtr();
+
+		auto speculativeBlock = std::move(blockIterator->second);
+		m_speculativeBlocks.erase(blockIterator);
+
+		//Memory might have been modified since the block was queued
+		bool valid = (speculativeBlock.block->GetEndAddress() == end) &&
+		             ((speculativeBlock.instructions.size() * 4) == blockSize) &&
+		             (memcmp(speculativeBlock.instructions.data(), blockMemory, blockSize) == 0);
+		//Jobs that haven't started yet are compiled here instead, it's as fast as waiting for them
+		bool cancelled = m_compileQueue->CancelJob(speculativeBlock.job);
+		if(!valid || cancelled)
+		{
+			return BasicBlockPtr();
+		}
+
+		auto waitStart = std::chrono::steady_clock::now();
+		m_compileQueue->WaitForJob(speculativeBlock.job);
+		uint64 waitTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - waitStart).count();
+		assert(speculativeBlock.job->state == CBlockCompileQueue::JOB_STATE_DONE);
+		assert(speculativeBlock.block->IsCompiled());
+
+		uint64 latency = speculativeBlock.job->latency;
+		m_compileStats.backgroundCompiledBlockCount++;
+		m_compileStats.compileTime += waitTime;
+		m_compileStats.maxCompileTime = std::max(m_compileStats.maxCompileTime, waitTime);
+		m_compileStats.backgroundLatency += latency;
+		m_compileStats.maxBackgroundLatency = std::max(m_compileStats.maxBackgroundLatency, latency);
+		AccumulateConstantStats(speculativeBlock.block.get());
+
+		return speculativeBlock.block;
+	}
+
+	//Stitches the chain of blocks usually executed after a hot block into a super block
+	CBasicBlock* FormSuperBlock(CBasicBlock* headBlock)
+	{
+		if(headBlock->IsEmpty()) return headBlock;
+		if(m_superBlocks.count(headBlock)) return headBlock;
+
+		CSuperBlock::SegmentArray segments;
+		uint32 instructionCount = 0;
+		uint32 address = headBlock->GetBeginAddress();
+		while(segments.size() < MAX_SUPER_BLOCK_SEGMENTS)
+		{
+			auto block = m_blockLookup.FindBlockAt(address);
+			if(block->IsEmpty()) break;
+			if(m_superBlocks.count(block)) break;
+			if(block->GetRecycleCount() >= RECYCLE_NOLINK_THRESHOLD) break;
+			if(m_context.HasBreakpointInRange(block->GetBeginAddress(), block->GetEndAddress())) break;
+			instructionCount += ((block->GetEndAddress() - block->GetBeginAddress()) / 4) + 1;
+			if(instructionCount > MAX_SUPER_BLOCK_INSTRUCTIONS) break;
+
+			CSuperBlock::SEGMENT segment;
+			segment.begin = block->GetBeginAddress();
+			segment.end = block->GetEndAddress();
+			segment.block = block->shared_from_this();
+			bool canContinue = GetSuperBlockSegmentSuccessor(segment, address);
+			segments.push_back(segment);
+			if(!canContinue) break;
+			if(address == headBlock->GetBeginAddress()) break;
+
+			//Don't go through the same block twice
+			bool visited = std::any_of(std::begin(segments), std::end(segments),
+			                           [address](const CSuperBlock::SEGMENT& segment) { return segment.begin == address; });
+			if(visited) break;
+		}
+
+		if(segments.size() < 2) return headBlock;
+
+		uint32 endAddress = segments.back().end;
+		uint32 branchAddress = segments.back().branchAddress;
+		bool fastMemoryEnabled = std::all_of(std::begin(segments), std::end(segments),
+		                                     [](const CSuperBlock::SEGMENT& segment) { return segment.block->IsFastMemoryEnabled(); });
+		auto superBlock = std::make_shared<CSuperBlock>(m_context, std::move(segments), m_blockCategory);
+		superBlock->SetFastMemoryEnabled(fastMemoryEnabled);
+		CompileBlock(superBlock.get(), AOT_BLOCK_KEY(), false);
+		m_compileStats.superBlockCount++;
+
+		//Replace head block by the super block and redirect links that were going to the head block
+		uint32 headAddress = headBlock->GetBeginAddress();
+		m_blockLookup.DeleteBlock(headBlock);
+		OrphanBlock(headBlock);
+		UnlinkIncomingLinks(headAddress);
+		m_blocks.erase(headBlock->shared_from_this());
+
+		ResetBlockOutLinks(superBlock.get());
+		m_blockLookup.AddBlock(superBlock.get());
+		m_superBlocks.insert(superBlock.get());
+		m_blocks.insert(superBlock);
+		SetupBlockLinks(headAddress, endAddress, branchAddress);
+
+		return superBlock.get();
+	}
+
+	//Finds out where execution is most likely to go after a segment. Returns false if the super block can't be extended.
+	bool GetSuperBlockSegmentSuccessor(CSuperBlock::SEGMENT& segment, uint32& nextAddress)
+	{
+		uint32 endOpcode = m_context.m_pMemoryMap->GetInstruction(segment.end);
+		if(m_context.m_pArch->IsInstructionBranch(&m_context, segment.end, endOpcode) != MIPS_BRANCH_NONE)
+		{
+			//Syscalls, exception returns or branch without its delay slot
+			return false;
+		}
+
+		nextAddress = (segment.end + 4) & m_addressMask;
+		if(segment.begin == segment.end) return true;
+
+		uint32 branchInstAddr = segment.end - 4;
+		uint32 branchOpcode = m_context.m_pMemoryMap->GetInstruction(branchInstAddr);
+		if(m_context.m_pArch->IsInstructionBranch(&m_context, branchInstAddr, branchOpcode) != MIPS_BRANCH_NORMAL)
+		{
+			return true;
+		}
+
+		uint32 branchAddress = m_context.m_pArch->GetInstructionEffectiveAddress(&m_context, branchInstAddr, branchOpcode);
+		segment.branchAddress = branchAddress;
+		//Unknown target (register jumps) or branch likely skipping its delay slot
+		if(branchAddress == MIPS_INVALID_PC) return false;
+		if(IsBranchLikely(branchOpcode)) return false;
+		if(branchAddress == nextAddress) return false;
+
+		//Assume backward branches are loops and forward branches aren't taken
+		segment.branchTaken = IsUnconditionalBranch(branchOpcode) || (branchAddress <= segment.begin);
+		if(segment.branchTaken)
+		{
+			nextAddress = branchAddress & m_addressMask;
+		}
+		return true;
+	}
+
+	static bool IsBranchLikely(uint32 opcode)
+	{
+		uint32 op = (opcode >> 26) & 0x3F;
+		uint32 rs = (opcode >> 21) & 0x1F;
+		uint32 rt = (opcode >> 16) & 0x1F;
+		switch(op)
+		{
+		case 0x01:
+			//REGIMM: BLTZL, BGEZL, BLTZALL, BGEZALL
+			return (rt & 0x0E) == 0x02;
+		case 0x10:
+		case 0x11:
+		case 0x12:
+			//COPz: BCzFL, BCzTL
+			return (rs == 0x08) && ((rt & 0x02) != 0);
+		case 0x14:
+		case 0x15:
+		case 0x16:
+		case 0x17:
+			//BEQL, BNEL, BLEZL, BGTZL
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	static bool IsUnconditionalBranch(uint32 opcode)
+	{
+		uint32 op = (opcode >> 26) & 0x3F;
+		uint32 rs = (opcode >> 21) & 0x1F;
+		uint32 rt = (opcode >> 16) & 0x1F;
+		//J, JAL, BEQ with identical registers
+		return (op == 0x02) || (op == 0x03) || ((op == 0x04) && (rs == rt));
+	}
+
+	void DiscardSpeculativeBlock(uint32 start)
+	{
+		auto blockIterator = m_speculativeBlocks.find(start);
+		if(blockIterator == std::end(m_speculativeBlocks)) return;
+		m_compileQueue->CancelJob(blockIterator->second.job);
+		m_speculativeBlocks.erase(blockIterator);
+	}
+
+	void DiscardSpeculativeBlocks()
+	{
+		for(const auto& speculativeBlockPair : m_speculativeBlocks)
+		{
+			m_compileQueue->CancelJob(speculativeBlockPair.second.job);
+		}
+		m_speculativeBlocks.clear();
+	}
+
+	AOT_BLOCK_KEY MakeBlockKey(const void* blockMemory, uint32 blockSize) const
+	{
+		auto xxHash = XXH3_128bits(blockMemory, blockSize);
+		AOT_BLOCK_KEY key = {};
+		key.category = m_blockCategory;
+		memcpy(&key.hash, &xxHash, sizeof(xxHash));
+		static_assert(sizeof(key.hash) == sizeof(xxHash));
+		key.size = blockSize;
+		return key;
+	}
+
 	void SetupBlockLinks(uint32 startAddress, uint32 endAddress, uint32 branchAddress)
 	{
 		auto block = m_blockLookup.FindBlockAt(startAddress);
@@ -210,10 +609,10 @@ protected:
 		}
 	}
 
-	virtual void PartitionFunction(uint32 startAddress)
+	void FindBlockRange(uint32 startAddress, uint32& endAddress, uint32& branchAddress)
 	{
-		uint32 endAddress = startAddress + MAX_BLOCK_SIZE;
-		uint32 branchAddress = MIPS_INVALID_PC;
+		endAddress = startAddress + MAX_BLOCK_SIZE;
+		branchAddress = MIPS_INVALID_PC;
 		for(uint32 address = startAddress; address < endAddress; address += 4)
 		{
 			uint32 opcode = m_context.m_pMemoryMap->GetInstruction(address);
@@ -242,6 +641,13 @@ protected:
 			}
 		}
 		assert((endAddress - startAddress) <= MAX_BLOCK_SIZE);
+	}
+
+	virtual void PartitionFunction(uint32 startAddress)
+	{
+		uint32 endAddress = MIPS_INVALID_PC;
+		uint32 branchAddress = MIPS_INVALID_PC;
+		FindBlockRange(startAddress, endAddress, branchAddress);
 		assert(endAddress <= m_maxAddress);
 		CreateBlock(startAddress, endAddress);
 		auto block = FindBlockStartingAt(startAddress);
@@ -249,6 +655,14 @@ protected:
 		{
 			SetupBlockLinks(startAddress, endAddress, branchAddress);
 		}
+		if(m_compileQueue)
+		{
+			QueueSpeculativeBlock(endAddress + 4, SPECULATION_DEPTH);
+			if(branchAddress != MIPS_INVALID_PC)
+			{
+				QueueSpeculativeBlock(branchAddress, SPECULATION_DEPTH);
+			}
+		}
 	}
 
 	//Unlink and removes block from all of our bookkeeping structures
@@ -289,6 +703,15 @@ protected:
 			m_blockLookup.DeleteBlock(block);
 		}
 
+		//Super blocks can span code outside of the scanned range
+		for(auto* superBlock : m_superBlocks)
+		{
+			if(superBlock == protectedBlock) continue;
+			if(!static_cast<CSuperBlock*>(superBlock)->OverlapsRange(start, end)) continue;
+			if(!clearedBlocks.insert(superBlock).second) continue;
+			m_blockLookup.DeleteBlock(superBlock);
+		}
+
 		//Remove pending block link entries for the blocks that are about to be cleared
 		for(auto& block : clearedBlocks)
 		{
@@ -298,25 +721,32 @@ protected:
 		//Undo all stale links
 		for(auto& block : clearedBlocks)
 		{
-			auto lowerBound = m_blockOutLinks.lower_bound(block->GetBeginAddress());
-			auto upperBound = m_blockOutLinks.upper_bound(block->GetBeginAddress());
-			for(auto blockLinkIterator = lowerBound; blockLinkIterator != upperBound; blockLinkIterator++)
-			{
-				auto& blockLink = blockLinkIterator->second;
-				if(!blockLink.live) continue;
-				auto referringBlock = m_blockLookup.FindBlockAt(blockLink.srcAddress);
-				if(referringBlock->IsEmpty()) continue;
-				referringBlock->UnlinkBlock(blockLink.slot);
-				blockLink.live = false;
-			}
+			UnlinkIncomingLinks(block->GetBeginAddress());
 		}
 
 		for(auto* clearedBlock : clearedBlocks)
 		{
+			m_superBlocks.erase(clearedBlock);
 			m_blocks.erase(clearedBlock->shared_from_this());
 		}
 	}
 
+	//Undo links made to the block starting at address
+	void UnlinkIncomingLinks(uint32 address)
+	{
+		auto lowerBound = m_blockOutLinks.lower_bound(address);
+		auto upperBound = m_blockOutLinks.upper_bound(address);
+		for(auto blockLinkIterator = lowerBound; blockLinkIterator != upperBound; blockLinkIterator++)
+		{
+			auto& blockLink = blockLinkIterator->second;
+			if(!blockLink.live) continue;
+			auto referringBlock = m_blockLookup.FindBlockAt(blockLink.srcAddress);
+			if(referringBlock->IsEmpty()) continue;
+			referringBlock->UnlinkBlock(blockLink.slot);
+			blockLink.live = false;
+		}
+	}
+
 	BlockStore m_blocks;
 	BasicBlockPtr m_emptyBlock;
 	BlockOutLinkMap m_blockOutLinks;
@@ -324,6 +754,7 @@ protected:
 	uint32 m_maxAddress = 0;
 	uint32 m_addressMask = 0;
 	BLOCK_CATEGORY m_blockCategory = BLOCK_CATEGORY_UNKNOWN;
+	std::shared_ptr<CBlockCodeCache> m_blockCodeCache;
 
 	BlockLookupType m_blockLookup;
 
@@ -332,4 +763,14 @@ protected:
 	bool m_breakpointsDisabledOnce = false;
 	int m_initQuota = 0;
 #endif
+
+	std::unordered_set<CBasicBlock*> m_superBlocks;
+	bool m_superBlocksEnabled = false;
+
+	std::mutex m_compileMutex;
+	BLOCK_COMPILE_STATS m_compileStats;
+	SpeculativeBlockMap m_speculativeBlocks;
+
+	//Declared last so that the worker thread is stopped before the rest of the executor goes away
+	std::unique_ptr<CBlockCompileQueue> m_compileQueue;
 };
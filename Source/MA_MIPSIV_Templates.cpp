@@ -94,6 +94,31 @@ void CMA_MIPSIV::Template_Load32Idx(const MemoryAccessIdxTraits& traits)
 		    m_codeGen->PullRel(offsetof(CMIPS, m_State.nGPR[m_nRT].nV[0]));
 	    };
 
+	uint32 handlerAddress = 0;
+	if(auto handlerElement = GetStaticHandlerAccess(false, handlerAddress))
+	{
+		CallStaticReadHandler(handlerElement, handlerAddress, traits.elementSize);
+		finishLoad();
+		return;
+	}
+
+	if((m_pCtx->m_fastMemoryBase != nullptr) && m_codeGen->IsFastMemoryEnabled())
+	{
+		ComputeFastMemAccessRefIdx(traits.elementSize);
+		((m_codeGen)->*(traits.loadFunction))(1);
+		finishLoad();
+		return;
+	}
+
+	uint32 staticAddress = 0;
+	if(GetStaticMemAccessAddress(staticAddress))
+	{
+		ComputeStaticMemAccessRefIdx(staticAddress, traits.elementSize);
+		((m_codeGen)->*(traits.loadFunction))(1);
+		finishLoad();
+		return;
+	}
+
 	bool usePageLookup = (m_pCtx->m_pageLookup != nullptr);
 
 	if(usePageLookup)
@@ -133,6 +158,30 @@ void CMA_MIPSIV::Template_Store32Idx(const MemoryAccessIdxTraits& traits)
 {
 	CheckTLBExceptions(true);
 
+	uint32 handlerAddress = 0;
+	if(auto handlerElement = GetStaticHandlerAccess(true, handlerAddress))
+	{
+		CallStaticWriteHandler(handlerElement, handlerAddress, traits.elementSize);
+		return;
+	}
+
+	if((m_pCtx->m_fastMemoryBase != nullptr) && m_codeGen->IsFastMemoryEnabled())
+	{
+		ComputeFastMemAccessRefIdx(traits.elementSize);
+		m_codeGen->PushRel(offsetof(CMIPS, m_State.nGPR[m_nRT].nV[0]));
+		((m_codeGen)->*(traits.storeFunction))(1);
+		return;
+	}
+
+	uint32 staticAddress = 0;
+	if(GetStaticMemAccessAddress(staticAddress))
+	{
+		ComputeStaticMemAccessRefIdx(staticAddress, traits.elementSize);
+		m_codeGen->PushRel(offsetof(CMIPS, m_State.nGPR[m_nRT].nV[0]));
+		((m_codeGen)->*(traits.storeFunction))(1);
+		return;
+	}
+
 	bool usePageLookup = (m_pCtx->m_pageLookup != nullptr);
 
 	if(usePageLookup)
@@ -157,6 +157,8 @@ public:
 
 	void* m_vuMem = nullptr;
 	void** m_pageLookup = nullptr;
+	//Base of a host region mirroring the guest address space, enables direct memory accesses in generated code
+	uint8* m_fastMemoryBase = nullptr;
 
 	std::function<void(CMIPS*)> m_emptyBlockHandler;
 
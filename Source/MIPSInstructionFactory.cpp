@@ -166,6 +166,115 @@ void CMIPSInstructionFactory::ComputeMemAccessPageRef()
 	m_codeGen->LoadRefFromRefIdx();
 }
 
+void CMIPSInstructionFactory::ComputeFastMemAccessRefIdx(uint32 accessSize)
+{
+	auto rs = static_cast<uint8>((m_nOpcode >> 21) & 0x001F);
+	auto immediate = static_cast<uint16>((m_nOpcode >> 0) & 0xFFFF);
+
+	//Whole address space is mirrored from the base, unmapped areas fault and get emulated
+	m_codeGen->PushRelRef(offsetof(CMIPS, m_fastMemoryBase));
+
+	m_codeGen->PushRel(offsetof(CMIPS, m_State.nGPR[rs].nV[0]));
+	m_codeGen->PushCst(static_cast<int16>(immediate));
+	m_codeGen->Add();
+	m_codeGen->PushCst(~(accessSize - 1));
+	m_codeGen->And();
+}
+
+//Checks if the address of a memory access is known at compile time and lands in a mapped page
+bool CMIPSInstructionFactory::GetStaticMemAccessAddress(uint32& address)
+{
+	if(m_pCtx->m_pageLookup == nullptr) return false;
+
+	auto rs = static_cast<uint8>((m_nOpcode >> 21) & 0x001F);
+	auto immediate = static_cast<int16>((m_nOpcode >> 0) & 0xFFFF);
+	uint32 baseValue = 0;
+	if(!m_codeGen->GetKnownGprValue(rs, baseValue)) return false;
+
+	address = baseValue + immediate;
+	return m_pCtx->m_pageLookup[address / MIPS_PAGE_SIZE] != nullptr;
+}
+
+void CMIPSInstructionFactory::ComputeStaticMemAccessRefIdx(uint32 address, uint32 accessSize)
+{
+	//Page table doesn't change after setup, the page is guaranteed to be mapped
+	m_codeGen->PushRelRef(offsetof(CMIPS, m_pageLookup));
+	m_codeGen->PushCst(address / MIPS_PAGE_SIZE);
+	m_codeGen->LoadRefFromRefIdx();
+
+	m_codeGen->PushCst(address & (MIPS_PAGE_SIZE - accessSize));
+	m_codeGen->NotifyMemoryAccessResolved();
+}
+
+//Checks if the address of a memory access is known at compile time and lands on a
+//hardware register range served by a plain function handler. Returns the physical address.
+const CMemoryMap::MEMORYMAPELEMENT* CMIPSInstructionFactory::GetStaticHandlerAccess(bool isWrite, uint32& address)
+{
+#ifdef AOT_BUILD_CACHE
+	//Handler contexts are host pointers, they can't be saved in the cache
+	return nullptr;
+#else
+	auto rs = static_cast<uint8>((m_nOpcode >> 21) & 0x001F);
+	auto immediate = static_cast<int16>((m_nOpcode >> 0) & 0xFFFF);
+	uint32 baseValue = 0;
+	if(!m_codeGen->GetKnownGprValue(rs, baseValue)) return nullptr;
+
+	uint32 vAddress = baseValue + immediate;
+	if((m_pCtx->m_pageLookup != nullptr) && (m_pCtx->m_pageLookup[vAddress / MIPS_PAGE_SIZE] != nullptr)) return nullptr;
+
+	//Translation must not depend on state that can change after compilation. The first
+	//512MB of the address space are never remapped, whatever translator is in use.
+	if(m_pCtx->m_pAddrTranslator == &CMIPS::TranslateAddress64)
+	{
+		address = CMIPS::TranslateAddress64(m_pCtx, vAddress);
+	}
+	else if(vAddress <= 0x1FFFFFFF)
+	{
+		address = vAddress;
+	}
+	else
+	{
+		return nullptr;
+	}
+
+	auto element = isWrite ? m_pCtx->m_pMemoryMap->GetWriteMap(address) : m_pCtx->m_pMemoryMap->GetReadMap(address);
+	if(!element || (element->nType != CMemoryMap::MEMORYMAP_TYPE_FUNCTION) || !element->handlerFunction) return nullptr;
+	return element;
+#endif
+}
+
+//Calls the handler with the physical address, pushes the result truncated to the access size
+void CMIPSInstructionFactory::CallStaticReadHandler(const CMemoryMap::MEMORYMAPELEMENT* element, uint32 address, uint32 accessSize)
+{
+	m_codeGen->PushHostPointer(element->handlerContext);
+	m_codeGen->PushCst(address);
+	m_codeGen->PushCst(0);
+	m_codeGen->Call(reinterpret_cast<void*>(element->handlerFunction), 3, Jitter::CJitter::RETURN_VALUE_32);
+	if(accessSize < 4)
+	{
+		m_codeGen->PushCst((1 << (accessSize * 8)) - 1);
+		m_codeGen->And();
+	}
+	m_codeGen->NotifyHandlerCallResolved();
+}
+
+void CMIPSInstructionFactory::CallStaticWriteHandler(const CMemoryMap::MEMORYMAPELEMENT* element, uint32 address, uint32 accessSize)
+{
+	auto rt = static_cast<uint8>((m_nOpcode >> 16) & 0x001F);
+
+	m_codeGen->PushHostPointer(element->handlerContext);
+	m_codeGen->PushCst(address);
+	m_codeGen->PushRel(offsetof(CMIPS, m_State.nGPR[rt].nV[0]));
+	if(accessSize < 4)
+	{
+		m_codeGen->PushCst((1 << (accessSize * 8)) - 1);
+		m_codeGen->And();
+	}
+	m_codeGen->Call(reinterpret_cast<void*>(element->handlerFunction), 3, Jitter::CJitter::RETURN_VALUE_32);
+	m_codeGen->PullTop();
+	m_codeGen->NotifyHandlerCallResolved();
+}
+
 void CMIPSInstructionFactory::Branch(Jitter::CONDITION condition)
 {
 	uint16 nImmediate = (uint16)(m_nOpcode & 0xFFFF);
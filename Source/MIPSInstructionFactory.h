@@ -2,6 +2,7 @@
 
 #include "Types.h"
 #include "MipsJitter.h"
+#include "MemoryMap.h"
 
 class CMIPS;
 
@@ -32,6 +33,12 @@ protected:
 	void ComputeMemAccessRef(uint32);
 	void ComputeMemAccessRefIdx(uint32);
 	void ComputeMemAccessPageRef();
+	void ComputeFastMemAccessRefIdx(uint32);
+	bool GetStaticMemAccessAddress(uint32&);
+	void ComputeStaticMemAccessRefIdx(uint32, uint32);
+	const CMemoryMap::MEMORYMAPELEMENT* GetStaticHandlerAccess(bool, uint32&);
+	void CallStaticReadHandler(const CMemoryMap::MEMORYMAPELEMENT*, uint32, uint32);
+	void CallStaticWriteHandler(const CMemoryMap::MEMORYMAPELEMENT*, uint32, uint32);
 
 	void CheckTLBExceptions(bool);
 	void CheckTrap();
@@ -8,30 +8,49 @@ void CMemoryMap::InsertReadMap(uint32 start, uint32 end, void* pointer, unsigned
 {
 	assert(GetReadMap(start) == nullptr);
 	InsertMap(m_readMap, start, end, pointer, key);
+	UpdateLookup(m_readMap, m_readLookup, start, end);
 }
 
 void CMemoryMap::InsertReadMap(uint32 start, uint32 end, const MemoryMapHandlerType& handler, unsigned char key)
 {
 	assert(GetReadMap(start) == nullptr);
 	InsertMap(m_readMap, start, end, handler, key);
+	UpdateLookup(m_readMap, m_readLookup, start, end);
+}
+
+void CMemoryMap::InsertReadMap(uint32 start, uint32 end, MemoryMapHandlerFunctionType handlerFunction, void* handlerContext, unsigned char key)
+{
+	assert(GetReadMap(start) == nullptr);
+	InsertMap(m_readMap, start, end, handlerFunction, handlerContext, key);
+	UpdateLookup(m_readMap, m_readLookup, start, end);
 }
 
 void CMemoryMap::InsertWriteMap(uint32 start, uint32 end, void* pointer, unsigned char key)
 {
 	assert(GetWriteMap(start) == nullptr);
 	InsertMap(m_writeMap, start, end, pointer, key);
+	UpdateLookup(m_writeMap, m_writeLookup, start, end);
 }
 
 void CMemoryMap::InsertWriteMap(uint32 start, uint32 end, const MemoryMapHandlerType& handler, unsigned char key)
 {
 	assert(GetWriteMap(start) == nullptr);
 	InsertMap(m_writeMap, start, end, handler, key);
+	UpdateLookup(m_writeMap, m_writeLookup, start, end);
+}
+
+void CMemoryMap::InsertWriteMap(uint32 start, uint32 end, MemoryMapHandlerFunctionType handlerFunction, void* handlerContext, unsigned char key)
+{
+	assert(GetWriteMap(start) == nullptr);
+	InsertMap(m_writeMap, start, end, handlerFunction, handlerContext, key);
+	UpdateLookup(m_writeMap, m_writeLookup, start, end);
 }
 
 void CMemoryMap::InsertInstructionMap(uint32 start, uint32 end, void* pointer, unsigned char key)
 {
-	assert(GetMap(m_instructionMap, start) == nullptr);
+	assert(GetInstructionMap(start) == nullptr);
 	InsertMap(m_instructionMap, start, end, pointer, key);
+	UpdateLookup(m_instructionMap, m_instructionLookup, start, end);
 }
 
 const CMemoryMap::MemoryMapListType& CMemoryMap::GetInstructionMaps()
@@ -41,17 +60,17 @@ const CMemoryMap::MemoryMapListType& CMemoryMap::GetInstructionMaps()
 
 const CMemoryMap::MEMORYMAPELEMENT* CMemoryMap::GetReadMap(uint32 address) const
 {
-	return GetMap(m_readMap, address);
+	return GetMap(m_readMap, m_readLookup, address);
 }
 
 const CMemoryMap::MEMORYMAPELEMENT* CMemoryMap::GetWriteMap(uint32 address) const
 {
-	return GetMap(m_writeMap, address);
+	return GetMap(m_writeMap, m_writeLookup, address);
 }
 
 const CMemoryMap::MEMORYMAPELEMENT* CMemoryMap::GetInstructionMap(uint32 address) const
 {
-	return GetMap(m_instructionMap, address);
+	return GetMap(m_instructionMap, m_instructionLookup, address);
 }
 
 void CMemoryMap::InsertMap(MemoryMapListType& memoryMap, uint32 start, uint32 end, void* pointer, unsigned char key)
@@ -75,7 +94,71 @@ void CMemoryMap::InsertMap(MemoryMapListType& memoryMap, uint32 start, uint32 en
 	memoryMap.push_back(element);
 }
 
-const CMemoryMap::MEMORYMAPELEMENT* CMemoryMap::GetMap(const MemoryMapListType& memoryMap, uint32 nAddress)
+void CMemoryMap::InsertMap(MemoryMapListType& memoryMap, uint32 start, uint32 end, MemoryMapHandlerFunctionType handlerFunction, void* handlerContext, unsigned char key)
+{
+	MEMORYMAPELEMENT element;
+	element.nStart = start;
+	element.nEnd = end;
+	element.handlerFunction = handlerFunction;
+	element.handlerContext = handlerContext;
+	element.pPointer = nullptr;
+	element.nType = MEMORYMAP_TYPE_FUNCTION;
+	memoryMap.push_back(element);
+}
+
+void CMemoryMap::UpdateLookup(const MemoryMapListType& memoryMap, MapLookupType& lookup, uint32 start, uint32 end)
+{
+	uint32 startPage = start >> LOOKUP_PAGE_BITS;
+	uint32 endPage = end >> LOOKUP_PAGE_BITS;
+	for(uint32 page = startPage; page <= endPage; page++)
+	{
+		uint32 pageStart = page << LOOKUP_PAGE_BITS;
+		uint32 pageEnd = pageStart + ((1 << LOOKUP_PAGE_BITS) - 1);
+		auto& region = lookup[pageStart >> LOOKUP_REGION_BITS];
+		if(!region)
+		{
+			region = std::make_unique<LookupRegion>();
+			region->fill(LOOKUP_ENTRY_NONE);
+		}
+		(*region)[page & (LOOKUP_PAGES_PER_REGION - 1)] = MakeLookupEntry(memoryMap, pageStart, pageEnd);
+	}
+}
+
+uint8 CMemoryMap::MakeLookupEntry(const MemoryMapListType& memoryMap, uint32 pageStart, uint32 pageEnd)
+{
+	//Scan results only change at element boundaries. The page gets a single entry if the scan
+	//finds the same element at its start and at every boundary of every element falling inside it.
+	auto element = ScanMap(memoryMap, pageStart);
+	for(const auto& mapElement : memoryMap)
+	{
+		for(uint32 boundary : {mapElement.nStart, mapElement.nEnd + 1})
+		{
+			if((boundary <= pageStart) || (boundary > pageEnd)) continue;
+			if(ScanMap(memoryMap, boundary) != element) return LOOKUP_ENTRY_MIXED;
+		}
+	}
+	if(!element) return LOOKUP_ENTRY_NONE;
+	size_t elementIndex = element - memoryMap.data();
+	return (elementIndex < (LOOKUP_ENTRY_MIXED - 1)) ? static_cast<uint8>(elementIndex + 1) : LOOKUP_ENTRY_MIXED;
+}
+
+const CMemoryMap::MEMORYMAPELEMENT* CMemoryMap::GetMap(const MemoryMapListType& memoryMap, const MapLookupType& lookup, uint32 address)
+{
+	const auto& region = lookup[address >> LOOKUP_REGION_BITS];
+	if(!region) return nullptr;
+	uint8 entry = (*region)[(address >> LOOKUP_PAGE_BITS) & (LOOKUP_PAGES_PER_REGION - 1)];
+	switch(entry)
+	{
+	case LOOKUP_ENTRY_NONE:
+		return nullptr;
+	case LOOKUP_ENTRY_MIXED:
+		return ScanMap(memoryMap, address);
+	default:
+		return &memoryMap[entry - 1];
+	}
+}
+
+const CMemoryMap::MEMORYMAPELEMENT* CMemoryMap::ScanMap(const MemoryMapListType& memoryMap, uint32 nAddress)
 {
 	for(const auto& mapElement : memoryMap)
 	{
@@ -90,7 +173,7 @@ const CMemoryMap::MEMORYMAPELEMENT* CMemoryMap::GetMap(const MemoryMapListType&
 
 uint8 CMemoryMap::GetByte(uint32 nAddress)
 {
-	const auto e = GetMap(m_readMap, nAddress);
+	const auto e = GetReadMap(nAddress);
 	if(!e)
 	{
 		CLog::GetInstance().Print(LOG_NAME, "Read byte from unmapped memory (0x%08X).\r\n", nAddress);
@@ -102,7 +185,7 @@ uint8 CMemoryMap::GetByte(uint32 nAddress)
 		return *(uint8*)&((uint8*)e->pPointer)[nAddress - e->nStart];
 		break;
 	case MEMORYMAP_TYPE_FUNCTION:
-		return static_cast<uint8>(e->handler(nAddress, 0));
+		return static_cast<uint8>(e->CallHandler(nAddress, 0));
 		break;
 	default:
 		assert(0);
@@ -113,7 +196,7 @@ uint8 CMemoryMap::GetByte(uint32 nAddress)
 
 void CMemoryMap::SetByte(uint32 nAddress, uint8 nValue)
 {
-	const auto e = GetMap(m_writeMap, nAddress);
+	const auto e = GetWriteMap(nAddress);
 	if(!e)
 	{
 		CLog::GetInstance().Print(LOG_NAME, "Wrote byte to unmapped memory (0x%08X, 0x%02X).\r\n", nAddress, nValue);
@@ -125,7 +208,7 @@ void CMemoryMap::SetByte(uint32 nAddress, uint8 nValue)
 		*(uint8*)&((uint8*)e->pPointer)[nAddress - e->nStart] = nValue;
 		break;
 	case MEMORYMAP_TYPE_FUNCTION:
-		e->handler(nAddress, nValue);
+		e->CallHandler(nAddress, nValue);
 		break;
 	default:
 		assert(0);
@@ -133,6 +216,32 @@ void CMemoryMap::SetByte(uint32 nAddress, uint8 nValue)
 	}
 }
 
+static thread_local CMemoryMap::CInstructionSnapshotScope* g_instructionSnapshot = nullptr;
+
+CMemoryMap::CInstructionSnapshotScope::CInstructionSnapshotScope(uint32 start, const std::vector<uint32>& instructions)
+    : m_start(start)
+    , m_instructions(instructions)
+    , m_previous(g_instructionSnapshot)
+{
+	g_instructionSnapshot = this;
+}
+
+CMemoryMap::CInstructionSnapshotScope::~CInstructionSnapshotScope()
+{
+	assert(g_instructionSnapshot == this);
+	g_instructionSnapshot = m_previous;
+}
+
+bool CMemoryMap::CInstructionSnapshotScope::GetInstruction(uint32 address, uint32& instruction)
+{
+	auto snapshot = g_instructionSnapshot;
+	if(!snapshot) return false;
+	uint32 index = (address - snapshot->m_start) / 4;
+	if((address < snapshot->m_start) || (index >= snapshot->m_instructions.size())) return false;
+	instruction = snapshot->m_instructions[index];
+	return true;
+}
+
 //////////////////////////////////////////////////////////////////
 //LSB First Memory Map Implementation
 //////////////////////////////////////////////////////////////////
@@ -140,7 +249,7 @@ void CMemoryMap::SetByte(uint32 nAddress, uint8 nValue)
 uint16 CMemoryMap_LSBF::GetHalf(uint32 nAddress)
 {
 	assert((nAddress & 0x01) == 0);
-	const auto e = GetMap(m_readMap, nAddress);
+	const auto e = GetReadMap(nAddress);
 	if(!e)
 	{
 		CLog::GetInstance().Print(LOG_NAME, "Read half from unmapped memory (0x%08X).\r\n", nAddress);
@@ -152,7 +261,7 @@ uint16 CMemoryMap_LSBF::GetHalf(uint32 nAddress)
 		return *(uint16*)&((uint8*)e->pPointer)[nAddress - e->nStart];
 		break;
 	default:
-		return static_cast<uint16>(e->handler(nAddress, 0));
+		return static_cast<uint16>(e->CallHandler(nAddress, 0));
 		break;
 	}
 }
@@ -160,7 +269,7 @@ uint16 CMemoryMap_LSBF::GetHalf(uint32 nAddress)
 uint32 CMemoryMap_LSBF::GetWord(uint32 nAddress)
 {
 	assert((nAddress & 0x03) == 0);
-	const auto e = GetMap(m_readMap, nAddress);
+	const auto e = GetReadMap(nAddress);
 	if(!e)
 	{
 		CLog::GetInstance().Print(LOG_NAME, "Read word from unmapped memory (0x%08X).\r\n", nAddress);
@@ -172,7 +281,7 @@ uint32 CMemoryMap_LSBF::GetWord(uint32 nAddress)
 		return *(uint32*)&((uint8*)e->pPointer)[nAddress - e->nStart];
 		break;
 	case MEMORYMAP_TYPE_FUNCTION:
-		return e->handler(nAddress, 0);
+		return e->CallHandler(nAddress, 0);
 		break;
 	default:
 		assert(0);
@@ -184,7 +293,9 @@ uint32 CMemoryMap_LSBF::GetWord(uint32 nAddress)
 uint32 CMemoryMap_LSBF::GetInstruction(uint32 address)
 {
 	assert((address & 0x03) == 0);
-	const auto e = GetMap(m_instructionMap, address);
+	uint32 instruction = 0;
+	if(CInstructionSnapshotScope::GetInstruction(address, instruction)) return instruction;
+	const auto e = GetInstructionMap(address);
 	if(!e) return 0xCCCCCCCC;
 	switch(e->nType)
 	{
@@ -201,7 +312,7 @@ uint32 CMemoryMap_LSBF::GetInstruction(uint32 address)
 void CMemoryMap_LSBF::SetHalf(uint32 nAddress, uint16 nValue)
 {
 	assert((nAddress & 0x01) == 0);
-	const auto e = GetMap(m_writeMap, nAddress);
+	const auto e = GetWriteMap(nAddress);
 	if(!e)
 	{
 		CLog::GetInstance().Print(LOG_NAME, "Wrote half to unmapped memory (0x%08X, 0x%04X).\r\n", nAddress, nValue);
@@ -213,7 +324,7 @@ void CMemoryMap_LSBF::SetHalf(uint32 nAddress, uint16 nValue)
 		*reinterpret_cast<uint16*>(&reinterpret_cast<uint8*>(e->pPointer)[nAddress - e->nStart]) = nValue;
 		break;
 	case MEMORYMAP_TYPE_FUNCTION:
-		e->handler(nAddress, nValue);
+		e->CallHandler(nAddress, nValue);
 		break;
 	default:
 		assert(0);
@@ -224,7 +335,7 @@ void CMemoryMap_LSBF::SetHalf(uint32 nAddress, uint16 nValue)
 void CMemoryMap_LSBF::SetWord(uint32 nAddress, uint32 nValue)
 {
 	assert((nAddress & 0x03) == 0);
-	const auto e = GetMap(m_writeMap, nAddress);
+	const auto e = GetWriteMap(nAddress);
 	if(!e)
 	{
 		CLog::GetInstance().Print(LOG_NAME, "Wrote word to unmapped memory (0x%08X, 0x%08X).\r\n", nAddress, nValue);
@@ -236,7 +347,7 @@ void CMemoryMap_LSBF::SetWord(uint32 nAddress, uint32 nValue)
 		*(uint32*)&((uint8*)e->pPointer)[nAddress - e->nStart] = nValue;
 		break;
 	case MEMORYMAP_TYPE_FUNCTION:
-		e->handler(nAddress, nValue);
+		e->CallHandler(nAddress, nValue);
 		break;
 	default:
 		assert(0);
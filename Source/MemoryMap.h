@@ -1,7 +1,9 @@
 #pragma once
 
 #include "Types.h"
+#include <array>
 #include <functional>
+#include <memory>
 #include <vector>
 
 enum MEMORYMAP_ENDIANNESS
@@ -14,6 +16,7 @@ class CMemoryMap
 {
 public:
 	typedef std::function<uint32(uint32, uint32)> MemoryMapHandlerType;
+	typedef uint32 (*MemoryMapHandlerFunctionType)(void*, uint32, uint32);
 
 	enum MEMORYMAP_TYPE
 	{
@@ -27,10 +30,38 @@ public:
 		uint32 nEnd;
 		void* pPointer;
 		MemoryMapHandlerType handler;
+		MemoryMapHandlerFunctionType handlerFunction = nullptr;
+		void* handlerContext = nullptr;
 		MEMORYMAP_TYPE nType;
+
+		uint32 CallHandler(uint32 address, uint32 value) const
+		{
+			//Plain function handlers avoid going through std::function
+			return handlerFunction ? handlerFunction(handlerContext, address, value) : handler(address, value);
+		}
 	};
 	typedef std::vector<MEMORYMAPELEMENT> MemoryMapListType;
 
+	//While alive, instructions fetched by the current thread inside the snapshot's range
+	//come from the snapshot instead of memory. Used to compile blocks from a copy of
+	//memory taken earlier while memory keeps changing on another thread.
+	class CInstructionSnapshotScope
+	{
+	public:
+		CInstructionSnapshotScope(uint32, const std::vector<uint32>&);
+		~CInstructionSnapshotScope();
+
+		CInstructionSnapshotScope(const CInstructionSnapshotScope&) = delete;
+		CInstructionSnapshotScope& operator=(const CInstructionSnapshotScope&) = delete;
+
+		static bool GetInstruction(uint32, uint32&);
+
+	private:
+		uint32 m_start = 0;
+		const std::vector<uint32>& m_instructions;
+		CInstructionSnapshotScope* m_previous = nullptr;
+	};
+
 	virtual ~CMemoryMap() = default;
 	uint8 GetByte(uint32);
 	virtual uint16 GetHalf(uint32) = 0;
@@ -41,24 +72,67 @@ public:
 	virtual void SetWord(uint32, uint32) = 0;
 	void InsertReadMap(uint32, uint32, void*, unsigned char);
 	void InsertReadMap(uint32, uint32, const MemoryMapHandlerType&, unsigned char);
+	void InsertReadMap(uint32, uint32, MemoryMapHandlerFunctionType, void*, unsigned char);
 	void InsertWriteMap(uint32, uint32, void*, unsigned char);
 	void InsertWriteMap(uint32, uint32, const MemoryMapHandlerType&, unsigned char);
+	void InsertWriteMap(uint32, uint32, MemoryMapHandlerFunctionType, void*, unsigned char);
 	void InsertInstructionMap(uint32, uint32, void*, unsigned char);
 	const MemoryMapListType& GetInstructionMaps();
 	const MEMORYMAPELEMENT* GetReadMap(uint32) const;
 	const MEMORYMAPELEMENT* GetWriteMap(uint32) const;
 	const MEMORYMAPELEMENT* GetInstructionMap(uint32) const;
 
+	//Adapts member functions to MemoryMapHandlerFunctionType, context is the object
+	template <typename ClassType, uint32 (ClassType::*Handler)(uint32)>
+	static uint32 ReadHandlerThunk(void* context, uint32 address, uint32)
+	{
+		return (reinterpret_cast<ClassType*>(context)->*Handler)(address);
+	}
+
+	template <typename ClassType, uint32 (ClassType::*Handler)(uint32, uint32)>
+	static uint32 WriteHandlerThunk(void* context, uint32 address, uint32 value)
+	{
+		return (reinterpret_cast<ClassType*>(context)->*Handler)(address, value);
+	}
+
 protected:
-	static const MEMORYMAPELEMENT* GetMap(const MemoryMapListType&, uint32);
+	//Maps are looked up through a page table (1MB regions of 4KB pages) that gives
+	//the index of the element covering the whole page. Pages covered by more than
+	//one element are resolved by scanning the element list.
+	enum
+	{
+		LOOKUP_PAGE_BITS = 12,
+		LOOKUP_REGION_BITS = 20,
+		LOOKUP_PAGES_PER_REGION = (1 << (LOOKUP_REGION_BITS - LOOKUP_PAGE_BITS)),
+		LOOKUP_REGION_COUNT = (1 << (32 - LOOKUP_REGION_BITS)),
+	};
+
+	enum LOOKUP_ENTRY : uint8
+	{
+		LOOKUP_ENTRY_NONE = 0,
+		LOOKUP_ENTRY_MIXED = 0xFF,
+	};
+
+	typedef std::array<uint8, LOOKUP_PAGES_PER_REGION> LookupRegion;
+	typedef std::vector<std::unique_ptr<LookupRegion>> MapLookupType;
+
+	static const MEMORYMAPELEMENT* GetMap(const MemoryMapListType&, const MapLookupType&, uint32);
+	static const MEMORYMAPELEMENT* ScanMap(const MemoryMapListType&, uint32);
 
 	MemoryMapListType m_instructionMap;
 	MemoryMapListType m_readMap;
 	MemoryMapListType m_writeMap;
 
+	MapLookupType m_instructionLookup = MapLookupType(LOOKUP_REGION_COUNT);
+	MapLookupType m_readLookup = MapLookupType(LOOKUP_REGION_COUNT);
+	MapLookupType m_writeLookup = MapLookupType(LOOKUP_REGION_COUNT);
+
 private:
 	static void InsertMap(MemoryMapListType&, uint32, uint32, void*, unsigned char);
 	static void InsertMap(MemoryMapListType&, uint32, uint32, const MemoryMapHandlerType&, unsigned char);
+	static void InsertMap(MemoryMapListType&, uint32, uint32, MemoryMapHandlerFunctionType, void*, unsigned char);
+	static void UpdateLookup(const MemoryMapListType&, MapLookupType&, uint32, uint32);
+	static uint8 MakeLookupEntry(const MemoryMapListType&, uint32, uint32);
 };
 
 class CMemoryMap_LSBF : public CMemoryMap
@@ -0,0 +1,206 @@
+#include <cassert>
+#include "MipsConstantAnalysis.h"
+#include "MIPS.h"
+
+bool CMipsConstantAnalysis::GPR_STATE::GetValue(uint32 reg, uint32& value) const
+{
+	assert(reg < 32);
+	if((knownMask & (1U << reg)) == 0) return false;
+	value = values[reg];
+	return true;
+}
+
+void CMipsConstantAnalysis::Analyze(CMIPS& context, uint32 begin, uint32 end)
+{
+	assert(end >= begin);
+	m_begin = begin;
+	m_states.resize(((end - begin) / 4) + 1);
+
+	//Nothing is known when entering the range
+	GPR_STATE state;
+	for(uint32 address = begin; address <= end; address += 4)
+	{
+		uint32 opcode = context.m_pMemoryMap->GetInstruction(address);
+		auto& instructionState = m_states[(address - begin) / 4];
+		instructionState = state;
+		if(!IsWriteLast(opcode))
+		{
+			instructionState.knownMask &= ~(GetWrittenRegisters(opcode) & ~1U);
+		}
+		ExecuteInstruction(state, opcode);
+	}
+}
+
+const CMipsConstantAnalysis::GPR_STATE& CMipsConstantAnalysis::GetState(uint32 address) const
+{
+	uint32 index = (address - m_begin) / 4;
+	assert(index < m_states.size());
+	return m_states[index];
+}
+
+//Returns a mask of the GPRs that an instruction might modify, errs on the side of caution
+uint32 CMipsConstantAnalysis::GetWrittenRegisters(uint32 opcode)
+{
+	uint32 op = (opcode >> 26) & 0x3F;
+	uint32 rt = (opcode >> 16) & 0x1F;
+	uint32 rd = (opcode >> 11) & 0x1F;
+	switch(op)
+	{
+	case 0x00:
+		//SPECIAL
+		return (1U << rd);
+	case 0x01:
+		//REGIMM (xxxAL variants write RA)
+		return (1U << CMIPS::RA);
+	case 0x02: //J
+	case 0x04: //BEQ
+	case 0x05: //BNE
+	case 0x06: //BLEZ
+	case 0x07: //BGTZ
+	case 0x14: //BEQL
+	case 0x15: //BNEL
+	case 0x16: //BLEZL
+	case 0x17: //BGTZL
+	case 0x1F: //SQ
+	case 0x28: //SB
+	case 0x29: //SH
+	case 0x2A: //SWL
+	case 0x2B: //SW
+	case 0x2C: //SDL
+	case 0x2D: //SDR
+	case 0x2E: //SWR
+	case 0x2F: //CACHE
+	case 0x31: //LWC1
+	case 0x33: //PREF
+	case 0x35: //LDC1
+	case 0x36: //LQC2/LDC2
+	case 0x39: //SWC1
+	case 0x3D: //SDC1
+	case 0x3E: //SQC2/SDC2
+	case 0x3F: //SD
+		return 0;
+	case 0x03:
+		//JAL
+		return (1U << CMIPS::RA);
+	default:
+		//Immediate operations, loads, coprocessor moves, MMI, SC/SCD
+		return (1U << rt) | (1U << rd);
+	}
+}
+
+//Instructions whose compiled code never reads a register after writing to it
+bool CMipsConstantAnalysis::IsWriteLast(uint32 opcode)
+{
+	uint32 op = (opcode >> 26) & 0x3F;
+	uint32 funct = (opcode >> 0) & 0x3F;
+	switch(op)
+	{
+	case 0x00:
+		//SLL, ADDU, OR
+		return (funct == 0x00) || (funct == 0x21) || (funct == 0x25);
+	case 0x08: //ADDI
+	case 0x09: //ADDIU
+	case 0x0C: //ANDI
+	case 0x0D: //ORI
+	case 0x0E: //XORI
+	case 0x0F: //LUI
+	case 0x20: //LB
+	case 0x21: //LH
+	case 0x23: //LW
+	case 0x24: //LBU
+	case 0x25: //LHU
+	case 0x27: //LWU
+		return true;
+	default:
+		return false;
+	}
+}
+
+void CMipsConstantAnalysis::ExecuteInstruction(GPR_STATE& state, uint32 opcode)
+{
+	uint32 op = (opcode >> 26) & 0x3F;
+	uint32 rs = (opcode >> 21) & 0x1F;
+	uint32 rt = (opcode >> 16) & 0x1F;
+	uint32 rd = (opcode >> 11) & 0x1F;
+	uint32 sa = (opcode >> 6) & 0x1F;
+	uint32 funct = (opcode >> 0) & 0x3F;
+	uint32 immediate = (opcode >> 0) & 0xFFFF;
+	uint32 signedImmediate = static_cast<int16>(immediate);
+
+	uint32 destination = 0;
+	uint32 result = 0;
+	bool known = false;
+	uint32 rsValue = 0;
+	uint32 rtValue = 0;
+	bool rsKnown = state.GetValue(rs, rsValue);
+	bool rtKnown = state.GetValue(rt, rtValue);
+
+	switch(op)
+	{
+	case 0x00:
+		destination = rd;
+		switch(funct)
+		{
+		case 0x00:
+			//SLL
+			known = rtKnown;
+			result = rtValue << sa;
+			break;
+		case 0x21:
+			//ADDU
+			known = rsKnown && rtKnown;
+			result = rsValue + rtValue;
+			break;
+		case 0x25:
+			//OR
+			known = rsKnown && rtKnown;
+			result = rsValue | rtValue;
+			break;
+		}
+		break;
+	case 0x08: //ADDI
+	case 0x09: //ADDIU
+		destination = rt;
+		known = rsKnown;
+		result = rsValue + signedImmediate;
+		break;
+	case 0x0C:
+		//ANDI
+		destination = rt;
+		known = rsKnown;
+		result = rsValue & immediate;
+		break;
+	case 0x0D:
+		//ORI
+		destination = rt;
+		known = rsKnown;
+		result = rsValue | immediate;
+		break;
+	case 0x0E:
+		//XORI
+		destination = rt;
+		known = rsKnown;
+		result = rsValue ^ immediate;
+		break;
+	case 0x0F:
+		//LUI
+		destination = rt;
+		known = true;
+		result = immediate << 16;
+		break;
+	}
+
+	if(known)
+	{
+		if(destination != 0)
+		{
+			state.knownMask |= (1U << destination);
+			state.values[destination] = result;
+		}
+	}
+	else
+	{
+		//R0 stays known whatever gets written to it
+		state.knownMask &= ~(GetWrittenRegisters(opcode) & ~1U);
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include "Types.h"
+
+class CMIPS;
+
+//Tracks GPRs holding known constant values through a range of straight-line code
+//(ie.: addresses built with lui/ori or lui/addiu pairs). Values are the low 32-bits of
+//registers, known values are always sign extended to 64-bits like MIPS32 results are.
+class CMipsConstantAnalysis
+{
+public:
+	struct GPR_STATE
+	{
+		uint32 knownMask = 1; //R0 is always known
+		uint32 values[32] = {};
+
+		bool GetValue(uint32, uint32&) const;
+	};
+
+	void Analyze(CMIPS&, uint32, uint32);
+
+	//State of the registers before the instruction at an address executes. Registers written by
+	//the instruction are only reported if it's known to read all of its operands before writing.
+	const GPR_STATE& GetState(uint32) const;
+
+	static uint32 GetWrittenRegisters(uint32);
+
+private:
+	static bool IsWriteLast(uint32);
+	static void ExecuteInstruction(GPR_STATE&, uint32);
+
+	uint32 m_begin = 0;
+	std::vector<GPR_STATE> m_states;
+};
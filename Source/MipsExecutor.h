@@ -1,14 +1,43 @@
 #pragma once
 
+#include <memory>
 #include "Types.h"
 
+class CBlockCodeCache;
+
 class CMipsExecutor
 {
 public:
+	struct BLOCK_COMPILE_STATS
+	{
+		uint32 compiledBlockCount = 0;           //Blocks compiled on the emulation thread
+		uint32 backgroundCompiledBlockCount = 0; //Blocks compiled ahead of time by the background compiler
+		uint32 superBlockCount = 0;              //Super blocks formed from hot block chains
+		uint64 compileTime = 0;                  //Time spent by the emulation thread compiling or waiting for blocks (ns)
+		uint64 maxCompileTime = 0;
+		uint64 backgroundLatency = 0; //Time between queueing and completion of background compiled blocks (ns)
+		uint64 maxBackgroundLatency = 0;
+		uint32 queueDepth = 0;
+		uint32 maxQueueDepth = 0;
+		uint32 smcFaultCount = 0;                  //Writes to protected code pages
+		uint32 smcGuardedPageCount = 0;            //Pages where blocks validate their code on entry instead of being protected
+		uint32 smcGuardMissCount = 0;              //Guarded blocks found to be stale on entry
+		uint32 fastMemoryFaultCount = 0;           //Direct memory accesses that faulted and were emulated
+		uint32 constantFoldedInstructionCount = 0; //Instructions compiled with operands known at compile time
+		uint32 constantResolvedAccessCount = 0;    //Memory accesses resolved at compile time
+		uint32 constantHandlerCallCount = 0;       //Hardware register accesses compiled as direct handler calls
+	};
+
 	virtual ~CMipsExecutor() = default;
 	virtual void Reset() = 0;
 	virtual int Execute(int) = 0;
 	virtual void ClearActiveBlocksInRange(uint32 start, uint32 end, bool executing) = 0;
+	virtual void SetBlockCodeCache(std::shared_ptr<CBlockCodeCache>) = 0;
+	virtual void SetBackgroundCompileEnabled(bool) = 0;
+	virtual void SetSuperBlocksEnabled(bool) = 0;
+
+	virtual BLOCK_COMPILE_STATS GetBlockCompileStats() const = 0;
+	virtual void ResetBlockCompileStats() = 0;
 
 #ifdef DEBUGGER_INCLUDED
 	virtual bool MustBreak() const = 0;
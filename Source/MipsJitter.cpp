@@ -25,10 +25,18 @@ void CMipsJitter::Begin()
 
 void CMipsJitter::PushRel(size_t offset)
 {
+	uint32 knownValue = 0;
 	VARIABLESTATUS* status = GetVariableStatus(offset);
 	if(status == NULL)
 	{
-		CJitter::PushRel(offset);
+		if(GetKnownGprPart(offset, knownValue))
+		{
+			CJitter::PushCst(knownValue);
+		}
+		else
+		{
+			CJitter::PushRel(offset);
+		}
 	}
 	else
 	{
@@ -46,11 +54,21 @@ void CMipsJitter::PushRel(size_t offset)
 
 void CMipsJitter::PushRel64(size_t offset)
 {
+	uint32 knownValueLo = 0;
+	uint32 knownValueHi = 0;
 	VARIABLESTATUS* statusLo = GetVariableStatus(offset + 0);
 	VARIABLESTATUS* statusHi = GetVariableStatus(offset + 4);
 	if(statusLo == NULL || statusHi == NULL)
 	{
-		CJitter::PushRel64(offset);
+		if(GetKnownGprPart(offset + 0, knownValueLo) && GetKnownGprPart(offset + 4, knownValueHi))
+		{
+			uint64 result = static_cast<uint64>(knownValueLo) | (static_cast<uint64>(knownValueHi) << 32);
+			CJitter::PushCst64(result);
+		}
+		else
+		{
+			CJitter::PushRel64(offset);
+		}
 	}
 	else
 	{
@@ -95,6 +113,92 @@ void CMipsJitter::MarkLastBlockLabel()
 	}
 }
 
+void CMipsJitter::SetKnownGprState(const CMipsConstantAnalysis::GPR_STATE* state)
+{
+	if(m_knownGprUsed)
+	{
+		m_constantStats.foldedInstructionCount++;
+		m_knownGprUsed = false;
+	}
+	m_knownGprState = state;
+}
+
+bool CMipsJitter::GetKnownGprValue(uint32 reg, uint32& value) const
+{
+	if(!m_knownGprState) return false;
+	return m_knownGprState->GetValue(reg, value);
+}
+
+void CMipsJitter::NotifyMemoryAccessResolved()
+{
+	m_constantStats.resolvedAccessCount++;
+}
+
+void CMipsJitter::NotifyHandlerCallResolved()
+{
+	m_constantStats.handlerCallCount++;
+}
+
+void CMipsJitter::PushHostPointer(const void* pointer)
+{
+	m_hostPointersUsed = true;
+	auto value = reinterpret_cast<uintptr_t>(pointer);
+	if(sizeof(uintptr_t) == 8)
+	{
+		PushCst64(static_cast<uint64>(value));
+	}
+	else
+	{
+		PushCst(static_cast<uint32>(value));
+	}
+}
+
+bool CMipsJitter::HasHostPointers() const
+{
+	return m_hostPointersUsed;
+}
+
+void CMipsJitter::SetFastMemoryEnabled(bool fastMemoryEnabled)
+{
+	m_fastMemoryEnabled = fastMemoryEnabled;
+}
+
+bool CMipsJitter::IsFastMemoryEnabled() const
+{
+	return m_fastMemoryEnabled;
+}
+
+const CMipsJitter::CONSTANT_STATS& CMipsJitter::GetConstantStats() const
+{
+	return m_constantStats;
+}
+
+void CMipsJitter::ResetConstantStats()
+{
+	m_constantStats = CONSTANT_STATS();
+	m_knownGprState = nullptr;
+	m_knownGprUsed = false;
+	m_hostPointersUsed = false;
+}
+
+//Known values are sign extended to 64-bits, upper 64-bits of EE registers aren't tracked
+bool CMipsJitter::GetKnownGprPart(size_t offset, uint32& value)
+{
+	if(!m_knownGprState) return false;
+	size_t gprBase = offsetof(CMIPS, m_State.nGPR[0]);
+	size_t gprEnd = gprBase + sizeof(MIPSSTATE::nGPR);
+	if((offset < gprBase) || (offset >= gprEnd)) return false;
+	uint32 reg = static_cast<uint32>((offset - gprBase) / sizeof(uint128));
+	uint32 part = static_cast<uint32>(((offset - gprBase) % sizeof(uint128)) / sizeof(uint32));
+	uint32 regValue = 0;
+	if(reg == CMIPS::R0) return false;
+	if(part > 1) return false;
+	if(!m_knownGprState->GetValue(reg, regValue)) return false;
+	value = (part == 0) ? regValue : ((static_cast<int32>(regValue) < 0) ? ~0U : 0U);
+	m_knownGprUsed = true;
+	return true;
+}
+
 void CMipsJitter::SetVariableAsConstant(size_t variableId, uint32 value)
 {
 	VARIABLESTATUS status;
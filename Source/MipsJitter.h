@@ -2,10 +2,18 @@
 
 #include <map>
 #include "Jitter.h"
+#include "MipsConstantAnalysis.h"
 
 class CMipsJitter : public Jitter::CJitter
 {
 public:
+	struct CONSTANT_STATS
+	{
+		uint32 foldedInstructionCount = 0; //Instructions that had register operands replaced by known constants
+		uint32 resolvedAccessCount = 0;    //Memory accesses resolved at compile time
+		uint32 handlerCallCount = 0;       //Hardware register accesses calling their handler directly
+	};
+
 	CMipsJitter(Jitter::CCodeGen*);
 	virtual ~CMipsJitter() = default;
 
@@ -15,6 +23,23 @@ public:
 
 	void SetVariableAsConstant(size_t, uint32);
 
+	//GPR values known before the instruction being compiled, PushRel/PushRel64 of those become constants
+	void SetKnownGprState(const CMipsConstantAnalysis::GPR_STATE*);
+	bool GetKnownGprValue(uint32, uint32&) const;
+	void NotifyMemoryAccessResolved();
+	void NotifyHandlerCallResolved();
+
+	//Host pointers are only valid in the current process, code using them can't be stored in a code cache
+	void PushHostPointer(const void*);
+	bool HasHostPointers() const;
+
+	//Memory accesses go through the fast memory arena when the context has one, unless disabled
+	void SetFastMemoryEnabled(bool);
+	bool IsFastMemoryEnabled() const;
+
+	const CONSTANT_STATS& GetConstantStats() const;
+	void ResetConstantStats();
+
 	LABEL GetFirstBlockLabel();
 	LABEL GetLastBlockLabel();
 
@@ -32,8 +57,14 @@ private:
 
 	VARIABLESTATUS* GetVariableStatus(size_t);
 	void SetVariableStatus(size_t, const VARIABLESTATUS&);
+	bool GetKnownGprPart(size_t, uint32&);
 
 	VariableStatusMap m_variableStatus;
+	const CMipsConstantAnalysis::GPR_STATE* m_knownGprState = nullptr;
+	bool m_knownGprUsed = false;
+	bool m_hostPointersUsed = false;
+	bool m_fastMemoryEnabled = true;
+	CONSTANT_STATS m_constantStats;
 	LABEL m_firstBlockLabel = -1;
 	LABEL m_lastBlockLabel = -1;
 };
@@ -29,6 +29,7 @@
 #include "iop/ioman/PreferenceDirectoryDevice.h"
 #include "Log.h"
 #include "DiskUtils.h"
+#include "BlockCodeCache.h"
 #ifdef __ANDROID__
 #include "android/JavaVM.h"
 #endif
@@ -36,6 +37,7 @@
 #define LOG_NAME ("ps2vm")
 
 #define THREAD_NAME ("PS2VM Thread")
+#define IOP_THREAD_NAME ("PS2VM IOP Thread")
 
 #define STATE_VM_TIMING_XML ("vm_timing.xml")
 #define STATE_VM_TIMING_VBLANK_TICKS ("vblankTicks")
@@ -43,6 +45,9 @@
 #define STATE_VM_TIMING_EE_EXECUTION_TICKS ("eeExecutionTicks")
 #define STATE_VM_TIMING_IOP_EXECUTION_TICKS ("iopExecutionTicks")
 #define STATE_VM_TIMING_SPU_UPDATE_TICKS ("spuUpdateTicks")
+#define STATE_VM_TIMING_HBLANK_TICKS ("hblankTicks")
+#define STATE_VM_TIMING_IOP_SYNC_TICKS ("iopSyncTicks")
+#define STATE_VM_TIMING_IOP_SYNC_STEP_COUNT ("iopSyncStepCount")
 
 #define PREF_PS2_ROM0_DIRECTORY_DEFAULT ("vfs/rom0")
 #define PREF_PS2_HOST_DIRECTORY_DEFAULT ("vfs/host")
@@ -91,13 +96,29 @@ CPS2VM::CPS2VM()
 	Framework::PathUtils::EnsurePathExists(GetStateDirectoryPath());
 
 	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_LIMIT_FRAMERATE, true);
+	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_FRAMEPACING_AUDIOCLOCK, false);
 	ReloadFrameRateLimit();
 
+	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_JIT_BLOCKCODECACHE, false);
+	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_JIT_BACKGROUNDCOMPILE, false);
+	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_JIT_SUPERBLOCKS, false);
+	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_JIT_FASTMEMORY, false);
+	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_VU1_THREADED, false);
+	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_IOP_THREADED, false);
+	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_PS2_IOP_MAXSKEW, m_eeTickStep * 8);
+	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_SYNC_ADAPTIVE, false);
+
 	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_AUDIO_SPUBLOCKCOUNT, 100);
 	ReloadSpuBlockCountImpl();
 
 	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_PS2_ARCADE_IO_SERVER_ENABLED, false);
 	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_PS2_ARCADE_IO_SERVER_PORT, 9876);
+
+	//IOP sync comes first, events at the same time see the IOP at the same point as the EE
+	m_iopSyncEvent = m_scheduler.RegisterEvent([this]() { OnIopSyncEvent(); });
+	m_spuUpdateEvent = m_scheduler.RegisterEvent([this]() { OnSpuUpdateEvent(); });
+	m_hblankEvent = m_scheduler.RegisterEvent([this]() { OnHBlankEvent(); });
+	m_vblankEvent = m_scheduler.RegisterEvent([this]() { OnVBlankEvent(); });
 }
 
 //////////////////////////////////////////////////
@@ -225,6 +246,95 @@ void CPS2VM::SetEeFrequencyScale(uint32 numerator, uint32 denominator)
 	ReloadFrameRateLimit();
 }
 
+void CPS2VM::SetAdaptiveSync(bool adaptiveSync)
+{
+	m_mailBox.SendCall([this, adaptiveSync]() { m_adaptiveSync = adaptiveSync; });
+}
+
+void CPS2VM::SetIopLockstep(bool lockstep)
+{
+	m_mailBox.SendCall([this, lockstep]() { m_iopLockstep = lockstep; });
+}
+
+void CPS2VM::SetTurboMode(bool turboMode)
+{
+	m_mailBox.SendCall(
+	    [this, turboMode]() {
+		    m_turboMode = turboMode;
+		    ReloadFrameRateLimit();
+	    });
+}
+
+bool CPS2VM::GetTurboMode() const
+{
+	return m_turboMode;
+}
+
+void CPS2VM::SetTurboSoundDecimation(uint32 decimation)
+{
+	m_turboSoundDecimation = decimation;
+}
+
+void CPS2VM::SetPresentationSkip(uint32 skipCount, uint32 period)
+{
+	m_mailBox.SendCall(
+	    [this, skipCount, period]() {
+		    m_presentationSkipCount = skipCount;
+		    m_presentationPeriod = period;
+		    if(m_ee->m_gs)
+		    {
+			    m_ee->m_gs->SetPresentationSkip(skipCount, period);
+		    }
+	    });
+}
+
+void CPS2VM::StartRecording(const fs::path& logPath)
+{
+	auto writer = std::make_shared<ReplayLog::CWriter>(std::make_unique<Framework::CStdStream>(Framework::CreateOutputStdStream(logPath.native())));
+	m_mailBox.SendCall(
+	    [this, writer]() {
+		    StopRecordingOrReplayImpl();
+		    auto iopLock = LockIop();
+		    m_replayWriter = writer;
+		    m_replaySavedIopLockstep = m_iopLockstep;
+		    m_iopLockstep = true;
+		    m_padRelay.SetWriter(m_replayWriter.get());
+		    RegisterModulesInPadHandler();
+	    },
+	    true);
+}
+
+void CPS2VM::StartReplay(const fs::path& logPath)
+{
+	auto reader = std::make_shared<ReplayLog::CReader>(std::make_unique<Framework::CStdStream>(Framework::CreateInputStdStream(logPath.native())));
+	m_mailBox.SendCall(
+	    [this, reader]() {
+		    StopRecordingOrReplayImpl();
+		    auto iopLock = LockIop();
+		    m_replayReader = reader;
+		    m_replaySavedIopLockstep = m_iopLockstep;
+		    m_iopLockstep = true;
+		    m_replayDivergenceCount = 0;
+		    m_replaying = true;
+	    },
+	    true);
+}
+
+void CPS2VM::StopRecordingOrReplay()
+{
+	m_mailBox.SendCall([this]() { StopRecordingOrReplayImpl(); }, true);
+}
+
+bool CPS2VM::IsReplaying() const
+{
+	return m_replaying;
+}
+
+uint32 CPS2VM::GetReplayDivergenceCount() const
+{
+	return m_replayDivergenceCount;
+}
+
 void CPS2VM::ReloadFrameRateLimit()
 {
 	uint32 hRefreshRate = PS2::GS_NTSC_HSYNC_FREQ;
@@ -235,11 +345,18 @@ void CPS2VM::ReloadFrameRateLimit()
 		vRefreshRate = m_ee->m_gs->GetCrtFrameRate();
 	}
 	bool limitFrameRate = CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_LIMIT_FRAMERATE);
-	m_frameLimiter.SetFrameRate(limitFrameRate ? vRefreshRate : 0);
+	bool audioClockPacing = CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_FRAMEPACING_AUDIOCLOCK);
+	m_frameLimiter.SetFrameRate((limitFrameRate && !m_turboMode) ? vRefreshRate : 0);
+	m_nominalFrameDuration = 1000000 / vRefreshRate;
+	m_frameLimiter.SetFrameDurationScale(1.0f);
 
 	//At 1x scale, IOP runs 8 times slower than EE
 	uint32 eeFreqScaled = PS2::EE_CLOCK_FREQ * m_eeFreqScaleNumerator / m_eeFreqScaleDenominator;
-	m_iopTickStep = (m_eeTickStep / 8) * m_eeFreqScaleDenominator / m_eeFreqScaleNumerator;
+	{
+		auto iopLock = LockIop();
+		m_iopTickStep = (m_eeTickStep / 8) * m_eeFreqScaleDenominator / m_eeFreqScaleNumerator;
+		m_audioClockPacing = audioClockPacing;
+	}
 
 	m_hblankTicksTotal = eeFreqScaled / hRefreshRate;
 
@@ -370,7 +487,45 @@ std::future<bool> CPS2VM::LoadState(const fs::path& statePath)
 
 CPS2VM::CPU_UTILISATION_INFO CPS2VM::GetCpuUtilisationInfo() const
 {
-	return m_cpuUtilisation;
+	auto cpuUtilisation = m_cpuUtilisation;
+	cpuUtilisation.tickStepCount = (cpuUtilisation.eeTotalTicks + m_eeTickStep - 1) / m_eeTickStep;
+	return cpuUtilisation;
+}
+
+uint32 CPS2VM::GetLastFrameDuration() const
+{
+	return m_frameLimiter.GetLastFrameDuration();
+}
+
+uint32 CPS2VM::GetNominalFrameDuration() const
+{
+	return m_nominalFrameDuration;
+}
+
+CMipsExecutor::BLOCK_COMPILE_STATS CPS2VM::GetBlockCompileStats() const
+{
+	CMipsExecutor::BLOCK_COMPILE_STATS result;
+	for(const auto& executor : {m_ee->m_EE.m_executor.get(), m_iop->m_cpu.m_executor.get()})
+	{
+		auto stats = executor->GetBlockCompileStats();
+		result.compiledBlockCount += stats.compiledBlockCount;
+		result.backgroundCompiledBlockCount += stats.backgroundCompiledBlockCount;
+		result.superBlockCount += stats.superBlockCount;
+		result.compileTime += stats.compileTime;
+		result.maxCompileTime = std::max(result.maxCompileTime, stats.maxCompileTime);
+		result.backgroundLatency += stats.backgroundLatency;
+		result.maxBackgroundLatency = std::max(result.maxBackgroundLatency, stats.maxBackgroundLatency);
+		result.queueDepth += stats.queueDepth;
+		result.maxQueueDepth = std::max(result.maxQueueDepth, stats.maxQueueDepth);
+		result.smcFaultCount += stats.smcFaultCount;
+		result.smcGuardedPageCount += stats.smcGuardedPageCount;
+		result.smcGuardMissCount += stats.smcGuardMissCount;
+		result.fastMemoryFaultCount += stats.fastMemoryFaultCount;
+		result.constantFoldedInstructionCount += stats.constantFoldedInstructionCount;
+		result.constantResolvedAccessCount += stats.constantResolvedAccessCount;
+		result.constantHandlerCallCount += stats.constantHandlerCallCount;
+	}
+	return result;
 }
 
 #ifdef DEBUGGER_INCLUDED
@@ -471,9 +626,22 @@ void CPS2VM::CreateVM()
 	m_iop = std::make_unique<Iop::CSubSystem>(true);
 	auto iopOs = dynamic_cast<CIopBios*>(m_iop->m_bios.get());
 
-	m_ee = std::make_unique<Ee::CSubSystem>(m_iop->m_ram, *iopOs);
+	//EE memory layout is decided when the VM is created, changes only apply to new VMs
+	bool useFastMemory = false;
+#ifdef FAST_MEMORY_SUPPORTED
+	useFastMemory = CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_JIT_FASTMEMORY);
+#endif
+
+	//Debugger keeps snapshots of VU1 state that would need to be taken on the VU1 thread
+	bool useThreadedVu1 = false;
+#if !defined(DEBUGGER_INCLUDED) && !defined(__EMSCRIPTEN__)
+	useThreadedVu1 = CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_VU1_THREADED);
+#endif
+
+	m_ee = std::make_unique<Ee::CSubSystem>(m_iop->m_ram, *iopOs, useFastMemory, useThreadedVu1);
 	m_OnRequestLoadExecutableConnection = m_ee->m_os->OnRequestLoadExecutable.Connect(std::bind(&CPS2VM::ReloadExecutable, this, std::placeholders::_1, std::placeholders::_2));
 	m_OnCrtModeChangeConnection = m_ee->m_os->OnCrtModeChange.Connect(std::bind(&CPS2VM::OnCrtModeChange, this));
+	m_OnExecutableChangeConnection = m_ee->m_os->OnExecutableChange.Connect(std::bind(&CPS2VM::OnExecutableChange, this));
 
 	ResetVM();
 }
@@ -511,19 +679,40 @@ void CPS2VM::ResetVM()
 		iopOs->GetIoman()->RegisterDevice("hdd0", std::make_shared<Iop::Ioman::CHardDiskDevice>());
 
 		iopOs->GetLoadcore()->SetLoadExecutableHandler(std::bind(&CPS2OS::LoadExecutable, m_ee->m_os, std::placeholders::_1, std::placeholders::_2));
+
+		iopOs->GetCdvdman()->SetHostTimeSource([this]() { return GetHostTime(); });
+		iopOs->GetCdvdman()->SetCommandCompletedHandler([this](uint32 command) { OnCdvdCommandCompleted(command); });
 	}
 
 	CDROM0_SyncPath();
 
 	SetEeFrequencyScale(1, 1);
 
-	m_hblankTicks = m_hblankTicksTotal;
-	m_vblankTicks = m_onScreenTicksTotal;
 	m_spuUpdateTicks = m_spuUpdateTicksTotal;
 	m_inVblank = false;
 
 	m_eeExecutionTicks = 0;
 	m_iopExecutionTicks = 0;
+	m_iopSyncStepCount = 1;
+	m_adaptiveSync = CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_SYNC_ADAPTIVE);
+	m_adaptiveSyncStepCount = 1;
+	m_lastSifTransferCount = m_ee->m_sif.GetTransferCount();
+
+	m_scheduler.CancelAll();
+	m_scheduler.Schedule(m_iopSyncEvent, m_eeTickStep);
+	m_scheduler.Schedule(m_vblankEvent, m_onScreenTicksTotal);
+	ScheduleHBlank(m_hblankTicksTotal);
+	ScheduleSpuUpdate();
+
+	{
+		bool backgroundCompile = CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_JIT_BACKGROUNDCOMPILE);
+		m_ee->m_EE.m_executor->SetBackgroundCompileEnabled(backgroundCompile);
+		m_iop->m_cpu.m_executor->SetBackgroundCompileEnabled(backgroundCompile);
+
+		bool superBlocks = CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_JIT_SUPERBLOCKS);
+		m_ee->m_EE.m_executor->SetSuperBlocksEnabled(superBlocks);
+		m_iop->m_cpu.m_executor->SetSuperBlocksEnabled(superBlocks);
+	}
 
 	m_currentSpuBlock = 0;
 	m_iop->m_spuCore0.SetDestinationSamplingRate(DST_SAMPLE_RATE);
@@ -608,8 +797,17 @@ bool CPS2VM::LoadVMState(const fs::path& statePath)
 
 void CPS2VM::SaveVmTimingState(Framework::CZipArchiveWriter& archive)
 {
+	//Deadlines are saved as 32-bit values, none of them is ever more than a frame away
+	auto getEventTicks =
+	    [this](CEventScheduler::EventId eventId) {
+		    return static_cast<uint32>(std::clamp<int64>(m_scheduler.GetTicksUntil(eventId), 0, INT_MAX));
+	    };
+
 	auto registerFile = std::make_unique<CRegisterStateFile>(STATE_VM_TIMING_XML);
-	registerFile->SetRegister32(STATE_VM_TIMING_VBLANK_TICKS, m_vblankTicks);
+	registerFile->SetRegister32(STATE_VM_TIMING_VBLANK_TICKS, getEventTicks(m_vblankEvent));
+	registerFile->SetRegister32(STATE_VM_TIMING_HBLANK_TICKS, getEventTicks(m_hblankEvent));
+	registerFile->SetRegister32(STATE_VM_TIMING_IOP_SYNC_TICKS, getEventTicks(m_iopSyncEvent));
+	registerFile->SetRegister32(STATE_VM_TIMING_IOP_SYNC_STEP_COUNT, m_iopSyncStepCount);
 	registerFile->SetRegister32(STATE_VM_TIMING_IN_VBLANK, m_inVblank);
 	registerFile->SetRegister32(STATE_VM_TIMING_EE_EXECUTION_TICKS, m_eeExecutionTicks);
 	registerFile->SetRegister32(STATE_VM_TIMING_IOP_EXECUTION_TICKS, m_iopExecutionTicks);
@@ -620,11 +818,21 @@ void CPS2VM::SaveVmTimingState(Framework::CZipArchiveWriter& archive)
 void CPS2VM::LoadVmTimingState(Framework::CZipArchiveReader& archive)
 {
 	CRegisterStateFile registerFile(*archive.BeginReadFile(STATE_VM_TIMING_XML));
-	m_vblankTicks = registerFile.GetRegister32(STATE_VM_TIMING_VBLANK_TICKS);
+	int32 vblankTicks = registerFile.GetRegister32(STATE_VM_TIMING_VBLANK_TICKS);
+	int32 hblankTicks = registerFile.GetRegister32(STATE_VM_TIMING_HBLANK_TICKS);
+	int32 iopSyncTicks = registerFile.GetRegister32(STATE_VM_TIMING_IOP_SYNC_TICKS);
+	uint32 iopSyncStepCount = registerFile.GetRegister32(STATE_VM_TIMING_IOP_SYNC_STEP_COUNT);
 	m_inVblank = registerFile.GetRegister32(STATE_VM_TIMING_IN_VBLANK) != 0;
 	m_eeExecutionTicks = registerFile.GetRegister32(STATE_VM_TIMING_EE_EXECUTION_TICKS);
 	m_iopExecutionTicks = registerFile.GetRegister32(STATE_VM_TIMING_IOP_EXECUTION_TICKS);
 	m_spuUpdateTicks = registerFile.GetRegister64(STATE_VM_TIMING_SPU_UPDATE_TICKS);
+	//States that predate hblank and IOP sync deadlines have them due right away
+	m_iopSyncStepCount = std::max<uint32>(iopSyncStepCount, 1);
+	m_scheduler.CancelAll();
+	m_scheduler.Schedule(m_iopSyncEvent, std::max<int32>(iopSyncTicks, 0));
+	m_scheduler.Schedule(m_vblankEvent, std::max<int32>(vblankTicks, 0));
+	ScheduleHBlank(std::max<int32>(hblankTicks, 0));
+	ScheduleSpuUpdate();
 }
 
 void CPS2VM::PauseImpl()
@@ -655,6 +863,7 @@ void CPS2VM::CreateGsHandlerImpl(const CGSHandler::FactoryFunction& factoryFunct
 	auto gs = m_ee->m_gs;
 	m_ee->m_gs = factoryFunction();
 	m_ee->m_gs->SetIntc(&m_ee->m_intc);
+	m_ee->m_gs->SetPresentationSkip(m_presentationSkipCount, m_presentationPeriod);
 	m_ee->m_gs->Initialize();
 	m_ee->m_gs->SendGSCall([this]() {
 		static_cast<CEeExecutor*>(m_ee->m_EE.m_executor.get())->AttachExceptionHandlerToThread();
@@ -691,6 +900,7 @@ void CPS2VM::DestroyPadHandlerImpl()
 void CPS2VM::CreateSoundHandlerImpl(const CSoundHandler::FactoryFunction& factoryFunction)
 {
 	m_soundHandler = factoryFunction();
+	m_resampler.Reset();
 }
 
 void CPS2VM::ReloadSpuBlockCountImpl()
@@ -730,10 +940,12 @@ void CPS2VM::UpdateEe()
 		m_ee->m_vpu1->Execute(m_singleStepVu1 ? 1 : executed);
 
 		m_eeExecutionTicks -= executed;
-		m_spuUpdateTicks -= (static_cast<int64>(executed) << SPU_UPDATE_TICKS_PRECISION);
+		if(!IsIopDecoupled())
+		{
+			m_spuUpdateTicks -= (static_cast<int64>(executed) << SPU_UPDATE_TICKS_PRECISION);
+		}
 		m_ee->CountTicks(executed);
-		m_hblankTicks -= executed;
-		m_vblankTicks -= executed;
+		m_scheduler.AdvanceTime(executed);
 
 #ifdef DEBUGGER_INCLUDED
 		if(m_singleStepEe || m_singleStepVu0 || m_singleStepVu1) break;
@@ -748,6 +960,11 @@ void CPS2VM::UpdateIop()
 	CProfilerZone profilerZone(m_iopProfilerZone);
 #endif
 
+	ExecuteIop();
+}
+
+void CPS2VM::ExecuteIop()
+{
 	while(m_iopExecutionTicks > 0)
 	{
 		int executed = m_iop->ExecuteCpu(m_singleStepIop ? 1 : m_iopExecutionTicks);
@@ -774,6 +991,11 @@ void CPS2VM::UpdateSpu()
 	CProfilerZone profilerZone(m_spuProfilerZone);
 #endif
 
+	RenderSpu();
+}
+
+void CPS2VM::RenderSpu()
+{
 	unsigned int blockOffset = (BLOCK_SIZE * m_currentSpuBlock);
 	int16* samplesSpu0 = m_samples + blockOffset;
 
@@ -798,13 +1020,325 @@ void CPS2VM::UpdateSpu()
 	{
 		if(m_soundHandler)
 		{
-			m_soundHandler->RecycleBuffers();
-			m_soundHandler->Write(m_samples, BLOCK_SIZE * m_spuBlockCount, DST_SAMPLE_RATE);
+			WriteSpuSamples();
 		}
 		m_currentSpuBlock = 0;
 	}
 }
 
+void CPS2VM::WriteSpuSamples()
+{
+	unsigned int sampleCount = BLOCK_SIZE * m_spuBlockCount;
+
+	m_soundHandler->RecycleBuffers();
+	int32 queuedSampleCount = m_soundHandler->GetQueuedSampleCount();
+	m_soundQueuedSampleCount = queuedSampleCount;
+	//Aim for one block being played while the next one is written
+	m_soundTargetSampleCount = sampleCount;
+
+	if(m_turboMode)
+	{
+		//Sound is produced faster than it's played, only keep some of it and drop what doesn't fit
+		uint32 decimation = m_turboSoundDecimation;
+		if((decimation == 0) || !m_soundHandler->HasFreeBuffers()) return;
+		m_resampledSamples.clear();
+		for(unsigned int i = 0; i < sampleCount; i += (decimation * 2))
+		{
+			m_resampledSamples.push_back(m_samples[i + 0]);
+			m_resampledSamples.push_back(m_samples[i + 1]);
+		}
+		m_soundHandler->Write(m_resampledSamples.data(), static_cast<unsigned int>(m_resampledSamples.size()), DST_SAMPLE_RATE);
+	}
+	else if(m_audioClockPacing && (queuedSampleCount >= 0))
+	{
+		//Consume a bit more or less than what was produced to bring the queue back to its target depth
+		float adjust = std::clamp<float>(GetSoundQueueDepthError() * AUDIOCLOCK_RESAMPLE_GAIN, -AUDIOCLOCK_RESAMPLE_MAX_ADJUST, AUDIOCLOCK_RESAMPLE_MAX_ADJUST);
+		m_resampler.Resample(m_samples, sampleCount, 1.0f - adjust, m_resampledSamples);
+		m_soundHandler->Write(m_resampledSamples.data(), static_cast<unsigned int>(m_resampledSamples.size()), DST_SAMPLE_RATE);
+	}
+	else
+	{
+		m_soundHandler->Write(m_samples, sampleCount, DST_SAMPLE_RATE);
+	}
+}
+
+float CPS2VM::GetSoundQueueDepthError() const
+{
+	int32 queuedSampleCount = m_soundQueuedSampleCount;
+	int32 targetSampleCount = m_soundTargetSampleCount;
+	if((queuedSampleCount < 0) || (targetSampleCount == 0)) return 0;
+	return static_cast<float>(queuedSampleCount - targetSampleCount) / static_cast<float>(targetSampleCount);
+}
+
+void CPS2VM::OnIopSyncEvent()
+{
+	int32 syncTicks = m_eeTickStep * m_iopSyncStepCount;
+	m_cpuUtilisation.iopSyncCount++;
+	m_cpuUtilisation.iopSyncTicks += syncTicks;
+	m_cpuUtilisation.maxIopSyncTicks = std::max(m_cpuUtilisation.maxIopSyncTicks, syncTicks);
+
+	if(IsIopDecoupled())
+	{
+		for(uint32 i = 0; i < m_iopSyncStepCount; i++)
+		{
+			StepIopThread();
+		}
+		m_iopSyncStepCount = 1;
+		m_scheduler.ScheduleNext(m_iopSyncEvent, m_eeTickStep);
+		return;
+	}
+
+	m_iopExecutionTicks += m_iopTickStep * m_iopSyncStepCount;
+	UpdateIop();
+
+	m_iopSyncStepCount = ComputeIopSyncStepCount();
+	m_scheduler.ScheduleNext(m_iopSyncEvent, m_eeTickStep * m_iopSyncStepCount);
+}
+
+uint32 CPS2VM::ComputeIopSyncStepCount()
+{
+	if(!m_adaptiveSync) return 1;
+
+	//Go back to syncing every step as soon as the processors talk to each other or the IOP
+	//needs to service an interrupt, grow the step count again while they stay quiet
+	uint32 sifTransferCount = m_ee->m_sif.GetTransferCount();
+	bool communicating = (sifTransferCount != m_lastSifTransferCount) || m_iop->m_intc.HasPendingInterrupt();
+	m_lastSifTransferCount = sifTransferCount;
+	if(communicating)
+	{
+		m_adaptiveSyncStepCount = 1;
+	}
+	else
+	{
+		bool bothIdle = m_ee->IsCpuIdle() && m_iop->IsCpuIdle();
+		uint32 maxStepCount = bothIdle ? ADAPTIVE_IDLE_MAX_SYNC_STEP_COUNT : ADAPTIVE_BUSY_MAX_SYNC_STEP_COUNT;
+		m_adaptiveSyncStepCount = std::min<uint32>(m_adaptiveSyncStepCount * 2, maxStepCount);
+	}
+	//Don't step past the next scheduled event, it would be serviced late
+	int64 stepCountUntilEvent = m_scheduler.GetTicksUntilNextEvent() / m_eeTickStep;
+	return static_cast<uint32>(std::clamp<int64>(stepCountUntilEvent, 1, m_adaptiveSyncStepCount));
+}
+
+void CPS2VM::OnSpuUpdateEvent()
+{
+	//When decoupled, the IOP thread renders SPU blocks on its own
+	if(!IsIopDecoupled() && (m_spuUpdateTicks <= 0))
+	{
+		UpdateSpu();
+		m_spuUpdateTicks += m_spuUpdateTicksTotal;
+	}
+	ScheduleSpuUpdate();
+}
+
+void CPS2VM::ScheduleSpuUpdate()
+{
+	int64 updateTicks = IsIopDecoupled() ? m_spuUpdateTicksTotal : m_spuUpdateTicks;
+	int64 ticks = (updateTicks + (1LL << SPU_UPDATE_TICKS_PRECISION) - 1) >> SPU_UPDATE_TICKS_PRECISION;
+	//m_spuUpdateTicks keeps counting down past the deadline, rendering late doesn't cause drift
+	m_scheduler.Schedule(m_spuUpdateEvent, AlignToSyncStep(std::max<int64>(ticks, 1)));
+}
+
+void CPS2VM::OnHBlankEvent()
+{
+	if(m_ee->m_gs)
+	{
+		m_ee->m_gs->SetHBlank();
+	}
+	ScheduleHBlank(m_hblankTicksTotal - m_hblankLateTicks);
+}
+
+//Remembers how late the event is compared to its exact deadline to avoid drifting
+void CPS2VM::ScheduleHBlank(int64 ticks)
+{
+	int64 alignedTicks = AlignToSyncStep(ticks);
+	m_hblankLateTicks = alignedTicks - ticks;
+	m_scheduler.Schedule(m_hblankEvent, alignedTicks);
+}
+
+//Hblank and SPU updates don't need exact timing. Pushing their deadlines to the next IOP
+//sync step boundary keeps them from splitting EE slices in between sync points.
+int64 CPS2VM::AlignToSyncStep(int64 ticks) const
+{
+	if(!m_scheduler.IsScheduled(m_iopSyncEvent)) return ticks;
+	//Boundaries are m_eeTickStep apart, starting from the next sync point
+	int64 boundaryTicks = m_scheduler.GetTicksUntil(m_iopSyncEvent);
+	if(boundaryTicks < ticks)
+	{
+		boundaryTicks += ((ticks - boundaryTicks + m_eeTickStep - 1) / m_eeTickStep) * m_eeTickStep;
+	}
+	if(boundaryTicks <= 0)
+	{
+		boundaryTicks += m_eeTickStep;
+	}
+	return boundaryTicks;
+}
+
+void CPS2VM::OnVBlankEvent()
+{
+	m_inVblank = !m_inVblank;
+	if(m_inVblank)
+	{
+		m_scheduler.ScheduleNext(m_vblankEvent, m_vblankTicksTotal);
+		m_ee->NotifyVBlankStart();
+		{
+			auto iopLock = LockIop();
+			m_iop->NotifyVBlankStart();
+		}
+
+		if(m_ee->m_gs != NULL)
+		{
+#ifdef PROFILE
+			CProfilerZone profilerZone(m_gsSyncProfilerZone);
+#endif
+			m_ee->m_gs->SetVBlank();
+		}
+
+		//Pad listeners and frame statistics reach IOP state
+		auto iopLock = LockIop();
+		if(m_replayReader)
+		{
+			ReplayFrameInput();
+		}
+		else if(m_pad != NULL)
+		{
+			m_pad->Update(m_ee->m_ram);
+		}
+		if(m_replayWriter)
+		{
+			m_replayWriter->WriteFrameEnd();
+		}
+#ifdef PROFILE
+		//Finish up profile
+		CProfiler::GetInstance().CountCurrentZone();
+#endif
+		OnNewFrame();
+#ifdef PROFILE
+		CProfiler::GetInstance().Reset();
+#endif
+		m_cpuUtilisation = CPU_UTILISATION_INFO();
+		m_ee->m_EE.m_executor->ResetBlockCompileStats();
+		m_iop->m_cpu.m_executor->ResetBlockCompileStats();
+		if(m_ee->m_gs != NULL)
+		{
+			m_ee->m_gs->ResetReadbackStats();
+		}
+	}
+	else
+	{
+		m_scheduler.ScheduleNext(m_vblankEvent, m_onScreenTicksTotal);
+		m_ee->NotifyVBlankEnd();
+		{
+			auto iopLock = LockIop();
+			m_iop->NotifyVBlankEnd();
+		}
+		if(m_ee->m_gs != NULL)
+		{
+			m_ee->m_gs->ResetVBlank();
+		}
+		if(m_audioClockPacing)
+		{
+			//Sound output is the master clock: slow down frames if the queue is filling up, speed up if it's draining
+			float adjust = std::clamp<float>(GetSoundQueueDepthError() * AUDIOCLOCK_FRAME_GAIN, -AUDIOCLOCK_FRAME_MAX_ADJUST, AUDIOCLOCK_FRAME_MAX_ADJUST);
+			m_frameLimiter.SetFrameDurationScale(1.0f + adjust);
+		}
+		m_frameLimiter.EndFrame();
+		m_frameLimiter.BeginFrame();
+	}
+}
+
+void CPS2VM::StartIopThread()
+{
+	//The debugger needs to break and step the IOP along with the EE
+#if !defined(DEBUGGER_INCLUDED) && !defined(__EMSCRIPTEN__)
+	if(!CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_IOP_THREADED)) return;
+
+	int maxSkew = CAppConfig::GetInstance().GetPreferenceInteger(PREF_PS2_IOP_MAXSKEW);
+	m_iopMaxSkewSteps = std::max<uint32>(maxSkew / m_eeTickStep, 1);
+	m_eeStepCount = 0;
+	m_iopStepCount = 0;
+	m_iopThreadEnd = false;
+	m_iopThread = std::thread([this]() { IopThread(); });
+	Framework::ThreadUtils::SetThreadName(m_iopThread, IOP_THREAD_NAME);
+	m_ee->SetIopMutex(&m_iopMutex);
+	m_iopThreaded = true;
+#endif
+}
+
+void CPS2VM::StopIopThread()
+{
+	if(!m_iopThreaded) return;
+	{
+		std::lock_guard<std::mutex> stepLock(m_iopStepMutex);
+		m_iopThreadEnd = true;
+	}
+	m_iopStepCondition.notify_all();
+	m_iopThread.join();
+	m_ee->SetIopMutex(nullptr);
+	m_iopThreaded = false;
+}
+
+void CPS2VM::IopThread()
+{
+	fesetround(FE_TOWARDZERO);
+	FpUtils::SetDenormalHandlingMode();
+	while(1)
+	{
+		{
+			std::unique_lock<std::mutex> stepLock(m_iopStepMutex);
+			m_iopStepCondition.wait(stepLock, [this]() { return m_iopThreadEnd || (m_iopStepCount != m_eeStepCount); });
+			if(m_iopThreadEnd) break;
+		}
+
+		//EE side code only gets in between steps
+		{
+			std::lock_guard<std::recursive_mutex> iopLock(m_iopMutex);
+			m_iopExecutionTicks += m_iopTickStep;
+			ExecuteIop();
+
+			m_spuUpdateTicks -= (static_cast<int64>(m_eeTickStep) << SPU_UPDATE_TICKS_PRECISION);
+			if(m_spuUpdateTicks <= 0)
+			{
+				RenderSpu();
+				m_spuUpdateTicks += m_spuUpdateTicksTotal;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> stepLock(m_iopStepMutex);
+			m_iopStepCount++;
+		}
+		m_iopStepCondition.notify_all();
+	}
+}
+
+//Lets the IOP thread run the step the EE just went through, waits if the IOP is too far behind
+void CPS2VM::StepIopThread()
+{
+	std::unique_lock<std::mutex> stepLock(m_iopStepMutex);
+	m_eeStepCount++;
+	m_iopStepCondition.notify_all();
+	m_iopStepCondition.wait(stepLock, [this]() { return (m_eeStepCount - m_iopStepCount) <= m_iopMaxSkewSteps; });
+}
+
+//Waits for the IOP thread to catch up with the EE
+void CPS2VM::SyncIopThread()
+{
+	if(!m_iopThreaded) return;
+	std::unique_lock<std::mutex> stepLock(m_iopStepMutex);
+	m_iopStepCondition.wait(stepLock, [this]() { return m_iopStepCount == m_eeStepCount; });
+}
+
+bool CPS2VM::IsIopDecoupled() const
+{
+	return m_iopThreaded && !m_iopLockstep;
+}
+
+std::unique_lock<std::recursive_mutex> CPS2VM::LockIop()
+{
+	if(!m_iopThreaded) return std::unique_lock<std::recursive_mutex>();
+	return std::unique_lock<std::recursive_mutex>(m_iopMutex);
+}
+
 void CPS2VM::CDROM0_SyncPath()
 {
 	//TODO: Check if there's an m_cdrom0 already
@@ -812,7 +1346,7 @@ void CPS2VM::CDROM0_SyncPath()
 
 	CDROM0_Reset();
 
-	auto path = CAppConfig::GetInstance().GetPreferencePath(PREF_PS2_CDROM0_PATH);
+	auto path = m_cdrom0PathOverride.empty() ? CAppConfig::GetInstance().GetPreferencePath(PREF_PS2_CDROM0_PATH) : m_cdrom0PathOverride;
 	if(!path.empty())
 	{
 		try
@@ -827,6 +1361,11 @@ void CPS2VM::CDROM0_SyncPath()
 	}
 }
 
+void CPS2VM::CDROM0_SetPathOverride(const fs::path& path)
+{
+	m_cdrom0PathOverride = path;
+}
+
 void CPS2VM::CDROM0_Reset()
 {
 	SetIopOpticalMedia(nullptr);
@@ -844,14 +1383,107 @@ void CPS2VM::SetIopOpticalMedia(COpticalMedia* opticalMedia)
 
 void CPS2VM::RegisterModulesInPadHandler()
 {
-	if(m_pad == nullptr) return;
-
 	auto iopOs = dynamic_cast<CIopBios*>(m_iop->m_bios.get());
 	assert(iopOs);
 
+	//Replayed input goes through the relay, recorded input too
+	m_padRelay.RemoveAllListeners();
+	m_padRelay.InsertListener(iopOs->GetPadman());
+	m_padRelay.InsertListener(&m_iop->m_sio2);
+
+	if(m_pad == nullptr) return;
+
 	m_pad->RemoveAllListeners();
-	m_pad->InsertListener(iopOs->GetPadman());
-	m_pad->InsertListener(&m_iop->m_sio2);
+	if(m_replayWriter)
+	{
+		m_pad->InsertListener(&m_padRelay);
+	}
+	else
+	{
+		m_pad->InsertListener(iopOs->GetPadman());
+		m_pad->InsertListener(&m_iop->m_sio2);
+	}
+}
+
+void CPS2VM::StopRecordingOrReplayImpl()
+{
+	if(!m_replayWriter && !m_replayReader) return;
+	auto iopLock = LockIop();
+	m_replayWriter.reset();
+	m_replayReader.reset();
+	m_replaying = false;
+	m_iopLockstep = m_replaySavedIopLockstep;
+	m_padRelay.SetWriter(nullptr);
+	RegisterModulesInPadHandler();
+}
+
+void CPS2VM::ReplayFrameInput()
+{
+	while(!m_replayReader->IsEnd())
+	{
+		auto event = m_replayReader->PeekEvent();
+		m_replayReader->SkipEvent();
+		switch(event.type)
+		{
+		case ReplayLog::EVENT_FRAME_END:
+			return;
+		case ReplayLog::EVENT_PAD_BUTTON:
+			m_padRelay.SetButtonState(event.pad, static_cast<PS2::CControllerInfo::BUTTON>(event.button), event.value != 0, m_ee->m_ram);
+			break;
+		case ReplayLog::EVENT_PAD_AXIS:
+			m_padRelay.SetAxisState(event.pad, static_cast<PS2::CControllerInfo::BUTTON>(event.button), event.value, m_ee->m_ram);
+			break;
+		default:
+			//Host event recorded in this frame that wasn't asked for
+			m_replayDivergenceCount++;
+			break;
+		}
+	}
+	//End of log, go back to live input
+	StopRecordingOrReplayImpl();
+}
+
+time_t CPS2VM::GetHostTime()
+{
+	if(m_replayReader)
+	{
+		if(!m_replayReader->IsEnd() && (m_replayReader->PeekEvent().type == ReplayLog::EVENT_HOST_TIME))
+		{
+			auto recordedTime = static_cast<time_t>(m_replayReader->PeekEvent().data);
+			m_replayReader->SkipEvent();
+			return recordedTime;
+		}
+		m_replayDivergenceCount++;
+	}
+	auto currentTime = time(nullptr);
+	if(m_replayWriter)
+	{
+		m_replayWriter->WriteHostTime(currentTime);
+	}
+	return currentTime;
+}
+
+void CPS2VM::OnCdvdCommandCompleted(uint32 command)
+{
+	if(m_replayWriter)
+	{
+		m_replayWriter->WriteCdvdCommandCompleted(command);
+	}
+	if(m_replayReader)
+	{
+		//Completions are deterministic when the IOP runs in lockstep, they only serve to detect divergence
+		bool matches = !m_replayReader->IsEnd() &&
+		               (m_replayReader->PeekEvent().type == ReplayLog::EVENT_CDVD_COMMAND_COMPLETED) &&
+		               (m_replayReader->PeekEvent().data == command);
+		if(matches)
+		{
+			m_replayReader->SkipEvent();
+		}
+		else
+		{
+			m_replayDivergenceCount++;
+		}
+	}
 }
 
 void CPS2VM::ReloadExecutable(const char* executablePath, const CPS2OS::ArgumentList& arguments)
@@ -880,6 +1512,38 @@ void CPS2VM::OnCrtModeChange()
 	ReloadFrameRateLimit();
 }
 
+void CPS2VM::OnExecutableChange()
+{
+	AttachBlockCodeCaches();
+}
+
+void CPS2VM::AttachBlockCodeCaches()
+{
+	std::shared_ptr<CBlockCodeCache> eeCache, vu0Cache, vu1Cache, iopCache;
+#ifdef BLOCK_CODE_CACHE_SUPPORTED
+	if(CAppConfig::GetInstance().GetPreferenceBoolean(PREF_PS2_JIT_BLOCKCODECACHE))
+	{
+		auto cachePath = CBlockCodeCache::GetCacheDirectoryPath();
+		std::string executableName = m_ee->m_os->GetExecutableName();
+		//Each combination of settings gets its own file, switching settings back and forth doesn't discard caches
+		auto makeCache =
+		    [&](const char* unitName, const CMIPS& context) {
+			    uint32 codeGenOptions = CBlockCodeCache::GetCodeGenOptions(context);
+			    auto cacheFileName = string_format("%s.%s.%02x.jitcache", executableName.c_str(), unitName, codeGenOptions);
+			    return std::make_shared<CBlockCodeCache>(cachePath / fs::path(cacheFileName), codeGenOptions);
+		    };
+		eeCache = makeCache("ee", m_ee->m_EE);
+		vu0Cache = makeCache("vu0", m_ee->m_VU0);
+		vu1Cache = makeCache("vu1", m_ee->m_VU1);
+		iopCache = makeCache("iop", m_iop->m_cpu);
+	}
+#endif
+	m_ee->m_EE.m_executor->SetBlockCodeCache(std::move(eeCache));
+	m_ee->m_VU0.m_executor->SetBlockCodeCache(std::move(vu0Cache));
+	m_ee->m_VU1.m_executor->SetBlockCodeCache(std::move(vu1Cache));
+	m_iop->m_cpu.m_executor->SetBlockCodeCache(std::move(iopCache));
+}
+
 void CPS2VM::EmuThread()
 {
 	CreateVM();
@@ -894,12 +1558,19 @@ void CPS2VM::EmuThread()
 	CProfilerZone profilerZone(m_otherProfilerZone);
 #endif
 	static_cast<CEeExecutor*>(m_ee->m_EE.m_executor.get())->AddExceptionHandler();
+	StartIopThread();
 	m_frameLimiter.BeginFrame();
 	while(1)
 	{
-		while(m_mailBox.IsPending())
+		if(m_mailBox.IsPending())
 		{
-			m_mailBox.ReceiveCall();
+			//Calls can look at or change IOP state, make sure it's at the same point as the EE
+			SyncIopThread();
+			auto iopLock = LockIop();
+			while(m_mailBox.IsPending())
+			{
+				m_mailBox.ReceiveCall();
+			}
 		}
 		if(m_nEnd) break;
 		if(m_nStatus == PAUSED)
@@ -908,73 +1579,21 @@ void CPS2VM::EmuThread()
 		}
 		if(m_nStatus == RUNNING)
 		{
-			if(m_spuUpdateTicks <= 0)
+#ifdef DEBUGGER_INCLUDED
+			if(m_singleStepIop)
 			{
-				UpdateSpu();
-				m_spuUpdateTicks += m_spuUpdateTicksTotal;
+				//Step the IOP right away instead of waiting for the next sync
+				m_iopExecutionTicks = std::max(m_iopExecutionTicks, 1);
+				UpdateIop();
 			}
-
-			{
-				if(m_hblankTicks <= 0)
-				{
-					if(m_ee->m_gs)
-					{
-						m_ee->m_gs->SetHBlank();
-						m_hblankTicks += m_hblankTicksTotal;
-					}
-				}
-
-				//Check vblank stuff
-				if(m_vblankTicks <= 0)
-				{
-					m_inVblank = !m_inVblank;
-					if(m_inVblank)
-					{
-						m_vblankTicks += m_vblankTicksTotal;
-						m_ee->NotifyVBlankStart();
-						m_iop->NotifyVBlankStart();
-
-						if(m_ee->m_gs != NULL)
-						{
-#ifdef PROFILE
-							CProfilerZone profilerZone(m_gsSyncProfilerZone);
+			else
 #endif
-							m_ee->m_gs->SetVBlank();
-						}
-
-						if(m_pad != NULL)
-						{
-							m_pad->Update(m_ee->m_ram);
-						}
-#ifdef PROFILE
-						//Finish up profile
-						CProfiler::GetInstance().CountCurrentZone();
-#endif
-						OnNewFrame();
-#ifdef PROFILE
-						CProfiler::GetInstance().Reset();
-#endif
-						m_cpuUtilisation = CPU_UTILISATION_INFO();
-					}
-					else
-					{
-						m_vblankTicks += m_onScreenTicksTotal;
-						m_ee->NotifyVBlankEnd();
-						m_iop->NotifyVBlankEnd();
-						if(m_ee->m_gs != NULL)
-						{
-							m_ee->m_gs->ResetVBlank();
-						}
-						m_frameLimiter.EndFrame();
-						m_frameLimiter.BeginFrame();
-					}
-				}
-
-				m_eeExecutionTicks += m_eeTickStep;
-				m_iopExecutionTicks += m_iopTickStep;
-
+			{
+				//Run the EE exactly until the next event is due
+				m_eeExecutionTicks = static_cast<int>(m_scheduler.GetTicksUntilNextEvent());
+				m_cpuUtilisation.sliceCount++;
 				UpdateEe();
-				UpdateIop();
+				m_cpuUtilisation.eventCount += m_scheduler.DispatchDueEvents();
 			}
 #ifdef DEBUGGER_INCLUDED
 			if(
@@ -994,6 +1613,7 @@ void CPS2VM::EmuThread()
 #endif
 		}
 	}
+	StopIopThread();
 	static_cast<CEeExecutor*>(m_ee->m_EE.m_executor.get())->RemoveExceptionHandler();
 #ifdef __ANDROID__
 	Framework::CJavaVM::DetachCurrentThread();
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
 #include <thread>
 #include <future>
 #include "filesystem_def.h"
@@ -10,10 +14,13 @@
 #include "ScreenPositionListener.h"
 #include "OpticalMedia.h"
 #include "VirtualMachine.h"
+#include "EventScheduler.h"
+#include "ReplayLog.h"
 #include "ee/Ee_SubSystem.h"
 #include "iop/Iop_SubSystem.h"
 #include "../tools/PsfPlayer/Source/SoundHandler.h"
 #include "FrameLimiter.h"
+#include "AudioResampler.h"
 #include "Profiler.h"
 
 class CPS2VM : public CVirtualMachine
@@ -26,6 +33,14 @@ public:
 
 		int32 iopTotalTicks = 0;
 		int32 iopIdleTicks = 0;
+
+		int32 sliceCount = 0;    //Times the EE ran until the next scheduled event
+		int32 tickStepCount = 0; //Times a loop polling every EE tick step would have run
+		int32 eventCount = 0;
+
+		int32 iopSyncCount = 0;    //Times the IOP was brought up to date with the EE
+		int32 iopSyncTicks = 0;    //EE ticks covered by those
+		int32 maxIopSyncTicks = 0;
 	};
 
 	typedef std::unique_ptr<COpticalMedia> OpticalMediaPtr;
@@ -67,10 +82,32 @@ public:
 
 	void CDROM0_SyncPath();
 	void CDROM0_Reset();
+	//Mounts the given path instead of the one from preferences, allows VMs in the same process to use different discs
+	void CDROM0_SetPathOverride(const fs::path&);
 
 	void SetEeFrequencyScale(uint32, uint32);
+	//Adaptive sync lets the IOP catch up less often while processors don't communicate
+	void SetAdaptiveSync(bool);
 	void ReloadFrameRateLimit();
 
+	//When the IOP runs on its own thread, lockstep mode makes it run in step with the EE again
+	//to get deterministic results (ie.: when recording or replaying input)
+	void SetIopLockstep(bool);
+
+	//Turbo mode runs unthrottled, sound output is decimated (1 sample out of N is kept, 0 drops everything)
+	void SetTurboMode(bool);
+	bool GetTurboMode() const;
+	void SetTurboSoundDecimation(uint32);
+	void SetPresentationSkip(uint32, uint32);
+
+	//Recording captures what the machine gets from the host (pad input, clock) along with disc command completions,
+	//replaying feeds it back. IOP runs in lockstep meanwhile, start right after a reset or a state load for identical runs.
+	void StartRecording(const fs::path&);
+	void StartReplay(const fs::path&);
+	void StopRecordingOrReplay();
+	bool IsReplaying() const;
+	uint32 GetReplayDivergenceCount() const;
+
 	static fs::path GetStateDirectoryPath();
 	fs::path GenerateStatePath(unsigned int) const;
 
@@ -78,6 +115,12 @@ public:
 	std::future<bool> LoadState(const fs::path&);
 
 	CPU_UTILISATION_INFO GetCpuUtilisationInfo() const;
+	CMipsExecutor::BLOCK_COMPILE_STATS GetBlockCompileStats() const;
+
+	//Time between the last two frames, in microseconds
+	uint32 GetLastFrameDuration() const;
+	//Duration of a frame when running at full speed, in microseconds
+	uint32 GetNominalFrameDuration() const;
 
 #ifdef DEBUGGER_INCLUDED
 	fs::path MakeDebugTagsPackagePath(const char*);
@@ -124,6 +167,9 @@ private:
 
 	void ReloadExecutable(const char*, const CPS2OS::ArgumentList&);
 	void OnCrtModeChange();
+	void OnExecutableChange();
+
+	void AttachBlockCodeCaches();
 
 	void PauseImpl();
 	void DestroyImpl();
@@ -142,16 +188,63 @@ private:
 	void UpdateEe();
 	void UpdateIop();
 	void UpdateSpu();
+	void ExecuteIop();
+	void RenderSpu();
+	void WriteSpuSamples();
+	float GetSoundQueueDepthError() const;
+
+	void OnIopSyncEvent();
+	uint32 ComputeIopSyncStepCount();
+	void OnSpuUpdateEvent();
+	void OnHBlankEvent();
+	void OnVBlankEvent();
+	void ScheduleSpuUpdate();
+	void ScheduleHBlank(int64);
+	int64 AlignToSyncStep(int64) const;
+
+	void StartIopThread();
+	void StopIopThread();
+	void IopThread();
+	void StepIopThread();
+	void SyncIopThread();
+	bool IsIopDecoupled() const;
+	std::unique_lock<std::recursive_mutex> LockIop();
 
 	void SetIopOpticalMedia(COpticalMedia*);
 
 	void RegisterModulesInPadHandler();
 
+	void StopRecordingOrReplayImpl();
+	void ReplayFrameInput();
+	time_t GetHostTime();
+	void OnCdvdCommandCompleted(uint32);
+
 	void EmuThread();
 
 	std::thread m_thread;
 	STATUS m_nStatus = PAUSED;
 	bool m_nEnd = false;
+	fs::path m_cdrom0PathOverride;
+
+	//IOP thread, steps are counted in m_eeTickStep EE cycles
+	std::thread m_iopThread;
+	std::recursive_mutex m_iopMutex;
+	std::mutex m_iopStepMutex;
+	std::condition_variable m_iopStepCondition;
+	uint64 m_eeStepCount = 0;
+	uint64 m_iopStepCount = 0;
+	uint32 m_iopMaxSkewSteps = 1;
+	bool m_iopThreaded = false;
+	bool m_iopThreadEnd = false;
+	bool m_iopLockstep = false;
+
+	//Record/replay state, only accessed by the EE thread or with the IOP lock held
+	std::shared_ptr<ReplayLog::CWriter> m_replayWriter;
+	std::shared_ptr<ReplayLog::CReader> m_replayReader;
+	ReplayLog::CPadRelay m_padRelay;
+	bool m_replaySavedIopLockstep = false;
+	std::atomic<bool> m_replaying = {false};
+	std::atomic<uint32> m_replayDivergenceCount = {0};
 
 	uint32 m_eeFreqScaleNumerator = 1;
 	uint32 m_eeFreqScaleDenominator = 1;
@@ -160,8 +253,6 @@ private:
 	uint32 m_hblankTicksTotal = 0;
 	uint32 m_onScreenTicksTotal = 0;
 	uint32 m_vblankTicksTotal = 0;
-	int m_hblankTicks = 0;
-	int m_vblankTicks = 0;
 	bool m_inVblank = false;
 	int64 m_spuUpdateTicks = 0;
 	int64 m_spuUpdateTicksTotal = 0;
@@ -169,7 +260,26 @@ private:
 	int m_iopExecutionTicks = 0;
 	static const int m_eeTickStep = 4800;
 	int m_iopTickStep = 0;
+	uint32 m_iopSyncStepCount = 1;
+	bool m_adaptiveSync = false;
+	uint32 m_adaptiveSyncStepCount = 1;
+	uint32 m_lastSifTransferCount = 0;
 	CFrameLimiter m_frameLimiter;
+	bool m_audioClockPacing = false;
+	uint32 m_nominalFrameDuration = 0;
+	std::atomic<bool> m_turboMode = {false};
+	std::atomic<uint32> m_turboSoundDecimation = {0};
+	uint32 m_presentationSkipCount = 0;
+	uint32 m_presentationPeriod = 0;
+
+	//Frame timing (hblank, vblank, SPU updates) and IOP sync points, all deadlines are in EE cycles.
+	//EE timers, DMA and other device delays aren't scheduled, they're counted after each slice.
+	CEventScheduler m_scheduler;
+	CEventScheduler::EventId m_iopSyncEvent = 0;
+	CEventScheduler::EventId m_spuUpdateEvent = 0;
+	CEventScheduler::EventId m_hblankEvent = 0;
+	CEventScheduler::EventId m_vblankEvent = 0;
+	int64 m_hblankLateTicks = 0;
 
 	CPU_UTILISATION_INFO m_cpuUtilisation;
 
@@ -178,6 +288,13 @@ private:
 	bool m_singleStepVu0 = false;
 	bool m_singleStepVu1 = false;
 
+	enum
+	{
+		//With adaptive sync, step count doubles every sync without communication, up to these
+		ADAPTIVE_BUSY_MAX_SYNC_STEP_COUNT = 4,
+		ADAPTIVE_IDLE_MAX_SYNC_STEP_COUNT = 16,
+	};
+
 	//SPU update parameters
 	enum
 	{
@@ -188,10 +305,21 @@ private:
 		MAX_BLOCK_COUNT = 400,
 	};
 
+	//Audio clock pacing parameters, the sound queue is kept around its target depth
+	//by resampling slightly and by adjusting the frame duration
+	static constexpr float AUDIOCLOCK_RESAMPLE_GAIN = 0.01f;
+	static constexpr float AUDIOCLOCK_RESAMPLE_MAX_ADJUST = 0.005f;
+	static constexpr float AUDIOCLOCK_FRAME_GAIN = 0.05f;
+	static constexpr float AUDIOCLOCK_FRAME_MAX_ADJUST = 0.02f;
+
 	int16 m_samples[BLOCK_SIZE * MAX_BLOCK_COUNT];
 	int m_currentSpuBlock = 0;
 	int m_spuBlockCount = 0;
 	CSoundHandler* m_soundHandler = nullptr;
+	CAudioResampler m_resampler;
+	std::vector<int16> m_resampledSamples;
+	std::atomic<int32> m_soundQueuedSampleCount = {-1};
+	std::atomic<int32> m_soundTargetSampleCount = {0};
 
 	CScreenPositionListener* m_gunListener = nullptr;
 	CScreenPositionListener* m_touchListener = nullptr;
@@ -204,4 +332,5 @@ private:
 
 	CPS2OS::RequestLoadExecutableEvent::Connection m_OnRequestLoadExecutableConnection;
 	Framework::CSignal<void()>::Connection m_OnCrtModeChangeConnection;
+	Framework::CSignal<void()>::Connection m_OnExecutableChangeConnection;
 };
@@ -13,6 +13,15 @@
 #define PREF_PS2_ARCADE_IO_SERVER_PORT ("ps2.arcade.ioserver.port")
 
 #define PREF_PS2_LIMIT_FRAMERATE ("ps2.limitframerate")
+#define PREF_PS2_FRAMEPACING_AUDIOCLOCK ("ps2.framepacing.audioclock")
+#define PREF_PS2_JIT_BLOCKCODECACHE ("ps2.jit.blockcodecache")
+#define PREF_PS2_JIT_BACKGROUNDCOMPILE ("ps2.jit.backgroundcompile")
+#define PREF_PS2_JIT_SUPERBLOCKS ("ps2.jit.superblocks")
+#define PREF_PS2_JIT_FASTMEMORY ("ps2.jit.fastmemory")
+#define PREF_PS2_VU1_THREADED ("ps2.vu1.threaded")
+#define PREF_PS2_IOP_THREADED ("ps2.iop.threaded")
+#define PREF_PS2_IOP_MAXSKEW ("ps2.iop.maxskew")
+#define PREF_PS2_SYNC_ADAPTIVE ("ps2.sync.adaptive")
 
 #define PREF_AUDIO_SPUBLOCKCOUNT ("audio.spublockcount")
 
@@ -1,5 +1,6 @@
 #include "Profiler.h"
 
+#include <algorithm>
 #include <cassert>
 
 CProfiler::CProfiler()
@@ -13,6 +14,7 @@ CProfiler::~CProfiler()
 CProfiler::ZoneHandle CProfiler::RegisterZone(const char* name)
 {
 #ifdef PROFILE
+	std::lock_guard<std::mutex> zonesLock(m_zonesMutex);
 	for(unsigned int i = 0; i < m_zones.size(); i++)
 	{
 		const auto& zone(m_zones[i]);
@@ -30,71 +32,86 @@ CProfiler::ZoneHandle CProfiler::RegisterZone(const char* name)
 
 void CProfiler::CountCurrentZone()
 {
-	assert(std::this_thread::get_id() == m_workThreadId);
-	assert(!m_zoneStack.empty());
+	auto& threadState = GetThreadState();
+	assert(!threadState.zoneStack.empty());
 
 	auto thisTime = std::chrono::high_resolution_clock::now();
 
 	{
-		auto topZoneHandle = m_zoneStack.top();
-		auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(thisTime - m_currentTime);
+		auto topZoneHandle = threadState.zoneStack.top();
+		auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(thisTime - threadState.currentTime);
 		AddTimeToZone(topZoneHandle, duration.count());
 	}
 
-	m_currentTime = thisTime;
+	threadState.currentTime = thisTime;
 }
 
 void CProfiler::EnterZone(ZoneHandle zoneHandle)
 {
-	assert(std::this_thread::get_id() == m_workThreadId);
+	auto& threadState = GetThreadState();
 
 	auto thisTime = std::chrono::high_resolution_clock::now();
 
-	if(!m_zoneStack.empty())
+	if(!threadState.zoneStack.empty())
 	{
-		auto topZoneHandle = m_zoneStack.top();
-		auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(thisTime - m_currentTime);
+		auto topZoneHandle = threadState.zoneStack.top();
+		auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(thisTime - threadState.currentTime);
 		AddTimeToZone(topZoneHandle, duration.count());
 	}
 
-	m_zoneStack.push(zoneHandle);
+	threadState.zoneStack.push(zoneHandle);
 
-	m_currentTime = thisTime;
+	threadState.currentTime = thisTime;
 }
 
 void CProfiler::ExitZone()
 {
 	CountCurrentZone();
-	m_zoneStack.pop();
+	GetThreadState().zoneStack.pop();
 }
 
 CProfiler::ZoneArray CProfiler::GetStats() const
 {
-	assert(std::this_thread::get_id() == m_workThreadId);
-	return m_zones;
+	ZoneArray result;
+	{
+		std::lock_guard<std::mutex> zonesLock(m_zonesMutex);
+		result = m_zones;
+	}
+	const auto& zoneTimes = GetThreadState().zoneTimes;
+	for(unsigned int i = 0; i < result.size(); i++)
+	{
+		result[i].totalTime = (i < zoneTimes.size()) ? zoneTimes[i] : 0;
+	}
+	return result;
 }
 
 void CProfiler::Reset()
 {
-	assert(std::this_thread::get_id() == m_workThreadId);
-	for(auto& zone : m_zones)
-	{
-		zone.totalTime = 0;
-	}
+	auto& zoneTimes = GetThreadState().zoneTimes;
+	std::fill(zoneTimes.begin(), zoneTimes.end(), 0);
 }
 
 void CProfiler::SetWorkThread()
 {
-#ifdef _DEBUG
-	m_workThreadId = std::this_thread::get_id();
-#endif
+	auto& threadState = GetThreadState();
+	threadState.zoneTimes.clear();
+	threadState.zoneStack = ZoneStack();
+}
+
+CProfiler::THREAD_STATE& CProfiler::GetThreadState()
+{
+	static thread_local THREAD_STATE threadState;
+	return threadState;
 }
 
 void CProfiler::AddTimeToZone(ZoneHandle zoneHandle, uint64 timeNs)
 {
-	assert(m_zones.size() > zoneHandle);
-	auto& zone = m_zones[zoneHandle];
-	zone.totalTime += timeNs;
+	auto& zoneTimes = GetThreadState().zoneTimes;
+	if(zoneTimes.size() <= zoneHandle)
+	{
+		zoneTimes.resize(zoneHandle + 1);
+	}
+	zoneTimes[zoneHandle] += timeNs;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <mutex>
 #include <stack>
 #include <thread>
 #include <vector>
@@ -8,6 +9,8 @@
 #include "Singleton.h"
 #include "Types.h"
 
+//Zones are registered globally, but time is accounted for each thread separately: every thread
+//(ie.: the EE thread of each virtual machine) only gets the stats of the zones it entered.
 class CProfiler : public CSingleton<CProfiler>
 {
 public:
@@ -40,15 +43,18 @@ public:
 private:
 	typedef std::stack<ZoneHandle> ZoneStack;
 
+	struct THREAD_STATE
+	{
+		std::vector<uint64> zoneTimes;
+		ZoneStack zoneStack;
+		TimePoint currentTime;
+	};
+
+	static THREAD_STATE& GetThreadState();
 	void AddTimeToZone(ZoneHandle, uint64);
 
+	mutable std::mutex m_zonesMutex;
 	ZoneArray m_zones;
-	ZoneStack m_zoneStack;
-	TimePoint m_currentTime;
-
-#ifdef _DEBUG
-	std::thread::id m_workThreadId;
-#endif
 };
 
 class CProfilerZone
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include "ReplayLog.h"
+
+using namespace ReplayLog;
+
+static const char g_replayLogMagic[8] = {'P', 'L', 'A', 'Y', 'R', 'P', 'L', 'Y'};
+static const uint32 g_replayLogVersion = 1;
+
+CWriter::CWriter(StreamPtr stream)
+    : m_stream(std::move(stream))
+{
+	m_stream->Write(g_replayLogMagic, sizeof(g_replayLogMagic));
+	m_stream->Write32(g_replayLogVersion);
+}
+
+void CWriter::WriteFrameEnd()
+{
+	EVENT event;
+	event.type = EVENT_FRAME_END;
+	WriteEvent(event);
+}
+
+void CWriter::WritePadButton(unsigned int pad, PS2::CControllerInfo::BUTTON button, bool pressed)
+{
+	EVENT event;
+	event.type = EVENT_PAD_BUTTON;
+	event.pad = static_cast<uint8>(pad);
+	event.button = static_cast<uint8>(button);
+	event.value = pressed ? 1 : 0;
+	WriteEvent(event);
+}
+
+void CWriter::WritePadAxis(unsigned int pad, PS2::CControllerInfo::BUTTON button, uint8 value)
+{
+	EVENT event;
+	event.type = EVENT_PAD_AXIS;
+	event.pad = static_cast<uint8>(pad);
+	event.button = static_cast<uint8>(button);
+	event.value = value;
+	WriteEvent(event);
+}
+
+void CWriter::WriteHostTime(int64 time)
+{
+	EVENT event;
+	event.type = EVENT_HOST_TIME;
+	event.data = static_cast<uint64>(time);
+	WriteEvent(event);
+}
+
+void CWriter::WriteCdvdCommandCompleted(uint32 command)
+{
+	EVENT event;
+	event.type = EVENT_CDVD_COMMAND_COMPLETED;
+	event.data = command;
+	WriteEvent(event);
+}
+
+void CWriter::WriteEvent(const EVENT& event)
+{
+	m_stream->Write8(event.type);
+	switch(event.type)
+	{
+	case EVENT_PAD_BUTTON:
+	case EVENT_PAD_AXIS:
+		m_stream->Write8(event.pad);
+		m_stream->Write8(event.button);
+		m_stream->Write8(event.value);
+		break;
+	case EVENT_HOST_TIME:
+	case EVENT_CDVD_COMMAND_COMPLETED:
+		m_stream->Write64(event.data);
+		break;
+	default:
+		break;
+	}
+}
+
+CReader::CReader(StreamPtr stream)
+    : m_stream(std::move(stream))
+{
+	char magic[sizeof(g_replayLogMagic)] = {};
+	m_stream->Read(magic, sizeof(magic));
+	if(memcmp(magic, g_replayLogMagic, sizeof(magic)) != 0)
+	{
+		throw std::runtime_error("Invalid replay log.");
+	}
+	uint32 version = m_stream->Read32();
+	if(version != g_replayLogVersion)
+	{
+		throw std::runtime_error("Unsupported replay log version.");
+	}
+	ReadNextEvent();
+}
+
+bool CReader::IsEnd()
+{
+	return !m_hasNextEvent;
+}
+
+const EVENT& CReader::PeekEvent()
+{
+	assert(m_hasNextEvent);
+	return m_nextEvent;
+}
+
+void CReader::SkipEvent()
+{
+	ReadNextEvent();
+}
+
+void CReader::ReadNextEvent()
+{
+	m_hasNextEvent = false;
+	uint8 type = 0;
+	if(m_stream->Read(&type, 1) != 1) return;
+	EVENT event;
+	event.type = static_cast<EVENT_TYPE>(type);
+	switch(event.type)
+	{
+	case EVENT_FRAME_END:
+		break;
+	case EVENT_PAD_BUTTON:
+	case EVENT_PAD_AXIS:
+		event.pad = m_stream->Read8();
+		event.button = m_stream->Read8();
+		event.value = m_stream->Read8();
+		break;
+	case EVENT_HOST_TIME:
+	case EVENT_CDVD_COMMAND_COMPLETED:
+		event.data = m_stream->Read64();
+		break;
+	default:
+		throw std::runtime_error("Invalid replay log event.");
+	}
+	m_nextEvent = event;
+	m_hasNextEvent = true;
+}
+
+void CPadRelay::InsertListener(CPadInterface* listener)
+{
+	m_listeners.push_back(listener);
+}
+
+void CPadRelay::RemoveAllListeners()
+{
+	m_listeners.clear();
+}
+
+void CPadRelay::SetWriter(CWriter* writer)
+{
+	m_writer = writer;
+}
+
+void CPadRelay::SetButtonState(unsigned int pad, PS2::CControllerInfo::BUTTON button, bool pressed, uint8* ram)
+{
+	if(m_writer)
+	{
+		m_writer->WritePadButton(pad, button, pressed);
+	}
+	for(auto* listener : m_listeners)
+	{
+		listener->SetButtonState(pad, button, pressed, ram);
+	}
+}
+
+void CPadRelay::SetAxisState(unsigned int pad, PS2::CControllerInfo::BUTTON button, uint8 value, uint8* ram)
+{
+	if(m_writer)
+	{
+		m_writer->WritePadAxis(pad, button, value);
+	}
+	for(auto* listener : m_listeners)
+	{
+		listener->SetAxisState(pad, button, value, ram);
+	}
+}
+
+void CPadRelay::GetVibration(unsigned int pad, uint8& largeMotor, uint8& smallMotor)
+{
+	largeMotor = 0;
+	smallMotor = 0;
+	for(auto* listener : m_listeners)
+	{
+		uint8 listenerLargeMotor = 0;
+		uint8 listenerSmallMotor = 0;
+		listener->GetVibration(pad, listenerLargeMotor, listenerSmallMotor);
+		largeMotor = std::max(largeMotor, listenerLargeMotor);
+		smallMotor = std::max(smallMotor, listenerSmallMotor);
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include "Types.h"
+#include "Stream.h"
+#include "PadInterface.h"
+
+//Replay logs hold everything a session gets from outside of the emulated machine, in the
+//order it was received. Pad input is recorded every vblank, along with values that depend
+//on the host (ie.: clock) and disc command completions, which are used to detect divergence.
+namespace ReplayLog
+{
+	enum EVENT_TYPE : uint8
+	{
+		EVENT_FRAME_END,
+		EVENT_PAD_BUTTON,
+		EVENT_PAD_AXIS,
+		EVENT_HOST_TIME,
+		EVENT_CDVD_COMMAND_COMPLETED,
+	};
+
+	struct EVENT
+	{
+		EVENT_TYPE type = EVENT_FRAME_END;
+		uint8 pad = 0;
+		uint8 button = 0;
+		uint8 value = 0;
+		uint64 data = 0;
+	};
+
+	typedef std::unique_ptr<Framework::CStream> StreamPtr;
+
+	class CWriter
+	{
+	public:
+		CWriter(StreamPtr);
+
+		void WriteFrameEnd();
+		void WritePadButton(unsigned int, PS2::CControllerInfo::BUTTON, bool);
+		void WritePadAxis(unsigned int, PS2::CControllerInfo::BUTTON, uint8);
+		void WriteHostTime(int64);
+		void WriteCdvdCommandCompleted(uint32);
+
+	private:
+		void WriteEvent(const EVENT&);
+
+		StreamPtr m_stream;
+	};
+
+	class CReader
+	{
+	public:
+		CReader(StreamPtr);
+
+		bool IsEnd();
+		const EVENT& PeekEvent();
+		void SkipEvent();
+
+	private:
+		void ReadNextEvent();
+
+		StreamPtr m_stream;
+		EVENT m_nextEvent;
+		bool m_hasNextEvent = false;
+	};
+
+	//Sits between the pad handler and the modules it reports to, records what goes through when a writer is set
+	class CPadRelay : public CPadInterface
+	{
+	public:
+		void InsertListener(CPadInterface*);
+		void RemoveAllListeners();
+		void SetWriter(CWriter*);
+
+		void SetButtonState(unsigned int, PS2::CControllerInfo::BUTTON, bool, uint8*) override;
+		void SetAxisState(unsigned int, PS2::CControllerInfo::BUTTON, uint8, uint8*) override;
+		void GetVibration(unsigned int, uint8& largeMotor, uint8& smallMotor) override;
+
+	private:
+		typedef std::list<CPadInterface*> ListenerList;
+
+		ListenerList m_listeners;
+		CWriter* m_writer = nullptr;
+	};
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cassert>
+#include "SpscMailBox.h"
+
+CSpscMailBox::~CSpscMailBox()
+{
+	while(auto call = m_fastCalls.GetReadSlot())
+	{
+		call->destroy(call->storage);
+		m_fastCalls.CommitRead();
+	}
+}
+
+bool CSpscMailBox::IsPending() const
+{
+	return (m_fastCallSendCount.load() != m_fastCallReceiveCount) || (m_callCount.load() != 0);
+}
+
+void CSpscMailBox::WaitForCall()
+{
+	std::unique_lock<std::mutex> callLock(m_callMutex);
+	m_receiverWaiting = true;
+	while(!IsPending())
+	{
+		m_waitCondition.wait(callLock);
+	}
+	m_receiverWaiting = false;
+}
+
+void CSpscMailBox::WaitForCall(unsigned int timeOut)
+{
+	std::unique_lock<std::mutex> callLock(m_callMutex);
+	if(IsPending()) return;
+	m_receiverWaiting = true;
+	if(!IsPending())
+	{
+		m_waitCondition.wait_for(callLock, std::chrono::milliseconds(timeOut));
+	}
+	m_receiverWaiting = false;
+}
+
+void CSpscMailBox::FlushCalls()
+{
+	SendCall([]() {}, true);
+}
+
+void CSpscMailBox::SendCall(const FunctionType& function, bool waitForCompletion)
+{
+	std::future<void> future;
+	{
+		std::lock_guard<std::mutex> callLock(m_callMutex);
+		MESSAGE message;
+		message.function = function;
+		message.fastCallSendCount = m_fastCallSendCount.load();
+
+		if(waitForCompletion)
+		{
+			message.promise = std::make_unique<std::promise<void>>();
+			future = message.promise->get_future();
+		}
+
+		m_calls.push_back(std::move(message));
+		m_callCount++;
+	}
+
+	m_waitCondition.notify_all();
+
+	if(waitForCompletion)
+	{
+		future.wait();
+	}
+}
+
+void CSpscMailBox::SendCall(FunctionType&& function)
+{
+	{
+		std::lock_guard<std::mutex> callLock(m_callMutex);
+		MESSAGE message;
+		message.function = std::move(function);
+		message.fastCallSendCount = m_fastCallSendCount.load();
+		m_calls.push_back(std::move(message));
+		m_callCount++;
+	}
+
+	m_waitCondition.notify_all();
+}
+
+void CSpscMailBox::ReceiveCall()
+{
+	//Fast calls sent after this point can't go before a call that's already in the locked queue
+	uint32 fastCallCount = m_fastCallSendCount.load() - m_fastCallReceiveCount;
+	if(m_callCount.load() != 0)
+	{
+		std::lock_guard<std::mutex> callLock(m_callMutex);
+		assert(!m_calls.empty());
+		int32 fastCallsBefore = static_cast<int32>(m_calls.front().fastCallSendCount - m_fastCallReceiveCount);
+		fastCallCount = std::min<uint32>(fastCallCount, std::max<int32>(fastCallsBefore, 0));
+	}
+
+	if(fastCallCount != 0)
+	{
+		auto call = m_fastCalls.GetReadSlot();
+		assert(call);
+		call->invoke(call->storage);
+		m_fastCalls.CommitRead();
+		m_fastCallReceiveCount++;
+		return;
+	}
+
+	MESSAGE message;
+	{
+		std::lock_guard<std::mutex> callLock(m_callMutex);
+		if(m_calls.empty()) return;
+		message = std::move(m_calls.front());
+		m_calls.pop_front();
+		m_callCount--;
+	}
+	message.function();
+	if(message.promise)
+	{
+		message.promise->set_value();
+	}
+}
+
+void CSpscMailBox::WakeReceiver()
+{
+	//Only take the lock if the receiver is about to sleep or sleeping
+	if(!m_receiverWaiting.load()) return;
+	std::lock_guard<std::mutex> callLock(m_callMutex);
+	m_waitCondition.notify_all();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include "Types.h"
+#include "SpscQueue.h"
+
+//Mailbox with a lock-free lane for calls sent by a single producer thread: those are stored in
+//place in a ring buffer and don't need any allocation or lock to go through. Other calls use
+//a locked queue and can be sent from any thread. Calls sent by the producer thread are received
+//in the order they were sent, whichever lane they went through.
+class CSpscMailBox
+{
+public:
+	typedef std::function<void()> FunctionType;
+
+	enum
+	{
+		FAST_CALL_STORAGE_SIZE = 48,
+		FAST_CALL_QUEUE_SIZE = 0x400,
+	};
+
+	CSpscMailBox() = default;
+	virtual ~CSpscMailBox();
+
+	CSpscMailBox(const CSpscMailBox&) = delete;
+	CSpscMailBox& operator=(const CSpscMailBox&) = delete;
+
+	void SendCall(const FunctionType&, bool = false);
+	void SendCall(FunctionType&&);
+	void FlushCalls();
+
+	//Must always be called from the same thread
+	template <typename CallableType>
+	void SendFastCall(CallableType&& callable)
+	{
+		typedef typename std::decay<CallableType>::type StoredType;
+		static_assert(sizeof(StoredType) <= FAST_CALL_STORAGE_SIZE, "Callable doesn't fit in fast call storage.");
+		static_assert(alignof(StoredType) <= alignof(std::max_align_t), "Callable alignment is too large for fast call storage.");
+
+		auto call = m_fastCalls.GetWriteSlot();
+		if(!call)
+		{
+			//Ring is full (ie.: calls are only received once per frame), use the locked queue
+			SendCall(FunctionType(std::forward<CallableType>(callable)));
+			return;
+		}
+
+		new(call->storage) StoredType(std::forward<CallableType>(callable));
+		call->invoke =
+		    [](void* storage) {
+			    auto callable = reinterpret_cast<StoredType*>(storage);
+			    (*callable)();
+			    callable->~StoredType();
+		    };
+		call->destroy =
+		    [](void* storage) {
+			    reinterpret_cast<StoredType*>(storage)->~StoredType();
+		    };
+		m_fastCalls.CommitWrite();
+		m_fastCallSendCount.fetch_add(1);
+		WakeReceiver();
+	}
+
+	bool IsPending() const;
+	void ReceiveCall();
+	void WaitForCall();
+	void WaitForCall(unsigned int);
+
+private:
+	struct FAST_CALL
+	{
+		alignas(std::max_align_t) uint8 storage[FAST_CALL_STORAGE_SIZE];
+		void (*invoke)(void*) = nullptr;
+		void (*destroy)(void*) = nullptr;
+	};
+
+	struct MESSAGE
+	{
+		FunctionType function;
+		std::unique_ptr<std::promise<void>> promise;
+		uint32 fastCallSendCount = 0; //Fast calls that need to be received before this one
+	};
+
+	void WakeReceiver();
+
+	CSpscQueue<FAST_CALL, FAST_CALL_QUEUE_SIZE> m_fastCalls;
+	std::atomic<uint32> m_fastCallSendCount = {0};
+	uint32 m_fastCallReceiveCount = 0;
+
+	std::deque<MESSAGE> m_calls;
+	std::atomic<uint32> m_callCount = {0};
+	std::mutex m_callMutex;
+	std::condition_variable m_waitCondition;
+	std::atomic<bool> m_receiverWaiting = {false};
+};
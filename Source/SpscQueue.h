@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <utility>
+#include "Types.h"
+
+//Fixed capacity lock-free queue with a single producer thread and a single consumer thread.
+//Slots are reused in place: the slot accessors allow filling or consuming an item without
+//moving it around, which keeps storage owned by items (ie.: vectors) allocated between uses.
+template <typename ItemType, uint32 Capacity>
+class CSpscQueue
+{
+public:
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2.");
+
+	bool IsEmpty() const
+	{
+		return m_readIndex.load(std::memory_order_acquire) == m_writeIndex.load(std::memory_order_acquire);
+	}
+
+	//Producer side
+	ItemType* GetWriteSlot()
+	{
+		uint32 writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+		if((writeIndex - m_readIndex.load(std::memory_order_acquire)) == Capacity) return nullptr;
+		return &m_items[writeIndex & (Capacity - 1)];
+	}
+
+	void CommitWrite()
+	{
+		m_writeIndex.store(m_writeIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	bool TryPush(ItemType item)
+	{
+		auto slot = GetWriteSlot();
+		if(!slot) return false;
+		*slot = std::move(item);
+		CommitWrite();
+		return true;
+	}
+
+	//Consumer side
+	ItemType* GetReadSlot()
+	{
+		uint32 readIndex = m_readIndex.load(std::memory_order_relaxed);
+		if(readIndex == m_writeIndex.load(std::memory_order_acquire)) return nullptr;
+		return &m_items[readIndex & (Capacity - 1)];
+	}
+
+	void CommitRead()
+	{
+		m_readIndex.store(m_readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	bool TryPop(ItemType& item)
+	{
+		auto slot = GetReadSlot();
+		if(!slot) return false;
+		item = std::move(*slot);
+		CommitRead();
+		return true;
+	}
+
+private:
+	std::array<ItemType, Capacity> m_items;
+	alignas(64) std::atomic<uint32> m_readIndex = {0};
+	alignas(64) std::atomic<uint32> m_writeIndex = {0};
+};
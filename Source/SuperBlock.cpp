@@ -0,0 +1,154 @@
+#include "SuperBlock.h"
+#include "offsetof_def.h"
+#include "MipsJitter.h"
+
+CSuperBlock::CSuperBlock(CMIPS& context, SegmentArray segments, BLOCK_CATEGORY category)
+    : CBasicBlock(context, segments.front().begin, segments.front().end, category)
+    , m_segments(std::move(segments))
+{
+	assert(m_segments.size() >= 2);
+}
+
+void CSuperBlock::CompileRange(CMipsJitter* jitter)
+{
+	const auto& lastSegment = m_segments.back();
+	bool loopsOnItself = (lastSegment.branchAddress == m_begin);
+
+	CompileProlog(jitter);
+	jitter->MarkFirstBlockLabel();
+
+	for(uint32 segmentIndex = 0; segmentIndex < m_segments.size(); segmentIndex++)
+	{
+		const auto& segment = m_segments[segmentIndex];
+
+		//Segments are analyzed separately, nothing is assumed about registers on segment entry
+		CMipsConstantAnalysis constantAnalysis;
+		constantAnalysis.Analyze(m_context, segment.begin, segment.end);
+
+		for(uint32 address = segment.begin; address <= segment.end; address += 4)
+		{
+			jitter->SetKnownGprState(&constantAnalysis.GetState(address));
+			//Instructions are compiled relative to the first segment since PC stays there
+			m_context.m_pArch->CompileInstruction(
+			    address,
+			    jitter,
+			    &m_context, address - m_begin);
+			//Sanity check
+			assert(jitter->IsStackEmpty());
+		}
+		jitter->SetKnownGprState(nullptr);
+
+		if(segmentIndex != (m_segments.size() - 1))
+		{
+			//Anything signaled by the segment's block end code makes the transition leave the super block
+			segment.block->CompileBlockEnd(jitter);
+			CompileSegmentTransition(jitter, segment, m_segments[segmentIndex + 1].begin);
+		}
+	}
+
+	jitter->MarkLastBlockLabel();
+	CompileEpilog(jitter, loopsOnItself);
+}
+
+bool CSuperBlock::IsCodeCacheable() const
+{
+	return false;
+}
+
+const CSuperBlock::SegmentArray& CSuperBlock::GetSegments() const
+{
+	return m_segments;
+}
+
+bool CSuperBlock::OverlapsRange(uint32 start, uint32 end) const
+{
+	for(const auto& segment : m_segments)
+	{
+		if((segment.begin <= end) && (start <= segment.end)) return true;
+	}
+	return false;
+}
+
+void CSuperBlock::CompileEpilog(CMipsJitter* jitter, bool loopsOnItself)
+{
+	const auto& lastSegment = m_segments.back();
+	lastSegment.block->CompileBlockEnd(jitter);
+	CompileExit(jitter, lastSegment.begin, lastSegment.end, loopsOnItself);
+}
+
+void CSuperBlock::CompileSegmentTransition(CMipsJitter* jitter, const SEGMENT& segment, uint32 nextSegmentAddress)
+{
+	uint32 expectedJumpAddr = segment.branchTaken ? segment.branchAddress : MIPS_INVALID_PC;
+
+	//Update cycle quota
+	jitter->PushRel(offsetof(CMIPS, m_State.cycleQuota));
+	jitter->PushCst(((segment.end - segment.begin) / 4) + 1);
+	jitter->Sub();
+	jitter->PullRel(offsetof(CMIPS, m_State.cycleQuota));
+
+	jitter->PushRel(offsetof(CMIPS, m_State.cycleQuota));
+	jitter->PushCst(0);
+	jitter->BeginIf(Jitter::CONDITION_LE);
+	{
+		jitter->PushRel(offsetof(CMIPS, m_State.nHasException));
+		jitter->PushCst(MIPS_EXECUTION_STATUS_QUOTADONE);
+		jitter->Or();
+		jitter->PullRel(offsetof(CMIPS, m_State.nHasException));
+	}
+	jitter->EndIf();
+
+	//Side exit if the branch didn't go where we expected
+	jitter->PushRel(offsetof(CMIPS, m_State.nDelayedJumpAddr));
+	jitter->PushCst(expectedJumpAddr);
+	jitter->BeginIf(Jitter::CONDITION_NE);
+	{
+		jitter->PushCst(MIPS_INVALID_PC);
+		jitter->PushRel(offsetof(CMIPS, m_State.nDelayedJumpAddr));
+		jitter->BeginIf(Jitter::CONDITION_NE);
+		{
+			jitter->PushRel(offsetof(CMIPS, m_State.nDelayedJumpAddr));
+			jitter->PullRel(offsetof(CMIPS, m_State.nPC));
+
+			jitter->PushCst(MIPS_INVALID_PC);
+			jitter->PullRel(offsetof(CMIPS, m_State.nDelayedJumpAddr));
+		}
+		jitter->Else();
+		{
+			jitter->PushRel(offsetof(CMIPS, m_State.nPC));
+			jitter->PushCst(segment.end - m_begin + 4);
+			jitter->Add();
+			jitter->PullRel(offsetof(CMIPS, m_State.nPC));
+		}
+		jitter->EndIf();
+
+		jitter->JumpTo(reinterpret_cast<void*>(&SideExitTrampoline));
+	}
+	jitter->EndIf();
+
+	if(segment.branchTaken)
+	{
+		jitter->PushCst(MIPS_INVALID_PC);
+		jitter->PullRel(offsetof(CMIPS, m_State.nDelayedJumpAddr));
+	}
+
+	//Leave if quota is done or if something needs to be handled outside
+	jitter->PushRel(offsetof(CMIPS, m_State.nHasException));
+	jitter->PushCst(0);
+	jitter->BeginIf(Jitter::CONDITION_NE);
+	{
+		jitter->PushRel(offsetof(CMIPS, m_State.nPC));
+		jitter->PushCst(nextSegmentAddress - m_begin);
+		jitter->Add();
+		jitter->PullRel(offsetof(CMIPS, m_State.nPC));
+
+		jitter->JumpTo(reinterpret_cast<void*>(&SideExitTrampoline));
+	}
+	jitter->EndIf();
+}
+
+//Side exits tail jump here and return to the executor, which dispatches from nPC like it
+//does after an unlinked block. Not shared with NextBlockTrampoline/BranchBlockTrampoline
+//since jumps to those are recorded as link slots.
+void CSuperBlock::SideExitTrampoline(CMIPS*)
+{
+}
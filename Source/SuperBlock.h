@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include "BasicBlock.h"
+
+#if !defined(AOT_BUILD_CACHE) && !defined(AOT_USE_CACHE)
+#define SUPER_BLOCK_SUPPORTED
+#endif
+
+//Block made of a chain of blocks that are usually executed one after the other.
+//Execution leaves the super block through a side exit when the chain isn't followed.
+//PC holds the address of the first segment for the whole execution of the block.
+//Guest registers are not kept in host registers across segments, they are written back
+//at every segment boundary like they would be at the end of a regular block.
+class CSuperBlock : public CBasicBlock
+{
+public:
+	struct SEGMENT
+	{
+		uint32 begin = MIPS_INVALID_PC;
+		uint32 end = MIPS_INVALID_PC;
+		uint32 branchAddress = MIPS_INVALID_PC; //Target of the branch ending this segment, if any
+		bool branchTaken = false;               //Whether the next segment is reached by taking the branch
+		std::shared_ptr<CBasicBlock> block;     //Block the segment was made from, provides its block end code
+	};
+	typedef std::vector<SEGMENT> SegmentArray;
+
+	CSuperBlock(CMIPS&, SegmentArray, BLOCK_CATEGORY = BLOCK_CATEGORY_UNKNOWN);
+	virtual ~CSuperBlock() = default;
+
+	void CompileRange(CMipsJitter*) override;
+	bool IsCodeCacheable() const override;
+
+	const SegmentArray& GetSegments() const;
+	bool OverlapsRange(uint32, uint32) const;
+
+protected:
+	void CompileEpilog(CMipsJitter*, bool) override;
+
+private:
+	void CompileSegmentTransition(CMipsJitter*, const SEGMENT&, uint32);
+
+	static void SideExitTrampoline(CMIPS*);
+
+	SegmentArray m_segments;
+};
@@ -1,40 +1,121 @@
 #include "EeBasicBlock.h"
+#include "EeExecutor.h"
 #include "offsetof_def.h"
 
-void CEeBasicBlock::CompileEpilog(CMipsJitter* jitter, bool loopsOnItself)
+void CEeBasicBlock::SetCodeGuard(uint64 codeHash)
+{
+	m_codeGuarded = true;
+	m_codeHash = codeHash;
+}
+
+bool CEeBasicBlock::IsCodeGuarded() const
+{
+	return m_codeGuarded;
+}
+
+uint64 CEeBasicBlock::GetCodeHash() const
+{
+	return m_codeHash;
+}
+
+void CEeBasicBlock::CompileProlog(CMipsJitter* jitter)
+{
+	CBasicBlock::CompileProlog(jitter);
+
+	if(m_codeGuarded)
+	{
+		jitter->PushCtx();
+		jitter->Call(reinterpret_cast<void*>(&CodeGuardFilter), 1, Jitter::CJitter::RETURN_VALUE_32);
+
+		jitter->PushCst(0);
+		jitter->BeginIf(Jitter::CONDITION_EQ);
+		{
+			jitter->JumpTo(reinterpret_cast<void*>(&CodeGuardHandler));
+		}
+		jitter->EndIf();
+	}
+}
+
+void CEeBasicBlock::CompileBlockEnd(CMipsJitter* jitter)
 {
 	if(IsIdleLoopBlock())
 	{
 		jitter->PushCst(MIPS_EXCEPTION_IDLE);
 		jitter->PullRel(offsetof(CMIPS, m_State.nHasException));
 	}
+}
 
-	CBasicBlock::CompileEpilog(jitter, loopsOnItself);
+uint32 CEeBasicBlock::CodeGuardFilter(CMIPS* context)
+{
+	return static_cast<CEeExecutor*>(context->m_executor.get())->IsGuardedBlockValid() ? 1 : 0;
+}
+
+void CEeBasicBlock::CodeGuardHandler(CMIPS* context)
+{
+	//Nothing has been executed yet, PC still points to the block
+	static_cast<CEeExecutor*>(context->m_executor.get())->ClearGuardedBlock();
 }
 
+//Recognizes loops that wait for a value in memory (ie.: a hardware register or a flag
+//set by an interrupt handler) to change. Such loops only load values, compute on them and
+//branch back to their start, no state they rely on is modified from one iteration to the next.
 bool CEeBasicBlock::IsIdleLoopBlock() const
 {
 	enum OP
 	{
+		OP_SPECIAL = 0x00,
+		OP_REGIMM = 0x01,
 		OP_BEQ = 0x04,
 		OP_BNE = 0x05,
+		OP_BLEZ = 0x06,
+		OP_BGTZ = 0x07,
+		OP_ADDIU = 0x09,
+		OP_SLTI = 0x0A,
 		OP_SLTIU = 0x0B,
 		OP_ANDI = 0x0C,
+		OP_ORI = 0x0D,
 		OP_XORI = 0x0E,
 		OP_LUI = 0x0F,
+		OP_BEQL = 0x14,
+		OP_BNEL = 0x15,
+		OP_BLEZL = 0x16,
+		OP_BGTZL = 0x17,
 		OP_LQ = 0x1E,
+		OP_LB = 0x20,
+		OP_LH = 0x21,
 		OP_LW = 0x23,
 		OP_LBU = 0x24,
+		OP_LHU = 0x25,
+		OP_LWU = 0x27,
+		OP_LD = 0x37,
 	};
 
 	enum
 	{
+		OP_SPECIAL_SLL = 0x00,
+		OP_SPECIAL_SRL = 0x02,
+		OP_SPECIAL_SRA = 0x03,
+		OP_SPECIAL_SYNC = 0x0F,
+		OP_SPECIAL_ADDU = 0x21,
+		OP_SPECIAL_SUBU = 0x23,
+		OP_SPECIAL_AND = 0x24,
+		OP_SPECIAL_OR = 0x25,
+		OP_SPECIAL_XOR = 0x26,
+		OP_SPECIAL_NOR = 0x27,
 		OP_SPECIAL_SLT = 0x2A,
 		OP_SPECIAL_SLTU = 0x2B,
 	};
 
+	enum
+	{
+		OP_REGIMM_BLTZ = 0x00,
+		OP_REGIMM_BGEZ = 0x01,
+		OP_REGIMM_BLTZL = 0x02,
+		OP_REGIMM_BGEZL = 0x03,
+	};
+
 	uint32 endInstructionAddress = m_end - 4;
-	uint32 endInstruction = m_context.m_pMemoryMap->GetWord(endInstructionAddress);
+	uint32 endInstruction = m_context.m_pMemoryMap->GetInstruction(endInstructionAddress);
 
 	//We need a branch at the end of the block
 	auto branchType = m_context.m_pArch->IsInstructionBranch(&m_context, endInstructionAddress, endInstruction);
@@ -45,8 +126,7 @@ bool CEeBasicBlock::IsIdleLoopBlock() const
 	if(branchTarget == MIPS_INVALID_PC) return false;
 	if(branchTarget != m_begin) return false;
 
-	uint32 compareRs = 0;
-	uint32 compareRt = 0;
+	uint32 compareUse = 0;
 
 	//Check what kind of branching instruction we have.
 	{
@@ -54,15 +134,42 @@ bool CEeBasicBlock::IsIdleLoopBlock() const
 		uint32 rt = (endInstruction >> 16) & 0x1F;
 		uint32 rs = (endInstruction >> 21) & 0x1F;
 
-		//We want a BEQ or BNE
-		if((op != OP_BEQ) && (op != OP_BNE)) return false;
-
-		compareRs = rs;
-		compareRt = rt;
+		switch(op)
+		{
+		case OP_BEQ:
+		case OP_BNE:
+		case OP_BEQL:
+		case OP_BNEL:
+			compareUse = (1 << rs) | (1 << rt);
+			break;
+		case OP_BLEZ:
+		case OP_BGTZ:
+		case OP_BLEZL:
+		case OP_BGTZL:
+			compareUse = (1 << rs);
+			break;
+		case OP_REGIMM:
+			switch(rt)
+			{
+			case OP_REGIMM_BLTZ:
+			case OP_REGIMM_BGEZ:
+			case OP_REGIMM_BLTZL:
+			case OP_REGIMM_BGEZL:
+				compareUse = (1 << rs);
+				break;
+			default:
+				//Linking branches modify RA
+				return false;
+			}
+			break;
+		default:
+			return false;
+		}
 	}
 
 	uint32 defState = 0; //Set of completely new definitions of registers within this block
 	uint32 useState = 0; //Set of previous state usage within this block
+	uint32 loadCount = 0;
 
 	//Check all instructions inside to see if we can prove it's waiting for some kind of flag
 	for(uint32 address = m_begin; address <= m_end; address += 4)
@@ -70,7 +177,7 @@ bool CEeBasicBlock::IsIdleLoopBlock() const
 		//Don't check branch instruction as we've checked it already
 		if(address == endInstructionAddress) continue;
 
-		uint32 inst = m_context.m_pMemoryMap->GetWord(address);
+		uint32 inst = m_context.m_pMemoryMap->GetInstruction(address);
 		if(inst == 0) continue;
 		uint32 special = inst & 0x3F;
 		uint32 rd = (inst >> 11) & 0x1F;
@@ -83,9 +190,23 @@ bool CEeBasicBlock::IsIdleLoopBlock() const
 
 		switch(op)
 		{
-		case 0x00:
+		case OP_SPECIAL:
 			switch(special)
 			{
+			case OP_SPECIAL_SLL:
+			case OP_SPECIAL_SRL:
+			case OP_SPECIAL_SRA:
+				newUse = (1 << rt);
+				newDef = (1 << rd);
+				break;
+			case OP_SPECIAL_SYNC:
+				break;
+			case OP_SPECIAL_ADDU:
+			case OP_SPECIAL_SUBU:
+			case OP_SPECIAL_AND:
+			case OP_SPECIAL_OR:
+			case OP_SPECIAL_XOR:
+			case OP_SPECIAL_NOR:
 			case OP_SPECIAL_SLT:
 			case OP_SPECIAL_SLTU:
 				newUse = (1 << rs) | (1 << rt);
@@ -99,19 +220,35 @@ bool CEeBasicBlock::IsIdleLoopBlock() const
 		case OP_LUI:
 			newDef = (1 << rt);
 			break;
+		case OP_LB:
+		case OP_LH:
 		case OP_LW:
-		case OP_LQ:
 		case OP_LBU:
+		case OP_LHU:
+		case OP_LWU:
+		case OP_LD:
+		case OP_LQ:
+			loadCount++;
+			newUse = (1 << rs);
+			newDef = (1 << rt);
+			break;
+		case OP_ADDIU:
+		case OP_SLTI:
 		case OP_SLTIU:
+		case OP_ANDI:
+		case OP_ORI:
 		case OP_XORI:
 			newUse = (1 << rs);
 			newDef = (1 << rt);
 			break;
 		default:
-			//We don't know what this does, let's not take a chance
+			//We don't know what this does (stores, calls, etc.), let's not take a chance
 			return false;
 		}
 
+		//R0 can't be modified
+		newDef &= ~1;
+
 		//Bail if this defines any state that we previously used
 		if(useState & newDef)
 		{
@@ -125,11 +262,11 @@ bool CEeBasicBlock::IsIdleLoopBlock() const
 		useState |= newUse;
 	}
 
-	//Just make sure that we've at least defined our comparision register
-	FRAMEWORK_MAYBE_UNUSED bool compareRsDefined = defState & (1 << compareRs);
-	FRAMEWORK_MAYBE_UNUSED bool compareRtDefined = defState & (1 << compareRt);
+	//Something must be read from memory for the loop to be able to exit
+	if(loadCount == 0) return false;
 
-	assert(compareRsDefined || compareRtDefined);
+	//Make sure that the branch depends on something that was computed in the loop
+	if((defState & compareUse & ~1) == 0) return false;
 
 	return true;
 }
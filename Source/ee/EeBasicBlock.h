@@ -7,9 +7,23 @@ class CEeBasicBlock : public CBasicBlock
 public:
 	using CBasicBlock::CBasicBlock;
 
+	//Guarded blocks check that their code in memory still hashes to the given value before running
+	void SetCodeGuard(uint64);
+	bool IsCodeGuarded() const;
+	uint64 GetCodeHash() const;
+
+	//Blocks recognized as idle loops signal idleness each time they loop
+	bool IsIdleLoopBlock() const;
+
+	void CompileBlockEnd(CMipsJitter*) override;
+
 protected:
-	void CompileEpilog(CMipsJitter*, bool) override;
+	void CompileProlog(CMipsJitter*) override;
 
 private:
-	bool IsIdleLoopBlock() const;
+	static uint32 CodeGuardFilter(CMIPS*);
+	static void CodeGuardHandler(CMIPS*);
+
+	bool m_codeGuarded = false;
+	uint64 m_codeHash = 0;
 };
@@ -1,8 +1,11 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include "EeExecutor.h"
 #include "../Ps2Const.h"
 #include "AlignedAlloc.h"
 #include "EeBasicBlock.h"
-#include "xxhash.h"
+#include "Log.h"
 
 #if defined(__unix__) || defined(__ANDROID__) || defined(__APPLE__)
 #include <sys/mman.h>
@@ -31,35 +34,80 @@
 
 #endif
 
-static CEeExecutor* g_eeExecutor = nullptr;
+#define LOG_NAME ("ee_executor")
+
+//Several virtual machines can live in the same process, access faults are offered
+//to every executor until one of them recognizes the address as its own. Handlers
+//count themselves in a slot while using its executor, an executor being removed
+//waits until its slot isn't used anymore.
+struct EXECUTOR_SLOT
+{
+	std::atomic<CEeExecutor*> executor = {nullptr};
+	std::atomic<uint32> useCount = {0};
+};
+
+static const uint32 g_maxEeExecutors = 64;
+static EXECUTOR_SLOT g_eeExecutors[g_maxEeExecutors];
+
+#if defined(_WIN32)
+//One handler serves every executor, installed with the first one and removed with the last one
+static std::mutex g_vectoredHandlerMutex;
+static uint32 g_vectoredHandlerUserCount = 0;
+static PVOID g_vectoredHandler = NULL;
+#elif defined(__unix__) || defined(__ANDROID__)
+//Faults that don't belong to any executor go to the handler that was installed before ours
+static struct sigaction g_previousSigAction;
+static std::once_flag g_sigActionInstallFlag;
+#endif
 
 CEeExecutor::CEeExecutor(CMIPS& context, uint8* ram)
     : CGenericMipsExecutor(context, 0x20000000, BLOCK_CATEGORY_PS2_EE)
     , m_ram(ram)
 {
 	m_pageSize = framework_getpagesize();
+	m_ramViews.push_back(m_ram);
+	m_pageFaultCounts.resize(PS2::EE_RAM_SIZE / m_pageSize);
+	m_guardedPages.resize(PS2::EE_RAM_SIZE / m_pageSize);
 }
 
 void CEeExecutor::AddExceptionHandler()
 {
-	assert(g_eeExecutor == nullptr);
-	g_eeExecutor = this;
+	bool registered = false;
+	for(auto& executorSlot : g_eeExecutors)
+	{
+		CEeExecutor* expected = nullptr;
+		if(executorSlot.executor.compare_exchange_strong(expected, this))
+		{
+			registered = true;
+			break;
+		}
+	}
+	assert(registered);
 
 #ifdef DISABLE_PROTECTION
 	return;
 #endif
 
 #if defined(_WIN32)
-	m_handler = AddVectoredExceptionHandler(TRUE, &CEeExecutor::HandleException);
-	assert(m_handler != NULL);
+	{
+		std::lock_guard<std::mutex> handlerLock(g_vectoredHandlerMutex);
+		if(g_vectoredHandlerUserCount++ == 0)
+		{
+			g_vectoredHandler = AddVectoredExceptionHandler(TRUE, &CEeExecutor::HandleException);
+			assert(g_vectoredHandler != NULL);
+		}
+	}
 #elif defined(__unix__) || defined(__ANDROID__)
-	struct sigaction sigAction;
-	sigAction.sa_handler = nullptr;
-	sigAction.sa_sigaction = &HandleException;
-	sigAction.sa_flags = SA_SIGINFO;
-	sigemptyset(&sigAction.sa_mask);
-	int result = sigaction(SIGSEGV, &sigAction, nullptr);
-	assert(result >= 0);
+	std::call_once(g_sigActionInstallFlag,
+	               []() {
+		               struct sigaction sigAction;
+		               sigAction.sa_handler = nullptr;
+		               sigAction.sa_sigaction = &HandleException;
+		               sigAction.sa_flags = SA_SIGINFO;
+		               sigemptyset(&sigAction.sa_mask);
+		               int result = sigaction(SIGSEGV, &sigAction, &g_previousSigAction);
+		               assert(result >= 0);
+	               });
 #elif defined(__APPLE__)
 	if(!m_running)
 	{
@@ -79,7 +127,15 @@ void CEeExecutor::RemoveExceptionHandler()
 #ifndef DISABLE_PROTECTION
 
 #if defined(_WIN32)
-	RemoveVectoredExceptionHandler(m_handler);
+	{
+		std::lock_guard<std::mutex> handlerLock(g_vectoredHandlerMutex);
+		assert(g_vectoredHandlerUserCount != 0);
+		if(--g_vectoredHandlerUserCount == 0)
+		{
+			RemoveVectoredExceptionHandler(g_vectoredHandler);
+			g_vectoredHandler = NULL;
+		}
+	}
 #elif defined(__APPLE__)
 	m_running = false;
 	m_handlerThread.join();
@@ -87,7 +143,17 @@ void CEeExecutor::RemoveExceptionHandler()
 
 #endif //!DISABLE_PROTECTION
 
-	g_eeExecutor = nullptr;
+	for(auto& executorSlot : g_eeExecutors)
+	{
+		CEeExecutor* expected = this;
+		if(!executorSlot.executor.compare_exchange_strong(expected, nullptr)) continue;
+		//A handler running on another thread might still be looking at us
+		while(executorSlot.useCount != 0)
+		{
+			std::this_thread::yield();
+		}
+		break;
+	}
 }
 
 void CEeExecutor::AttachExceptionHandlerToThread()
@@ -107,17 +173,43 @@ void CEeExecutor::AttachExceptionHandlerToThread()
 #endif
 }
 
+void CEeExecutor::SetFastMemoryArena(CFastMemoryArena* arena, CFastMemoryArena::ViewArray ramViews)
+{
+	assert(!ramViews.empty() && (ramViews[0] == m_ram));
+	m_fastMemoryArena = arena;
+	m_ramViews = std::move(ramViews);
+}
+
 void CEeExecutor::Reset()
 {
-	SetMemoryProtected(m_ram, PS2::EE_RAM_SIZE, false);
-	m_cachedBlocks.clear();
+	SetRamProtected(0, PS2::EE_RAM_SIZE, false);
+	m_cachedBlocks.Clear();
+	std::fill(std::begin(m_pageFaultCounts), std::end(m_pageFaultCounts), 0);
+	std::fill(std::begin(m_guardedPages), std::end(m_guardedPages), false);
+	m_guardedPageCount = 0;
+	m_retiredGuardedBlock.reset();
+	m_slowMemoryBlocks.clear();
+	m_pendingSlowMemoryBlocks.clear();
 	CGenericMipsExecutor::Reset();
 }
 
+int CEeExecutor::Execute(int cycles)
+{
+	int result = CGenericMipsExecutor::Execute(cycles);
+	for(auto address : m_pendingSlowMemoryBlocks)
+	{
+		auto block = FindBlockStartingAt(address);
+		if(block->IsEmpty()) continue;
+		ClearActiveBlocksInRange(block->GetBeginAddress(), block->GetEndAddress() + 4, false);
+	}
+	m_pendingSlowMemoryBlocks.clear();
+	return result;
+}
+
 void CEeExecutor::ClearActiveBlocksInRange(uint32 start, uint32 end, bool executing)
 {
 	uint32 rangeSize = end - start;
-	SetMemoryProtected(m_ram + start, rangeSize, false);
+	SetRamProtected(start, rangeSize, false);
 	CGenericMipsExecutor::ClearActiveBlocksInRange(start, end, executing);
 }
 
@@ -128,9 +220,13 @@ BasicBlockPtr CEeExecutor::BlockFactory(CMIPS& context, uint32 start, uint32 end
 	//Kernel area is below 0x100000 and isn't protected. Some games will write code in there
 	//but it is safe to assume that it won't change (code writes some data just besides itself
 	//so it keeps generating exceptions, making the game slower)
-	if(start >= 0x100000 && start < PS2::EE_RAM_SIZE)
+	bool isProtectable = (start >= 0x100000 && start < PS2::EE_RAM_SIZE);
+
+	//Pages that keep faulting aren't protected anymore, blocks in them check their code on entry instead
+	bool isGuarded = isProtectable && IsRangeGuarded(start, end);
+	if(isProtectable && !isGuarded)
 	{
-		SetMemoryProtected(m_ram + start, blockSize, true);
+		SetRamProtected(start, blockSize, true);
 	}
 
 	auto blockMemory = reinterpret_cast<uint32*>(alloca(blockSize));
@@ -141,19 +237,28 @@ BasicBlockPtr CEeExecutor::BlockFactory(CMIPS& context, uint32 start, uint32 end
 		blockMemory[index] = opcode;
 	}
 
-	auto xxHash = XXH3_128bits(blockMemory, blockSize);
-	uint128 hash;
-	memcpy(&hash, &xxHash, sizeof(xxHash));
-	static_assert(sizeof(hash) == sizeof(xxHash));
-	auto blockKey = std::make_pair(hash, blockSize);
+	auto codeCacheKey = MakeBlockKey(blockMemory, blockSize);
+	CachedBlockKey blockKey = {codeCacheKey.hash, blockSize};
+
+	bool isSlowMemory = (m_slowMemoryBlocks.count(start) != 0);
+
+	uint64 codeHash = isGuarded ? XXH3_64bits(blockMemory, blockSize) : 0;
+	auto isVariantMatching =
+	    [isGuarded, isSlowMemory](const BasicBlockPtr& block) {
+		    return (static_cast<CEeBasicBlock*>(block.get())->IsCodeGuarded() == isGuarded) &&
+		           (block->IsFastMemoryEnabled() == !isSlowMemory);
+	    };
 
 	bool hasBreakpoint = m_context.HasBreakpointInRange(start, end);
 	if(!hasBreakpoint)
 	{
-		auto blockIterator = m_cachedBlocks.find(blockKey);
-		if(blockIterator != std::end(m_cachedBlocks))
+		auto cachedBlock = m_cachedBlocks.Find(blockKey,
+		                                       [&](const BasicBlockPtr& block) {
+			                                       return isVariantMatching(block) && (block->GetBeginAddress() == start) && (block->GetEndAddress() == end);
+		                                       });
+		if(cachedBlock && isVariantMatching(*cachedBlock))
 		{
-			const auto& basicBlock(blockIterator->second);
+			const auto& basicBlock(*cachedBlock);
 			if(basicBlock->GetBeginAddress() == start && basicBlock->GetEndAddress() == end)
 			{
 				uint32 recycleCount = basicBlock->GetRecycleCount();
@@ -164,32 +269,165 @@ BasicBlockPtr CEeExecutor::BlockFactory(CMIPS& context, uint32 start, uint32 end
 			{
 				auto result = std::make_shared<CEeBasicBlock>(context, start, end, m_blockCategory);
 				result->CopyFunctionFrom(basicBlock);
+				if(isGuarded)
+				{
+					result->SetCodeGuard(codeHash);
+					result->SetRecycleCount(RECYCLE_NOLINK_THRESHOLD);
+				}
 				return result;
 			}
 		}
 	}
 
-	auto result = std::make_shared<CEeBasicBlock>(context, start, end, m_blockCategory);
-	result->Compile();
+	BasicBlockPtr result;
+	if(isGuarded || isSlowMemory)
+	{
+		//Speculative and cached code is compiled without a guard and with fast memory accesses
+		DiscardSpeculativeBlock(start);
+		auto block = std::static_pointer_cast<CEeBasicBlock>(MakeBasicBlock(start, end));
+		if(isGuarded)
+		{
+			block->SetCodeGuard(codeHash);
+			//Guarded blocks are always entered through the dispatcher and never become part of super blocks
+			block->SetRecycleCount(RECYCLE_NOLINK_THRESHOLD);
+		}
+		block->SetFastMemoryEnabled(!isSlowMemory);
+		CompileBlock(block.get(), codeCacheKey, false);
+		result = block;
+	}
+	else
+	{
+		result = hasBreakpoint ? BasicBlockPtr() : TakeSpeculativeBlock(start, end, blockMemory, blockSize);
+		if(!result)
+		{
+			result = MakeBasicBlock(start, end);
+			CompileBlock(result.get(), codeCacheKey, !hasBreakpoint);
+		}
+	}
+	//Only reported when the block is first made, blocks found in the cache were reported already
+	if(static_cast<CEeBasicBlock*>(result.get())->IsIdleLoopBlock())
+	{
+		CLog::GetInstance().Print(LOG_NAME, "Detected idle loop at 0x%08X-0x%08X.\r\n", start, end);
+	}
 	if(!hasBreakpoint)
 	{
-		m_cachedBlocks.insert(std::make_pair(blockKey, result));
+		m_cachedBlocks.Insert(blockKey, result);
 	}
 	return result;
 }
 
+BasicBlockPtr CEeExecutor::MakeBasicBlock(uint32 start, uint32 end)
+{
+	return std::make_shared<CEeBasicBlock>(m_context, start, end, m_blockCategory);
+}
+
+CMipsExecutor::BLOCK_COMPILE_STATS CEeExecutor::GetBlockCompileStats() const
+{
+	auto stats = CGenericMipsExecutor::GetBlockCompileStats();
+	stats.smcGuardedPageCount = m_guardedPageCount;
+	return stats;
+}
+
+bool CEeExecutor::IsGuardedBlockValid() const
+{
+	auto block = static_cast<CEeBasicBlock*>(FindBlockStartingAt(m_context.m_State.nPC & m_addressMask));
+	assert(!block->IsEmpty() && block->IsCodeGuarded());
+	uint32 blockSize = (block->GetEndAddress() - block->GetBeginAddress()) + 4;
+	return XXH3_64bits(m_ram + block->GetBeginAddress(), blockSize) == block->GetCodeHash();
+}
+
+void CEeExecutor::ClearGuardedBlock()
+{
+	auto block = FindBlockStartingAt(m_context.m_State.nPC & m_addressMask);
+	assert(!block->IsEmpty());
+	//We're returning from the block's code, keep it alive until the next guard miss
+	m_retiredGuardedBlock = block->shared_from_this();
+	m_compileStats.smcGuardMissCount++;
+	ClearActiveBlocksInRange(block->GetBeginAddress(), block->GetEndAddress() + 4, false);
+}
+
+uint32 CEeExecutor::GetPageFaultCount(uint32 address) const
+{
+	uint32 pageIndex = address / m_pageSize;
+	return (pageIndex < m_pageFaultCounts.size()) ? m_pageFaultCounts[pageIndex] : 0;
+}
+
+bool CEeExecutor::IsPageGuarded(uint32 address) const
+{
+	uint32 pageIndex = address / m_pageSize;
+	return (pageIndex < m_guardedPages.size()) ? m_guardedPages[pageIndex] : false;
+}
+
+bool CEeExecutor::IsRangeGuarded(uint32 start, uint32 end) const
+{
+	uint32 startPage = start / m_pageSize;
+	uint32 endPage = std::min<uint32>(end / m_pageSize, m_guardedPages.size() - 1);
+	for(uint32 pageIndex = startPage; pageIndex <= endPage; pageIndex++)
+	{
+		if(m_guardedPages[pageIndex]) return true;
+	}
+	return false;
+}
+
+bool CEeExecutor::IsExecutingBlockInRange(uint32 start, uint32 end) const
+{
+	auto block = FindBlockStartingAt(m_context.m_State.nPC & m_addressMask);
+	if(block->IsEmpty()) return false;
+	if(m_superBlocks.count(block))
+	{
+		return static_cast<CSuperBlock*>(block)->OverlapsRange(start, end);
+	}
+	return (block->GetBeginAddress() < end) && (start <= block->GetEndAddress());
+}
+
+bool CEeExecutor::GetRamOffset(intptr_t ptr, uint32& offset) const
+{
+	//Writes through any of the RAM views fault when code is protected
+	for(auto view : m_ramViews)
+	{
+		ptrdiff_t addr = reinterpret_cast<uint8*>(ptr) - view;
+		if(addr >= 0 && addr < PS2::EE_RAM_SIZE)
+		{
+			offset = static_cast<uint32>(addr);
+			return true;
+		}
+	}
+	return false;
+}
+
 bool CEeExecutor::HandleAccessFault(intptr_t ptr)
 {
-	ptrdiff_t addr = reinterpret_cast<uint8*>(ptr) - m_ram;
-	if(addr >= 0 && addr < PS2::EE_RAM_SIZE)
+	uint32 addr = 0;
+	if(GetRamOffset(ptr, addr))
 	{
 		addr &= ~(m_pageSize - 1);
+		uint32 pageIndex = addr / m_pageSize;
+		m_pageFaultCounts[pageIndex]++;
+		m_compileStats.smcFaultCount++;
+		//The executing block can't be cleared right now, it would not be guarded if the page switched
+		//while it's still active. Keep relying on protection until some other block faults the page.
+		if(
+		    !m_guardedPages[pageIndex] &&
+		    (m_pageFaultCounts[pageIndex] >= SMC_GUARD_FAULT_THRESHOLD) &&
+		    !IsExecutingBlockInRange(addr, addr + m_pageSize))
+		{
+			m_guardedPages[pageIndex] = true;
+			m_guardedPageCount++;
+		}
 		ClearActiveBlocksInRange(addr, addr + m_pageSize, true);
 		return true;
 	}
 	return false;
 }
 
+void CEeExecutor::SetRamProtected(uint32 offset, size_t size, bool protect)
+{
+	for(auto view : m_ramViews)
+	{
+		SetMemoryProtected(view + offset, size, protect);
+	}
+}
+
 void CEeExecutor::SetMemoryProtected(void* addr, size_t size, bool protect)
 {
 #ifdef DISABLE_PROTECTION
@@ -217,7 +455,15 @@ void CEeExecutor::SetMemoryProtected(void* addr, size_t size, bool protect)
 
 LONG WINAPI CEeExecutor::HandleException(_EXCEPTION_POINTERS* exceptionInfo)
 {
-	return g_eeExecutor->HandleExceptionInternal(exceptionInfo);
+	for(auto& executorSlot : g_eeExecutors)
+	{
+		executorSlot.useCount++;
+		auto executor = executorSlot.executor.load();
+		bool handled = executor && (executor->HandleExceptionInternal(exceptionInfo) == EXCEPTION_CONTINUE_EXECUTION);
+		executorSlot.useCount--;
+		if(handled) return EXCEPTION_CONTINUE_EXECUTION;
+	}
+	return EXCEPTION_CONTINUE_SEARCH;
 }
 
 LONG CEeExecutor::HandleExceptionInternal(_EXCEPTION_POINTERS* exceptionInfo)
@@ -237,17 +483,68 @@ LONG CEeExecutor::HandleExceptionInternal(_EXCEPTION_POINTERS* exceptionInfo)
 
 void CEeExecutor::HandleException(int sigId, siginfo_t* sigInfo, void* baseContext)
 {
-	g_eeExecutor->HandleExceptionInternal(sigId, sigInfo, baseContext);
+	if(sigId != SIGSEGV) return;
+	for(auto& executorSlot : g_eeExecutors)
+	{
+		executorSlot.useCount++;
+		auto executor = executorSlot.executor.load();
+		bool handled = executor && executor->HandleExceptionInternal(sigInfo, baseContext);
+		executorSlot.useCount--;
+		if(handled) return;
+	}
+	if(g_previousSigAction.sa_flags & SA_SIGINFO)
+	{
+		g_previousSigAction.sa_sigaction(sigId, sigInfo, baseContext);
+	}
+	else if((g_previousSigAction.sa_handler != SIG_DFL) && (g_previousSigAction.sa_handler != SIG_IGN))
+	{
+		g_previousSigAction.sa_handler(sigId);
+	}
+	else
+	{
+		//Faulting instruction will run again with the default action and terminate the process
+		signal(SIGSEGV, SIG_DFL);
+	}
 }
 
-void CEeExecutor::HandleExceptionInternal(int sigId, siginfo_t* sigInfo, void* baseContext)
+bool CEeExecutor::HandleExceptionInternal(siginfo_t* sigInfo, void* baseContext)
 {
-	if(sigId != SIGSEGV) return;
 	if(HandleAccessFault(reinterpret_cast<intptr_t>(sigInfo->si_addr)))
 	{
-		return;
+		return true;
+	}
+	if(HandleFastMemoryFault(sigInfo->si_addr, baseContext))
+	{
+		return true;
+	}
+	return false;
+}
+
+bool CEeExecutor::HandleFastMemoryFault(void* faultAddress, void* baseContext)
+{
+	//Direct accesses to areas that aren't mapped in the arena (ie.: I/O ports) end up here.
+	//Device handlers can't run in signal context, the access is redirected to a thunk that
+	//completes it through the memory map once the signal handler has returned.
+	uint32 address = 0;
+	if(!m_fastMemoryArena || !m_fastMemoryArena->GetGuestAddress(faultAddress, address))
+	{
+		return false;
+	}
+	return CFastMemoryArena::RedirectAccess(baseContext, &m_context, address, &CEeExecutor::HandleFastMemoryAccessCompleted);
+}
+
+void CEeExecutor::HandleFastMemoryAccessCompleted(CMIPS* context, uint32)
+{
+	//Not in signal context anymore. The running block will keep faulting on this access,
+	//have it recompiled with regular accesses and leave the execution loop after it.
+	auto executor = static_cast<CEeExecutor*>(context->m_executor.get());
+	uint32 blockAddress = context->m_State.nPC & executor->m_addressMask;
+	executor->m_compileStats.fastMemoryFaultCount++;
+	if(executor->m_slowMemoryBlocks.insert(blockAddress).second)
+	{
+		executor->m_pendingSlowMemoryBlocks.push_back(blockAddress);
 	}
-	signal(SIGSEGV, SIG_DFL);
+	context->m_State.nHasException |= MIPS_EXECUTION_STATUS_QUOTADONE;
 }
 
 #elif defined(__APPLE__)
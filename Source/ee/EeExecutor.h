@@ -9,7 +9,10 @@
 #include <signal.h>
 #endif
 
+#include <unordered_set>
 #include "../GenericMipsExecutor.h"
+#include "../BlockCacheIndex.h"
+#include "../FastMemoryArena.h"
 
 class CEeExecutor : public CGenericMipsExecutor<BlockLookupTwoWay>
 {
@@ -22,30 +25,72 @@ public:
 
 	void AttachExceptionHandlerToThread();
 
+	//RAM is mapped in the arena at every address it can be accessed from, the first view being the main one
+	void SetFastMemoryArena(CFastMemoryArena*, CFastMemoryArena::ViewArray);
+
 	void Reset() override;
+	int Execute(int) override;
 	void ClearActiveBlocksInRange(uint32, uint32, bool) override;
 
 	BasicBlockPtr BlockFactory(CMIPS&, uint32, uint32) override;
+	BasicBlockPtr MakeBasicBlock(uint32, uint32) override;
+
+	BLOCK_COMPILE_STATS GetBlockCompileStats() const override;
+
+	//Used by guarded blocks, checks/clears the block starting at PC
+	bool IsGuardedBlockValid() const;
+	void ClearGuardedBlock();
+
+	uint32 GetPageFaultCount(uint32) const;
+	bool IsPageGuarded(uint32) const;
 
 private:
-	typedef std::pair<uint128, uint32> CachedBlockKey;
-	typedef std::map<CachedBlockKey, BasicBlockPtr> CachedBlockMap;
-	CachedBlockMap m_cachedBlocks;
+	enum
+	{
+		MAX_CACHED_BLOCKS = 0x8000,
+	};
+
+	//Number of write faults on a page before its blocks stop relying on memory protection
+	enum
+	{
+		SMC_GUARD_FAULT_THRESHOLD = 8,
+	};
+
+	typedef CBlockCacheIndex<BasicBlockPtr> CachedBlockIndex;
+	typedef CachedBlockIndex::KEY CachedBlockKey;
+	CachedBlockIndex m_cachedBlocks = CachedBlockIndex(MAX_CACHED_BLOCKS);
 
 	uint8* m_ram = nullptr;
 	size_t m_pageSize = 0;
 
+	CFastMemoryArena* m_fastMemoryArena = nullptr;
+	CFastMemoryArena::ViewArray m_ramViews;
+
+	//Blocks (by start address) that faulted on fast memory accesses, compiled with regular accesses.
+	//Blocks can't be replaced while running, the ones that just faulted are cleared after execution.
+	std::unordered_set<uint32> m_slowMemoryBlocks;
+	std::vector<uint32> m_pendingSlowMemoryBlocks;
+
+	std::vector<uint32> m_pageFaultCounts;
+	std::vector<bool> m_guardedPages;
+	uint32 m_guardedPageCount = 0;
+	BasicBlockPtr m_retiredGuardedBlock;
+
+	bool IsRangeGuarded(uint32, uint32) const;
+	bool IsExecutingBlockInRange(uint32, uint32) const;
+	bool GetRamOffset(intptr_t, uint32&) const;
 	bool HandleAccessFault(intptr_t);
+	void SetRamProtected(uint32, size_t, bool);
 	void SetMemoryProtected(void*, size_t, bool);
 
 #if defined(_WIN32)
 	static LONG CALLBACK HandleException(_EXCEPTION_POINTERS*);
 	LONG HandleExceptionInternal(_EXCEPTION_POINTERS*);
-
-	LPVOID m_handler = NULL;
 #elif defined(__unix__) || defined(__ANDROID__)
 	static void HandleException(int, siginfo_t*, void*);
-	void HandleExceptionInternal(int, siginfo_t*, void*);
+	bool HandleExceptionInternal(siginfo_t*, void*);
+	bool HandleFastMemoryFault(void*, void*);
+	static void HandleFastMemoryAccessCompleted(CMIPS*, uint32);
 #elif defined(__APPLE__)
 	void HandlerThreadProc();
 
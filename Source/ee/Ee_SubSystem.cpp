@@ -26,10 +26,15 @@ using namespace Ee;
 
 #define FAKE_IOP_RAM_SIZE (0x1000)
 
-CSubSystem::CSubSystem(uint8* iopRam, CIopBios& iopBios)
-    : m_ram(reinterpret_cast<uint8*>(framework_aligned_alloc(PS2::EE_RAM_SIZE, framework_getpagesize())))
+//Uncached and Uncached + Accelerated segments and kernel segment map to the same RAM
+static const CFastMemoryArena::AddressArray g_ramMirrorAddresses = {0x00000000, 0x20000000, 0x30000000, 0x80000000};
+static const uint32 g_sprVirtualAddress = 0x70000000;
+
+CSubSystem::CSubSystem(uint8* iopRam, CIopBios& iopBios, bool useFastMemory, bool useThreadedVu1)
+    : m_fastMemoryArena(useFastMemory ? std::make_unique<CFastMemoryArena>() : nullptr)
+    , m_ram(AllocateRam())
     , m_bios(new uint8[PS2::EE_BIOS_SIZE])
-    , m_spr(reinterpret_cast<uint8*>(framework_aligned_alloc(PS2::EE_SPR_SIZE, 0x10)))
+    , m_spr(AllocateSpr())
     , m_fakeIopRam(new uint8[FAKE_IOP_RAM_SIZE])
     , m_vuMem0(reinterpret_cast<uint8*>(framework_aligned_alloc(PS2::VUMEM0SIZE, 0x10)))
     , m_microMem0(new uint8[PS2::MICROMEM0SIZE])
@@ -68,27 +73,55 @@ CSubSystem::CSubSystem(uint8* iopRam, CIopBios& iopBios)
 	{
 		m_EE.m_executor = std::make_unique<CEeExecutor>(m_EE, m_ram);
 
+		if(m_fastMemoryArena)
+		{
+			CFastMemoryArena::ViewArray ramViews;
+			for(auto address : g_ramMirrorAddresses)
+			{
+				ramViews.push_back(m_fastMemoryArena->GetBase() + address);
+			}
+			static_cast<CEeExecutor*>(m_EE.m_executor.get())->SetFastMemoryArena(m_fastMemoryArena.get(), std::move(ramViews));
+			m_EE.m_fastMemoryBase = m_fastMemoryArena->GetBase();
+		}
+
 		//Read map
 		m_EE.m_pMemoryMap->InsertReadMap(0x00000000, PS2::EE_RAM_SIZE - 1, m_ram, 0x00);
 		m_EE.m_pMemoryMap->InsertReadMap(PS2::EE_SPR_ADDR, PS2::EE_SPR_ADDR + PS2::EE_SPR_SIZE - 1, m_spr, 0x01);
-		m_EE.m_pMemoryMap->InsertReadMap(0x10000000, 0x10FFFFFF, std::bind(&CSubSystem::IOPortReadHandler, this, PLACEHOLDER_1), 0x02);
+		m_EE.m_pMemoryMap->InsertReadMap(0x10000000, 0x10FFFFFF, &CMemoryMap::ReadHandlerThunk<CSubSystem, &CSubSystem::IOPortReadHandler>, this, 0x02);
 		m_EE.m_pMemoryMap->InsertReadMap(PS2::MICROMEM0ADDR, PS2::MICROMEM0ADDR + PS2::MICROMEM0SIZE - 1, m_microMem0, 0x03);
 		m_EE.m_pMemoryMap->InsertReadMap(PS2::VUMEM0ADDR, PS2::VUMEM0ADDR + PS2::VUMEM0SIZE - 1, m_vuMem0, 0x04);
-		m_EE.m_pMemoryMap->InsertReadMap(PS2::MICROMEM1ADDR, PS2::MICROMEM1ADDR + PS2::MICROMEM1SIZE - 1, m_microMem1, 0x05);
-		m_EE.m_pMemoryMap->InsertReadMap(PS2::VUMEM1ADDR, PS2::VUMEM1ADDR + PS2::VUMEM1SIZE - 1, m_vuMem1, 0x06);
-		m_EE.m_pMemoryMap->InsertReadMap(0x12000000, 0x12FFFFFF, std::bind(&CSubSystem::IOPortReadHandler, this, PLACEHOLDER_1), 0x07);
+		if(useThreadedVu1)
+		{
+			//VU1 might be running on its own thread, reads need to wait for it
+			m_EE.m_pMemoryMap->InsertReadMap(PS2::MICROMEM1ADDR, PS2::MICROMEM1ADDR + PS2::MICROMEM1SIZE - 1, &CMemoryMap::ReadHandlerThunk<CSubSystem, &CSubSystem::Vu1MemoryReadHandler>, this, 0x05);
+			m_EE.m_pMemoryMap->InsertReadMap(PS2::VUMEM1ADDR, PS2::VUMEM1ADDR + PS2::VUMEM1SIZE - 1, &CMemoryMap::ReadHandlerThunk<CSubSystem, &CSubSystem::Vu1MemoryReadHandler>, this, 0x06);
+		}
+		else
+		{
+			m_EE.m_pMemoryMap->InsertReadMap(PS2::MICROMEM1ADDR, PS2::MICROMEM1ADDR + PS2::MICROMEM1SIZE - 1, m_microMem1, 0x05);
+			m_EE.m_pMemoryMap->InsertReadMap(PS2::VUMEM1ADDR, PS2::VUMEM1ADDR + PS2::VUMEM1SIZE - 1, m_vuMem1, 0x06);
+		}
+		m_EE.m_pMemoryMap->InsertReadMap(0x12000000, 0x12FFFFFF, &CMemoryMap::ReadHandlerThunk<CSubSystem, &CSubSystem::IOPortReadHandler>, this, 0x07);
 		m_EE.m_pMemoryMap->InsertReadMap(0x1C000000, 0x1C001000, m_fakeIopRam, 0x08);
 		m_EE.m_pMemoryMap->InsertReadMap(PS2::EE_BIOS_ADDR, PS2::EE_BIOS_ADDR + PS2::EE_BIOS_SIZE - 1, m_bios, 0x09);
 
 		//Write map
 		m_EE.m_pMemoryMap->InsertWriteMap(0x00000000, PS2::EE_RAM_SIZE - 1, m_ram, 0x00);
 		m_EE.m_pMemoryMap->InsertWriteMap(PS2::EE_SPR_ADDR, PS2::EE_SPR_ADDR + PS2::EE_SPR_SIZE - 1, m_spr, 0x01);
-		m_EE.m_pMemoryMap->InsertWriteMap(0x10000000, 0x10FFFFFF, std::bind(&CSubSystem::IOPortWriteHandler, this, PLACEHOLDER_1, PLACEHOLDER_2), 0x02);
-		m_EE.m_pMemoryMap->InsertWriteMap(PS2::MICROMEM0ADDR, PS2::MICROMEM0ADDR + PS2::MICROMEM0SIZE - 1, std::bind(&CSubSystem::Vu0MicroMemWriteHandler, this, PLACEHOLDER_1, PLACEHOLDER_2), 0x03);
+		m_EE.m_pMemoryMap->InsertWriteMap(0x10000000, 0x10FFFFFF, &CMemoryMap::WriteHandlerThunk<CSubSystem, &CSubSystem::IOPortWriteHandler>, this, 0x02);
+		m_EE.m_pMemoryMap->InsertWriteMap(PS2::MICROMEM0ADDR, PS2::MICROMEM0ADDR + PS2::MICROMEM0SIZE - 1, &CMemoryMap::WriteHandlerThunk<CSubSystem, &CSubSystem::Vu0MicroMemWriteHandler>, this, 0x03);
 		m_EE.m_pMemoryMap->InsertWriteMap(PS2::VUMEM0ADDR, PS2::VUMEM0ADDR + PS2::VUMEM0SIZE - 1, m_vuMem0, 0x04);
-		m_EE.m_pMemoryMap->InsertWriteMap(PS2::MICROMEM1ADDR, PS2::MICROMEM1ADDR + PS2::MICROMEM1SIZE - 1, std::bind(&CSubSystem::Vu1MicroMemWriteHandler, this, PLACEHOLDER_1, PLACEHOLDER_2), 0x05);
-		m_EE.m_pMemoryMap->InsertWriteMap(PS2::VUMEM1ADDR, PS2::VUMEM1ADDR + PS2::VUMEM1SIZE - 1, m_vuMem1, 0x06);
-		m_EE.m_pMemoryMap->InsertWriteMap(0x12000000, 0x12FFFFFF, std::bind(&CSubSystem::IOPortWriteHandler, this, PLACEHOLDER_1, PLACEHOLDER_2), 0x07);
+		m_EE.m_pMemoryMap->InsertWriteMap(PS2::MICROMEM1ADDR, PS2::MICROMEM1ADDR + PS2::MICROMEM1SIZE - 1, &CMemoryMap::WriteHandlerThunk<CSubSystem, &CSubSystem::Vu1MicroMemWriteHandler>, this, 0x05);
+		if(useThreadedVu1)
+		{
+			//VU1 might be running on its own thread, writes need to wait for it
+			m_EE.m_pMemoryMap->InsertWriteMap(PS2::VUMEM1ADDR, PS2::VUMEM1ADDR + PS2::VUMEM1SIZE - 1, &CMemoryMap::WriteHandlerThunk<CSubSystem, &CSubSystem::Vu1MemoryWriteHandler>, this, 0x06);
+		}
+		else
+		{
+			m_EE.m_pMemoryMap->InsertWriteMap(PS2::VUMEM1ADDR, PS2::VUMEM1ADDR + PS2::VUMEM1SIZE - 1, m_vuMem1, 0x06);
+		}
+		m_EE.m_pMemoryMap->InsertWriteMap(0x12000000, 0x12FFFFFF, &CMemoryMap::WriteHandlerThunk<CSubSystem, &CSubSystem::IOPortWriteHandler>, this, 0x07);
 
 		//Instruction map
 		m_EE.m_pMemoryMap->InsertInstructionMap(0x00000000, PS2::EE_RAM_SIZE - 1, m_ram, 0x00);
@@ -110,13 +143,13 @@ CSubSystem::CSubSystem(uint8* iopRam, CIopBios& iopBios)
 		m_VU0.m_pMemoryMap->InsertReadMap(0x00001000, 0x00001FFF, m_vuMem0, 0x02);
 		m_VU0.m_pMemoryMap->InsertReadMap(0x00002000, 0x00002FFF, m_vuMem0, 0x03);
 		m_VU0.m_pMemoryMap->InsertReadMap(0x00003000, 0x00003FFF, m_vuMem0, 0x04);
-		m_VU0.m_pMemoryMap->InsertReadMap(0x00004000, 0x00008FFF, std::bind(&CSubSystem::Vu0IoPortReadHandler, this, PLACEHOLDER_1), 0x05);
+		m_VU0.m_pMemoryMap->InsertReadMap(0x00004000, 0x00008FFF, &CMemoryMap::ReadHandlerThunk<CSubSystem, &CSubSystem::Vu0IoPortReadHandler>, this, 0x05);
 
 		m_VU0.m_pMemoryMap->InsertWriteMap(0x00000000, 0x00000FFF, m_vuMem0, 0x01);
 		m_VU0.m_pMemoryMap->InsertWriteMap(0x00001000, 0x00001FFF, m_vuMem0, 0x02);
 		m_VU0.m_pMemoryMap->InsertWriteMap(0x00002000, 0x00002FFF, m_vuMem0, 0x03);
 		m_VU0.m_pMemoryMap->InsertWriteMap(0x00003000, 0x00003FFF, m_vuMem0, 0x04);
-		m_VU0.m_pMemoryMap->InsertWriteMap(0x00004000, 0x00008FFF, std::bind(&CSubSystem::Vu0IoPortWriteHandler, this, PLACEHOLDER_1, PLACEHOLDER_2), 0x05);
+		m_VU0.m_pMemoryMap->InsertWriteMap(0x00004000, 0x00008FFF, &CMemoryMap::WriteHandlerThunk<CSubSystem, &CSubSystem::Vu0IoPortWriteHandler>, this, 0x05);
 
 		m_VU0.m_pMemoryMap->InsertInstructionMap(0x00000000, 0x00000FFF, m_microMem0, 0x00);
 
@@ -129,10 +162,10 @@ CSubSystem::CSubSystem(uint8* iopRam, CIopBios& iopBios)
 		m_VU1.m_executor = std::make_unique<CVuExecutor>(m_VU1, PS2::MICROMEM1SIZE);
 
 		m_VU1.m_pMemoryMap->InsertReadMap(0x00000000, 0x00003FFF, m_vuMem1, 0x00);
-		m_VU1.m_pMemoryMap->InsertReadMap(0x00008000, 0x00008FFF, std::bind(&CSubSystem::Vu1IoPortReadHandler, this, PLACEHOLDER_1), 0x01);
+		m_VU1.m_pMemoryMap->InsertReadMap(0x00008000, 0x00008FFF, &CMemoryMap::ReadHandlerThunk<CSubSystem, &CSubSystem::Vu1IoPortReadHandler>, this, 0x01);
 
 		m_VU1.m_pMemoryMap->InsertWriteMap(0x00000000, 0x00003FFF, m_vuMem1, 0x00);
-		m_VU1.m_pMemoryMap->InsertWriteMap(0x00008000, 0x00008FFF, std::bind(&CSubSystem::Vu1IoPortWriteHandler, this, PLACEHOLDER_1, PLACEHOLDER_2), 0x01);
+		m_VU1.m_pMemoryMap->InsertWriteMap(0x00008000, 0x00008FFF, &CMemoryMap::WriteHandlerThunk<CSubSystem, &CSubSystem::Vu1IoPortWriteHandler>, this, 0x01);
 
 		m_VU1.m_pMemoryMap->InsertInstructionMap(0x00000000, 0x00003FFF, m_microMem1, 0x01);
 
@@ -146,10 +179,23 @@ CSubSystem::CSubSystem(uint8* iopRam, CIopBios& iopBios)
 
 	m_dmac.SetChannelTransferFunction(CDMAC::CHANNEL_ID_VIF0, std::bind(&CVif::ReceiveDMA, &m_vpu0->GetVif(), PLACEHOLDER_1, PLACEHOLDER_2, PLACEHOLDER_3, PLACEHOLDER_4));
 	m_dmac.SetChannelTransferFunction(CDMAC::CHANNEL_ID_VIF1, std::bind(&CVif::ReceiveDMA, &m_vpu1->GetVif(), PLACEHOLDER_1, PLACEHOLDER_2, PLACEHOLDER_3, PLACEHOLDER_4));
-	m_dmac.SetChannelTransferFunction(CDMAC::CHANNEL_ID_GIF, std::bind(&CGIF::ReceiveDMA, &m_gif, PLACEHOLDER_1, PLACEHOLDER_2, PLACEHOLDER_3, PLACEHOLDER_4));
+	m_dmac.SetChannelTransferFunction(CDMAC::CHANNEL_ID_GIF,
+	                                  [this](uint32 address, uint32 qwc, uint32 direction, bool tagIncluded) {
+		                                  //PATH3 transfers can't go ahead of packets already kicked by VU1
+		                                  m_vpu1->FlushXgKicks();
+		                                  return m_gif.ReceiveDMA(address, qwc, direction, tagIncluded);
+	                                  });
 	m_dmac.SetChannelTransferFunction(CDMAC::CHANNEL_ID_TO_IPU, std::bind(&CIPU::ReceiveDMA4, &m_ipu, PLACEHOLDER_1, PLACEHOLDER_2, PLACEHOLDER_4, m_ram, m_spr));
-	m_dmac.SetChannelTransferFunction(CDMAC::CHANNEL_ID_SIF0, std::bind(&CSIF::ReceiveDMA5, &m_sif, PLACEHOLDER_1, PLACEHOLDER_2, PLACEHOLDER_3, PLACEHOLDER_4));
-	m_dmac.SetChannelTransferFunction(CDMAC::CHANNEL_ID_SIF1, std::bind(&CSIF::ReceiveDMA6, &m_sif, PLACEHOLDER_1, PLACEHOLDER_2, PLACEHOLDER_3, PLACEHOLDER_4));
+	m_dmac.SetChannelTransferFunction(CDMAC::CHANNEL_ID_SIF0,
+	                                  [this](uint32 address, uint32 size, uint32 dstAddress, bool tagIncluded) {
+		                                  auto iopLock = LockIop();
+		                                  return m_sif.ReceiveDMA5(address, size, dstAddress, tagIncluded);
+	                                  });
+	m_dmac.SetChannelTransferFunction(CDMAC::CHANNEL_ID_SIF1,
+	                                  [this](uint32 address, uint32 size, uint32 dstAddress, bool tagIncluded) {
+		                                  auto iopLock = LockIop();
+		                                  return m_sif.ReceiveDMA6(address, size, dstAddress, tagIncluded);
+	                                  });
 
 	m_ipu.SetDMA3ReceiveHandler(std::bind(&CDMAC::ResumeDMA3, &m_dmac, PLACEHOLDER_1, PLACEHOLDER_2));
 
@@ -157,15 +203,21 @@ CSubSystem::CSubSystem(uint8* iopRam, CIopBios& iopBios)
 	m_OnRequestInstructionCacheFlushConnection = m_os->OnRequestInstructionCacheFlush.Connect(std::bind(&CSubSystem::FlushInstructionCache, this));
 
 	SetupEePageTable();
+
+	m_vpu1->SetThreaded(useThreadedVu1);
 }
 
 CSubSystem::~CSubSystem()
 {
+	m_vpu1->SetThreaded(false);
 	m_EE.m_executor->Reset();
 	delete m_os;
-	framework_aligned_free(m_ram);
+	if(!m_fastMemoryArena)
+	{
+		framework_aligned_free(m_ram);
+		framework_aligned_free(m_spr);
+	}
 	delete[] m_bios;
-	framework_aligned_free(m_spr);
 	delete[] m_fakeIopRam;
 	framework_aligned_free(m_vuMem0);
 	delete[] m_microMem0;
@@ -183,8 +235,21 @@ void CSubSystem::SetVpu1(std::shared_ptr<CVpu> newVpu1)
 	m_vpu1 = newVpu1;
 }
 
+void CSubSystem::SetIopMutex(std::recursive_mutex* iopMutex)
+{
+	m_iopMutex = iopMutex;
+	m_sif.SetEeRamWritesDeferred(iopMutex != nullptr);
+}
+
+std::unique_lock<std::recursive_mutex> CSubSystem::LockIop()
+{
+	if(!m_iopMutex) return std::unique_lock<std::recursive_mutex>();
+	return std::unique_lock<std::recursive_mutex>(*m_iopMutex);
+}
+
 void CSubSystem::Reset(uint32 ramSize)
 {
+	m_vpu1->Synchronize();
 	m_os->Release();
 	m_EE.m_executor->Reset();
 
@@ -211,6 +276,7 @@ void CSubSystem::Reset(uint32 ramSize)
 
 	//Reset subunits
 	m_sif.Reset();
+	m_sifPendingTicks = 0;
 	m_ipu.Reset();
 	m_gif.Reset();
 	m_vpu0->Reset();
@@ -250,8 +316,11 @@ int CSubSystem::ExecuteCpu(int quota)
 		switch(m_EE.m_State.nHasException)
 		{
 		case MIPS_EXCEPTION_SYSCALL:
+		{
+			auto iopLock = m_os->IsIopSyscall() ? LockIop() : std::unique_lock<std::recursive_mutex>();
 			m_os->HandleSyscall();
-			break;
+		}
+		break;
 		case MIPS_EXCEPTION_TLB:
 			m_os->HandleTLBException();
 			break;
@@ -319,7 +388,14 @@ void CSubSystem::CountTicks(int ticks)
 	{
 		if((m_EE.m_State.nCOP0[CCOP_SCU::STATUS] & CMIPS::STATUS_EXL) == 0)
 		{
-			m_sif.CountTicks(ticks);
+			//Don't wait for the IOP thread here, packets will go through on a later call
+			m_sifPendingTicks += ticks;
+			auto iopLock = m_iopMutex ? std::unique_lock<std::recursive_mutex>(*m_iopMutex, std::try_to_lock) : std::unique_lock<std::recursive_mutex>();
+			if(!m_iopMutex || iopLock.owns_lock())
+			{
+				m_sif.CountTicks(m_sifPendingTicks);
+				m_sifPendingTicks = 0;
+			}
 		}
 	}
 	m_EE.m_State.nCOP0[CCOP_SCU::COUNT] += ticks;
@@ -362,6 +438,8 @@ void CSubSystem::NotifyVBlankEnd()
 
 void CSubSystem::SaveState(Framework::CZipArchiveWriter& archive)
 {
+	m_vpu1->Synchronize();
+	m_sif.FlushEeRamWrites();
 	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_EE, &m_EE.m_State, sizeof(MIPSSTATE)));
 	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_VU0, &m_VU0.m_State, sizeof(MIPSSTATE)));
 	archive.InsertFile(std::make_unique<CMemoryStateFile>(STATE_VU1, &m_VU1.m_State, sizeof(MIPSSTATE)));
@@ -385,6 +463,7 @@ void CSubSystem::SaveState(Framework::CZipArchiveWriter& archive)
 
 void CSubSystem::LoadState(Framework::CZipArchiveReader& archive)
 {
+	m_vpu1->Synchronize();
 	m_EE.m_executor->ClearActiveBlocksInRange(0, PS2::EE_RAM_SIZE, false);
 	m_vpu0->GetContext().m_executor->ClearActiveBlocksInRange(0, PS2::MICROMEM0SIZE, false);
 	m_vpu1->GetContext().m_executor->ClearActiveBlocksInRange(0, PS2::MICROMEM1SIZE, false);
@@ -410,13 +489,33 @@ void CSubSystem::LoadState(Framework::CZipArchiveReader& archive)
 	m_os->GetLibMc2().LoadState(archive);
 }
 
+uint8* CSubSystem::AllocateRam()
+{
+	if(m_fastMemoryArena)
+	{
+		auto views = m_fastMemoryArena->MapMemory(PS2::EE_RAM_SIZE, g_ramMirrorAddresses);
+		return views[0];
+	}
+	return reinterpret_cast<uint8*>(framework_aligned_alloc(PS2::EE_RAM_SIZE, framework_getpagesize()));
+}
+
+uint8* CSubSystem::AllocateSpr()
+{
+	if(m_fastMemoryArena)
+	{
+		auto views = m_fastMemoryArena->MapMemory(PS2::EE_SPR_SIZE, {g_sprVirtualAddress});
+		return views[0];
+	}
+	return reinterpret_cast<uint8*>(framework_aligned_alloc(PS2::EE_SPR_SIZE, 0x10));
+}
+
 void CSubSystem::SetupEePageTable()
 {
-	m_EE.MapPages(0x00000000, PS2::EE_RAM_SIZE, m_ram);
-	m_EE.MapPages(0x20000000, PS2::EE_RAM_SIZE, m_ram); //Uncached
-	m_EE.MapPages(0x30000000, PS2::EE_RAM_SIZE, m_ram); //Uncached + Accelerated
-	m_EE.MapPages(0x70000000, PS2::EE_SPR_SIZE, m_spr);
-	m_EE.MapPages(0x80000000, PS2::EE_RAM_SIZE, m_ram);
+	for(auto address : g_ramMirrorAddresses)
+	{
+		m_EE.MapPages(address, PS2::EE_RAM_SIZE, m_ram);
+	}
+	m_EE.MapPages(g_sprVirtualAddress, PS2::EE_SPR_SIZE, m_spr);
 }
 
 uint32 CSubSystem::IOPortReadHandler(uint32 nAddress)
@@ -432,6 +531,7 @@ uint32 CSubSystem::IOPortReadHandler(uint32 nAddress)
 	}
 	else if(nAddress >= CGIF::REGS_START && nAddress < CGIF::REGS_END)
 	{
+		m_vpu1->FlushXgKicks();
 		nReturn = m_gif.GetRegister(nAddress);
 	}
 	else if(nAddress >= CVif::REGS0_START && nAddress < CVif::REGS0_END)
@@ -440,6 +540,7 @@ uint32 CSubSystem::IOPortReadHandler(uint32 nAddress)
 	}
 	else if(nAddress >= CVif::REGS1_START && nAddress < CVif::REGS1_END)
 	{
+		m_vpu1->Synchronize();
 		nReturn = m_vpu1->GetVif().GetRegister(nAddress);
 	}
 	else if(nAddress >= 0x10008000 && nAddress <= 0x1000EFFC)
@@ -458,6 +559,7 @@ uint32 CSubSystem::IOPortReadHandler(uint32 nAddress)
 	{
 		if(m_gs != NULL)
 		{
+			m_vpu1->FlushXgKicks();
 			nReturn = m_gs->ReadPrivRegister(nAddress);
 		}
 	}
@@ -508,6 +610,7 @@ uint32 CSubSystem::IOPortWriteHandler(uint32 nAddress, uint32 nData)
 	}
 	else if(nAddress >= CGIF::REGS_START && nAddress < CGIF::REGS_END)
 	{
+		m_vpu1->FlushXgKicks();
 		m_gif.SetRegister(nAddress, nData);
 	}
 	else if(nAddress >= CVif::REGS0_START && nAddress < CVif::REGS0_END)
@@ -516,6 +619,7 @@ uint32 CSubSystem::IOPortWriteHandler(uint32 nAddress, uint32 nData)
 	}
 	else if(nAddress >= CVif::REGS1_START && nAddress < CVif::REGS1_END)
 	{
+		m_vpu1->Synchronize();
 		m_vpu1->GetVif().SetRegister(nAddress, nData);
 	}
 	else if(nAddress >= CVif::VIF0_FIFO_START && nAddress < CVif::VIF0_FIFO_END)
@@ -524,10 +628,12 @@ uint32 CSubSystem::IOPortWriteHandler(uint32 nAddress, uint32 nData)
 	}
 	else if(nAddress >= CVif::VIF1_FIFO_START && nAddress < CVif::VIF1_FIFO_END)
 	{
+		m_vpu1->Synchronize();
 		m_vpu1->GetVif().SetRegister(nAddress, nData);
 	}
 	else if(nAddress >= CGIF::GIF_FIFO_START && nAddress < CGIF::GIF_FIFO_END)
 	{
+		m_vpu1->FlushXgKicks();
 		m_gif.SetRegister(nAddress, nData);
 	}
 	else if(nAddress >= 0x10007000 && nAddress <= 0x1000702F)
@@ -547,6 +653,7 @@ uint32 CSubSystem::IOPortWriteHandler(uint32 nAddress, uint32 nData)
 	else if(nAddress == 0x1000F180)
 	{
 		//stdout data
+		auto iopLock = LockIop();
 		m_iopBios.GetIoman()->Write(Iop::CIoman::FID_STDOUT, 1, &nData);
 	}
 	else if(nAddress >= 0x1000F520 && nAddress <= 0x1000F59C)
@@ -561,6 +668,7 @@ uint32 CSubSystem::IOPortWriteHandler(uint32 nAddress, uint32 nData)
 	else if(nAddress == CVpu::EE_ADDR_VU_CMSAR1)
 	{
 		bool validAddress = (nData & 0x7) == 0;
+		m_vpu1->Synchronize();
 		if(!m_vpu1->IsVuRunning() && validAddress)
 		{
 			m_vpu1->ExecuteMicroProgram(nData);
@@ -570,6 +678,7 @@ uint32 CSubSystem::IOPortWriteHandler(uint32 nAddress, uint32 nData)
 	{
 		if(m_gs != NULL)
 		{
+			m_vpu1->FlushXgKicks();
 			m_gs->WritePrivRegister(nAddress, nData);
 		}
 	}
@@ -652,12 +761,39 @@ void CSubSystem::Vu0StateChanged(bool running)
 
 uint32 CSubSystem::Vu1MicroMemWriteHandler(uint32 address, uint32 value)
 {
+	m_vpu1->Synchronize();
 	uint32 baseAddress = (address - PS2::MICROMEM1ADDR) & ~0x03;
 	*reinterpret_cast<uint32*>(m_microMem1 + baseAddress) = value;
 	m_vpu1->InvalidateMicroProgram(baseAddress, baseAddress + 4);
 	return 0;
 }
 
+uint32 CSubSystem::Vu1MemoryReadHandler(uint32 address)
+{
+	m_vpu1->Synchronize();
+	uint8* memory = m_vuMem1;
+	uint32 offset = address - PS2::VUMEM1ADDR;
+	uint32 size = PS2::VUMEM1SIZE;
+	if(address < PS2::VUMEM1ADDR)
+	{
+		memory = m_microMem1;
+		offset = address - PS2::MICROMEM1ADDR;
+		size = PS2::MICROMEM1SIZE;
+	}
+	//Byte and half reads only use the lower bits of the result
+	uint32 result = 0;
+	memcpy(&result, memory + offset, std::min<uint32>(sizeof(uint32), size - offset));
+	return result;
+}
+
+uint32 CSubSystem::Vu1MemoryWriteHandler(uint32 address, uint32 value)
+{
+	m_vpu1->Synchronize();
+	uint32 baseAddress = (address - PS2::VUMEM1ADDR) & ~0x03;
+	*reinterpret_cast<uint32*>(m_vuMem1 + baseAddress) = value;
+	return 0;
+}
+
 uint32 CSubSystem::Vu1IoPortReadHandler(uint32 address)
 {
 	uint32 result = 0xCCCCCCCC;
@@ -714,6 +850,7 @@ void CSubSystem::CopyVuState(CMIPS& dst, const CMIPS& src)
 
 void CSubSystem::HandleVu1AreaWrite(uint32 offset, uint32 value)
 {
+	m_vpu1->Synchronize();
 	assert(!m_vpu1->IsVuRunning());
 	assert(offset < 0x400);
 	if(offset >= 0 && offset <= 0x1FF)
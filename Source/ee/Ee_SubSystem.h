@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include "AlignedAlloc.h"
 #include "../COP_SCU.h"
 #include "../COP_FPU.h"
@@ -16,6 +17,7 @@
 #include "COP_VU.h"
 #include "PS2OS.h"
 #include "../gs/GSHandler.h"
+#include "../FastMemoryArena.h"
 
 #include "signal/Signal.h"
 
@@ -24,7 +26,7 @@ namespace Ee
 	class CSubSystem
 	{
 	public:
-		CSubSystem(uint8*, CIopBios&);
+		CSubSystem(uint8*, CIopBios&, bool = false, bool = false);
 		virtual ~CSubSystem();
 
 		void Reset(uint32);
@@ -41,6 +43,12 @@ namespace Ee
 		void SetVpu0(std::shared_ptr<CVpu>);
 		void SetVpu1(std::shared_ptr<CVpu>);
 
+		//Mutex held by the IOP thread while it runs, taken when EE side code reaches IOP state
+		void SetIopMutex(std::recursive_mutex*);
+
+		//Needs to be declared before the memory blocks it provides
+		std::unique_ptr<CFastMemoryArena> m_fastMemoryArena;
+
 		uint8* m_ram = nullptr;
 		uint8* m_bios = nullptr;
 		uint8* m_spr = nullptr;
@@ -81,6 +89,8 @@ namespace Ee
 	private:
 		typedef std::map<uint32, uint32> StatusRegisterCheckerMap;
 
+		uint8* AllocateRam();
+		uint8* AllocateSpr();
 		void SetupEePageTable();
 
 		uint32 IOPortReadHandler(uint32);
@@ -93,6 +103,8 @@ namespace Ee
 		void Vu0StateChanged(bool);
 
 		uint32 Vu1MicroMemWriteHandler(uint32, uint32);
+		uint32 Vu1MemoryReadHandler(uint32);
+		uint32 Vu1MemoryWriteHandler(uint32, uint32);
 
 		uint32 Vu1IoPortReadHandler(uint32);
 		uint32 Vu1IoPortWriteHandler(uint32, uint32);
@@ -102,6 +114,8 @@ namespace Ee
 
 		void ExecuteIpu();
 
+		std::unique_lock<std::recursive_mutex> LockIop();
+
 		void CheckPendingInterrupts();
 
 		void FlushInstructionCache();
@@ -112,6 +126,9 @@ namespace Ee
 		StatusRegisterCheckerMap m_statusRegisterCheckers;
 		bool m_isIdle = false;
 
+		std::recursive_mutex* m_iopMutex = nullptr;
+		uint32 m_sifPendingTicks = 0;
+
 		CMA_VU m_MAVU0;
 		CMA_VU m_MAVU1;
 		CMA_EE m_EEArch;
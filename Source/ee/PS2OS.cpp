@@ -3232,6 +3232,35 @@ void CPS2OS::sc_GetMemorySize()
 //System Call Handler
 //////////////////////////////////////////////////
 
+//Syscalls that reach IOP state through the SIF, IOP modules or the IOP's I/O manager
+bool CPS2OS::IsIopSyscall() const
+{
+	uint32 func = m_ee.m_State.nGPR[CMIPS::V1].nV[0];
+	if((func >= Ee::CLibMc2::SYSCALL_RANGE_START) && (func < Ee::CLibMc2::SYSCALL_RANGE_END))
+	{
+		return true;
+	}
+	if(func & 0x80000000)
+	{
+		func = 0 - func;
+	}
+	switch(func)
+	{
+	case 0x04: //Exit
+	case 0x06: //LoadExecPS2
+	case 0x07: //ExecPS2
+	case 0x76: //SifDmaStat
+	case 0x77: //SifSetDma
+	case 0x78: //SifSetDChain
+	case 0x79: //SifSetReg
+	case 0x7A: //SifGetReg
+	case 0x7C: //Deci2Call
+		return true;
+	default:
+		return false;
+	}
+}
+
 void CPS2OS::HandleSyscall()
 {
 	uint32 searchAddress = m_ee.m_State.nCOP0[CCOP_SCU::EPC];
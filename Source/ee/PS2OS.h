@@ -46,6 +46,7 @@ public:
 
 	void HandleInterrupt(int32);
 	void HandleSyscall();
+	bool IsIopSyscall() const;
 	void HandleReturnFromException();
 	void HandleTLBException();
 	bool CheckVBlankFlag();
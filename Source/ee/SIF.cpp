@@ -82,6 +82,7 @@ void CSIF::Reset()
 
 	m_packetQueue.clear();
 	m_packetProcessed = true;
+	m_eeRamWrites.clear();
 
 	m_callReplies.clear();
 	m_bindReplies.clear();
@@ -159,6 +160,7 @@ uint32 CSIF::ReceiveDMA5(uint32 srcAddress, uint32 size, uint32 unused, bool isT
 uint32 CSIF::ReceiveDMA6(uint32 nSrcAddr, uint32 nSize, uint32 nDstAddr, bool isTagIncluded)
 {
 	assert(!isTagIncluded);
+	m_transferCount++;
 
 	//Humm, this is kinda odd, but it ors the address with 0x20000000
 	nSrcAddr &= (PS2::EE_RAM_SIZE - 1);
@@ -249,6 +251,7 @@ void CSIF::SendPacket(const void* packet, uint32 size)
 
 void CSIF::SendPacketToAddress(const void* packet, uint32 size, uint32 dstAddr)
 {
+	m_transferCount++;
 	m_packetQueue.insert(m_packetQueue.end(),
 	                     reinterpret_cast<const uint8*>(&size),
 	                     reinterpret_cast<const uint8*>(&size) + 4);
@@ -262,6 +265,9 @@ void CSIF::SendPacketToAddress(const void* packet, uint32 size, uint32 dstAddr)
 
 void CSIF::CountTicks(uint32 ticks)
 {
+	//Data needs to be there before packets referring to it are sent
+	FlushEeRamWrites();
+
 	CheckPendingBindRequests(ticks);
 
 	if(m_packetProcessed && !m_packetQueue.empty())
@@ -283,6 +289,7 @@ void CSIF::MarkPacketProcessed()
 
 void CSIF::SendDMA(const void* data, uint32 dstAddr, uint32 size)
 {
+	m_transferCount++;
 	memcpy(m_eeRam + dstAddr, data, size);
 
 	uint32 qwc = (size + 0x0F) / 0x10;
@@ -291,6 +298,47 @@ void CSIF::SendDMA(const void* data, uint32 dstAddr, uint32 size)
 	m_dmac.SetRegister(CDMAC::D5_CHCR, CDMAC::CHCR_STR);
 }
 
+void CSIF::WriteEeRam(uint32 dstAddr, const void* data, uint32 size)
+{
+	if(!m_eeRamWritesDeferred)
+	{
+		memcpy(m_eeRam + dstAddr, data, size);
+		return;
+	}
+	m_eeRamWrites.insert(m_eeRamWrites.end(),
+	                     reinterpret_cast<const uint8*>(&size),
+	                     reinterpret_cast<const uint8*>(&size) + 4);
+	m_eeRamWrites.insert(m_eeRamWrites.end(),
+	                     reinterpret_cast<const uint8*>(&dstAddr),
+	                     reinterpret_cast<const uint8*>(&dstAddr) + 4);
+	m_eeRamWrites.insert(m_eeRamWrites.end(),
+	                     reinterpret_cast<const uint8*>(data),
+	                     reinterpret_cast<const uint8*>(data) + size);
+}
+
+void CSIF::SetEeRamWritesDeferred(bool eeRamWritesDeferred)
+{
+	if(!eeRamWritesDeferred)
+	{
+		FlushEeRamWrites();
+	}
+	m_eeRamWritesDeferred = eeRamWritesDeferred;
+}
+
+void CSIF::FlushEeRamWrites()
+{
+	uint32 offset = 0;
+	while(offset < m_eeRamWrites.size())
+	{
+		assert((m_eeRamWrites.size() - offset) >= 8);
+		uint32 size = *reinterpret_cast<uint32*>(&m_eeRamWrites[offset + 0]);
+		uint32 dstAddr = *reinterpret_cast<uint32*>(&m_eeRamWrites[offset + 4]);
+		memcpy(m_eeRam + dstAddr, &m_eeRamWrites[offset + 8], size);
+		offset += 8 + size;
+	}
+	m_eeRamWrites.clear();
+}
+
 void CSIF::LoadState(Framework::CZipArchiveReader& archive)
 {
 	{
@@ -305,6 +353,7 @@ void CSIF::LoadState(Framework::CZipArchiveReader& archive)
 	}
 
 	m_packetQueue = LoadPacketQueue(archive);
+	m_eeRamWrites.clear();
 
 	m_callReplies = LoadCallReplies(archive);
 	m_bindReplies = LoadBindReplies(archive);
@@ -634,7 +683,7 @@ void CSIF::Cmd_GetOtherData(const SIFCMDHEADER* hdr)
 	uint32 dstPtr = otherData->dstPtr & (PS2::EE_RAM_SIZE - 1);
 	uint32 srcPtr = otherData->srcPtr & (PS2::IOP_RAM_SIZE - 1);
 
-	memcpy(m_eeRam + dstPtr, m_iopRam + srcPtr, otherData->size);
+	WriteEeRam(dstPtr, m_iopRam + srcPtr, otherData->size);
 
 	{
 		SIFRPCREQUESTEND rend;
@@ -669,7 +718,7 @@ void CSIF::SendCallReply(uint32 serverId, const void* returnData)
 		//Size needs to be a multiple of 4
 		assert((requestInfo.call.recvSize & 0x03) == 0);
 		uint32 dstSize = (requestInfo.call.recvSize + 0x03) & ~0x03;
-		memcpy(m_eeRam + dstPtr, returnData, dstSize);
+		WriteEeRam(dstPtr, returnData, dstSize);
 	}
 	SendPacket(&requestInfo.reply, sizeof(SIFRPCREQUESTEND));
 	m_callReplies.erase(replyIterator);
@@ -718,8 +767,14 @@ uint32 CSIF::GetRegister(uint32 nRegister)
 	}
 }
 
+uint32 CSIF::GetTransferCount() const
+{
+	return m_transferCount;
+}
+
 void CSIF::SetRegister(uint32 nRegister, uint32 nValue)
 {
+	m_transferCount++;
 	switch(nRegister)
 	{
 	case 0x00000001:
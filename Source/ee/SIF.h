@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <vector>
 #include "../SifDefs.h"
@@ -40,9 +41,18 @@ public:
 
 	void SendDMA(const void*, uint32, uint32);
 
+	//When the IOP runs on its own thread, its writes to EE RAM are queued and
+	//applied on the EE thread when packets are delivered (CountTicks)
+	void WriteEeRam(uint32, const void*, uint32);
+	void SetEeRamWritesDeferred(bool);
+	void FlushEeRamWrites();
+
 	uint32 GetRegister(uint32);
 	void SetRegister(uint32, uint32);
 
+	//Incremented every time data or a flag goes through, allows detecting communication between processors
+	uint32 GetTransferCount() const;
+
 	void LoadState(Framework::CZipArchiveReader&);
 	void SaveState(Framework::CZipArchiveWriter&);
 
@@ -105,11 +115,16 @@ private:
 	uint32 m_nEERecvAddr = 0;
 	uint32 m_nDataAddr = 0;
 
+	std::atomic<uint32> m_transferCount = {0};
+
 	ModuleMap m_modules;
 
 	PacketQueue m_packetQueue;
 	bool m_packetProcessed;
 
+	bool m_eeRamWritesDeferred = false;
+	PacketQueue m_eeRamWrites;
+
 	CallReplyMap m_callReplies;
 	BindReplyMap m_bindReplies;
 
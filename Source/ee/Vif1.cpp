@@ -114,6 +114,7 @@ void CVif1::ExecuteCommand(StreamType& stream, CODE nCommand)
 		m_gif.SetPath3Masked((nCommand.nIMM & 0x8000) != 0);
 		break;
 	case CODE_CMD_FLUSH:
+		m_vpu.FlushXgKicks();
 		if(m_vpu.IsVuRunning())
 		{
 			m_STAT.nVEW = 1;
@@ -129,6 +130,7 @@ void CVif1::ExecuteCommand(StreamType& stream, CODE nCommand)
 		}
 		break;
 	case CODE_CMD_FLUSHA:
+		m_vpu.FlushXgKicks();
 		if(m_vpu.IsVuRunning())
 		{
 			m_STAT.nVEW = 1;
@@ -155,6 +157,9 @@ void CVif1::ExecuteCommand(StreamType& stream, CODE nCommand)
 
 void CVif1::Cmd_DIRECT(StreamType& stream, CODE nCommand)
 {
+	//Packets kicked by VU1 before this must reach the GIF first
+	m_vpu.FlushXgKicks();
+
 	uint32 nSize = stream.GetAvailableReadBytes();
 	assert((nSize & 0x03) == 0);
 
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "Vpu.h"
 #include "make_unique.h"
 #include "string_format.h"
@@ -36,6 +37,7 @@ CVpu::CVpu(unsigned int number, const VPUINIT& vpuInit, CGIF& gif, CINTC& intc,
 
 CVpu::~CVpu()
 {
+	SetThreaded(false);
 #ifdef DEBUGGER_INCLUDED
 	delete[] m_microMemMiniState;
 	delete[] m_vuMemMiniState;
@@ -44,18 +46,37 @@ CVpu::~CVpu()
 
 void CVpu::Execute(int32 quota)
 {
+	if(m_threaded)
+	{
+		FlushXgKicks();
+		if(m_running)
+		{
+			PostCommand(quota, 1);
+		}
+		return;
+	}
+
 	if(!m_running) return;
 
 #ifdef PROFILE
 	CProfilerZone profilerZone(m_vuProfilerZone);
 #endif
 
-	m_ctx->m_executor->Execute(quota);
-	if(m_ctx->m_State.nHasException)
+	ExecuteSlices(quota, 1);
+}
+
+void CVpu::ExecuteSlices(int32 quota, uint32 sliceCount)
+{
+	for(uint32 i = 0; i < sliceCount; i++)
 	{
-		//E bit encountered
-		m_running = false;
-		VuStateChanged(m_running);
+		if(!m_running) break;
+		m_ctx->m_executor->Execute(quota);
+		if(m_ctx->m_State.nHasException)
+		{
+			//E bit encountered
+			m_running = false;
+			VuStateChanged(false);
+		}
 	}
 }
 
@@ -99,6 +120,8 @@ uint32 CVpu::GetVuItopMiniState() const
 
 void CVpu::Reset()
 {
+	Synchronize();
+	m_deferredXgKicks.clear();
 	m_running = false;
 	m_ctx->m_executor->Reset();
 	m_vif->Reset();
@@ -106,6 +129,7 @@ void CVpu::Reset()
 
 void CVpu::SaveState(Framework::CZipArchiveWriter& archive)
 {
+	Synchronize();
 	{
 		auto path = string_format(STATE_PATH_REGS_FORMAT, m_number);
 		auto registerFile = std::make_unique<CRegisterStateFile>(path.c_str());
@@ -118,11 +142,13 @@ void CVpu::SaveState(Framework::CZipArchiveWriter& archive)
 
 void CVpu::LoadState(Framework::CZipArchiveReader& archive)
 {
+	Synchronize();
 	{
 		auto path = string_format(STATE_PATH_REGS_FORMAT, m_number);
 		CRegisterStateFile registerFile(*archive.BeginReadFile(path.c_str()));
 		m_running = registerFile.GetRegister32(STATE_REGS_RUNNING) != 0;
 	}
+	m_deferredXgKicks.clear();
 
 	m_vif->LoadState(archive);
 }
@@ -162,6 +188,154 @@ CVif& CVpu::GetVif()
 	return *m_vif.get();
 }
 
+void CVpu::SetThreaded(bool threaded)
+{
+	if(threaded == m_threaded) return;
+	if(threaded)
+	{
+		m_workerEnd = false;
+		m_workerThread = std::thread([this]() { WorkerThreadProc(); });
+	}
+	else
+	{
+		Synchronize();
+		{
+			std::lock_guard<std::mutex> lock(m_workerMutex);
+			m_workerEnd = true;
+		}
+		m_workerCondition.notify_one();
+		m_workerThread.join();
+	}
+	m_threaded = threaded;
+}
+
+bool CVpu::IsThreaded() const
+{
+	return m_threaded;
+}
+
+void CVpu::Synchronize()
+{
+	if(!m_threaded) return;
+	while(m_pendingCommandCount != 0)
+	{
+		//The worker might be waiting for room in the XGKICK queue
+		FlushXgKicks();
+		DeferXgKicks();
+		std::this_thread::yield();
+	}
+	FlushXgKicks();
+}
+
+void CVpu::FlushXgKicks()
+{
+	while(!m_deferredXgKicks.empty())
+	{
+		if(!CanSendXgKick()) return;
+		auto& packet = m_deferredXgKicks.front();
+		uint32 packetSize = static_cast<uint32>(packet.size());
+		m_gif.ProcessSinglePacket(packet.data(), packetSize, 0, packetSize, CGsPacketMetadata(1));
+		m_deferredXgKicks.pop_front();
+	}
+	bool sent = false;
+	while(auto packet = m_xgKicks.GetReadSlot())
+	{
+		if(!CanSendXgKick()) break;
+		uint32 packetSize = static_cast<uint32>(packet->size());
+		m_gif.ProcessSinglePacket(packet->data(), packetSize, 0, packetSize, CGsPacketMetadata(1));
+		m_xgKicks.CommitRead();
+		sent = true;
+	}
+	if(sent)
+	{
+		//Pairs with the fence in QueueXgKick: either the worker sees the room or we see it waiting
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(m_xgKickStalled.load(std::memory_order_relaxed))
+		{
+			std::lock_guard<std::mutex> lock(m_xgKickMutex);
+			m_xgKickCondition.notify_one();
+		}
+	}
+}
+
+//Keep packets queued while another path is in the middle of a transfer
+bool CVpu::CanSendXgKick() const
+{
+	uint32 activePath = m_gif.GetActivePath();
+	return (activePath == 0) || (activePath == 1);
+}
+
+//When the worker is stuck on a full queue while another GIF path holds the bus, that path
+//can only move forward once the EE thread goes on. Take the packets out of the queue to let
+//the worker complete, they'll be sent when the bus is released.
+void CVpu::DeferXgKicks()
+{
+	if(!m_xgKickStalled.load()) return;
+	if(CanSendXgKick()) return;
+	bool deferred = false;
+	while(auto packet = m_xgKicks.GetReadSlot())
+	{
+		m_deferredXgKicks.push_back(std::move(*packet));
+		m_xgKicks.CommitRead();
+		deferred = true;
+	}
+	if(deferred)
+	{
+		std::lock_guard<std::mutex> lock(m_xgKickMutex);
+		m_xgKickCondition.notify_one();
+	}
+}
+
+void CVpu::PostCommand(int32 quota, uint32 sliceCount)
+{
+	COMMAND command;
+	command.quota = quota;
+	command.sliceCount = sliceCount;
+	m_pendingCommandCount++;
+	while(!m_commands.TryPush(command))
+	{
+		FlushXgKicks();
+		DeferXgKicks();
+		std::this_thread::yield();
+	}
+	//Pairs with the fence in the worker: either it sees the new command or we see it sleeping
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(m_workerSleeping.load(std::memory_order_relaxed))
+	{
+		std::lock_guard<std::mutex> lock(m_workerMutex);
+		m_workerCondition.notify_one();
+	}
+}
+
+void CVpu::WorkerThreadProc()
+{
+	uint32 spinCount = 0;
+	while(1)
+	{
+		if(auto command = m_commands.GetReadSlot())
+		{
+			ExecuteSlices(command->quota, command->sliceCount);
+			m_commands.CommitRead();
+			m_pendingCommandCount--;
+			spinCount = 0;
+			continue;
+		}
+		if(spinCount < WORKER_SPIN_COUNT)
+		{
+			spinCount++;
+			std::this_thread::yield();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_workerMutex);
+		m_workerSleeping = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		m_workerCondition.wait(lock, [this]() { return m_workerEnd || !m_commands.IsEmpty(); });
+		m_workerSleeping = false;
+		if(m_workerEnd) break;
+		spinCount = 0;
+	}
+}
+
 void CVpu::ExecuteMicroProgram(uint32 nAddress)
 {
 	CLog::GetInstance().Print(LOG_NAME, "Starting microprogram execution at 0x%08X.\r\n", nAddress);
@@ -179,21 +353,29 @@ void CVpu::ExecuteMicroProgram(uint32 nAddress)
 
 	assert(!m_running);
 	m_running = true;
-	VuStateChanged(m_running);
-	for(unsigned int i = 0; i < 100; i++)
+	VuStateChanged(true);
+	if(m_threaded)
 	{
-		Execute(5000);
-		if(!m_running) break;
+		PostCommand(MICROPROGRAM_SLICE_QUOTA, MICROPROGRAM_SLICE_COUNT);
+		return;
 	}
+
+#ifdef PROFILE
+	CProfilerZone profilerZone(m_vuProfilerZone);
+#endif
+
+	ExecuteSlices(MICROPROGRAM_SLICE_QUOTA, MICROPROGRAM_SLICE_COUNT);
 }
 
 void CVpu::InvalidateMicroProgram()
 {
+	Synchronize();
 	m_ctx->m_executor->ClearActiveBlocksInRange(0, (m_number == 0) ? PS2::MICROMEM0SIZE : PS2::MICROMEM1SIZE, false);
 }
 
 void CVpu::InvalidateMicroProgram(uint32 start, uint32 end)
 {
+	Synchronize();
 	m_ctx->m_executor->ClearActiveBlocksInRange(start, end, false);
 }
 
@@ -202,6 +384,12 @@ void CVpu::ProcessXgKick(uint32 address)
 	address &= 0x3FF;
 	address *= 0x10;
 
+	if(m_threaded)
+	{
+		QueueXgKick(address);
+		return;
+	}
+
 	CGsPacketMetadata metadata;
 	metadata.pathIndex = 1;
 #ifdef DEBUGGER_INCLUDED
@@ -225,3 +413,54 @@ void CVpu::ProcessXgKick(uint32 address)
 	SaveMiniState();
 #endif
 }
+
+void CVpu::QueueXgKick(uint32 address)
+{
+	XgKickPacket* packet = m_xgKicks.GetWriteSlot();
+	if(!packet)
+	{
+		//Wait for the EE thread to send or set aside older packets
+		std::unique_lock<std::mutex> lock(m_xgKickMutex);
+		m_xgKickStalled = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		m_xgKickCondition.wait(lock, [&]() { return (packet = m_xgKicks.GetWriteSlot()) != nullptr; });
+		m_xgKickStalled = false;
+	}
+
+	//Copy the packet out of VU memory since the micro program might overwrite it right away
+	uint32 packetSize = GetXgKickPacketSize(address);
+	packet->resize(packetSize);
+	uint32 size1 = std::min<uint32>(packetSize, PS2::VUMEM1SIZE - address);
+	memcpy(packet->data(), GetVuMemory() + address, size1);
+	memcpy(packet->data() + size1, GetVuMemory(), packetSize - size1);
+	m_xgKicks.CommitWrite();
+}
+
+//Walks GIF tags until the end of packet to find how much data the GIF will read
+uint32 CVpu::GetXgKickPacketSize(uint32 address) const
+{
+	uint32 size = 0;
+	while(size < PS2::VUMEM1SIZE)
+	{
+		auto tag = reinterpret_cast<const CGIF::TAG*>(GetVuMemory() + ((address + size) & (PS2::VUMEM1SIZE - 1)));
+		uint32 regCount = (tag->nreg == 0) ? 0x10 : tag->nreg;
+		size += 0x10;
+		switch(tag->cmd)
+		{
+		case 0:
+			//PACKED
+			size += tag->loops * regCount * 0x10;
+			break;
+		case 1:
+			//REGLIST
+			size += ((tag->loops * regCount + 1) / 2) * 0x10;
+			break;
+		default:
+			//IMAGE
+			size += tag->loops * 0x10;
+			break;
+		}
+		if(tag->eop) break;
+	}
+	return std::min<uint32>(size, PS2::VUMEM1SIZE);
+}
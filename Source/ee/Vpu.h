@@ -1,8 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "Types.h"
 #include "../MIPS.h"
 #include "../Profiler.h"
+#include "../SpscQueue.h"
 #include "Convertible.h"
 #include "zip/ZipArchiveWriter.h"
 #include "zip/ZipArchiveReader.h"
@@ -59,6 +66,15 @@ public:
 
 	CVif& GetVif();
 
+	//Threaded mode runs micro programs on a worker thread while the EE keeps going. XGKICK packets
+	//are queued by the worker and sent to the GIF by the EE thread to keep their order with other paths.
+	void SetThreaded(bool);
+	bool IsThreaded() const;
+
+	//Waits for the worker to go idle. Must be called before the EE thread looks at VU state.
+	void Synchronize();
+	void FlushXgKicks();
+
 	void ExecuteMicroProgram(uint32);
 	void InvalidateMicroProgram();
 	void InvalidateMicroProgram(uint32, uint32);
@@ -79,6 +95,31 @@ public:
 protected:
 	typedef std::unique_ptr<CVif> VifPtr;
 
+	enum
+	{
+		COMMAND_QUEUE_SIZE = 0x40,
+		XGKICK_QUEUE_SIZE = 0x40,
+		WORKER_SPIN_COUNT = 0x100,
+		MICROPROGRAM_SLICE_COUNT = 100,
+		MICROPROGRAM_SLICE_QUOTA = 5000,
+	};
+
+	struct COMMAND
+	{
+		int32 quota = 0;
+		uint32 sliceCount = 0;
+	};
+
+	typedef std::vector<uint8> XgKickPacket;
+
+	void ExecuteSlices(int32, uint32);
+	void PostCommand(int32, uint32);
+	void QueueXgKick(uint32);
+	void DeferXgKicks();
+	bool CanSendXgKick() const;
+	uint32 GetXgKickPacketSize(uint32) const;
+	void WorkerThreadProc();
+
 	unsigned int m_number = 0;
 	VifPtr m_vif;
 	uint8* m_microMem = nullptr;
@@ -96,7 +137,25 @@ protected:
 	uint32 m_itopMiniState;
 #endif
 
-	bool m_running = false;
+	std::atomic<bool> m_running = {false};
+
+	bool m_threaded = false;
+	std::thread m_workerThread;
+	std::mutex m_workerMutex;
+	std::condition_variable m_workerCondition;
+	std::atomic<bool> m_workerSleeping = {false};
+	bool m_workerEnd = false;
+	std::atomic<uint32> m_pendingCommandCount = {0};
+	CSpscQueue<COMMAND, COMMAND_QUEUE_SIZE> m_commands;
+	CSpscQueue<XgKickPacket, XGKICK_QUEUE_SIZE> m_xgKicks;
+
+	//Worker waits for room in the XGKICK queue, EE thread signals it when packets leave it
+	std::mutex m_xgKickMutex;
+	std::condition_variable m_xgKickCondition;
+	std::atomic<bool> m_xgKickStalled = {false};
+
+	//Packets taken out of a full queue while another GIF path was active, sent before queued ones (EE thread only)
+	std::deque<XgKickPacket> m_deferredXgKicks;
 
 	CProfiler::ZoneHandle m_vuProfilerZone = 0;
 };
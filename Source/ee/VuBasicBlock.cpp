@@ -14,6 +14,12 @@ bool CVuBasicBlock::IsLinkable() const
 	return m_isLinkable;
 }
 
+bool CVuBasicBlock::IsCodeCacheable() const
+{
+	//Non linkable blocks might contain code from outside of their range
+	return m_isLinkable;
+}
+
 void CVuBasicBlock::CompileRange(CMipsJitter* jitter)
 {
 	CompileProlog(jitter);
@@ -1,7 +1,6 @@
 #include "VuExecutor.h"
 #include "VuBasicBlock.h"
 #include "VUShared.h"
-#include "xxhash.h"
 
 CVuExecutor::CVuExecutor(CMIPS& context, uint32 maxAddress)
     : CGenericMipsExecutor(context, maxAddress, BLOCK_CATEGORY_PS2_VU)
@@ -10,7 +9,7 @@ CVuExecutor::CVuExecutor(CMIPS& context, uint32 maxAddress)
 
 void CVuExecutor::Reset()
 {
-	m_cachedBlocks.clear();
+	m_cachedBlocks.Clear();
 	CGenericMipsExecutor::Reset();
 }
 
@@ -24,43 +23,39 @@ BasicBlockPtr CVuExecutor::BlockFactory(CMIPS& context, uint32 begin, uint32 end
 	uint32 localBegin = begin - map->nStart;
 	auto blockMemory = reinterpret_cast<const uint32*>(reinterpret_cast<uint8*>(map->pPointer) + localBegin);
 
-	auto xxHash = XXH3_128bits(blockMemory, blockSizeByte);
-	uint128 hash;
-	memcpy(&hash, &xxHash, sizeof(xxHash));
-	static_assert(sizeof(hash) == sizeof(xxHash));
-	auto blockKey = std::make_pair(hash, blockSizeByte);
+	auto codeCacheKey = MakeBlockKey(blockMemory, blockSizeByte);
+	CachedBlockKey blockKey = {codeCacheKey.hash, blockSizeByte};
 
 	//Don't use the cached blocks of we have a breakpoint in our block range.
 	bool hasBreakpoint = m_context.HasBreakpointInRange(begin, end);
 	if(!hasBreakpoint)
 	{
-		auto beginBlockIterator = m_cachedBlocks.lower_bound(blockKey);
-		auto endBlockIterator = m_cachedBlocks.upper_bound(blockKey);
-		//Check if we have a block that has the same contents and the same range.
-		for(auto blockIterator = beginBlockIterator; blockIterator != endBlockIterator; blockIterator++)
+		//Check if we have a block that has the same contents, preferably with the same range.
+		auto cachedBlock = m_cachedBlocks.Find(blockKey,
+		                                       [&](const BasicBlockPtr& basicBlock) {
+			                                       return basicBlock->GetBeginAddress() == begin && basicBlock->GetEndAddress() == end;
+		                                       });
+		if(cachedBlock)
 		{
-			const auto& basicBlock(blockIterator->second);
+			const auto& basicBlock(*cachedBlock);
 			if(basicBlock->GetBeginAddress() == begin && basicBlock->GetEndAddress() == end)
 			{
 				return basicBlock;
 			}
-		}
-		//Check if we have a block that has the same contents but not the same range. Reuse the code of that block if that's the case.
-		if(beginBlockIterator != endBlockIterator)
-		{
+			//Same contents but not the same range. Reuse the code of that block.
 			auto result = std::make_shared<CVuBasicBlock>(context, begin, end, m_blockCategory);
-			result->CopyFunctionFrom(beginBlockIterator->second);
-			m_cachedBlocks.insert(std::make_pair(blockKey, result));
+			result->CopyFunctionFrom(basicBlock);
+			m_cachedBlocks.Insert(blockKey, result);
 			return result;
 		}
 	}
 
 	//Totally new block, build it from scratch
 	auto result = std::make_shared<CVuBasicBlock>(context, begin, end, m_blockCategory);
-	result->Compile();
+	CompileBlock(result.get(), codeCacheKey, !hasBreakpoint);
 	if(!hasBreakpoint)
 	{
-		m_cachedBlocks.insert(std::make_pair(blockKey, result));
+		m_cachedBlocks.Insert(blockKey, result);
 	}
 	return result;
 }
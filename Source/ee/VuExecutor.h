@@ -1,7 +1,7 @@
 #pragma once
 
-#include <map>
 #include "../GenericMipsExecutor.h"
+#include "../BlockCacheIndex.h"
 
 class CVuExecutor : public CGenericMipsExecutor<BlockLookupOneWay, 8>
 {
@@ -12,9 +12,14 @@ public:
 	void Reset() override;
 
 protected:
-	typedef std::pair<uint128, uint32> CachedBlockKey;
-	typedef std::multimap<CachedBlockKey, BasicBlockPtr> CachedBlockMap;
-	CachedBlockMap m_cachedBlocks;
+	enum
+	{
+		MAX_CACHED_BLOCKS = 0x2000,
+	};
+
+	typedef CBlockCacheIndex<BasicBlockPtr> CachedBlockIndex;
+	typedef CachedBlockIndex::KEY CachedBlockKey;
+	CachedBlockIndex m_cachedBlocks = CachedBlockIndex(MAX_CACHED_BLOCKS);
 
 	BasicBlockPtr BlockFactory(CMIPS&, uint32, uint32) override;
 	void PartitionFunction(uint32) override;
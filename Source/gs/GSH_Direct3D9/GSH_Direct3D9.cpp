@@ -1,4 +1,5 @@
 #include "GSH_Direct3D9.h"
+#include "../../AppConfig.h"
 #include "../../Log.h"
 #include "../../gs/GsPixelFormats.h"
 #include "../../gs/GsTransferRange.h"
@@ -39,6 +40,7 @@ static uint8 MulBy2Clamp(uint8 value)
 
 CGSH_Direct3D9::CGSH_Direct3D9(Framework::Win32::CWindow* outputWindow)
     : m_outputWnd(outputWindow)
+    , m_textureCache(CAppConfig::GetInstance().GetPreferenceInteger(PREF_CGSHANDLER_TEXTURECACHE_SIZE))
 {
 	memset(&m_renderState, 0, sizeof(m_renderState));
 	m_primitiveMode <<= 0;
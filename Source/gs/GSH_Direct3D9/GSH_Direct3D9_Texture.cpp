@@ -3,6 +3,7 @@
 #include "math/Matrix4.h"
 #include "GSH_Direct3D9.h"
 #include "../../gs/GsPixelFormats.h"
+#include "../../gs/GsTextureConvert.h"
 
 void CGSH_Direct3D9::SetupTextureUpdaters()
 {
@@ -227,70 +228,29 @@ void CGSH_Direct3D9::TexUpdater_Psm32(D3DLOCKED_RECT* lockedRect, uint32 bufPtr,
 template <typename IndexorType>
 void CGSH_Direct3D9::TexUpdater_Psm16(D3DLOCKED_RECT* lockedRect, uint32 bufPtr, uint32 bufWidth, unsigned int texX, unsigned int texY, unsigned int texWidth, unsigned int texHeight)
 {
-	IndexorType indexor(m_pRAM, bufPtr, bufWidth);
-
-	auto dstPitch = lockedRect->Pitch / 2;
-	auto dst = reinterpret_cast<uint16*>(lockedRect->pBits);
-	dst += texX + (texY * dstPitch);
-
-	for(unsigned int y = 0; y < texHeight; y++)
-	{
-		for(unsigned int x = 0; x < texWidth; x++)
-		{
-			auto pixel = indexor.GetPixel(texX + x, texY + y);
-			auto cvtPixel =
-			    (((pixel & 0x001F) >> 0) << 10) | //R
-			    (((pixel & 0x03E0) >> 5) << 5) |  //G
-			    (((pixel & 0x7C00) >> 10) << 0) | //B
-			    (((pixel & 0x8000) >> 15) << 15); //A
-			dst[x] = cvtPixel;
-		}
+	auto dst = reinterpret_cast<uint8*>(lockedRect->pBits);
+	dst += (texX * sizeof(uint16)) + (texY * lockedRect->Pitch);
 
-		dst += dstPitch;
-	}
+	GsTextureConvert::ConvertPsm16<IndexorType>(dst, lockedRect->Pitch, m_pRAM, bufPtr, bufWidth, texX, texY, texWidth, texHeight,
+	                                            GsTextureConvert::COLOR16_FORMAT_ARGB1555);
 }
 
 template <typename IndexorType>
 void CGSH_Direct3D9::TexUpdater_Psm48(D3DLOCKED_RECT* lockedRect, uint32 bufPtr, uint32 bufWidth, unsigned int texX, unsigned int texY, unsigned int texWidth, unsigned int texHeight)
 {
-	IndexorType indexor(m_pRAM, bufPtr, bufWidth);
-
-	auto dstPitch = lockedRect->Pitch;
 	auto dst = reinterpret_cast<uint8*>(lockedRect->pBits);
-	dst += texX + (texY * dstPitch);
-
-	for(unsigned int y = 0; y < texHeight; y++)
-	{
-		for(unsigned int x = 0; x < texWidth; x++)
-		{
-			uint8 pixel = indexor.GetPixel(texX + x, texY + y);
-			dst[x] = pixel;
-		}
+	dst += texX + (texY * lockedRect->Pitch);
 
-		dst += dstPitch;
-	}
+	GsTextureConvert::ConvertPsm48<IndexorType>(dst, lockedRect->Pitch, m_pRAM, bufPtr, bufWidth, texX, texY, texWidth, texHeight);
 }
 
 template <uint32 shiftAmount, uint32 mask>
 void CGSH_Direct3D9::TexUpdater_Psm48H(D3DLOCKED_RECT* lockedRect, uint32 bufPtr, uint32 bufWidth, unsigned int texX, unsigned int texY, unsigned int texWidth, unsigned int texHeight)
 {
-	CGsPixelFormats::CPixelIndexorPSMCT32 indexor(m_pRAM, bufPtr, bufWidth);
-
-	auto dstPitch = lockedRect->Pitch;
 	auto dst = reinterpret_cast<uint8*>(lockedRect->pBits);
-	dst += texX + (texY * dstPitch);
+	dst += texX + (texY * lockedRect->Pitch);
 
-	for(unsigned int y = 0; y < texHeight; y++)
-	{
-		for(unsigned int x = 0; x < texWidth; x++)
-		{
-			uint32 pixel = indexor.GetPixel(texX + x, texY + y);
-			pixel = (pixel >> shiftAmount) & mask;
-			dst[x] = static_cast<uint8>(pixel);
-		}
-
-		dst += dstPitch;
-	}
+	GsTextureConvert::ConvertPsm48H<shiftAmount, mask>(dst, lockedRect->Pitch, m_pRAM, bufPtr, bufWidth, texX, texY, texWidth, texHeight);
 }
 
 //------------------------------------------------------------------------
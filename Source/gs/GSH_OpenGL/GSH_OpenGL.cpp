@@ -60,6 +60,8 @@ static uint32 MakeColor(uint8 r, uint8 g, uint8 b, uint8 a)
 CGSH_OpenGL::CGSH_OpenGL(bool gsThreaded)
     : CGSHandler(gsThreaded)
     , m_pCvtBuffer(nullptr)
+    , m_textureCache(CAppConfig::GetInstance().GetPreferenceInteger(PREF_CGSHANDLER_TEXTURECACHE_SIZE))
+    , m_textureDecodeCache(CAppConfig::GetInstance().GetPreferenceInteger(PREF_CGSHANDLER_TEXTURECACHE_SIZE))
 {
 	RegisterPreferences();
 	LoadPreferences();
@@ -113,6 +115,7 @@ void CGSH_OpenGL::ResetImpl()
 {
 	LoadPreferences();
 	m_textureCache.Flush();
+	m_textureDecodeCache.Flush();
 	PalCache_Flush();
 	m_framebuffers.clear();
 	m_depthbuffers.clear();
@@ -251,12 +254,14 @@ void CGSH_OpenGL::RegisterPreferences()
 	CGSHandler::RegisterPreferences();
 	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_CGSH_OPENGL_RESOLUTION_FACTOR, 1);
 	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_CGSH_OPENGL_FORCEBILINEARTEXTURES, false);
+	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_CGSH_OPENGL_TEXTUREDECODECACHE, false);
 }
 
 void CGSH_OpenGL::NotifyPreferencesChangedImpl()
 {
 	LoadPreferences();
 	m_textureCache.Flush();
+	m_textureDecodeCache.Flush();
 	PalCache_Flush();
 	m_framebuffers.clear();
 	m_depthbuffers.clear();
@@ -267,6 +272,7 @@ void CGSH_OpenGL::LoadPreferences()
 {
 	m_fbScale = CAppConfig::GetInstance().GetPreferenceInteger(PREF_CGSH_OPENGL_RESOLUTION_FACTOR);
 	m_forceBilinearTextures = CAppConfig::GetInstance().GetPreferenceBoolean(PREF_CGSH_OPENGL_FORCEBILINEARTEXTURES);
+	m_textureDecodeCacheEnabled = CAppConfig::GetInstance().GetPreferenceBoolean(PREF_CGSH_OPENGL_TEXTUREDECODECACHE);
 }
 
 void CGSH_OpenGL::InitializeRC()
@@ -6,6 +6,7 @@
 #include "../GsDebuggerInterface.h"
 #include "../GsCachedArea.h"
 #include "../GsTextureCache.h"
+#include "../GsTextureDecodeCache.h"
 #include "opengl/OpenGlDef.h"
 #include "opengl/Program.h"
 #include "opengl/Shader.h"
@@ -13,6 +14,7 @@
 
 #define PREF_CGSH_OPENGL_RESOLUTION_FACTOR "renderer.opengl.resfactor"
 #define PREF_CGSH_OPENGL_FORCEBILINEARTEXTURES "renderer.opengl.forcebilineartextures"
+#define PREF_CGSH_OPENGL_TEXTUREDECODECACHE "renderer.opengl.texturedecodecache"
 
 #if !defined(GLES_COMPATIBILITY) && !defined(__APPLE__)
 //- Dual source blending is disabled on macOS because it seems to be problematic on
@@ -66,7 +68,10 @@ protected:
 	GLuint m_presentFramebuffer = 0;
 
 private:
-	typedef CGsTextureCache<Framework::OpenGl::CTexture> TextureCache;
+	//Texture handles can be shared between cache entries through the decode cache
+	typedef std::shared_ptr<Framework::OpenGl::CTexture> TextureHandlePtr;
+	typedef CGsTextureCache<TextureHandlePtr> TextureCache;
+	typedef CGsTextureDecodeCache<TextureHandlePtr> TextureDecodeCache;
 	typedef uint64 ShaderCapsInt;
 
 	struct SHADERCAPS : public convertible<ShaderCapsInt>
@@ -175,7 +180,6 @@ private:
 
 	enum
 	{
-		MAX_TEXTURE_CACHE = 256,
 		MAX_PALETTE_CACHE = 256,
 	};
 
@@ -312,6 +316,7 @@ private:
 	virtual void PresentBackbuffer() = 0;
 	void MakeLinearZOrtho(float*, float, float, float, float);
 	TEXTURE_INFO PrepareTexture(const TEX0&);
+	TextureHandlePtr AllocateTexture(const TEX0&);
 	TEXTURE_INFO SearchTextureFramebuffer(const TEX0&);
 	GLuint PreparePalette(const TEX0&);
 
@@ -363,6 +368,7 @@ private:
 	void SetupTexture(uint64, uint64, uint64, uint64, uint64);
 	static uint32 GetFramebufferBitDepth(uint32);
 	static TEXTUREFORMAT_INFO GetTextureFormatInfo(uint32);
+	static uint32 GetTextureMemorySize(const TEX0&);
 
 	FramebufferPtr FindFramebuffer(const FRAME&) const;
 	DepthbufferPtr FindDepthbuffer(const ZBUF&, const FRAME&) const;
@@ -379,9 +385,6 @@ private:
 	template <typename>
 	void TexUpdater_Psm16(uint32, uint32, unsigned int, unsigned int, unsigned int, unsigned int);
 
-	void TexUpdater_Psm8(uint32, uint32, unsigned int, unsigned int, unsigned int, unsigned int);
-	void TexUpdater_Psm4(uint32, uint32, unsigned int, unsigned int, unsigned int, unsigned int);
-
 	template <typename>
 	void TexUpdater_Psm48(uint32, uint32, unsigned int, unsigned int, unsigned int, unsigned int);
 	template <uint32, uint32>
@@ -394,6 +397,7 @@ private:
 	uint32 m_nTexHeight;
 
 	bool m_forceBilinearTextures = false;
+	bool m_textureDecodeCacheEnabled = false;
 	unsigned int m_fbScale = 1;
 	bool m_multisampleEnabled = false;
 	bool m_depthTestingEnabled = true;
@@ -425,6 +429,7 @@ private:
 	GLint m_copyToFbSrcSizeUniform = -1;
 
 	TextureCache m_textureCache;
+	TextureDecodeCache m_textureDecodeCache;
 	PaletteList m_paletteCache;
 	FramebufferList m_framebuffers;
 	DepthbufferList m_depthbuffers;
@@ -3,14 +3,11 @@
 #include <sys/stat.h>
 #include <limits.h>
 #include <algorithm>
-#ifdef _WIN32
-#include <intrin.h>
-#endif
-#include "SimdDefs.h"
 #include "GSH_OpenGL.h"
 #include "StdStream.h"
 #include "bitmap/BMP.h"
 #include "../GsPixelFormats.h"
+#include "../GsTextureConvert.h"
 
 /////////////////////////////////////////////////////////////
 // Texture Loading
@@ -18,21 +15,6 @@
 
 void CGSH_OpenGL::SetupTextureUpdaters()
 {
-	bool canUseSimd48Updaters = true;
-
-#ifdef _WIN32
-	{
-		std::array<int, 4> cpuInfo;
-		__cpuid(cpuInfo.data(), 1);
-
-		static const uint32 CPUID_FLAG_SSSE3 = 0x000200;
-		bool hasSsse3 = (cpuInfo[2] & CPUID_FLAG_SSSE3) != 0;
-
-		//x86 SIMD updaters use PSHUFB that is available on SSSE3
-		canUseSimd48Updaters = hasSsse3;
-	}
-#endif
-
 	for(unsigned int i = 0; i < PSM_MAX; i++)
 	{
 		m_textureUpdater[i] = &CGSH_OpenGL::TexUpdater_Invalid;
@@ -45,16 +27,8 @@ void CGSH_OpenGL::SetupTextureUpdaters()
 	m_textureUpdater[PSMCT24_UNK] = &CGSH_OpenGL::TexUpdater_Psm32;
 	m_textureUpdater[PSMCT16S] = &CGSH_OpenGL::TexUpdater_Psm16<CGsPixelFormats::CPixelIndexorPSMCT16S>;
 
-	if(canUseSimd48Updaters)
-	{
-		m_textureUpdater[PSMT8] = &CGSH_OpenGL::TexUpdater_Psm8;
-		m_textureUpdater[PSMT4] = &CGSH_OpenGL::TexUpdater_Psm4;
-	}
-	else
-	{
-		m_textureUpdater[PSMT8] = &CGSH_OpenGL::TexUpdater_Psm48<CGsPixelFormats::CPixelIndexorPSMT8>;
-		m_textureUpdater[PSMT4] = &CGSH_OpenGL::TexUpdater_Psm48<CGsPixelFormats::CPixelIndexorPSMT4>;
-	}
+	m_textureUpdater[PSMT8] = &CGSH_OpenGL::TexUpdater_Psm48<CGsPixelFormats::CPixelIndexorPSMT8>;
+	m_textureUpdater[PSMT4] = &CGSH_OpenGL::TexUpdater_Psm48<CGsPixelFormats::CPixelIndexorPSMT4>;
 
 	m_textureUpdater[PSMT8H] = &CGSH_OpenGL::TexUpdater_Psm48H<24, 0xFF>;
 	m_textureUpdater[PSMT4HL] = &CGSH_OpenGL::TexUpdater_Psm48H<24, 0x0F>;
@@ -194,31 +168,42 @@ CGSH_OpenGL::TEXTURE_INFO CGSH_OpenGL::PrepareTexture(const TEX0& tex0)
 	auto texture = m_textureCache.Search(tex0);
 	if(!texture)
 	{
-		//Validate texture dimensions to prevent problems
-		auto texWidth = tex0.GetWidth();
-		auto texHeight = tex0.GetHeight();
-		assert(texWidth <= TEX0_MAX_TEXTURE_SIZE);
-		assert(texHeight <= TEX0_MAX_TEXTURE_SIZE);
-		texWidth = std::min<uint32>(texWidth, TEX0_MAX_TEXTURE_SIZE);
-		texHeight = std::min<uint32>(texHeight, TEX0_MAX_TEXTURE_SIZE);
-		auto texFormat = GetTextureFormatInfo(tex0.nPsm);
+		m_textureCache.Insert(tex0, AllocateTexture(tex0));
+		texture = m_textureCache.Search(tex0);
+		texture->m_cachedArea.Invalidate(0, RAMSIZE);
+	}
 
+	auto& cachedArea = texture->m_cachedArea;
+	if(m_textureDecodeCacheEnabled && cachedArea.HasDirtyPages())
+	{
+		auto decodeKey = TextureDecodeCache::MakeKey(m_pRAM, tex0, cachedArea);
+		m_frameTextureCacheStats.decodeLookupCount++;
+		if(auto decodedTexture = m_textureDecodeCache.Search(decodeKey))
 		{
-			auto textureHandle = Framework::OpenGl::CTexture::Create();
-			glBindTexture(GL_TEXTURE_2D, textureHandle);
-			glTexStorage2D(GL_TEXTURE_2D, 1, texFormat.internalFormat, texWidth, texHeight);
-			CHECKGLERROR();
-			m_textureCache.Insert(tex0, std::move(textureHandle));
+			m_frameTextureCacheStats.decodeHitCount++;
+			texture->m_textureHandle = std::move(decodedTexture);
+			cachedArea.ClearDirtyPages();
+		}
+		else
+		{
+			//The decode cache's own reference doesn't count, only other texture cache entries do
+			bool decodeCached = m_textureDecodeCache.Contains(texture->m_textureHandle);
+			auto userCount = texture->m_textureHandle.use_count() - (decodeCached ? 1 : 0);
+			if(userCount != 1)
+			{
+				//Other entries are using this texture, decode in a new one instead of modifying it
+				texture->m_textureHandle = AllocateTexture(tex0);
+				cachedArea.Invalidate(0, RAMSIZE);
+			}
+			//Will contain the decoded area once dirty pages are updated below, Insert drops
+			//the entry for the texture's previous contents if there's one.
+			m_textureDecodeCache.Insert(decodeKey, texture->m_textureHandle, GetTextureMemorySize(tex0));
 		}
-
-		texture = m_textureCache.Search(tex0);
-		texture->m_cachedArea.Invalidate(0, RAMSIZE);
 	}
 
-	texInfo.textureHandle = texture->m_textureHandle;
+	texInfo.textureHandle = *texture->m_textureHandle;
 
-	glBindTexture(GL_TEXTURE_2D, texture->m_textureHandle);
-	auto& cachedArea = texture->m_cachedArea;
+	glBindTexture(GL_TEXTURE_2D, *texture->m_textureHandle);
 	auto texturePageSize = CGsPixelFormats::GetPsmPageSize(tex0.nPsm);
 	auto areaRect = cachedArea.GetAreaPageRect();
 
@@ -252,6 +237,41 @@ CGSH_OpenGL::TEXTURE_INFO CGSH_OpenGL::PrepareTexture(const TEX0& tex0)
 	return texInfo;
 }
 
+uint32 CGSH_OpenGL::GetTextureMemorySize(const TEX0& tex0)
+{
+	auto texWidth = std::min<uint32>(tex0.GetWidth(), TEX0_MAX_TEXTURE_SIZE);
+	auto texHeight = std::min<uint32>(tex0.GetHeight(), TEX0_MAX_TEXTURE_SIZE);
+	uint32 texelSize = 4;
+	switch(GetTextureFormatInfo(tex0.nPsm).internalFormat)
+	{
+	case GL_RGB5_A1:
+		texelSize = 2;
+		break;
+	case GL_R8:
+		texelSize = 1;
+		break;
+	}
+	return texWidth * texHeight * texelSize;
+}
+
+CGSH_OpenGL::TextureHandlePtr CGSH_OpenGL::AllocateTexture(const TEX0& tex0)
+{
+	//Validate texture dimensions to prevent problems
+	auto texWidth = tex0.GetWidth();
+	auto texHeight = tex0.GetHeight();
+	assert(texWidth <= TEX0_MAX_TEXTURE_SIZE);
+	assert(texHeight <= TEX0_MAX_TEXTURE_SIZE);
+	texWidth = std::min<uint32>(texWidth, TEX0_MAX_TEXTURE_SIZE);
+	texHeight = std::min<uint32>(texHeight, TEX0_MAX_TEXTURE_SIZE);
+	auto texFormat = GetTextureFormatInfo(tex0.nPsm);
+
+	auto textureHandle = std::make_shared<Framework::OpenGl::CTexture>(Framework::OpenGl::CTexture::Create());
+	glBindTexture(GL_TEXTURE_2D, *textureHandle);
+	glTexStorage2D(GL_TEXTURE_2D, 1, texFormat.internalFormat, texWidth, texHeight);
+	CHECKGLERROR();
+	return textureHandle;
+}
+
 GLuint CGSH_OpenGL::PreparePalette(const TEX0& tex0)
 {
 	GLuint textureHandle = PalCache_Search(tex0);
@@ -326,331 +346,17 @@ void CGSH_OpenGL::TexUpdater_Psm32(uint32 bufPtr, uint32 bufWidth, unsigned int
 template <typename IndexorType>
 void CGSH_OpenGL::TexUpdater_Psm16(uint32 bufPtr, uint32 bufWidth, unsigned int texX, unsigned int texY, unsigned int texWidth, unsigned int texHeight)
 {
-	IndexorType indexor(m_pRAM, bufPtr, bufWidth);
-
-	auto dst = reinterpret_cast<uint16*>(m_pCvtBuffer);
-	for(unsigned int y = 0; y < texHeight; y++)
-	{
-		for(unsigned int x = 0; x < texWidth; x++)
-		{
-			auto pixel = indexor.GetPixel(texX + x, texY + y);
-			auto cvtPixel =
-			    (((pixel & 0x001F) >> 0) << 11) | //R
-			    (((pixel & 0x03E0) >> 5) << 6) |  //G
-			    (((pixel & 0x7C00) >> 10) << 1) | //B
-			    (pixel >> 15);                    //A
-			dst[x] = cvtPixel;
-		}
-
-		dst += texWidth;
-	}
+	GsTextureConvert::ConvertPsm16<IndexorType>(m_pCvtBuffer, texWidth * sizeof(uint16), m_pRAM, bufPtr, bufWidth, texX, texY, texWidth, texHeight,
+	                                            GsTextureConvert::COLOR16_FORMAT_RGBA5551);
 
 	glTexSubImage2D(GL_TEXTURE_2D, 0, texX, texY, texWidth, texHeight, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, m_pCvtBuffer);
 	CHECKGLERROR();
 }
 
-#if defined(FRAMEWORK_SIMD_USE_SSE)
-#include <xmmintrin.h>
-#include <emmintrin.h>
-#include <tmmintrin.h>
-
-void convertColumn8(uint8* dest, const int destStride, int colNum, __m128i a, __m128i b, __m128i c, __m128i d)
-{
-	__m128i* mdest = (__m128i*)dest;
-
-	__m128i temp_a = a;
-	__m128i temp_c = c;
-
-	a = _mm_unpacklo_epi8(temp_a, b);
-	c = _mm_unpackhi_epi8(temp_a, b);
-	b = _mm_unpacklo_epi8(temp_c, d);
-	d = _mm_unpackhi_epi8(temp_c, d);
-
-	temp_a = a;
-	temp_c = c;
-
-	a = _mm_unpacklo_epi16(temp_a, b);
-	c = _mm_unpackhi_epi16(temp_a, b);
-	b = _mm_unpacklo_epi16(temp_c, d);
-	d = _mm_unpackhi_epi16(temp_c, d);
-
-	temp_a = a;
-	__m128i temp_b = b;
-
-	a = _mm_unpacklo_epi8(temp_a, c);
-	b = _mm_unpackhi_epi8(temp_a, c);
-	c = _mm_unpacklo_epi8(temp_b, d);
-	d = _mm_unpackhi_epi8(temp_b, d);
-
-	temp_a = a;
-	temp_c = c;
-
-	a = _mm_unpacklo_epi64(temp_a, b);
-	c = _mm_unpackhi_epi64(temp_a, b);
-	b = _mm_unpacklo_epi64(temp_c, d);
-	d = _mm_unpackhi_epi64(temp_c, d);
-
-	if((colNum & 1) == 0)
-	{
-		c = _mm_shuffle_epi32(c, _MM_SHUFFLE(2, 3, 0, 1));
-		d = _mm_shuffle_epi32(d, _MM_SHUFFLE(2, 3, 0, 1));
-	}
-	else
-	{
-		a = _mm_shuffle_epi32(a, _MM_SHUFFLE(2, 3, 0, 1));
-		b = _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 3, 0, 1));
-	}
-
-	int mStride = destStride / 16;
-
-	mdest[0] = a;
-	mdest[mStride] = b;
-	mdest[mStride * 2] = c;
-	mdest[mStride * 3] = d;
-}
-
-inline void convertColumn8(uint8* dest, const int destStride, uint8* src, int colNum)
-{
-	__m128i* mSrc = (__m128i*)src;
-
-	__m128i a = mSrc[0];
-	__m128i b = mSrc[1];
-	__m128i c = mSrc[2];
-	__m128i d = mSrc[3];
-	convertColumn8(dest, destStride, colNum, a, b, c, d);
-}
-
-inline void convertColumn4(uint8* dest, const int destStride, uint8* src, int colNum)
-{
-	__m128i* mSrc = (__m128i*)src;
-
-	__m128i a = mSrc[0];
-	__m128i b = mSrc[1];
-	__m128i c = mSrc[2];
-	__m128i d = mSrc[3];
-
-	// 4 bpp looks like 2 8bpp columns side by side.
-	// The 4pp are expanded to 8bpp.
-	// so 01 23 45 67 89 ab cd ef gh ij kl mn op qr st uv expands to
-	// 00 01 02 03 08 09 0a 0b 0g 0h 0i 0j 0o 0p 0q 0r as the first row on the left hand block.
-
-	__m128i perm = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 0x0c, 0x0d, 2, 3, 6, 7, 0x0a, 0x0b, 0x0e, 0x0f);
-	a = _mm_shuffle_epi8(a, perm);
-	b = _mm_shuffle_epi8(b, perm);
-	c = _mm_shuffle_epi8(c, perm);
-	d = _mm_shuffle_epi8(d, perm);
-
-	__m128i a_orig = a;
-
-	const __m128i mask = _mm_set1_epi32(0x0f0f0f0f);
-	const __m128i shiftCount = _mm_set_epi32(0, 0, 0, 4);
-	__m128i lowNybbles = _mm_and_si128(a, mask);
-	__m128i highNybbles = _mm_and_si128(_mm_srl_epi32(a, shiftCount), mask);
-	a = _mm_unpacklo_epi8(lowNybbles, highNybbles);
-	__m128i a2 = _mm_unpackhi_epi8(lowNybbles, highNybbles);
-
-	lowNybbles = _mm_and_si128(b, mask);
-	highNybbles = _mm_and_si128(_mm_srl_epi32(b, shiftCount), mask);
-	b = _mm_unpacklo_epi8(lowNybbles, highNybbles);
-	__m128i b2 = _mm_unpackhi_epi8(lowNybbles, highNybbles);
-
-	lowNybbles = _mm_and_si128(c, mask);
-	highNybbles = _mm_and_si128(_mm_srl_epi32(c, shiftCount), mask);
-	c = _mm_unpacklo_epi8(lowNybbles, highNybbles);
-	__m128i c2 = _mm_unpackhi_epi8(lowNybbles, highNybbles);
-
-	lowNybbles = _mm_and_si128(d, mask);
-	highNybbles = _mm_and_si128(_mm_srl_epi32(d, shiftCount), mask);
-	d = _mm_unpacklo_epi8(lowNybbles, highNybbles);
-	__m128i d2 = _mm_unpackhi_epi8(lowNybbles, highNybbles);
-
-	convertColumn8(dest, destStride, colNum, a, b, c, d);
-	if(destStride > 16)
-	{
-		convertColumn8(dest + 16, destStride, colNum, a2, b2, c2, d2);
-	}
-}
-
-#elif defined(FRAMEWORK_SIMD_USE_NEON)
-#include <arm_neon.h>
-
-inline void convertColumn8(uint8x16x4_t data, uint8* dest, const int destStride, int colNum)
-{
-	uint16x8_t row0 = vcombine_u16(vmovn_u32(vreinterpretq_u32_u8(data.val[0])), vmovn_u32(vreinterpretq_u32_u8(data.val[2])));
-	uint16x8_t revr0 = vrev32q_u16(vreinterpretq_u16_u8(data.val[0]));
-	uint16x8_t revr2 = vrev32q_u16(vreinterpretq_u16_u8(data.val[2]));
-	uint16x8_t row1 = vcombine_u16(vmovn_u32(vreinterpretq_u32_u16(revr0)), vmovn_u32(vreinterpretq_u32_u16(revr2)));
-
-	uint16x8_t row2 = vcombine_u16(vmovn_u32(vreinterpretq_u32_u8(data.val[1])), vmovn_u32(vreinterpretq_u32_u8(data.val[3])));
-	uint16x8_t revr1 = vrev32q_u16(vreinterpretq_u16_u8(data.val[1]));
-	uint16x8_t revr3 = vrev32q_u16(vreinterpretq_u16_u8(data.val[3]));
-	uint16x8_t row3 = vcombine_u16(vmovn_u32(vreinterpretq_u32_u16(revr1)), vmovn_u32(vreinterpretq_u32_u16(revr3)));
-
-	if((colNum & 1) == 0)
-	{
-		row2 = vreinterpretq_u16_u32(vrev64q_u32(vreinterpretq_u32_u16(row2)));
-		row3 = vreinterpretq_u16_u32(vrev64q_u32(vreinterpretq_u32_u16(row3)));
-	}
-	else
-	{
-		row0 = vreinterpretq_u16_u32(vrev64q_u32(vreinterpretq_u32_u16(row0)));
-		row1 = vreinterpretq_u16_u32(vrev64q_u32(vreinterpretq_u32_u16(row1)));
-	}
-
-	vst1q_u8(dest, vreinterpretq_u8_u16(row0));
-	vst1q_u8(dest + destStride, vreinterpretq_u8_u16(row1));
-	vst1q_u8(dest + 2 * destStride, vreinterpretq_u8_u16(row2));
-	vst1q_u8(dest + 3 * destStride, vreinterpretq_u8_u16(row3));
-}
-
-inline void convertColumn8(uint8* dest, const int destStride, uint8* src, int colNum)
-{
-	// This sucks in the entire column and de-interleaves it
-	uint8x16x4_t data = vld4q_u8(src);
-	convertColumn8(data, dest, destStride, colNum);
-}
-
-inline void convertColumn4(uint8* dest, const int destStride, uint8* src, int colNum)
-{
-	// https://developer.arm.com/architectures/instruction-sets/simd-isas/neon/intrinsics
-
-	uint8x16x4_t data = vld4q_u8(src);
-
-	const auto mask = vdupq_n_u8(0x0F);
-
-	auto high_nybbles = vshrq_n_u8(data.val[0], 4);
-	auto lo_nybbles = vandq_u8(data.val[0], mask);
-
-	uint8x16x4_t col8Data;
-	col8Data.val[0] = lo_nybbles;
-	col8Data.val[1] = high_nybbles;
-
-	high_nybbles = vshrq_n_u8(data.val[1], 4);
-	lo_nybbles = vandq_u8(data.val[1], mask);
-	col8Data.val[2] = lo_nybbles;
-	col8Data.val[3] = high_nybbles;
-	convertColumn8(col8Data, dest, destStride, colNum);
-
-	if(destStride > 16)
-	{
-
-		high_nybbles = vshrq_n_u8(data.val[2], 4);
-		lo_nybbles = vandq_u8(data.val[2], mask);
-		col8Data.val[0] = lo_nybbles;
-		col8Data.val[1] = high_nybbles;
-		high_nybbles = vshrq_n_u8(data.val[3], 4);
-		lo_nybbles = vandq_u8(data.val[3], mask);
-		col8Data.val[2] = lo_nybbles;
-		col8Data.val[3] = high_nybbles;
-		convertColumn8(col8Data, dest + 16, destStride, colNum);
-	}
-}
-
-#else
-/*
-// If we have a platform that does not have SIMD then implement the basic case here.
-void convertColumn8(uint8* dest, const int destStride, uint8* src, int colNum)
-{
-
-}
-*/
-#endif
-
-void CGSH_OpenGL::TexUpdater_Psm8(uint32 bufPtr, uint32 bufWidth, unsigned int texX, unsigned int texY, unsigned int texWidth, unsigned int texHeight)
-{
-	if(texWidth < 16)
-	{
-		// Widths are powers of 2, so anything over 16 will be an integral number of columns wide.
-		// Note: for small textures it still may be a win to do the SIMD swizzle and then cut out the sub-region to
-		// correct the row stride.
-		return CGSH_OpenGL::TexUpdater_Psm48<CGsPixelFormats::CPixelIndexorPSMT8>(bufPtr, bufWidth, texX, texY, texWidth, texHeight);
-	}
-
-	CGsPixelFormats::CPixelIndexorPSMT8 indexor(m_pRAM, bufPtr, bufWidth);
-	uint8* dst = m_pCvtBuffer;
-	for(unsigned int y = 0; y < texHeight; y += 16)
-	{
-		for(unsigned int x = 0; x < texWidth; x += 16)
-		{
-			uint8* colDst = dst;
-			uint8* src = indexor.GetPixelAddress(texX + x, texY + y);
-
-			// process an entire 16x16 block.
-			// A column (64 bytes) is 16x4 pixels and they stack vertically in a block
-
-			int colNum = 0;
-			for(unsigned int coly = 0; coly < 16; coly += 4)
-			{
-				convertColumn8(colDst + x, texWidth, src, colNum++);
-				src += 64;
-				colDst += texWidth * 4;
-			}
-		}
-
-		dst += texWidth * 16;
-	}
-
-	glTexSubImage2D(GL_TEXTURE_2D, 0, texX, texY, texWidth, texHeight, GL_RED, GL_UNSIGNED_BYTE, m_pCvtBuffer);
-	CHECKGLERROR();
-}
-
-void CGSH_OpenGL::TexUpdater_Psm4(unsigned int bufPtr, unsigned int bufWidth, unsigned int texX, unsigned int texY, unsigned int texWidth, unsigned int texHeight)
-{
-	if(texWidth < 16)
-	{
-		// Widths are powers of 2, so anything over 32 will be an integral number of columns wide.
-		// 16 wide textures are dealt with as a special case in the SIMD code.
-		// Note: for small textures it still may be a win to do the SIMD swizzle and then cut out the sub-region to
-		// correct the row stride.
-		return CGSH_OpenGL::TexUpdater_Psm48<CGsPixelFormats::CPixelIndexorPSMT4>(bufPtr, bufWidth, texX, texY, texWidth, texHeight);
-	}
-
-	CGsPixelFormats::CPixelIndexorPSMT4 indexor(m_pRAM, bufPtr, bufWidth);
-
-	uint8* dst = m_pCvtBuffer;
-	for(unsigned int y = 0; y < texHeight; y += 16)
-	{
-		for(unsigned int x = 0; x < texWidth; x += 32)
-		{
-			uint8* colDst = dst + x;
-			unsigned int nx = texX + x;
-			unsigned int ny = texY + y;
-			uint32 colAddr = indexor.GetColumnAddress(nx, ny);
-			uint8* src = m_pRAM + colAddr;
-
-			// process an entire 32x16 block.
-			// A column (64 bytes) is 32x4 pixels and they stack vertically in a block
-
-			for(unsigned int colNum = 0; colNum < 4; ++colNum)
-			{
-				convertColumn4(colDst, texWidth, src, colNum);
-				src += 64;
-				colDst += texWidth * 4;
-			}
-		}
-
-		dst += texWidth * 16;
-	}
-	glTexSubImage2D(GL_TEXTURE_2D, 0, texX, texY, texWidth, texHeight, GL_RED, GL_UNSIGNED_BYTE, m_pCvtBuffer);
-	CHECKGLERROR();
-}
-
 template <typename IndexorType>
 void CGSH_OpenGL::TexUpdater_Psm48(uint32 bufPtr, uint32 bufWidth, unsigned int texX, unsigned int texY, unsigned int texWidth, unsigned int texHeight)
 {
-	IndexorType indexor(m_pRAM, bufPtr, bufWidth);
-
-	uint8* dst = m_pCvtBuffer;
-	for(unsigned int y = 0; y < texHeight; y++)
-	{
-		for(unsigned int x = 0; x < texWidth; x++)
-		{
-			uint8 pixel = indexor.GetPixel(texX + x, texY + y);
-			dst[x] = pixel;
-		}
-
-		dst += texWidth;
-	}
+	GsTextureConvert::ConvertPsm48<IndexorType>(m_pCvtBuffer, texWidth, m_pRAM, bufPtr, bufWidth, texX, texY, texWidth, texHeight);
 
 	glTexSubImage2D(GL_TEXTURE_2D, 0, texX, texY, texWidth, texHeight, GL_RED, GL_UNSIGNED_BYTE, m_pCvtBuffer);
 	CHECKGLERROR();
@@ -659,20 +365,7 @@ void CGSH_OpenGL::TexUpdater_Psm48(uint32 bufPtr, uint32 bufWidth, unsigned int
 template <uint32 shiftAmount, uint32 mask>
 void CGSH_OpenGL::TexUpdater_Psm48H(uint32 bufPtr, uint32 bufWidth, unsigned int texX, unsigned int texY, unsigned int texWidth, unsigned int texHeight)
 {
-	CGsPixelFormats::CPixelIndexorPSMCT32 indexor(m_pRAM, bufPtr, bufWidth);
-
-	uint8* dst = m_pCvtBuffer;
-	for(unsigned int y = 0; y < texHeight; y++)
-	{
-		for(unsigned int x = 0; x < texWidth; x++)
-		{
-			uint32 pixel = indexor.GetPixel(texX + x, texY + y);
-			pixel = (pixel >> shiftAmount) & mask;
-			dst[x] = static_cast<uint8>(pixel);
-		}
-
-		dst += texWidth;
-	}
+	GsTextureConvert::ConvertPsm48H<shiftAmount, mask>(m_pCvtBuffer, texWidth, m_pRAM, bufPtr, bufWidth, texX, texY, texWidth, texHeight);
 
 	glTexSubImage2D(GL_TEXTURE_2D, 0, texX, texY, texWidth, texHeight, GL_RED, GL_UNSIGNED_BYTE, m_pCvtBuffer);
 	CHECKGLERROR();
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <string.h>
+#include <chrono>
 #include <functional>
 #include "../AppConfig.h"
 #include "../Log.h"
@@ -9,6 +10,8 @@
 #include "../ee/INTC.h"
 #include "GSHandler.h"
 #include "GsPixelFormats.h"
+#include "GsSwizzle.h"
+#include "SimdDefs.h"
 #include "string_format.h"
 #include "ThreadUtils.h"
 
@@ -129,6 +132,7 @@ void CGSHandler::RegisterPreferences()
 	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_CGSHANDLER_PRESENTATION_MODE, CGSHandler::PRESENTATION_MODE_FIT);
 	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_CGSHANDLER_GS_RAM_READS_ENABLED, true);
 	CAppConfig::GetInstance().RegisterPreferenceBoolean(PREF_CGSHANDLER_WIDESCREEN, false);
+	CAppConfig::GetInstance().RegisterPreferenceInteger(PREF_CGSHANDLER_TEXTURECACHE_SIZE, PREF_CGSHANDLER_TEXTURECACHE_SIZE_DEFAULT);
 }
 
 void CGSHandler::NotifyPreferencesChanged()
@@ -179,6 +183,7 @@ void CGSHandler::ResetBase()
 	m_writeBufferSubmitIndex = 0;
 	m_writeBufferIndex = 0;
 	m_currentWriteBuffer = m_writeBuffers[m_writeBufferIndex];
+	ResetReadbacks();
 }
 
 void CGSHandler::ResetImpl()
@@ -306,6 +311,7 @@ void CGSHandler::LoadState(Framework::CZipArchiveReader& archive)
 		m_nCBP1 = registerFile.GetRegister32(STATE_REG_CBP1);
 	}
 
+	ResetReadbacks();
 	SendGSCall([&]() { WriteBackMemoryCache(); });
 }
 
@@ -391,6 +397,14 @@ void CGSHandler::SetDrawEnabled(bool drawEnabled)
 	m_drawEnabled = drawEnabled;
 }
 
+void CGSHandler::SetPresentationSkip(uint32 skipCount, uint32 period)
+{
+	assert((period == 0) || (skipCount < period));
+	m_presentationSkipCount = skipCount;
+	m_presentationPeriod = period;
+	m_presentationIndex = 0;
+}
+
 void CGSHandler::SetHBlank()
 {
 	std::lock_guard registerMutexLock(m_registerMutex);
@@ -565,6 +579,13 @@ void CGSHandler::Flip(uint32 flags)
 {
 	bool waitForCompletion = (flags & FLIP_FLAG_WAIT) != 0;
 	bool force = (flags & FLIP_FLAG_FORCE) != 0;
+	if(m_presentationPeriod != 0)
+	{
+		bool skip = (m_presentationIndex < m_presentationSkipCount);
+		m_presentationIndex = (m_presentationIndex + 1) % m_presentationPeriod;
+		//Registers stay dirty, the next frame that's presented will pick up the changes
+		if(skip && !force && !waitForCompletion) return;
+	}
 	SendGSCall(
 	    [this, displayInfo = GetCurrentDisplayInfo(), force]() {
 		    if(force || m_regsDirty)
@@ -586,6 +607,9 @@ void CGSHandler::MarkNewFrame()
 {
 	OnNewFrame(m_drawCallCount);
 	m_drawCallCount = 0;
+	m_textureDecodeLookupCount += m_frameTextureCacheStats.decodeLookupCount;
+	m_textureDecodeHitCount += m_frameTextureCacheStats.decodeHitCount;
+	m_frameTextureCacheStats = TEXTURE_CACHE_STATS();
 	UpdateFrameDumpState();
 #ifdef _DEBUG
 	CLog::GetInstance().Print(LOG_NAME, "Frame Done.\r\n---------------------------------------------------------------------------------\r\n");
@@ -649,8 +673,100 @@ void CGSHandler::FeedImageData(const void* data, uint32 length)
 void CGSHandler::ReadImageData(void* data, uint32 length)
 {
 	assert(m_writeBufferProcessIndex == m_writeBufferSize);
-	SubmitWriteBuffer();
-	SendGSCall([this, data, length]() { ReadImageDataImpl(data, length); }, true);
+	if(m_readbackRequestCount == 0)
+	{
+		//No snapshot was requested (ie.: GS isn't threaded), read from GS RAM directly
+		SubmitWriteBuffer();
+		SendGSCall([this, data, length]() { ReadImageDataImpl(data, length); }, true);
+		return;
+	}
+
+	if(m_currentReadback.sequence != m_readbackRequestCount)
+	{
+		WaitForReadback();
+	}
+
+	auto& readbackData = m_currentReadback.data;
+	uint32 readSize = std::min<uint32>(length, readbackData.size() - m_currentReadbackOffset);
+	memcpy(data, readbackData.data() + m_currentReadbackOffset, readSize);
+	memset(reinterpret_cast<uint8*>(data) + readSize, 0, length - readSize);
+	m_currentReadbackOffset += readSize;
+}
+
+void CGSHandler::WaitForReadback()
+{
+	std::unique_lock<std::mutex> readbackLock(m_readbackMutex);
+	if(m_readbackCompleteCount != m_readbackRequestCount)
+	{
+		m_readbackStats.stallCount++;
+		auto waitStart = std::chrono::steady_clock::now();
+		m_readbackCondition.wait(readbackLock, [this]() { return m_readbackCompleteCount == m_readbackRequestCount; });
+		auto waitTime = std::chrono::steady_clock::now() - waitStart;
+		m_readbackStats.stallTime += std::chrono::duration_cast<std::chrono::nanoseconds>(waitTime).count();
+	}
+
+	//Older snapshots were never read, drop them
+	while(m_readbacks.front().sequence != m_readbackRequestCount)
+	{
+		m_readbacks.pop_front();
+	}
+	m_currentReadback = std::move(m_readbacks.front());
+	m_readbacks.pop_front();
+	m_currentReadbackOffset = 0;
+	m_readbackStats.readbackCount++;
+}
+
+void CGSHandler::ResetReadbacks()
+{
+	std::unique_lock<std::mutex> readbackLock(m_readbackMutex);
+	//Snapshots still in flight would complete with sequence numbers from before the reset
+	m_readbackCondition.wait(readbackLock, [this]() { return m_readbackCompleteCount == m_readbackRequestCount; });
+	m_readbacks.clear();
+	m_readbackCompleteCount = 0;
+	m_readbackRequestCount = 0;
+	m_currentReadback = READBACK();
+	m_currentReadbackOffset = 0;
+}
+
+void CGSHandler::TakeReadbackSnapshotImpl(uint32 sequence)
+{
+	READBACK readback;
+	readback.sequence = sequence;
+	readback.data.resize(m_trxCtx.nSize);
+	if(m_trxCtx.nSize != 0)
+	{
+		ReadImageDataImpl(readback.data.data(), m_trxCtx.nSize);
+	}
+
+	{
+		std::lock_guard<std::mutex> readbackLock(m_readbackMutex);
+		m_readbacks.push_back(std::move(readback));
+		while(m_readbacks.size() > MAX_PENDING_READBACKS)
+		{
+			m_readbacks.pop_front();
+		}
+		m_readbackCompleteCount = sequence;
+	}
+	m_readbackCondition.notify_all();
+}
+
+CGSHandler::READBACK_STATS CGSHandler::GetReadbackStats() const
+{
+	return m_readbackStats;
+}
+
+void CGSHandler::ResetReadbackStats()
+{
+	m_readbackStats = READBACK_STATS();
+}
+
+CGSHandler::TEXTURE_CACHE_STATS CGSHandler::TakeTextureCacheStats()
+{
+	//Lookups are added before hits and taken after them, a frame's hits are never taken without its lookups
+	TEXTURE_CACHE_STATS stats;
+	stats.decodeHitCount = m_textureDecodeHitCount.exchange(0);
+	stats.decodeLookupCount = m_textureDecodeLookupCount.exchange(0);
+	return stats;
 }
 
 void CGSHandler::ProcessWriteBuffer(const CGsPacketMetadata* metadata)
@@ -702,6 +818,15 @@ void CGSHandler::ProcessWriteBuffer(const CGsPacketMetadata* metadata)
 			m_nSIGLBLID = siglblid;
 		}
 		break;
+		case GS_REG_TRXDIR:
+			if(m_gsThreaded && ((write.second & 0x03) == 1))
+			{
+				//Local to host transfer, get the GS thread to start it and snapshot its data right away
+				SubmitWriteBuffer(writeIndex + 1);
+				m_readbackRequestCount++;
+				m_mailBox.SendFastCall([this, sequence = m_readbackRequestCount]() { TakeReadbackSnapshotImpl(sequence); });
+			}
+			break;
 		}
 	}
 	m_writeBufferProcessIndex = m_writeBufferSize;
@@ -714,22 +839,29 @@ void CGSHandler::ProcessWriteBuffer(const CGsPacketMetadata* metadata)
 
 void CGSHandler::SubmitWriteBuffer()
 {
-	assert(m_writeBufferSubmitIndex <= m_writeBufferSize);
-	if(m_writeBufferSubmitIndex == m_writeBufferSize) return;
+	SubmitWriteBuffer(m_writeBufferSize);
+}
+
+void CGSHandler::SubmitWriteBuffer(uint32 submitEndIndex)
+{
+	assert(m_writeBufferSubmitIndex <= submitEndIndex);
+	assert(submitEndIndex <= m_writeBufferSize);
+	if(m_writeBufferSubmitIndex == submitEndIndex) return;
 
 #ifdef _DEBUG
 	m_transferCount++;
 #endif
 
 	auto bufferStart = m_currentWriteBuffer + m_writeBufferSubmitIndex;
-	auto bufferEnd = m_currentWriteBuffer + m_writeBufferSize;
+	auto bufferEnd = m_currentWriteBuffer + submitEndIndex;
 
-	SendGSCall(
+	//Always called from the thread writing to the GS, doesn't need to allocate or lock
+	m_mailBox.SendFastCall(
 	    [this, bufferStart, bufferEnd]() {
 		    SubmitWriteBufferImpl(bufferStart, bufferEnd);
 	    });
 
-	m_writeBufferSubmitIndex = m_writeBufferSize;
+	m_writeBufferSubmitIndex = submitEndIndex;
 }
 
 void CGSHandler::FlushWriteBuffer()
@@ -968,6 +1100,147 @@ bool CGSHandler::TransferWriteHandlerInvalid(const void* pData, uint32 nLength)
 	return false;
 }
 
+template <typename Storage>
+bool WriteTransferColumn(uint8*, const uint8*, uint32, uint32);
+
+template <>
+bool WriteTransferColumn<CGsPixelFormats::STORAGEPSMCT32>(uint8* column, const uint8* src, uint32 srcPitch, uint32)
+{
+	return GsSwizzle::WriteColumnPSMCT32(column, src, srcPitch);
+}
+
+template <>
+bool WriteTransferColumn<CGsPixelFormats::STORAGEPSMCT16>(uint8* column, const uint8* src, uint32 srcPitch, uint32)
+{
+	return GsSwizzle::WriteColumnPSMCT16(column, src, srcPitch);
+}
+
+template <>
+bool WriteTransferColumn<CGsPixelFormats::STORAGEPSMCT16S>(uint8* column, const uint8* src, uint32 srcPitch, uint32)
+{
+	return GsSwizzle::WriteColumnPSMCT16(column, src, srcPitch);
+}
+
+template <>
+bool WriteTransferColumn<CGsPixelFormats::STORAGEPSMT8>(uint8* column, const uint8* src, uint32 srcPitch, uint32 columnParity)
+{
+	return GsSwizzle::WriteColumnPSMT8(column, src, srcPitch, columnParity);
+}
+
+template <>
+bool WriteTransferColumn<CGsPixelFormats::STORAGEPSMT4>(uint8* column, const uint8* src, uint32 srcPitch, uint32 columnParity)
+{
+	return GsSwizzle::WriteColumnPSMT4(column, src, srcPitch, columnParity);
+}
+
+template <typename Storage>
+void ReadTransferColumn(uint8*, uint32, const uint8*, uint32);
+
+template <>
+void ReadTransferColumn<CGsPixelFormats::STORAGEPSMCT32>(uint8* dst, uint32 dstPitch, const uint8* column, uint32)
+{
+	GsSwizzle::ReadColumnPSMCT32(dst, dstPitch, column);
+}
+
+template <>
+void ReadTransferColumn<CGsPixelFormats::STORAGEPSMZ32>(uint8* dst, uint32 dstPitch, const uint8* column, uint32)
+{
+	GsSwizzle::ReadColumnPSMCT32(dst, dstPitch, column);
+}
+
+template <>
+void ReadTransferColumn<CGsPixelFormats::STORAGEPSMCT16>(uint8* dst, uint32 dstPitch, const uint8* column, uint32)
+{
+	GsSwizzle::ReadColumnPSMCT16(dst, dstPitch, column);
+}
+
+template <>
+void ReadTransferColumn<CGsPixelFormats::STORAGEPSMCT16S>(uint8* dst, uint32 dstPitch, const uint8* column, uint32)
+{
+	GsSwizzle::ReadColumnPSMCT16(dst, dstPitch, column);
+}
+
+template <>
+void ReadTransferColumn<CGsPixelFormats::STORAGEPSMZ16S>(uint8* dst, uint32 dstPitch, const uint8* column, uint32)
+{
+	GsSwizzle::ReadColumnPSMCT16(dst, dstPitch, column);
+}
+
+template <>
+void ReadTransferColumn<CGsPixelFormats::STORAGEPSMT8>(uint8* dst, uint32 dstPitch, const uint8* column, uint32 columnParity)
+{
+	GsSwizzle::ReadColumnPSMT8(dst, dstPitch, column, columnParity);
+}
+
+//Column transfers are only used when the rectangle starts on a column boundary
+//and doesn't wrap around horizontally
+template <typename Storage>
+static bool CanTransferColumns(uint32 x, uint32 width)
+{
+	return ((x % Storage::COLUMNWIDTH) == 0) &&
+	       (width >= Storage::COLUMNWIDTH) &&
+	       ((x + width) <= 2048);
+}
+
+//Column writes only beat the indexor when swizzling is done with vector instructions
+template <typename Storage>
+static bool CanWriteColumns(uint32 x, uint32 width)
+{
+#if defined(FRAMEWORK_SIMD_USE_SSE) || defined(FRAMEWORK_SIMD_USE_NEON)
+	return CanTransferColumns<Storage>(x, width);
+#else
+	return false;
+#endif
+}
+
+//Swizzles COLUMNHEIGHT rows of 'width' pixels starting on a column boundary, 'width' needs to be
+//a multiple of COLUMNWIDTH. Each column covers 64 bytes of source data spread over its rows.
+template <typename Storage>
+static bool TransferWriteColumns(uint8* ram, CGsPixelFormats::CPixelIndexor<Storage>& indexor, const uint8* src, uint32 srcPitch, uint32 dstX, uint32 dstY, uint32 width)
+{
+	static const uint32 columnSrcSize = CGsPixelFormats::COLUMNSIZE / Storage::COLUMNHEIGHT;
+	uint32 columnParity = (dstY / Storage::COLUMNHEIGHT) & 1;
+	bool dirty = false;
+	for(uint32 x = 0; x < width; x += Storage::COLUMNWIDTH)
+	{
+		unsigned int columnX = dstX + x;
+		unsigned int columnY = dstY;
+		uint8* column = ram + indexor.GetColumnAddress(columnX, columnY);
+		dirty |= WriteTransferColumn<Storage>(column, src, srcPitch, columnParity);
+		src += columnSrcSize;
+	}
+	return dirty;
+}
+
+//Unswizzles COLUMNHEIGHT rows of 'width' pixels starting on a column boundary, 'width' needs to be
+//a multiple of COLUMNWIDTH. Columns are handed to 'columnHandler' along with their position in the row.
+template <typename Storage, typename ColumnHandler>
+static void TransferReadColumns(uint8* ram, CGsPixelFormats::CPixelIndexor<Storage>& indexor, uint32 srcX, uint32 srcY, uint32 width, const ColumnHandler& columnHandler)
+{
+	uint32 columnParity = (srcY / Storage::COLUMNHEIGHT) & 1;
+	for(uint32 x = 0; x < width; x += Storage::COLUMNWIDTH)
+	{
+		unsigned int columnX = srcX + x;
+		unsigned int columnY = srcY;
+		const uint8* column = ram + indexor.GetColumnAddress(columnX, columnY);
+		columnHandler(x, column, columnParity);
+	}
+}
+
+//Reads a rectangle made of whole columns as linear rows of pixels
+template <typename Storage>
+static void ReadColumns(uint8* ram, CGsPixelFormats::CPixelIndexor<Storage>& indexor, typename Storage::Unit* dst, uint32 x, uint32 y, uint32 width, uint32 height)
+{
+	for(uint32 rowY = 0; rowY < height; rowY += Storage::COLUMNHEIGHT)
+	{
+		auto rowsDst = dst + (rowY * width);
+		TransferReadColumns(ram, indexor, x, y + rowY, width,
+		                    [&](uint32 columnX, const uint8* column, uint32 columnParity) {
+			                    ReadTransferColumn<Storage>(reinterpret_cast<uint8*>(rowsDst + columnX), width * sizeof(typename Storage::Unit), column, columnParity);
+		                    });
+	}
+}
+
 template <typename Storage>
 bool CGSHandler::TransferWriteHandlerGeneric(const void* pData, uint32 nLength)
 {
@@ -982,19 +1255,46 @@ bool CGSHandler::TransferWriteHandlerGeneric(const void* pData, uint32 nLength)
 
 	auto pSrc = reinterpret_cast<const typename Storage::Unit*>(pData);
 
-	for(unsigned int i = 0; i < nLength; i++)
-	{
-		uint32 nX = (m_trxCtx.nRRX + trxPos.nDSAX) % 2048;
-		uint32 nY = (m_trxCtx.nRRY + trxPos.nDSAY) % 2048;
+	auto writePixel =
+	    [&](uint32 nX, uint32 nY, typename Storage::Unit nPixel) {
+		    auto pPixel = Indexor.GetPixelAddress(nX % 2048, nY % 2048);
+		    if((*pPixel) != nPixel)
+		    {
+			    (*pPixel) = nPixel;
+			    nDirty = true;
+		    }
+	    };
 
-		auto pPixel = Indexor.GetPixelAddress(nX, nY);
+	bool canWriteColumns = CanWriteColumns<Storage>(trxPos.nDSAX, trxReg.nRRW);
+	uint32 columnRowsLength = trxReg.nRRW * Storage::COLUMNHEIGHT;
+	uint32 columnsWidth = trxReg.nRRW & ~(Storage::COLUMNWIDTH - 1);
 
-		if((*pPixel) != pSrc[i])
+	unsigned int i = 0;
+	while(i < nLength)
+	{
+		uint32 nY = m_trxCtx.nRRY + trxPos.nDSAY;
+
+		//Swizzle whole columns when all of their rows are available, pixels past the last column go through the indexor
+		if(canWriteColumns && (m_trxCtx.nRRX == 0) && ((nY % Storage::COLUMNHEIGHT) == 0) &&
+		   ((nY + Storage::COLUMNHEIGHT) <= 2048) && ((nLength - i) >= columnRowsLength))
 		{
-			(*pPixel) = pSrc[i];
-			nDirty = true;
+			nDirty |= TransferWriteColumns(m_pRAM, Indexor, reinterpret_cast<const uint8*>(pSrc + i),
+			                               trxReg.nRRW * sizeof(typename Storage::Unit), trxPos.nDSAX, nY, columnsWidth);
+			for(uint32 y = 0; y < Storage::COLUMNHEIGHT; y++)
+			{
+				for(uint32 x = columnsWidth; x < trxReg.nRRW; x++)
+				{
+					writePixel(trxPos.nDSAX + x, nY + y, pSrc[i + (y * trxReg.nRRW) + x]);
+				}
+			}
+			i += columnRowsLength;
+			m_trxCtx.nRRY += Storage::COLUMNHEIGHT;
+			continue;
 		}
 
+		writePixel(m_trxCtx.nRRX + trxPos.nDSAX, nY, pSrc[i]);
+		i++;
+
 		m_trxCtx.nRRX++;
 		if(m_trxCtx.nRRX == trxReg.nRRW)
 		{
@@ -1039,6 +1339,8 @@ bool CGSHandler::TransferWriteHandlerPSMCT24(const void* pData, uint32 nLength)
 
 bool CGSHandler::TransferWriteHandlerPSMT4(const void* pData, uint32 nLength)
 {
+	typedef CGsPixelFormats::STORAGEPSMT4 Storage;
+
 	bool dirty = false;
 	auto trxPos = make_convertible<TRXPOS>(m_nReg[GS_REG_TRXPOS]);
 	auto trxReg = make_convertible<TRXREG>(m_nReg[GS_REG_TRXREG]);
@@ -1048,8 +1350,39 @@ bool CGSHandler::TransferWriteHandlerPSMT4(const void* pData, uint32 nLength)
 
 	auto pSrc = reinterpret_cast<const uint8*>(pData);
 
-	for(unsigned int i = 0; i < nLength; i++)
+	//Column writes need rows to start on a byte boundary
+	bool canWriteColumns = ((trxReg.nRRW % 2) == 0) && CanWriteColumns<Storage>(trxPos.nDSAX, trxReg.nRRW);
+	uint32 rowLength = trxReg.nRRW / 2;
+	uint32 columnRowsLength = rowLength * Storage::COLUMNHEIGHT;
+	uint32 columnsWidth = trxReg.nRRW & ~(Storage::COLUMNWIDTH - 1);
+
+	unsigned int i = 0;
+	while(i < nLength)
 	{
+		uint32 nRowY = m_trxCtx.nRRY + trxPos.nDSAY;
+		if(canWriteColumns && (m_trxCtx.nRRX == 0) && ((nRowY % Storage::COLUMNHEIGHT) == 0) &&
+		   ((nRowY + Storage::COLUMNHEIGHT) <= 2048) && ((nLength - i) >= columnRowsLength))
+		{
+			dirty |= TransferWriteColumns(m_pRAM, Indexor, pSrc + i, rowLength, trxPos.nDSAX, nRowY, columnsWidth);
+			for(uint32 y = 0; y < Storage::COLUMNHEIGHT; y++)
+			{
+				for(uint32 x = columnsWidth; x < trxReg.nRRW; x++)
+				{
+					uint32 nX = (trxPos.nDSAX + x) % 2048;
+					uint32 nY = (nRowY + y) % 2048;
+					uint8 pixel = (pSrc[i + (y * rowLength) + (x / 2)] >> ((x & 1) * 4)) & 0x0F;
+					if(Indexor.GetPixel(nX, nY) != pixel)
+					{
+						Indexor.SetPixel(nX, nY, pixel);
+						dirty = true;
+					}
+				}
+			}
+			i += columnRowsLength;
+			m_trxCtx.nRRY += Storage::COLUMNHEIGHT;
+			continue;
+		}
+
 		uint8 nPixel[2];
 
 		nPixel[0] = (pSrc[i] >> 0) & 0x0F;
@@ -1074,6 +1407,8 @@ bool CGSHandler::TransferWriteHandlerPSMT4(const void* pData, uint32 nLength)
 				m_trxCtx.nRRY++;
 			}
 		}
+
+		i++;
 	}
 
 	return dirty;
@@ -1178,12 +1513,39 @@ void CGSHandler::TransferReadHandlerGeneric(void* buffer, uint32 length)
 	auto typedBuffer = reinterpret_cast<typename Storage::Unit*>(buffer);
 
 	CGsPixelFormats::CPixelIndexor<Storage> indexor(GetRam(), trxBuf.GetSrcPtr(), trxBuf.nSrcWidth);
-	for(uint32 i = 0; i < typedLength; i++)
+
+	bool canReadColumns = CanTransferColumns<Storage>(trxPos.nSSAX, trxReg.nRRW);
+	uint32 columnRowsLength = trxReg.nRRW * Storage::COLUMNHEIGHT;
+	uint32 columnsWidth = trxReg.nRRW & ~(Storage::COLUMNWIDTH - 1);
+	uint32 rowPitch = trxReg.nRRW * sizeof(typename Storage::Unit);
+
+	uint32 i = 0;
+	while(i < typedLength)
 	{
-		uint32 x = (m_trxCtx.nRRX + trxPos.nSSAX) % 2048;
-		uint32 y = (m_trxCtx.nRRY + trxPos.nSSAY) % 2048;
-		auto pixel = indexor.GetPixel(x, y);
+		uint32 y = m_trxCtx.nRRY + trxPos.nSSAY;
+		if(canReadColumns && (m_trxCtx.nRRX == 0) && ((y % Storage::COLUMNHEIGHT) == 0) &&
+		   ((y + Storage::COLUMNHEIGHT) <= 2048) && ((typedLength - i) >= columnRowsLength))
+		{
+			auto rowsBuffer = typedBuffer + i;
+			TransferReadColumns(GetRam(), indexor, trxPos.nSSAX, y, columnsWidth,
+			                    [&](uint32 x, const uint8* column, uint32 columnParity) {
+				                    ReadTransferColumn<Storage>(reinterpret_cast<uint8*>(rowsBuffer + x), rowPitch, column, columnParity);
+			                    });
+			for(uint32 rowY = 0; rowY < Storage::COLUMNHEIGHT; rowY++)
+			{
+				for(uint32 x = columnsWidth; x < trxReg.nRRW; x++)
+				{
+					rowsBuffer[(rowY * trxReg.nRRW) + x] = indexor.GetPixel((trxPos.nSSAX + x) % 2048, y + rowY);
+				}
+			}
+			i += columnRowsLength;
+			m_trxCtx.nRRY += Storage::COLUMNHEIGHT;
+			continue;
+		}
+
+		auto pixel = indexor.GetPixel((m_trxCtx.nRRX + trxPos.nSSAX) % 2048, y % 2048);
 		typedBuffer[i] = pixel;
+		i++;
 		m_trxCtx.nRRX++;
 		if(m_trxCtx.nRRX == trxReg.nRRW)
 		{
@@ -1203,14 +1565,53 @@ void CGSHandler::TransferReadHandler24(void* buffer, uint32 length)
 	auto dst = reinterpret_cast<uint8*>(buffer);
 
 	CGsPixelFormats::CPixelIndexor<Storage> indexor(GetRam(), trxBuf.GetSrcPtr(), trxBuf.nSrcWidth);
-	for(uint32 i = 0; i < length; i += 3)
-	{
-		uint32 x = (m_trxCtx.nRRX + trxPos.nSSAX) % 2048;
-		uint32 y = (m_trxCtx.nRRY + trxPos.nSSAY) % 2048;
-		auto pixel = indexor.GetPixel(x, y);
-		dst[i + 0] = (pixel >> 0) & 0xFF;
-		dst[i + 1] = (pixel >> 8) & 0xFF;
-		dst[i + 2] = (pixel >> 16) & 0xFF;
+
+	auto writePixel =
+	    [](uint8* pixelDst, uint32 pixel) {
+		    pixelDst[0] = (pixel >> 0) & 0xFF;
+		    pixelDst[1] = (pixel >> 8) & 0xFF;
+		    pixelDst[2] = (pixel >> 16) & 0xFF;
+	    };
+
+	bool canReadColumns = CanTransferColumns<Storage>(trxPos.nSSAX, trxReg.nRRW);
+	uint32 rowLength = trxReg.nRRW * 3;
+	uint32 columnsWidth = trxReg.nRRW & ~(Storage::COLUMNWIDTH - 1);
+
+	uint32 i = 0;
+	while(i < length)
+	{
+		uint32 y = m_trxCtx.nRRY + trxPos.nSSAY;
+		if(canReadColumns && (m_trxCtx.nRRX == 0) && ((y % Storage::COLUMNHEIGHT) == 0) &&
+		   ((y + Storage::COLUMNHEIGHT) <= 2048) && ((length - i) >= (rowLength * Storage::COLUMNHEIGHT)))
+		{
+			auto rowsDst = dst + i;
+			TransferReadColumns(GetRam(), indexor, trxPos.nSSAX, y, columnsWidth,
+			                    [&](uint32 x, const uint8* column, uint32 columnParity) {
+				                    uint32 pixels[Storage::COLUMNHEIGHT][Storage::COLUMNWIDTH];
+				                    ReadTransferColumn<Storage>(reinterpret_cast<uint8*>(pixels), sizeof(pixels[0]), column, columnParity);
+				                    for(uint32 rowY = 0; rowY < Storage::COLUMNHEIGHT; rowY++)
+				                    {
+					                    for(uint32 columnX = 0; columnX < Storage::COLUMNWIDTH; columnX++)
+					                    {
+						                    writePixel(rowsDst + (rowY * rowLength) + ((x + columnX) * 3), pixels[rowY][columnX]);
+					                    }
+				                    }
+			                    });
+			for(uint32 rowY = 0; rowY < Storage::COLUMNHEIGHT; rowY++)
+			{
+				for(uint32 x = columnsWidth; x < trxReg.nRRW; x++)
+				{
+					writePixel(rowsDst + (rowY * rowLength) + (x * 3), indexor.GetPixel((trxPos.nSSAX + x) % 2048, y + rowY));
+				}
+			}
+			i += rowLength * Storage::COLUMNHEIGHT;
+			m_trxCtx.nRRY += Storage::COLUMNHEIGHT;
+			continue;
+		}
+
+		auto pixel = indexor.GetPixel((m_trxCtx.nRRX + trxPos.nSSAX) % 2048, y % 2048);
+		writePixel(dst + i, pixel);
+		i += 3;
 		m_trxCtx.nRRX++;
 		if(m_trxCtx.nRRX == trxReg.nRRW)
 		{
@@ -1226,15 +1627,51 @@ void CGSHandler::TransferReadHandlerPSMT8H(void* buffer, uint32 length)
 	auto trxReg = make_convertible<TRXREG>(m_nReg[GS_REG_TRXREG]);
 	auto trxBuf = make_convertible<BITBLTBUF>(m_nReg[GS_REG_BITBLTBUF]);
 
+	typedef CGsPixelFormats::STORAGEPSMCT32 Storage;
+
 	auto dst = reinterpret_cast<uint8*>(buffer);
 
 	CGsPixelFormats::CPixelIndexorPSMCT32 indexor(GetRam(), trxBuf.GetSrcPtr(), trxBuf.nSrcWidth);
-	for(uint32 i = 0; i < length; i++)
+
+	bool canReadColumns = CanTransferColumns<Storage>(trxPos.nSSAX, trxReg.nRRW);
+	uint32 columnRowsLength = trxReg.nRRW * Storage::COLUMNHEIGHT;
+	uint32 columnsWidth = trxReg.nRRW & ~(Storage::COLUMNWIDTH - 1);
+
+	uint32 i = 0;
+	while(i < length)
 	{
-		uint32 x = (m_trxCtx.nRRX + trxPos.nSSAX) % 2048;
-		uint32 y = (m_trxCtx.nRRY + trxPos.nSSAY) % 2048;
-		auto pixel = indexor.GetPixel(x, y);
+		uint32 y = m_trxCtx.nRRY + trxPos.nSSAY;
+		if(canReadColumns && (m_trxCtx.nRRX == 0) && ((y % Storage::COLUMNHEIGHT) == 0) &&
+		   ((y + Storage::COLUMNHEIGHT) <= 2048) && ((length - i) >= columnRowsLength))
+		{
+			auto rowsDst = dst + i;
+			TransferReadColumns(GetRam(), indexor, trxPos.nSSAX, y, columnsWidth,
+			                    [&](uint32 x, const uint8* column, uint32) {
+				                    uint32 pixels[Storage::COLUMNHEIGHT][Storage::COLUMNWIDTH];
+				                    GsSwizzle::ReadColumnPSMCT32(reinterpret_cast<uint8*>(pixels), sizeof(pixels[0]), column);
+				                    for(uint32 rowY = 0; rowY < Storage::COLUMNHEIGHT; rowY++)
+				                    {
+					                    for(uint32 columnX = 0; columnX < Storage::COLUMNWIDTH; columnX++)
+					                    {
+						                    rowsDst[(rowY * trxReg.nRRW) + x + columnX] = static_cast<uint8>(pixels[rowY][columnX] >> 24);
+					                    }
+				                    }
+			                    });
+			for(uint32 rowY = 0; rowY < Storage::COLUMNHEIGHT; rowY++)
+			{
+				for(uint32 x = columnsWidth; x < trxReg.nRRW; x++)
+				{
+					rowsDst[(rowY * trxReg.nRRW) + x] = static_cast<uint8>(indexor.GetPixel((trxPos.nSSAX + x) % 2048, y + rowY) >> 24);
+				}
+			}
+			i += columnRowsLength;
+			m_trxCtx.nRRY += Storage::COLUMNHEIGHT;
+			continue;
+		}
+
+		auto pixel = indexor.GetPixel((m_trxCtx.nRRX + trxPos.nSSAX) % 2048, y % 2048);
 		dst[i] = static_cast<uint8>(pixel >> 24);
+		i++;
 		m_trxCtx.nRRX++;
 		if(m_trxCtx.nRRX == trxReg.nRRW)
 		{
@@ -1516,61 +1953,52 @@ bool CGSHandler::ProcessCLD(const TEX0& tex0)
 	}
 }
 
-template <typename Indexor>
-bool CGSHandler::ReadCLUT4_16(const TEX0& tex0)
+//Updates part of the CLUT, returns true if it changed
+static bool UpdateCLUT(uint16* clut, const uint16* colors, uint32 count)
 {
-	bool changed = false;
+	if(!memcmp(clut, colors, count * sizeof(uint16))) return false;
+	memcpy(clut, colors, count * sizeof(uint16));
+	return true;
+}
 
+//CSM1 8-bit CLUTs swap bits 3 and 4 of color indices, runs of 8 colors stay contiguous
+static uint32 GetCLUT8RunIndex(uint32 index)
+{
+	return (index & ~0x18) | ((index & 0x08) << 1) | ((index & 0x10) >> 1);
+}
+
+template <typename Storage>
+bool CGSHandler::ReadCLUT4_16(const TEX0& tex0)
+{
 	assert(tex0.nCSA < 32);
 
-	Indexor indexor(m_pRAM, tex0.GetCLUTPtr(), 1);
-	uint32 clutOffset = tex0.nCSA * 16;
-	uint16* pDst = m_pCLUT + clutOffset;
+	//8x2 colors, all within a column
+	CGsPixelFormats::CPixelIndexor<Storage> indexor(m_pRAM, tex0.GetCLUTPtr(), 1);
+	uint16 colors[Storage::COLUMNHEIGHT][Storage::COLUMNWIDTH];
+	ReadColumns(m_pRAM, indexor, &colors[0][0], 0, 0, Storage::COLUMNWIDTH, Storage::COLUMNHEIGHT);
 
-	for(unsigned int j = 0; j < 2; j++)
-	{
-		for(unsigned int i = 0; i < 8; i++)
-		{
-			uint16 color = indexor.GetPixel(i, j);
+	uint16 clut[0x10];
+	memcpy(clut + 0, colors[0], 8 * sizeof(uint16));
+	memcpy(clut + 8, colors[1], 8 * sizeof(uint16));
 
-			if(*pDst != color)
-			{
-				changed = true;
-			}
-
-			(*pDst++) = color;
-		}
-	}
-
-	return changed;
+	uint32 clutOffset = tex0.nCSA * 16;
+	return UpdateCLUT(m_pCLUT + clutOffset, clut, 0x10);
 }
 
-template <typename Indexor>
+template <typename Storage>
 bool CGSHandler::ReadCLUT8_16(const TEX0& tex0)
 {
-	bool changed = false;
+	CGsPixelFormats::CPixelIndexor<Storage> indexor(m_pRAM, tex0.GetCLUTPtr(), 1);
+	uint16 colors[0x100];
+	ReadColumns(m_pRAM, indexor, colors, 0, 0, 16, 16);
 
-	Indexor indexor(m_pRAM, tex0.GetCLUTPtr(), 1);
-
-	for(unsigned int j = 0; j < 16; j++)
+	uint16 clut[0x100];
+	for(unsigned int i = 0; i < 0x100; i += 8)
 	{
-		for(unsigned int i = 0; i < 16; i++)
-		{
-			uint16 color = indexor.GetPixel(i, j);
-
-			uint8 index = i + (j * 16);
-			index = (index & ~0x18) | ((index & 0x08) << 1) | ((index & 0x10) >> 1);
-
-			if(m_pCLUT[index] != color)
-			{
-				changed = true;
-			}
-
-			m_pCLUT[index] = color;
-		}
+		memcpy(clut + GetCLUT8RunIndex(i), colors + i, 8 * sizeof(uint16));
 	}
 
-	return changed;
+	return UpdateCLUT(m_pCLUT, clut, 0x100);
 }
 
 void CGSHandler::ReadCLUT4(const TEX0& tex0)
@@ -1584,38 +2012,30 @@ void CGSHandler::ReadCLUT4(const TEX0& tex0)
 		{
 			assert(tex0.nCSA < 16);
 
+			//8x2 colors, exactly one column
 			CGsPixelFormats::CPixelIndexorPSMCT32 Indexor(m_pRAM, tex0.GetCLUTPtr(), 1);
-			uint32 clutOffset = (tex0.nCSA & 0x0F) * 16;
-			uint16* pDst = m_pCLUT + clutOffset;
+			uint32 colors[0x10];
+			ReadColumns(m_pRAM, Indexor, colors, 0, 0, 8, 2);
 
-			for(unsigned int j = 0; j < 2; j++)
+			uint16 clutLo[0x10];
+			uint16 clutHi[0x10];
+			for(unsigned int i = 0; i < 0x10; i++)
 			{
-				for(unsigned int i = 0; i < 8; i++)
-				{
-					uint32 color = Indexor.GetPixel(i, j);
-					uint16 colorLo = static_cast<uint16>(color & 0xFFFF);
-					uint16 colorHi = static_cast<uint16>(color >> 16);
-
-					if(
-					    (pDst[0x000] != colorLo) ||
-					    (pDst[0x100] != colorHi))
-					{
-						changed = true;
-					}
-
-					pDst[0x000] = colorLo;
-					pDst[0x100] = colorHi;
-					pDst++;
-				}
+				clutLo[i] = static_cast<uint16>(colors[i] & 0xFFFF);
+				clutHi[i] = static_cast<uint16>(colors[i] >> 16);
 			}
+
+			uint32 clutOffset = (tex0.nCSA & 0x0F) * 16;
+			changed |= UpdateCLUT(m_pCLUT + clutOffset + 0x000, clutLo, 0x10);
+			changed |= UpdateCLUT(m_pCLUT + clutOffset + 0x100, clutHi, 0x10);
 		}
 		else if(tex0.nCPSM == PSMCT16)
 		{
-			changed = ReadCLUT4_16<CGsPixelFormats::CPixelIndexorPSMCT16>(tex0);
+			changed = ReadCLUT4_16<CGsPixelFormats::STORAGEPSMCT16>(tex0);
 		}
 		else if(tex0.nCPSM == PSMCT16S)
 		{
-			changed = ReadCLUT4_16<CGsPixelFormats::CPixelIndexorPSMCT16S>(tex0);
+			changed = ReadCLUT4_16<CGsPixelFormats::STORAGEPSMCT16S>(tex0);
 		}
 		else
 		{
@@ -1630,22 +2050,14 @@ void CGSHandler::ReadCLUT4(const TEX0& tex0)
 
 		auto texClut = make_convertible<TEXCLUT>(m_nReg[GS_REG_TEXCLUT]);
 
+		//Colors are in a single row of a column
 		CGsPixelFormats::CPixelIndexorPSMCT16 Indexor(m_pRAM, tex0.GetCLUTPtr(), texClut.nCBW);
 		unsigned int nOffsetX = texClut.GetOffsetU();
 		unsigned int nOffsetY = texClut.GetOffsetV();
-		uint16* pDst = m_pCLUT;
-
-		for(unsigned int i = 0; i < 0x10; i++)
-		{
-			uint16 color = Indexor.GetPixel(nOffsetX + i, nOffsetY);
-
-			if(*pDst != color)
-			{
-				changed = true;
-			}
+		uint16 colors[2][0x10];
+		ReadColumns(m_pRAM, Indexor, &colors[0][0], nOffsetX, nOffsetY & ~1, 0x10, 2);
 
-			(*pDst++) = color;
-		}
+		changed = UpdateCLUT(m_pCLUT, colors[nOffsetY & 1], 0x10);
 	}
 
 	if(changed)
@@ -1665,37 +2077,29 @@ void CGSHandler::ReadCLUT8(const TEX0& tex0)
 		if(tex0.nCPSM == PSMCT32 || tex0.nCPSM == PSMCT24)
 		{
 			CGsPixelFormats::CPixelIndexorPSMCT32 Indexor(m_pRAM, tex0.GetCLUTPtr(), 1);
+			uint32 colors[0x100];
+			ReadColumns(m_pRAM, Indexor, colors, 0, 0, 16, 16);
 
-			for(unsigned int j = 0; j < 16; j++)
+			uint16 clut[0x200];
+			for(unsigned int i = 0; i < 0x100; i += 8)
 			{
-				for(unsigned int i = 0; i < 16; i++)
+				uint32 index = GetCLUT8RunIndex(i);
+				for(unsigned int j = 0; j < 8; j++)
 				{
-					uint32 color = Indexor.GetPixel(i, j);
-					uint16 colorLo = static_cast<uint16>(color & 0xFFFF);
-					uint16 colorHi = static_cast<uint16>(color >> 16);
-
-					uint8 index = i + (j * 16);
-					index = (index & ~0x18) | ((index & 0x08) << 1) | ((index & 0x10) >> 1);
-
-					if(
-					    (m_pCLUT[index + 0x000] != colorLo) ||
-					    (m_pCLUT[index + 0x100] != colorHi))
-					{
-						changed = true;
-					}
-
-					m_pCLUT[index + 0x000] = colorLo;
-					m_pCLUT[index + 0x100] = colorHi;
+					clut[index + j + 0x000] = static_cast<uint16>(colors[i + j] & 0xFFFF);
+					clut[index + j + 0x100] = static_cast<uint16>(colors[i + j] >> 16);
 				}
 			}
+
+			changed = UpdateCLUT(m_pCLUT, clut, 0x200);
 		}
 		else if(tex0.nCPSM == PSMCT16)
 		{
-			changed = ReadCLUT8_16<CGsPixelFormats::CPixelIndexorPSMCT16>(tex0);
+			changed = ReadCLUT8_16<CGsPixelFormats::STORAGEPSMCT16>(tex0);
 		}
 		else if(tex0.nCPSM == PSMCT16S)
 		{
-			changed = ReadCLUT8_16<CGsPixelFormats::CPixelIndexorPSMCT16S>(tex0);
+			changed = ReadCLUT8_16<CGsPixelFormats::STORAGEPSMCT16S>(tex0);
 		}
 		else
 		{
@@ -1709,22 +2113,14 @@ void CGSHandler::ReadCLUT8(const TEX0& tex0)
 
 		auto texClut = make_convertible<TEXCLUT>(m_nReg[GS_REG_TEXCLUT]);
 
+		//Colors are in a single row of 16 columns
 		CGsPixelFormats::CPixelIndexorPSMCT16 indexor(m_pRAM, tex0.GetCLUTPtr(), texClut.nCBW);
 		unsigned int offsetX = texClut.GetOffsetU();
 		unsigned int offsetY = texClut.GetOffsetV();
-		uint16* dst = m_pCLUT;
-
-		for(unsigned int i = 0; i < 0x100; i++)
-		{
-			uint16 color = indexor.GetPixel(offsetX + i, offsetY);
+		uint16 colors[2][0x100];
+		ReadColumns(m_pRAM, indexor, &colors[0][0], offsetX, offsetY & ~1, 0x100, 2);
 
-			if(*dst != color)
-			{
-				changed = true;
-			}
-
-			(*dst++) = color;
-		}
+		changed = UpdateCLUT(m_pCLUT, colors[offsetY & 1], 0x100);
 	}
 
 	if(changed)
@@ -2172,7 +2568,7 @@ void CGSHandler::ThreadProc()
 	}
 }
 
-void CGSHandler::SendGSCall(const CMailBox::FunctionType& function, bool waitForCompletion, bool forceWaitForCompletion)
+void CGSHandler::SendGSCall(const CSpscMailBox::FunctionType& function, bool waitForCompletion, bool forceWaitForCompletion)
 {
 	if(!m_gsThreaded)
 	{
@@ -2182,7 +2578,7 @@ void CGSHandler::SendGSCall(const CMailBox::FunctionType& function, bool waitFor
 	m_mailBox.SendCall(function, waitForCompletion);
 }
 
-void CGSHandler::SendGSCall(CMailBox::FunctionType&& function)
+void CGSHandler::SendGSCall(CSpscMailBox::FunctionType&& function)
 {
 	m_mailBox.SendCall(std::move(function));
 }
@@ -2,15 +2,18 @@
 
 #include <thread>
 #include <vector>
+#include <deque>
 #include <functional>
 #include <atomic>
 #include <array>
+#include <condition_variable>
+#include <mutex>
 #include "signal/Signal.h"
 
 #include "bitmap/Bitmap.h"
 #include "Types.h"
 #include "Convertible.h"
-#include "../MailBox.h"
+#include "../SpscMailBox.h"
 #include "../Integer64.h"
 #include "zip/ZipArchiveWriter.h"
 #include "zip/ZipArchiveReader.h"
@@ -22,6 +25,8 @@ class CINTC;
 #define PREF_CGSHANDLER_PRESENTATION_MODE "renderer.presentationmode"
 #define PREF_CGSHANDLER_GS_RAM_READS_ENABLED "renderer.ramreads.enabled"
 #define PREF_CGSHANDLER_WIDESCREEN "renderer.widescreen"
+#define PREF_CGSHANDLER_TEXTURECACHE_SIZE "renderer.texturecache.size"
+#define PREF_CGSHANDLER_TEXTURECACHE_SIZE_DEFAULT 256
 
 enum GS_REGS
 {
@@ -818,6 +823,19 @@ public:
 	typedef Framework::CSignal<void()> FlipCompleteEvent;
 	typedef Framework::CSignal<void(uint32)> NewFrameEvent;
 
+	struct READBACK_STATS
+	{
+		uint32 readbackCount = 0; //Local to host transfers read by the EE
+		uint32 stallCount = 0;    //Transfers the EE had to wait for
+		uint64 stallTime = 0;     //Time spent waiting, in nanoseconds
+	};
+
+	struct TEXTURE_CACHE_STATS
+	{
+		uint32 decodeLookupCount = 0; //Textures that needed decoding, looked up by contents
+		uint32 decodeHitCount = 0;    //Lookups that reused an already decoded texture
+	};
+
 	CGSHandler(bool = true);
 	virtual ~CGSHandler();
 
@@ -840,6 +858,9 @@ public:
 	bool GetDrawEnabled() const;
 	void SetDrawEnabled(bool);
 
+	//Skips presenting the first N frames of every M frames (ie.: while fast forwarding), M = 0 presents all frames
+	void SetPresentationSkip(uint32, uint32);
+
 	void WritePrivRegister(uint32, uint32);
 	uint32 ReadPrivRegister(uint32);
 
@@ -853,6 +874,12 @@ public:
 	void FeedImageData(const void*, uint32);
 	void ReadImageData(void*, uint32);
 
+	READBACK_STATS GetReadbackStats() const;
+	void ResetReadbackStats();
+
+	//Returns the counters of frames completed since the last call and resets them
+	TEXTURE_CACHE_STATS TakeTextureCacheStats();
+
 	inline void WriteRegister(const RegisterWrite& write)
 	{
 		assert(m_writeBufferSize < REGISTERWRITEBUFFER_SIZE);
@@ -897,8 +924,8 @@ public:
 
 	virtual Framework::CBitmap GetScreenshot();
 
-	void SendGSCall(CMailBox::FunctionType&&);
-	void SendGSCall(const CMailBox::FunctionType&, bool = false, bool = false);
+	void SendGSCall(CSpscMailBox::FunctionType&&);
+	void SendGSCall(const CSpscMailBox::FunctionType&, bool = false, bool = false);
 
 	void ProcessSingleFrame();
 
@@ -1041,7 +1068,11 @@ protected:
 	virtual void WriteRegisterImpl(uint8, uint64);
 	void FeedImageDataImpl(const uint8*, uint32);
 	void ReadImageDataImpl(void*, uint32);
+	void SubmitWriteBuffer(uint32);
 	void SubmitWriteBufferImpl(const RegisterWrite*, const RegisterWrite*);
+	void TakeReadbackSnapshotImpl(uint32);
+	void WaitForReadback();
+	void ResetReadbacks();
 
 	void UpdateFrameDumpState();
 
@@ -1074,9 +1105,9 @@ protected:
 
 	virtual void SyncCLUT(const TEX0&);
 	bool ProcessCLD(const TEX0&);
-	template <typename Indexor>
+	template <typename Storage>
 	bool ReadCLUT4_16(const TEX0&);
-	template <typename Indexor>
+	template <typename Storage>
 	bool ReadCLUT8_16(const TEX0&);
 	void ReadCLUT4(const TEX0&);
 	void ReadCLUT8(const TEX0&);
@@ -1109,6 +1140,7 @@ protected:
 	uint32 m_nCBP1;
 
 	uint32 m_drawCallCount = 0;
+	TEXTURE_CACHE_STATS m_frameTextureCacheStats;
 
 	static constexpr int MAX_INFLIGHT_FRAMES = 2;
 	RegisterWrite* m_writeBuffers[MAX_INFLIGHT_FRAMES] = {};
@@ -1134,7 +1166,36 @@ protected:
 	CINTC* m_intc = nullptr;
 	bool m_gsThreaded = true;
 	bool m_flipped = false;
+	uint32 m_presentationSkipCount = 0;
+	uint32 m_presentationPeriod = 0;
+	uint32 m_presentationIndex = 0;
+
+	//Local to host transfers: when threaded, the GS thread copies the transfer's data to a staging
+	//buffer as soon as it begins, the EE only waits for it if it reads the data before that's done
+	struct READBACK
+	{
+		uint32 sequence = 0;
+		std::vector<uint8> data;
+	};
+
+	enum
+	{
+		MAX_PENDING_READBACKS = 4,
+	};
+
+	std::mutex m_readbackMutex;
+	std::condition_variable m_readbackCondition;
+	std::deque<READBACK> m_readbacks;
+	uint32 m_readbackCompleteCount = 0;
+	uint32 m_readbackRequestCount = 0;
+	READBACK m_currentReadback;
+	uint32 m_currentReadbackOffset = 0;
+	READBACK_STATS m_readbackStats;
+
+	//Accumulated by the GS thread on every frame, taken by any other thread
+	std::atomic<uint32> m_textureDecodeLookupCount = {0};
+	std::atomic<uint32> m_textureDecodeHitCount = {0};
 
 private:
-	CMailBox m_mailBox;
+	CSpscMailBox m_mailBox;
 };
@@ -0,0 +1,236 @@
+#include "SimdDefs.h"
+#include "GsSwizzle.h"
+#include "GsVector.h"
+
+static inline bool StoreColumn(uint8* column, Vector c0, Vector c1, Vector c2, Vector c3)
+{
+	Vector diff0 = Or(Xor(Load(column + 0x00), c0), Xor(Load(column + 0x10), c1));
+	Vector diff1 = Or(Xor(Load(column + 0x20), c2), Xor(Load(column + 0x30), c3));
+	Store(column + 0x00, c0);
+	Store(column + 0x10, c1);
+	Store(column + 0x20, c2);
+	Store(column + 0x30, c3);
+	return !IsZero(Or(diff0, diff1));
+}
+
+//8 and 4 bits columns store 4 rows in each word: rows 0 and 1 in the even bytes
+//and rows 2 and 3 in the odd bytes. Depending on the column's parity, either the
+//first or the last two rows have the words holding their left and right halves swapped.
+static inline bool StoreColumn8(uint8* column, Vector row0, Vector row1, Vector row2, Vector row3)
+{
+	//Input rows contain one byte per word for each of their 16 elements
+	Vector even = InterleaveLo8(row0, row2);
+	Vector odd = InterleaveHi8(row0, row2);
+	Vector words02Lo = InterleaveLo16(even, odd);
+	Vector words02Hi = InterleaveHi16(even, odd);
+
+	even = InterleaveLo8(row1, row3);
+	odd = InterleaveHi8(row1, row3);
+	Vector words13Lo = InterleaveLo16(even, odd);
+	Vector words13Hi = InterleaveHi16(even, odd);
+
+	return StoreColumn(column,
+	                   InterleaveLo64(words02Lo, words13Lo), InterleaveHi64(words02Lo, words13Lo),
+	                   InterleaveLo64(words02Hi, words13Hi), InterleaveHi64(words02Hi, words13Hi));
+}
+
+bool GsSwizzle::WriteColumnPSMCT32(uint8* column, const uint8* src, uint32 srcPitch)
+{
+	Vector row0Lo = Load(src);
+	Vector row0Hi = Load(src + 0x10);
+	Vector row1Lo = Load(src + srcPitch);
+	Vector row1Hi = Load(src + srcPitch + 0x10);
+
+	//Pixel pairs from each row alternate
+	return StoreColumn(column,
+	                   InterleaveLo64(row0Lo, row1Lo), InterleaveHi64(row0Lo, row1Lo),
+	                   InterleaveLo64(row0Hi, row1Hi), InterleaveHi64(row0Hi, row1Hi));
+}
+
+bool GsSwizzle::WriteColumnPSMCT16(uint8* column, const uint8* src, uint32 srcPitch)
+{
+	Vector row0Lo = Load(src);
+	Vector row0Hi = Load(src + 0x10);
+	Vector row1Lo = Load(src + srcPitch);
+	Vector row1Hi = Load(src + srcPitch + 0x10);
+
+	//Each word holds pixels x and x + 8 of a row, pairs of words from each row alternate
+	Vector row0Words0 = InterleaveLo16(row0Lo, row0Hi);
+	Vector row0Words1 = InterleaveHi16(row0Lo, row0Hi);
+	Vector row1Words0 = InterleaveLo16(row1Lo, row1Hi);
+	Vector row1Words1 = InterleaveHi16(row1Lo, row1Hi);
+
+	return StoreColumn(column,
+	                   InterleaveLo64(row0Words0, row1Words0), InterleaveHi64(row0Words0, row1Words0),
+	                   InterleaveLo64(row0Words1, row1Words1), InterleaveHi64(row0Words1, row1Words1));
+}
+
+bool GsSwizzle::WriteColumnPSMT8(uint8* column, const uint8* src, uint32 srcPitch, uint32 columnParity)
+{
+	Vector row0 = Load(src);
+	Vector row1 = Load(src + srcPitch);
+	Vector row2 = Load(src + srcPitch * 2);
+	Vector row3 = Load(src + srcPitch * 3);
+
+	if(columnParity == 0)
+	{
+		row2 = SwapWordPairs(row2);
+		row3 = SwapWordPairs(row3);
+	}
+	else
+	{
+		row0 = SwapWordPairs(row0);
+		row1 = SwapWordPairs(row1);
+	}
+
+	return StoreColumn8(column, row0, row1, row2, row3);
+}
+
+bool GsSwizzle::WriteColumnPSMT4(uint8* column, const uint8* src, uint32 srcPitch, uint32 columnParity)
+{
+	Vector row0 = Load(src);
+	Vector row1 = Load(src + srcPitch);
+	Vector row2 = Load(src + srcPitch * 2);
+	Vector row3 = Load(src + srcPitch * 3);
+
+	//Same as PSMT8, but a group of 8 pixels is 4 bytes wide
+	if(columnParity == 0)
+	{
+		row2 = SwapHalfWordPairs(row2);
+		row3 = SwapHalfWordPairs(row3);
+	}
+	else
+	{
+		row0 = SwapHalfWordPairs(row0);
+		row1 = SwapHalfWordPairs(row1);
+	}
+
+	//Pixels of rows 0 and 2 (and 1 and 3) share a byte. Those bytes are stored like a PSMT8
+	//column where each row would hold pixels 0-7 and 16-23 and the next one pixels 8-15 and 24-31
+	Vector evenPixels02 = Or(LowNibbles(row0), ShiftNibblesUp(row2));
+	Vector oddPixels02 = Or(ShiftNibblesDown(row0), HighNibbles(row2));
+	Vector pixels02Lo = InterleaveLo8(evenPixels02, oddPixels02);
+	Vector pixels02Hi = InterleaveHi8(evenPixels02, oddPixels02);
+
+	Vector evenPixels13 = Or(LowNibbles(row1), ShiftNibblesUp(row3));
+	Vector oddPixels13 = Or(ShiftNibblesDown(row1), HighNibbles(row3));
+	Vector pixels13Lo = InterleaveLo8(evenPixels13, oddPixels13);
+	Vector pixels13Hi = InterleaveHi8(evenPixels13, oddPixels13);
+
+	return StoreColumn8(column,
+	                    InterleaveLo64(pixels02Lo, pixels02Hi), InterleaveLo64(pixels13Lo, pixels13Hi),
+	                    InterleaveHi64(pixels02Lo, pixels02Hi), InterleaveHi64(pixels13Lo, pixels13Hi));
+}
+
+//Read functions undo the steps of their write counterparts in reverse order
+
+void GsSwizzle::ReadColumnPSMCT32(uint8* dst, uint32 dstPitch, const uint8* column)
+{
+	Vector c0 = Load(column + 0x00);
+	Vector c1 = Load(column + 0x10);
+	Vector c2 = Load(column + 0x20);
+	Vector c3 = Load(column + 0x30);
+
+	Store(dst, InterleaveLo64(c0, c1));
+	Store(dst + 0x10, InterleaveLo64(c2, c3));
+	Store(dst + dstPitch, InterleaveHi64(c0, c1));
+	Store(dst + dstPitch + 0x10, InterleaveHi64(c2, c3));
+}
+
+void GsSwizzle::ReadColumnPSMCT16(uint8* dst, uint32 dstPitch, const uint8* column)
+{
+	Vector c0 = Load(column + 0x00);
+	Vector c1 = Load(column + 0x10);
+	Vector c2 = Load(column + 0x20);
+	Vector c3 = Load(column + 0x30);
+
+	Vector row0Words0 = InterleaveLo64(c0, c1);
+	Vector row1Words0 = InterleaveHi64(c0, c1);
+	Vector row0Words1 = InterleaveLo64(c2, c3);
+	Vector row1Words1 = InterleaveHi64(c2, c3);
+
+	Store(dst, EvenHalfWords(row0Words0, row0Words1));
+	Store(dst + 0x10, OddHalfWords(row0Words0, row0Words1));
+	Store(dst + dstPitch, EvenHalfWords(row1Words0, row1Words1));
+	Store(dst + dstPitch + 0x10, OddHalfWords(row1Words0, row1Words1));
+}
+
+static inline void LoadColumn8(const uint8* column, Vector& row0, Vector& row1, Vector& row2, Vector& row3)
+{
+	Vector c0 = Load(column + 0x00);
+	Vector c1 = Load(column + 0x10);
+	Vector c2 = Load(column + 0x20);
+	Vector c3 = Load(column + 0x30);
+
+	Vector words02Lo = InterleaveLo64(c0, c1);
+	Vector words13Lo = InterleaveHi64(c0, c1);
+	Vector words02Hi = InterleaveLo64(c2, c3);
+	Vector words13Hi = InterleaveHi64(c2, c3);
+
+	Vector even = EvenHalfWords(words02Lo, words02Hi);
+	Vector odd = OddHalfWords(words02Lo, words02Hi);
+	row0 = EvenBytes(even, odd);
+	row2 = OddBytes(even, odd);
+
+	even = EvenHalfWords(words13Lo, words13Hi);
+	odd = OddHalfWords(words13Lo, words13Hi);
+	row1 = EvenBytes(even, odd);
+	row3 = OddBytes(even, odd);
+}
+
+void GsSwizzle::ReadColumnPSMT8(uint8* dst, uint32 dstPitch, const uint8* column, uint32 columnParity)
+{
+	Vector row0, row1, row2, row3;
+	LoadColumn8(column, row0, row1, row2, row3);
+
+	if(columnParity == 0)
+	{
+		row2 = SwapWordPairs(row2);
+		row3 = SwapWordPairs(row3);
+	}
+	else
+	{
+		row0 = SwapWordPairs(row0);
+		row1 = SwapWordPairs(row1);
+	}
+
+	Store(dst, row0);
+	Store(dst + dstPitch, row1);
+	Store(dst + dstPitch * 2, row2);
+	Store(dst + dstPitch * 3, row3);
+}
+
+void GsSwizzle::ReadColumnPSMT4(uint8* dst, uint32 dstPitch, const uint8* column, uint32 columnParity)
+{
+	//Bytes are stored like a PSMT8 column where each row would hold pixels 0-7 and 16-23
+	//and the next one pixels 8-15 and 24-31. Each byte holds pixels of rows 0 and 2 (or 1 and 3).
+	Vector bytes02Lo, bytes13Lo, bytes02Hi, bytes13Hi;
+	LoadColumn8(column, bytes02Lo, bytes13Lo, bytes02Hi, bytes13Hi);
+
+	Vector pixels02Left = InterleaveLo64(bytes02Lo, bytes02Hi);
+	Vector pixels02Right = InterleaveHi64(bytes02Lo, bytes02Hi);
+	Vector pixels13Left = InterleaveLo64(bytes13Lo, bytes13Hi);
+	Vector pixels13Right = InterleaveHi64(bytes13Lo, bytes13Hi);
+
+	Vector rows[4][2] =
+	    {
+	        {LowNibbles(pixels02Left), LowNibbles(pixels02Right)},
+	        {LowNibbles(pixels13Left), LowNibbles(pixels13Right)},
+	        {ShiftNibblesDown(pixels02Left), ShiftNibblesDown(pixels02Right)},
+	        {ShiftNibblesDown(pixels13Left), ShiftNibblesDown(pixels13Right)},
+	    };
+
+	//Once expanded, a group of 8 pixels is 8 bytes wide
+	uint32 swappedRow = (columnParity == 0) ? 2 : 0;
+	for(uint32 i = swappedRow; i < swappedRow + 2; i++)
+	{
+		rows[i][0] = SwapWordPairs(rows[i][0]);
+		rows[i][1] = SwapWordPairs(rows[i][1]);
+	}
+
+	for(uint32 i = 0; i < 4; i++)
+	{
+		Store(dst + (dstPitch * i), rows[i][0]);
+		Store(dst + (dstPitch * i) + 0x10, rows[i][1]);
+	}
+}
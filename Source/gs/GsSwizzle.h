@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Types.h"
+
+//Converts whole GS memory columns (64 bytes) from/to linear rows of pixels.
+//A column covers COLUMNWIDTH x COLUMNHEIGHT pixels of its storage format
+//(8x2 for PSMCT32, 16x2 for PSMCT16, 16x4 for PSMT8, 32x4 for PSMT4), each source
+//row is then always 32 bytes (32 and 16 bits formats) or 16 bytes (8 and 4 bits formats) long.
+//PSMT8 and PSMT4 columns have a different layout depending on their parity in the block.
+namespace GsSwizzle
+{
+	//Write functions return true if the contents of the column changed
+	bool WriteColumnPSMCT32(uint8* column, const uint8* src, uint32 srcPitch);
+	bool WriteColumnPSMCT16(uint8* column, const uint8* src, uint32 srcPitch);
+	bool WriteColumnPSMT8(uint8* column, const uint8* src, uint32 srcPitch, uint32 columnParity);
+	bool WriteColumnPSMT4(uint8* column, const uint8* src, uint32 srcPitch, uint32 columnParity);
+
+	void ReadColumnPSMCT32(uint8* dst, uint32 dstPitch, const uint8* column);
+	void ReadColumnPSMCT16(uint8* dst, uint32 dstPitch, const uint8* column);
+	void ReadColumnPSMT8(uint8* dst, uint32 dstPitch, const uint8* column, uint32 columnParity);
+	//Expands pixels to one byte each, rows are 32 bytes long
+	void ReadColumnPSMT4(uint8* dst, uint32 dstPitch, const uint8* column, uint32 columnParity);
+}
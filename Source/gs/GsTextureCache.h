@@ -1,8 +1,13 @@
 #pragma once
 
-#include <list>
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "GSHandler.h"
 #include "GsCachedArea.h"
+#include "GsPixelFormats.h"
 
 #define TEX0_CLUTINFO_MASK (~0xFFFFFFE000000000ULL)
 
@@ -26,43 +31,67 @@ public:
 
 		//Platform specific
 		TextureHandleType m_textureHandle;
+
+	private:
+		friend class CGsTextureCache;
+
+		//LRU list links, m_lruPrev is closer to the most recently used texture
+		CTexture* m_lruPrev = nullptr;
+		CTexture* m_lruNext = nullptr;
+
+		//GS RAM pages covered by m_cachedArea
+		uint32 m_firstPage = 0;
+		uint32 m_lastPage = 0;
+		uint32 m_invalidationId = 0;
 	};
 
 	enum
 	{
-		MAX_TEXTURE_CACHE = 256,
+		DEFAULT_TEXTURE_CACHE_SIZE = PREF_CGSHANDLER_TEXTURECACHE_SIZE_DEFAULT,
 	};
 
-	CGsTextureCache()
+	CGsTextureCache(uint32 cacheSize = DEFAULT_TEXTURE_CACHE_SIZE)
 	{
-		for(unsigned int i = 0; i < MAX_TEXTURE_CACHE; i++)
+		cacheSize = std::max<uint32>(cacheSize, 1);
+		m_textures.reserve(cacheSize);
+		m_textureIndex.reserve(cacheSize);
+		for(unsigned int i = 0; i < cacheSize; i++)
 		{
-			m_textureCache.push_back(std::make_shared<CTexture>());
+			m_textures.push_back(std::make_unique<CTexture>());
+			LinkBack(m_textures.back().get());
 		}
 	}
 
+	CGsTextureCache(const CGsTextureCache&) = delete;
+	CGsTextureCache& operator=(const CGsTextureCache&) = delete;
+
+	uint32 GetCacheSize() const
+	{
+		return static_cast<uint32>(m_textures.size());
+	}
+
 	CTexture* Search(const CGSHandler::TEX0& tex0)
 	{
 		uint64 maskedTex0 = static_cast<uint64>(tex0) & TEX0_CLUTINFO_MASK;
 
-		for(auto textureIterator(m_textureCache.begin());
-		    textureIterator != m_textureCache.end(); textureIterator++)
-		{
-			auto texture = *textureIterator;
-			if(!texture->m_live) continue;
-			if(maskedTex0 != texture->m_tex0) continue;
-			m_textureCache.erase(textureIterator);
-			m_textureCache.push_front(texture);
-			return texture.get();
-		}
+		auto textureIterator = m_textureIndex.find(maskedTex0);
+		if(textureIterator == m_textureIndex.end()) return nullptr;
 
-		return nullptr;
+		auto texture = textureIterator->second;
+		assert(texture->m_live);
+		Unlink(texture);
+		LinkFront(texture);
+		return texture;
 	}
 
 	void Insert(const CGSHandler::TEX0& tex0, TextureHandleType textureHandle)
 	{
-		auto texture = *m_textureCache.rbegin();
-		texture->Reset();
+		uint64 maskedTex0 = static_cast<uint64>(tex0) & TEX0_CLUTINFO_MASK;
+
+		//Replace the texture with the same key if there's one, otherwise the least recently used one
+		auto textureIterator = m_textureIndex.find(maskedTex0);
+		auto texture = (textureIterator != m_textureIndex.end()) ? textureIterator->second : m_lruTail;
+		Evict(texture);
 
 		// DBZ Budokai Tenkaichi 2 and 3 use invalid (empty) buffer sizes.
 		// Account for that, by assuming image width.
@@ -75,29 +104,157 @@ public:
 
 		texture->m_cachedArea.SetArea(tex0.nPsm, tex0.GetBufPtr(), bufSize, texHeight);
 
-		texture->m_tex0 = static_cast<uint64>(tex0) & TEX0_CLUTINFO_MASK;
+		texture->m_tex0 = maskedTex0;
 		texture->m_textureHandle = std::move(textureHandle);
 		texture->m_live = true;
 
-		m_textureCache.pop_back();
-		m_textureCache.push_front(texture);
+		//Areas going past the end of RAM are not wrapped around by CGsCachedArea::Invalidate
+		uint32 areaStart = tex0.GetBufPtr();
+		uint32 areaEnd = std::min<uint32>(areaStart + texture->m_cachedArea.GetSize(), CGSHandler::RAMSIZE);
+		texture->m_firstPage = areaStart / CGsPixelFormats::PAGESIZE;
+		texture->m_lastPage = (std::max<uint32>(areaEnd, areaStart + 1) - 1) / CGsPixelFormats::PAGESIZE;
+		for(uint32 page = texture->m_firstPage; page <= texture->m_lastPage; page++)
+		{
+			m_pageTextures[page].push_back(texture);
+		}
+
+		m_textureIndex[maskedTex0] = texture;
+
+		Unlink(texture);
+		LinkFront(texture);
 	}
 
 	void InvalidateRange(uint32 start, uint32 size)
 	{
-		std::for_each(std::begin(m_textureCache), std::end(m_textureCache),
-		              [start, size](TexturePtr& texture) { if(texture->m_live) { texture->m_cachedArea.Invalidate(start, size); } });
+		if((size == 0) || (start >= CGSHandler::RAMSIZE)) return;
+
+		//Only visit textures overlapping with the written pages, those spanning
+		//several pages are marked to be invalidated only once.
+		uint32 invalidationId = NextInvalidationId();
+		uint32 end = std::min<uint32>(start + size, CGSHandler::RAMSIZE);
+		uint32 firstPage = start / CGsPixelFormats::PAGESIZE;
+		uint32 lastPage = (end - 1) / CGsPixelFormats::PAGESIZE;
+		for(uint32 page = firstPage; page <= lastPage; page++)
+		{
+			for(auto texture : m_pageTextures[page])
+			{
+				if(texture->m_invalidationId == invalidationId) continue;
+				texture->m_invalidationId = invalidationId;
+				texture->m_cachedArea.Invalidate(start, size);
+			}
+		}
 	}
 
 	void Flush()
 	{
-		std::for_each(std::begin(m_textureCache), std::end(m_textureCache),
-		              [](TexturePtr& texture) { texture->Reset(); });
+		for(const auto& texture : m_textures)
+		{
+			texture->Reset();
+		}
+		m_textureIndex.clear();
+		for(auto& pageTextures : m_pageTextures)
+		{
+			pageTextures.clear();
+		}
 	}
 
 private:
-	typedef std::shared_ptr<CTexture> TexturePtr;
-	typedef std::list<TexturePtr> TextureList;
+	enum
+	{
+		PAGE_COUNT = CGSHandler::RAMSIZE / CGsPixelFormats::PAGESIZE,
+	};
+
+	typedef std::unique_ptr<CTexture> TexturePtr;
+	typedef std::vector<TexturePtr> TextureArray;
+	typedef std::unordered_map<uint64, CTexture*> TextureIndex;
+	typedef std::vector<CTexture*> PageTextureList;
+
+	uint32 NextInvalidationId()
+	{
+		if(++m_invalidationId == 0)
+		{
+			for(const auto& texture : m_textures)
+			{
+				texture->m_invalidationId = 0;
+			}
+			m_invalidationId = 1;
+		}
+		return m_invalidationId;
+	}
+
+	void Evict(CTexture* texture)
+	{
+		if(texture->m_live)
+		{
+			m_textureIndex.erase(texture->m_tex0);
+			for(uint32 page = texture->m_firstPage; page <= texture->m_lastPage; page++)
+			{
+				auto& pageTextures = m_pageTextures[page];
+				auto textureIterator = std::find(pageTextures.begin(), pageTextures.end(), texture);
+				assert(textureIterator != pageTextures.end());
+				*textureIterator = pageTextures.back();
+				pageTextures.pop_back();
+			}
+		}
+		texture->Reset();
+	}
+
+	void Unlink(CTexture* texture)
+	{
+		if(texture->m_lruPrev)
+		{
+			texture->m_lruPrev->m_lruNext = texture->m_lruNext;
+		}
+		else
+		{
+			m_lruHead = texture->m_lruNext;
+		}
+		if(texture->m_lruNext)
+		{
+			texture->m_lruNext->m_lruPrev = texture->m_lruPrev;
+		}
+		else
+		{
+			m_lruTail = texture->m_lruPrev;
+		}
+		texture->m_lruPrev = nullptr;
+		texture->m_lruNext = nullptr;
+	}
+
+	void LinkFront(CTexture* texture)
+	{
+		texture->m_lruPrev = nullptr;
+		texture->m_lruNext = m_lruHead;
+		if(m_lruHead)
+		{
+			m_lruHead->m_lruPrev = texture;
+		}
+		else
+		{
+			m_lruTail = texture;
+		}
+		m_lruHead = texture;
+	}
+
+	void LinkBack(CTexture* texture)
+	{
+		texture->m_lruPrev = m_lruTail;
+		texture->m_lruNext = nullptr;
+		if(m_lruTail)
+		{
+			m_lruTail->m_lruNext = texture;
+		}
+		else
+		{
+			m_lruHead = texture;
+		}
+		m_lruTail = texture;
+	}
 
-	TextureList m_textureCache;
+	TextureArray m_textures;
+	TextureIndex m_textureIndex;
+	PageTextureList m_pageTextures[PAGE_COUNT];
+	CTexture* m_lruHead = nullptr;
+	CTexture* m_lruTail = nullptr;
+	uint32 m_invalidationId = 0;
 };
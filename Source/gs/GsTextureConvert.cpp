@@ -0,0 +1,259 @@
+#include <cstring>
+#include "GsTextureConvert.h"
+#include "GsPixelFormats.h"
+#include "GsSwizzle.h"
+#include "GsVector.h"
+
+using namespace GsTextureConvert;
+
+template <typename IndexorType>
+struct IndexorStorage;
+
+template <typename Storage>
+struct IndexorStorage<CGsPixelFormats::CPixelIndexor<Storage>>
+{
+	typedef Storage Type;
+};
+
+template <typename Storage>
+static bool IsColumnAligned(uint32 texX, uint32 texY, uint32 texWidth, uint32 texHeight)
+{
+	return ((texX % Storage::COLUMNWIDTH) == 0) && ((texWidth % Storage::COLUMNWIDTH) == 0) &&
+	       ((texY % Storage::COLUMNHEIGHT) == 0) && ((texHeight % Storage::COLUMNHEIGHT) == 0);
+}
+
+template <typename Storage>
+static bool IsHalfColumnAligned(uint32 texX, uint32 texY, uint32 texWidth, uint32 texHeight)
+{
+	return IsColumnAligned<Storage>(texX * 2, texY, texWidth * 2, texHeight);
+}
+
+//Calls 'columnHandler' for every column of an area made of whole columns
+template <typename Storage, typename ColumnHandler>
+static void ForEachColumn(uint8* ram, CGsPixelFormats::CPixelIndexor<Storage>& indexor, uint32 texX, uint32 texY, uint32 texWidth, uint32 texHeight, const ColumnHandler& columnHandler)
+{
+	for(uint32 y = 0; y < texHeight; y += Storage::COLUMNHEIGHT)
+	{
+		uint32 columnParity = ((texY + y) / Storage::COLUMNHEIGHT) & 1;
+		for(uint32 x = 0; x < texWidth; x += Storage::COLUMNWIDTH)
+		{
+			unsigned int columnX = texX + x;
+			unsigned int columnY = texY + y;
+			const uint8* column = ram + indexor.GetColumnAddress(columnX, columnY);
+			columnHandler(x, y, column, columnParity);
+		}
+	}
+}
+
+template <typename Storage, typename PixelType, typename PixelConverter>
+static void ConvertPixels(uint8* dst, uint32 dstPitch, CGsPixelFormats::CPixelIndexor<Storage>& indexor, uint32 texX, uint32 texY, uint32 texWidth, uint32 texHeight, const PixelConverter& pixelConverter)
+{
+	for(uint32 y = 0; y < texHeight; y++)
+	{
+		auto rowDst = reinterpret_cast<PixelType*>(dst + (y * dstPitch));
+		for(uint32 x = 0; x < texWidth; x++)
+		{
+			rowDst[x] = pixelConverter(indexor.GetPixel(texX + x, texY + y));
+		}
+	}
+}
+
+//PSMCT16
+//-------------------------------------------------
+
+template <COLOR16_FORMAT format>
+static inline uint16 ConvertColor16(uint16 pixel)
+{
+	if(format == COLOR16_FORMAT_RGBA5551)
+	{
+		return (((pixel & 0x001F) >> 0) << 11) | //R
+		       (((pixel & 0x03E0) >> 5) << 6) |  //G
+		       (((pixel & 0x7C00) >> 10) << 1) | //B
+		       (pixel >> 15);                    //A
+	}
+	else
+	{
+		return (((pixel & 0x001F) >> 0) << 10) | //R
+		       (((pixel & 0x03E0) >> 5) << 5) |  //G
+		       (((pixel & 0x7C00) >> 10) << 0) | //B
+		       (((pixel & 0x8000) >> 15) << 15); //A
+	}
+}
+
+template <COLOR16_FORMAT format>
+static inline Vector ConvertColor16(Vector pixels)
+{
+	Vector mask = Splat16(0x1F);
+	Vector r = And(pixels, mask);
+	Vector g = And(ShiftRight16<5>(pixels), mask);
+	Vector b = And(ShiftRight16<10>(pixels), mask);
+	Vector a = ShiftRight16<15>(pixels);
+	if(format == COLOR16_FORMAT_RGBA5551)
+	{
+		return Or(Or(ShiftLeft16<11>(r), ShiftLeft16<6>(g)), Or(ShiftLeft16<1>(b), a));
+	}
+	else
+	{
+		return Or(Or(ShiftLeft16<10>(r), ShiftLeft16<5>(g)), Or(b, ShiftLeft16<15>(a)));
+	}
+}
+
+template <typename Storage, COLOR16_FORMAT format>
+static void ConvertPsm16Impl(uint8* dst, uint32 dstPitch, uint8* ram, uint32 bufPtr, uint32 bufWidth, uint32 texX, uint32 texY, uint32 texWidth, uint32 texHeight)
+{
+	CGsPixelFormats::CPixelIndexor<Storage> indexor(ram, bufPtr, bufWidth);
+
+	if(!IsColumnAligned<Storage>(texX, texY, texWidth, texHeight))
+	{
+		ConvertPixels<Storage, uint16>(dst, dstPitch, indexor, texX, texY, texWidth, texHeight,
+		                               [](uint16 pixel) { return ConvertColor16<format>(pixel); });
+		return;
+	}
+
+	ForEachColumn(ram, indexor, texX, texY, texWidth, texHeight,
+	              [&](uint32 x, uint32 y, const uint8* column, uint32) {
+		              uint8* columnDst = dst + (y * dstPitch) + (x * 2);
+		              GsSwizzle::ReadColumnPSMCT16(columnDst, dstPitch, column);
+		              for(uint32 row = 0; row < Storage::COLUMNHEIGHT; row++)
+		              {
+			              uint8* rowDst = columnDst + (row * dstPitch);
+			              Store(rowDst, ConvertColor16<format>(Load(rowDst)));
+			              Store(rowDst + 0x10, ConvertColor16<format>(Load(rowDst + 0x10)));
+		              }
+	              });
+}
+
+template <typename IndexorType>
+void GsTextureConvert::ConvertPsm16(uint8* dst, uint32 dstPitch, uint8* ram, uint32 bufPtr, uint32 bufWidth, uint32 texX, uint32 texY, uint32 texWidth, uint32 texHeight, COLOR16_FORMAT format)
+{
+	typedef typename IndexorStorage<IndexorType>::Type Storage;
+	switch(format)
+	{
+	case COLOR16_FORMAT_RGBA5551:
+		ConvertPsm16Impl<Storage, COLOR16_FORMAT_RGBA5551>(dst, dstPitch, ram, bufPtr, bufWidth, texX, texY, texWidth, texHeight);
+		break;
+	case COLOR16_FORMAT_ARGB1555:
+		ConvertPsm16Impl<Storage, COLOR16_FORMAT_ARGB1555>(dst, dstPitch, ram, bufPtr, bufWidth, texX, texY, texWidth, texHeight);
+		break;
+	}
+}
+
+//PSMT8 & PSMT4
+//-------------------------------------------------
+
+template <typename Storage>
+static void ReadIndexColumn(uint8* dst, uint32 dstPitch, const uint8* column, uint32 columnParity);
+
+template <>
+void ReadIndexColumn<CGsPixelFormats::STORAGEPSMT8>(uint8* dst, uint32 dstPitch, const uint8* column, uint32 columnParity)
+{
+	GsSwizzle::ReadColumnPSMT8(dst, dstPitch, column, columnParity);
+}
+
+template <>
+void ReadIndexColumn<CGsPixelFormats::STORAGEPSMT4>(uint8* dst, uint32 dstPitch, const uint8* column, uint32 columnParity)
+{
+	GsSwizzle::ReadColumnPSMT4(dst, dstPitch, column, columnParity);
+}
+
+template <typename IndexorType>
+void GsTextureConvert::ConvertPsm48(uint8* dst, uint32 dstPitch, uint8* ram, uint32 bufPtr, uint32 bufWidth, uint32 texX, uint32 texY, uint32 texWidth, uint32 texHeight)
+{
+	typedef typename IndexorStorage<IndexorType>::Type Storage;
+	IndexorType indexor(ram, bufPtr, bufWidth);
+
+	if(IsColumnAligned<Storage>(texX, texY, texWidth, texHeight))
+	{
+		ForEachColumn(ram, indexor, texX, texY, texWidth, texHeight,
+		              [&](uint32 x, uint32 y, const uint8* column, uint32 columnParity) {
+			              ReadIndexColumn<Storage>(dst + (y * dstPitch) + x, dstPitch, column, columnParity);
+		              });
+	}
+	else if(IsHalfColumnAligned<Storage>(texX, texY, texWidth, texHeight))
+	{
+		//16 pixels wide PSMT4 (or 8 pixels wide PSMT8) textures only cover half of a column,
+		//read the whole column and only keep the half that's needed
+		static const uint32 halfColumnWidth = Storage::COLUMNWIDTH / 2;
+		uint8 columnDst[Storage::COLUMNWIDTH * Storage::COLUMNHEIGHT];
+		for(uint32 y = 0; y < texHeight; y += Storage::COLUMNHEIGHT)
+		{
+			uint32 columnParity = ((texY + y) / Storage::COLUMNHEIGHT) & 1;
+			for(uint32 x = 0; x < texWidth; x += halfColumnWidth)
+			{
+				unsigned int columnX = texX + x;
+				unsigned int columnY = texY + y;
+				const uint8* column = ram + indexor.GetColumnAddress(columnX, columnY);
+				ReadIndexColumn<Storage>(columnDst, Storage::COLUMNWIDTH, column, columnParity);
+				for(uint32 row = 0; row < Storage::COLUMNHEIGHT; row++)
+				{
+					memcpy(dst + ((y + row) * dstPitch) + x, columnDst + (row * Storage::COLUMNWIDTH) + columnX, halfColumnWidth);
+				}
+			}
+		}
+	}
+	else
+	{
+		ConvertPixels<Storage, uint8>(dst, dstPitch, indexor, texX, texY, texWidth, texHeight,
+		                              [](uint8 pixel) { return pixel; });
+	}
+}
+
+//PSMT8H, PSMT4HL & PSMT4HH
+//-------------------------------------------------
+
+template <uint32 shiftAmount, uint32 mask>
+static inline Vector ExtractIndices(Vector upperBytes)
+{
+	static_assert((shiftAmount == 24) || ((shiftAmount == 28) && (mask == 0x0F)), "Unsupported index location.");
+	if(shiftAmount == 28)
+	{
+		return ShiftNibblesDown(upperBytes);
+	}
+	else if(mask == 0x0F)
+	{
+		return LowNibbles(upperBytes);
+	}
+	else
+	{
+		return upperBytes;
+	}
+}
+
+template <uint32 shiftAmount, uint32 mask>
+void GsTextureConvert::ConvertPsm48H(uint8* dst, uint32 dstPitch, uint8* ram, uint32 bufPtr, uint32 bufWidth, uint32 texX, uint32 texY, uint32 texWidth, uint32 texHeight)
+{
+	typedef CGsPixelFormats::STORAGEPSMCT32 Storage;
+	CGsPixelFormats::CPixelIndexor<Storage> indexor(ram, bufPtr, bufWidth);
+
+	if(!IsColumnAligned<Storage>(texX, texY, texWidth, texHeight))
+	{
+		ConvertPixels<Storage, uint8>(dst, dstPitch, indexor, texX, texY, texWidth, texHeight,
+		                              [](uint32 pixel) { return static_cast<uint8>((pixel >> shiftAmount) & mask); });
+		return;
+	}
+
+	ForEachColumn(ram, indexor, texX, texY, texWidth, texHeight,
+	              [&](uint32 x, uint32 y, const uint8* column, uint32) {
+		              Vector c0 = Load(column + 0x00);
+		              Vector c1 = Load(column + 0x10);
+		              Vector c2 = Load(column + 0x20);
+		              Vector c3 = Load(column + 0x30);
+
+		              //Same as PSMCT32 column, but only keep the upper byte of every pixel
+		              Vector row0Upper = OddHalfWords(InterleaveLo64(c0, c1), InterleaveLo64(c2, c3));
+		              Vector row1Upper = OddHalfWords(InterleaveHi64(c0, c1), InterleaveHi64(c2, c3));
+		              Vector indices = ExtractIndices<shiftAmount, mask>(OddBytes(row0Upper, row1Upper));
+
+		              uint8* columnDst = dst + (y * dstPitch) + x;
+		              StoreLow(columnDst, indices);
+		              StoreLow(columnDst + dstPitch, InterleaveHi64(indices, indices));
+	              });
+}
+
+template void GsTextureConvert::ConvertPsm16<CGsPixelFormats::CPixelIndexorPSMCT16>(uint8*, uint32, uint8*, uint32, uint32, uint32, uint32, uint32, uint32, COLOR16_FORMAT);
+template void GsTextureConvert::ConvertPsm16<CGsPixelFormats::CPixelIndexorPSMCT16S>(uint8*, uint32, uint8*, uint32, uint32, uint32, uint32, uint32, uint32, COLOR16_FORMAT);
+template void GsTextureConvert::ConvertPsm48<CGsPixelFormats::CPixelIndexorPSMT8>(uint8*, uint32, uint8*, uint32, uint32, uint32, uint32, uint32, uint32);
+template void GsTextureConvert::ConvertPsm48<CGsPixelFormats::CPixelIndexorPSMT4>(uint8*, uint32, uint8*, uint32, uint32, uint32, uint32, uint32, uint32);
+template void GsTextureConvert::ConvertPsm48H<24, 0xFF>(uint8*, uint32, uint8*, uint32, uint32, uint32, uint32, uint32, uint32);
+template void GsTextureConvert::ConvertPsm48H<24, 0x0F>(uint8*, uint32, uint8*, uint32, uint32, uint32, uint32, uint32, uint32);
+template void GsTextureConvert::ConvertPsm48H<28, 0x0F>(uint8*, uint32, uint8*, uint32, uint32, uint32, uint32, uint32, uint32);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Types.h"
+
+//Converts areas of textures stored in GS RAM to linear host texture data. Areas made of
+//whole columns are converted a column at a time, others go through the pixel indexor.
+//Those are shared by renderers that decode textures on the CPU.
+namespace GsTextureConvert
+{
+	enum COLOR16_FORMAT
+	{
+		COLOR16_FORMAT_RGBA5551, //Red in the highest bits, alpha in the lowest bit
+		COLOR16_FORMAT_ARGB1555, //Alpha in the highest bit, blue in the lowest bits
+	};
+
+	//Converts PSMCT16 or PSMCT16S pixels to 'format'
+	template <typename IndexorType>
+	void ConvertPsm16(uint8* dst, uint32 dstPitch, uint8* ram, uint32 bufPtr, uint32 bufWidth, uint32 texX, uint32 texY, uint32 texWidth, uint32 texHeight, COLOR16_FORMAT format);
+
+	//Expands PSMT8 or PSMT4 indices to one byte per pixel
+	template <typename IndexorType>
+	void ConvertPsm48(uint8* dst, uint32 dstPitch, uint8* ram, uint32 bufPtr, uint32 bufWidth, uint32 texX, uint32 texY, uint32 texWidth, uint32 texHeight);
+
+	//Extracts PSMT8H, PSMT4HL or PSMT4HH indices, stored in the upper bits of 32 bits pixels, to one byte per pixel
+	template <uint32 shiftAmount, uint32 mask>
+	void ConvertPsm48H(uint8* dst, uint32 dstPitch, uint8* ram, uint32 bufPtr, uint32 bufWidth, uint32 texX, uint32 texY, uint32 texWidth, uint32 texHeight);
+}
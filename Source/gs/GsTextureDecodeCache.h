@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include "xxhash.h"
+#include "GSHandler.h"
+#include "GsCachedArea.h"
+
+//Second level texture cache, indexed by the contents of the GS RAM area a texture was
+//decoded from instead of its location. Lets identical data uploaded at another address
+//reuse a texture that's already been decoded. Textures stored here must not be modified
+//anymore since other cache entries might be referencing them, unless they're removed first.
+//Size is bounded by entry count and by the amount of GPU memory used by the textures.
+template <typename TextureHandleType>
+class CGsTextureDecodeCache
+{
+public:
+	struct KEY
+	{
+		uint64 hash = 0;
+		uint64 layout = 0;
+
+		bool operator==(const KEY& rhs) const
+		{
+			return (hash == rhs.hash) && (layout == rhs.layout);
+		}
+	};
+
+	enum
+	{
+		DEFAULT_CACHE_SIZE = 256,
+		DEFAULT_MAX_MEMORY_SIZE = 128 * 1024 * 1024,
+	};
+
+	CGsTextureDecodeCache(uint32 cacheSize = DEFAULT_CACHE_SIZE, uint32 maxMemorySize = DEFAULT_MAX_MEMORY_SIZE)
+	    : m_cacheSize(std::max<uint32>(cacheSize, 1))
+	    , m_maxMemorySize(maxMemorySize)
+	{
+	}
+
+	static KEY MakeKey(const uint8* ram, const CGSHandler::TEX0& tex0, const CGsCachedArea& cachedArea)
+	{
+		//Only buffer width, pixel format and texture dimensions have an effect on decoding,
+		//CLUT is applied separately.
+		static const uint64 TEX0_LAYOUT_MASK = 0x00000003FFFFC000ULL;
+
+		//Area can go past the end of RAM, indexors wrap around in that case
+		uint32 areaStart = tex0.GetBufPtr();
+		uint32 areaSize = std::min<uint32>(cachedArea.GetSize(), CGSHandler::RAMSIZE);
+		uint32 firstPartSize = std::min<uint32>(areaSize, CGSHandler::RAMSIZE - areaStart);
+
+		KEY key;
+		key.hash = XXH3_64bits(ram + areaStart, firstPartSize);
+		if(firstPartSize != areaSize)
+		{
+			key.hash = XXH3_64bits_withSeed(ram, areaSize - firstPartSize, key.hash);
+		}
+		key.layout = static_cast<uint64>(tex0) & TEX0_LAYOUT_MASK;
+		return key;
+	}
+
+	TextureHandleType Search(const KEY& key)
+	{
+		auto entryIterator = m_entryIndex.find(key);
+		if(entryIterator == m_entryIndex.end()) return TextureHandleType();
+
+		m_entries.splice(m_entries.begin(), m_entries, entryIterator->second);
+		return entryIterator->second->textureHandle;
+	}
+
+	bool Contains(const TextureHandleType& textureHandle) const
+	{
+		return m_handleIndex.find(textureHandle.get()) != m_handleIndex.end();
+	}
+
+	//'memorySize' is the amount of GPU memory used by the texture
+	void Insert(const KEY& key, TextureHandleType textureHandle, uint32 memorySize)
+	{
+		auto entryIterator = m_entryIndex.find(key);
+		if(entryIterator != m_entryIndex.end())
+		{
+			Erase(entryIterator->second);
+		}
+		Remove(textureHandle);
+
+		while(!m_entries.empty() &&
+		      ((m_entries.size() >= m_cacheSize) || ((m_memorySize + memorySize) > m_maxMemorySize)))
+		{
+			Erase(std::prev(m_entries.end()));
+		}
+
+		m_entries.push_front(ENTRY{key, std::move(textureHandle), memorySize});
+		m_entryIndex[key] = m_entries.begin();
+		m_handleIndex[m_entries.front().textureHandle.get()] = m_entries.begin();
+		m_memorySize += memorySize;
+	}
+
+	void Remove(const TextureHandleType& textureHandle)
+	{
+		auto handleIterator = m_handleIndex.find(textureHandle.get());
+		if(handleIterator == m_handleIndex.end()) return;
+		Erase(handleIterator->second);
+	}
+
+	void Flush()
+	{
+		m_entryIndex.clear();
+		m_handleIndex.clear();
+		m_entries.clear();
+		m_memorySize = 0;
+	}
+
+	uint32 GetMemorySize() const
+	{
+		return m_memorySize;
+	}
+
+private:
+	struct KeyHasher
+	{
+		size_t operator()(const KEY& key) const
+		{
+			return static_cast<size_t>(key.hash ^ (key.layout * 0x9E3779B97F4A7C15ULL));
+		}
+	};
+
+	struct ENTRY
+	{
+		KEY key;
+		TextureHandleType textureHandle;
+		uint32 memorySize = 0;
+	};
+
+	typedef std::list<ENTRY> EntryList;
+	typedef std::unordered_map<KEY, typename EntryList::iterator, KeyHasher> EntryIndex;
+	//Indexed by the object the handle points to, holding a copy of the handle would add a reference
+	typedef std::unordered_map<const void*, typename EntryList::iterator> HandleIndex;
+
+	void Erase(typename EntryList::iterator entryIterator)
+	{
+		assert(m_memorySize >= entryIterator->memorySize);
+		m_memorySize -= entryIterator->memorySize;
+		m_entryIndex.erase(entryIterator->key);
+		m_handleIndex.erase(entryIterator->textureHandle.get());
+		m_entries.erase(entryIterator);
+	}
+
+	uint32 m_cacheSize = DEFAULT_CACHE_SIZE;
+	uint32 m_maxMemorySize = DEFAULT_MAX_MEMORY_SIZE;
+	uint32 m_memorySize = 0;
+	EntryList m_entries;
+	EntryIndex m_entryIndex;
+	HandleIndex m_handleIndex;
+};
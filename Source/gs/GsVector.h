@@ -0,0 +1,286 @@
+#pragma once
+
+#include <cstring>
+#include "Types.h"
+#include "SimdDefs.h"
+
+//128-bit vector operations used by GS memory swizzling and texture conversion code,
+//each platform provides those with its own instructions.
+//Only meant to be included by translation units, functions are static.
+
+#if defined(FRAMEWORK_SIMD_USE_SSE)
+
+#include <emmintrin.h>
+
+typedef __m128i Vector;
+
+static inline Vector Load(const uint8* src)
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+static inline void Store(uint8* dst, Vector value)
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+}
+
+//Stores the lower 8 bytes
+static inline void StoreLow(uint8* dst, Vector value)
+{
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), value);
+}
+
+static inline Vector Splat16(uint16 value)
+{
+	return _mm_set1_epi16(static_cast<short>(value));
+}
+
+template <int Amount>
+static inline Vector ShiftLeft16(Vector a)
+{
+	return _mm_slli_epi16(a, Amount);
+}
+
+template <int Amount>
+static inline Vector ShiftRight16(Vector a)
+{
+	return _mm_srli_epi16(a, Amount);
+}
+
+static inline bool IsZero(Vector value)
+{
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(value, _mm_setzero_si128())) == 0xFFFF;
+}
+
+// clang-format off
+static inline Vector And(Vector a, Vector b)                 { return _mm_and_si128(a, b); }
+static inline Vector Or(Vector a, Vector b)                  { return _mm_or_si128(a, b); }
+static inline Vector Xor(Vector a, Vector b)                 { return _mm_xor_si128(a, b); }
+static inline Vector InterleaveLo8(Vector a, Vector b)       { return _mm_unpacklo_epi8(a, b); }
+static inline Vector InterleaveHi8(Vector a, Vector b)       { return _mm_unpackhi_epi8(a, b); }
+static inline Vector InterleaveLo16(Vector a, Vector b)      { return _mm_unpacklo_epi16(a, b); }
+static inline Vector InterleaveHi16(Vector a, Vector b)      { return _mm_unpackhi_epi16(a, b); }
+static inline Vector InterleaveLo64(Vector a, Vector b)      { return _mm_unpacklo_epi64(a, b); }
+static inline Vector InterleaveHi64(Vector a, Vector b)      { return _mm_unpackhi_epi64(a, b); }
+static inline Vector EvenBytes(Vector a, Vector b)           { return _mm_packus_epi16(_mm_and_si128(a, _mm_set1_epi16(0xFF)), _mm_and_si128(b, _mm_set1_epi16(0xFF))); }
+static inline Vector OddBytes(Vector a, Vector b)            { return _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)); }
+static inline Vector EvenHalfWords(Vector a, Vector b)       { return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16)); }
+static inline Vector OddHalfWords(Vector a, Vector b)        { return _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16)); }
+static inline Vector SwapWordPairs(Vector a)                 { return _mm_shuffle_epi32(a, _MM_SHUFFLE(2, 3, 0, 1)); }
+static inline Vector SwapHalfWordPairs(Vector a)             { return _mm_or_si128(_mm_slli_epi32(a, 16), _mm_srli_epi32(a, 16)); }
+static inline Vector LowNibbles(Vector a)                    { return _mm_and_si128(a, _mm_set1_epi8(0x0F)); }
+static inline Vector HighNibbles(Vector a)                   { return _mm_and_si128(a, _mm_set1_epi8(static_cast<char>(0xF0))); }
+static inline Vector ShiftNibblesUp(Vector a)                { return _mm_and_si128(_mm_slli_epi16(a, 4), _mm_set1_epi8(static_cast<char>(0xF0))); }
+static inline Vector ShiftNibblesDown(Vector a)              { return _mm_and_si128(_mm_srli_epi16(a, 4), _mm_set1_epi8(0x0F)); }
+// clang-format on
+
+#elif defined(FRAMEWORK_SIMD_USE_NEON)
+
+#include <arm_neon.h>
+
+typedef uint8x16_t Vector;
+
+static inline Vector Load(const uint8* src)
+{
+	return vld1q_u8(src);
+}
+
+static inline void Store(uint8* dst, Vector value)
+{
+	vst1q_u8(dst, value);
+}
+
+//Stores the lower 8 bytes
+static inline void StoreLow(uint8* dst, Vector value)
+{
+	vst1_u8(dst, vget_low_u8(value));
+}
+
+static inline Vector Splat16(uint16 value)
+{
+	return vreinterpretq_u8_u16(vdupq_n_u16(value));
+}
+
+template <int Amount>
+static inline Vector ShiftLeft16(Vector a)
+{
+	return vreinterpretq_u8_u16(vshlq_n_u16(vreinterpretq_u16_u8(a), Amount));
+}
+
+template <int Amount>
+static inline Vector ShiftRight16(Vector a)
+{
+	return vreinterpretq_u8_u16(vshrq_n_u16(vreinterpretq_u16_u8(a), Amount));
+}
+
+static inline bool IsZero(Vector value)
+{
+	uint64x2_t value64 = vreinterpretq_u64_u8(value);
+	return (vgetq_lane_u64(value64, 0) | vgetq_lane_u64(value64, 1)) == 0;
+}
+
+static inline Vector InterleaveLo16(Vector a, Vector b)
+{
+	return vreinterpretq_u8_u16(vzipq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)).val[0]);
+}
+
+static inline Vector InterleaveHi16(Vector a, Vector b)
+{
+	return vreinterpretq_u8_u16(vzipq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)).val[1]);
+}
+
+static inline Vector EvenHalfWords(Vector a, Vector b)
+{
+	return vreinterpretq_u8_u16(vuzpq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)).val[0]);
+}
+
+static inline Vector OddHalfWords(Vector a, Vector b)
+{
+	return vreinterpretq_u8_u16(vuzpq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)).val[1]);
+}
+
+// clang-format off
+static inline Vector And(Vector a, Vector b)                 { return vandq_u8(a, b); }
+static inline Vector Or(Vector a, Vector b)                  { return vorrq_u8(a, b); }
+static inline Vector Xor(Vector a, Vector b)                 { return veorq_u8(a, b); }
+static inline Vector InterleaveLo8(Vector a, Vector b)       { return vzipq_u8(a, b).val[0]; }
+static inline Vector InterleaveHi8(Vector a, Vector b)       { return vzipq_u8(a, b).val[1]; }
+static inline Vector InterleaveLo64(Vector a, Vector b)      { return vcombine_u8(vget_low_u8(a), vget_low_u8(b)); }
+static inline Vector InterleaveHi64(Vector a, Vector b)      { return vcombine_u8(vget_high_u8(a), vget_high_u8(b)); }
+static inline Vector EvenBytes(Vector a, Vector b)           { return vuzpq_u8(a, b).val[0]; }
+static inline Vector OddBytes(Vector a, Vector b)            { return vuzpq_u8(a, b).val[1]; }
+static inline Vector SwapWordPairs(Vector a)                 { return vreinterpretq_u8_u32(vrev64q_u32(vreinterpretq_u32_u8(a))); }
+static inline Vector SwapHalfWordPairs(Vector a)             { return vreinterpretq_u8_u16(vrev32q_u16(vreinterpretq_u16_u8(a))); }
+static inline Vector LowNibbles(Vector a)                    { return vandq_u8(a, vdupq_n_u8(0x0F)); }
+static inline Vector HighNibbles(Vector a)                   { return vandq_u8(a, vdupq_n_u8(0xF0)); }
+static inline Vector ShiftNibblesUp(Vector a)                { return vshlq_n_u8(a, 4); }
+static inline Vector ShiftNibblesDown(Vector a)              { return vshrq_n_u8(a, 4); }
+// clang-format on
+
+#else
+
+//Plain implementation of the vector operations for platforms without SIMD support
+struct Vector
+{
+	uint8 bytes[16];
+};
+
+static inline Vector Load(const uint8* src)
+{
+	Vector result;
+	memcpy(result.bytes, src, 16);
+	return result;
+}
+
+static inline void Store(uint8* dst, const Vector& value)
+{
+	memcpy(dst, value.bytes, 16);
+}
+
+//Stores the lower 8 bytes
+static inline void StoreLow(uint8* dst, const Vector& value)
+{
+	memcpy(dst, value.bytes, 8);
+}
+
+template <typename Operation>
+static inline Vector Transform16(const Vector& a, const Operation& operation)
+{
+	Vector result;
+	for(unsigned int i = 0; i < 16; i += 2)
+	{
+		uint16 element = 0;
+		memcpy(&element, a.bytes + i, 2);
+		element = operation(element);
+		memcpy(result.bytes + i, &element, 2);
+	}
+	return result;
+}
+
+static inline Vector Splat16(uint16 value)
+{
+	return Transform16(Vector(), [value](uint16) { return value; });
+}
+
+template <int Amount>
+static inline Vector ShiftLeft16(const Vector& a)
+{
+	return Transform16(a, [](uint16 v) { return static_cast<uint16>(v << Amount); });
+}
+
+template <int Amount>
+static inline Vector ShiftRight16(const Vector& a)
+{
+	return Transform16(a, [](uint16 v) { return static_cast<uint16>(v >> Amount); });
+}
+
+static inline bool IsZero(const Vector& value)
+{
+	uint8 result = 0;
+	for(unsigned int i = 0; i < 16; i++)
+	{
+		result |= value.bytes[i];
+	}
+	return result == 0;
+}
+
+template <uint32 ElementSize, bool High>
+static inline Vector Interleave(const Vector& a, const Vector& b)
+{
+	Vector result;
+	uint32 srcBase = High ? 8 : 0;
+	for(unsigned int i = 0; i < 8; i += ElementSize)
+	{
+		memcpy(result.bytes + (i * 2), a.bytes + srcBase + i, ElementSize);
+		memcpy(result.bytes + (i * 2) + ElementSize, b.bytes + srcBase + i, ElementSize);
+	}
+	return result;
+}
+
+template <uint32 ElementSize, bool Odd>
+static inline Vector Deinterleave(const Vector& a, const Vector& b)
+{
+	Vector result;
+	uint32 srcBase = Odd ? ElementSize : 0;
+	for(unsigned int i = 0; i < 8; i += ElementSize)
+	{
+		memcpy(result.bytes + i, a.bytes + (i * 2) + srcBase, ElementSize);
+		memcpy(result.bytes + 8 + i, b.bytes + (i * 2) + srcBase, ElementSize);
+	}
+	return result;
+}
+
+template <typename Operation>
+static inline Vector Transform(const Vector& a, const Operation& operation)
+{
+	Vector result;
+	for(unsigned int i = 0; i < 16; i++)
+	{
+		result.bytes[i] = operation(i, a);
+	}
+	return result;
+}
+
+// clang-format off
+static inline Vector And(const Vector& a, const Vector& b)            { return Transform(a, [&](unsigned int i, const Vector& v) { return static_cast<uint8>(v.bytes[i] & b.bytes[i]); }); }
+static inline Vector Or(const Vector& a, const Vector& b)             { return Transform(a, [&](unsigned int i, const Vector& v) { return static_cast<uint8>(v.bytes[i] | b.bytes[i]); }); }
+static inline Vector Xor(const Vector& a, const Vector& b)            { return Transform(a, [&](unsigned int i, const Vector& v) { return static_cast<uint8>(v.bytes[i] ^ b.bytes[i]); }); }
+static inline Vector InterleaveLo8(const Vector& a, const Vector& b)  { return Interleave<1, false>(a, b); }
+static inline Vector InterleaveHi8(const Vector& a, const Vector& b)  { return Interleave<1, true>(a, b); }
+static inline Vector InterleaveLo16(const Vector& a, const Vector& b) { return Interleave<2, false>(a, b); }
+static inline Vector InterleaveHi16(const Vector& a, const Vector& b) { return Interleave<2, true>(a, b); }
+static inline Vector InterleaveLo64(const Vector& a, const Vector& b) { return Interleave<8, false>(a, b); }
+static inline Vector InterleaveHi64(const Vector& a, const Vector& b) { return Interleave<8, true>(a, b); }
+static inline Vector EvenBytes(const Vector& a, const Vector& b)      { return Deinterleave<1, false>(a, b); }
+static inline Vector OddBytes(const Vector& a, const Vector& b)       { return Deinterleave<1, true>(a, b); }
+static inline Vector EvenHalfWords(const Vector& a, const Vector& b)  { return Deinterleave<2, false>(a, b); }
+static inline Vector OddHalfWords(const Vector& a, const Vector& b)   { return Deinterleave<2, true>(a, b); }
+static inline Vector SwapWordPairs(const Vector& a)                   { return Transform(a, [](unsigned int i, const Vector& v) { return v.bytes[i ^ 4]; }); }
+static inline Vector SwapHalfWordPairs(const Vector& a)               { return Transform(a, [](unsigned int i, const Vector& v) { return v.bytes[i ^ 2]; }); }
+static inline Vector LowNibbles(const Vector& a)                      { return Transform(a, [](unsigned int i, const Vector& v) { return static_cast<uint8>(v.bytes[i] & 0x0F); }); }
+static inline Vector HighNibbles(const Vector& a)                     { return Transform(a, [](unsigned int i, const Vector& v) { return static_cast<uint8>(v.bytes[i] & 0xF0); }); }
+static inline Vector ShiftNibblesUp(const Vector& a)                  { return Transform(a, [](unsigned int i, const Vector& v) { return static_cast<uint8>(v.bytes[i] << 4); }); }
+static inline Vector ShiftNibblesDown(const Vector& a)                { return Transform(a, [](unsigned int i, const Vector& v) { return static_cast<uint8>(v.bytes[i] >> 4); }); }
+// clang-format on
+
+#endif
@@ -84,7 +84,7 @@ static uint8 Uint8ToBcd(uint8 input)
 
 uint32 CCdvdman::CdReadClockDirect(uint8* clockBuffer)
 {
-	auto currentTime = time(0);
+	auto currentTime = m_hostTimeSource ? m_hostTimeSource() : time(0);
 	auto localTime = localtime(&currentTime);
 	clockBuffer[0] = 0;                                                        //Status (0 = ok, anything else = error)
 	clockBuffer[1] = Uint8ToBcd(static_cast<uint8>(localTime->tm_sec));        //Seconds
@@ -424,6 +424,10 @@ void CCdvdman::CountTicks(uint32 ticks)
 			}
 			m_bios.ReleaseWaitCdSync();
 			m_status = CDVD_STATUS_PAUSED;
+			if(m_commandCompletedHandler)
+			{
+				m_commandCompletedHandler(m_pendingCommand);
+			}
 			m_pendingCommand = COMMAND_NONE;
 		}
 	}
@@ -434,6 +438,16 @@ void CCdvdman::SetOpticalMedia(COpticalMedia* opticalMedia)
 	m_opticalMedia = opticalMedia;
 }
 
+void CCdvdman::SetHostTimeSource(HostTimeSource hostTimeSource)
+{
+	m_hostTimeSource = std::move(hostTimeSource);
+}
+
+void CCdvdman::SetCommandCompletedHandler(CommandCompletedHandler commandCompletedHandler)
+{
+	m_commandCompletedHandler = std::move(commandCompletedHandler);
+}
+
 uint32 CCdvdman::CdInit(uint32 mode)
 {
 	CLog::GetInstance().Print(LOG_NAME, FUNCTION_CDINIT "(mode = %d);\r\n", mode);
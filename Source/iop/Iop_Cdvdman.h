@@ -1,5 +1,7 @@
 #pragma once
 
+#include <ctime>
+#include <functional>
 #include "Iop_Module.h"
 #include "../OpticalMedia.h"
 #include "zip/ZipArchiveWriter.h"
@@ -42,6 +44,9 @@ namespace Iop
 			uint8 date[8];
 		};
 
+		typedef std::function<time_t()> HostTimeSource;
+		typedef std::function<void(uint32)> CommandCompletedHandler;
+
 		CCdvdman(CIopBios&, uint8*);
 		virtual ~CCdvdman() = default;
 
@@ -52,6 +57,10 @@ namespace Iop
 		void CountTicks(uint32);
 		void SetOpticalMedia(COpticalMedia*);
 
+		//Allows the clock to be provided and command completions to be observed (ie.: to record or replay a session)
+		void SetHostTimeSource(HostTimeSource);
+		void SetCommandCompletedHandler(CommandCompletedHandler);
+
 		void LoadState(Framework::CZipArchiveReader&) override;
 		void SaveState(Framework::CZipArchiveWriter&) const override;
 
@@ -114,6 +123,9 @@ namespace Iop
 		uint32 m_streamBufferSize = 0;
 		COMMAND m_pendingCommand = COMMAND_NONE;
 		int32 m_pendingCommandDelay = 0;
+
+		HostTimeSource m_hostTimeSource;
+		CommandCompletedHandler m_commandCompletedHandler;
 	};
 
 	typedef std::shared_ptr<CCdvdman> CdvdmanPtr;
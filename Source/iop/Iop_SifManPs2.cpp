@@ -85,8 +85,7 @@ uint32 CSifManPs2::SifSetDma(uint32 structAddr, uint32 count)
 		}
 		else
 		{
-			uint8* dst = m_eeRam + dstAddr;
-			memcpy(dst, src, dmaReg.size);
+			m_sif.WriteEeRam(dstAddr, src, dmaReg.size);
 		}
 	}
 
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include "StatsManager.h"
 #include "string_format.h"
 #include "PS2VM.h"
@@ -12,6 +13,46 @@ void CStatsManager::OnNewFrame(CPS2VM* virtualMachine)
 		m_cpuUtilisation.eeIdleTicks += cpuUtilisation.eeIdleTicks;
 		m_cpuUtilisation.iopTotalTicks += cpuUtilisation.iopTotalTicks;
 		m_cpuUtilisation.iopIdleTicks += cpuUtilisation.iopIdleTicks;
+		m_cpuUtilisation.sliceCount += cpuUtilisation.sliceCount;
+		m_cpuUtilisation.tickStepCount += cpuUtilisation.tickStepCount;
+		m_cpuUtilisation.eventCount += cpuUtilisation.eventCount;
+		m_cpuUtilisation.iopSyncCount += cpuUtilisation.iopSyncCount;
+		m_cpuUtilisation.iopSyncTicks += cpuUtilisation.iopSyncTicks;
+		m_cpuUtilisation.maxIopSyncTicks = std::max(m_cpuUtilisation.maxIopSyncTicks, cpuUtilisation.maxIopSyncTicks);
+
+		auto blockCompileStats = virtualMachine->GetBlockCompileStats();
+		m_blockCompileStats.compiledBlockCount += blockCompileStats.compiledBlockCount;
+		m_blockCompileStats.backgroundCompiledBlockCount += blockCompileStats.backgroundCompiledBlockCount;
+		m_blockCompileStats.superBlockCount += blockCompileStats.superBlockCount;
+		m_blockCompileStats.compileTime += blockCompileStats.compileTime;
+		m_blockCompileStats.maxCompileTime = std::max(m_blockCompileStats.maxCompileTime, blockCompileStats.maxCompileTime);
+		m_blockCompileStats.backgroundLatency += blockCompileStats.backgroundLatency;
+		m_blockCompileStats.maxBackgroundLatency = std::max(m_blockCompileStats.maxBackgroundLatency, blockCompileStats.maxBackgroundLatency);
+		m_blockCompileStats.queueDepth = blockCompileStats.queueDepth;
+		m_blockCompileStats.maxQueueDepth = std::max(m_blockCompileStats.maxQueueDepth, blockCompileStats.maxQueueDepth);
+		m_blockCompileStats.smcFaultCount += blockCompileStats.smcFaultCount;
+		m_blockCompileStats.smcGuardedPageCount = blockCompileStats.smcGuardedPageCount;
+		m_blockCompileStats.smcGuardMissCount += blockCompileStats.smcGuardMissCount;
+		m_blockCompileStats.fastMemoryFaultCount += blockCompileStats.fastMemoryFaultCount;
+		m_blockCompileStats.constantFoldedInstructionCount += blockCompileStats.constantFoldedInstructionCount;
+		m_blockCompileStats.constantResolvedAccessCount += blockCompileStats.constantResolvedAccessCount;
+		m_blockCompileStats.constantHandlerCallCount += blockCompileStats.constantHandlerCallCount;
+
+		if(auto gs = virtualMachine->GetGSHandler())
+		{
+			auto readbackStats = gs->GetReadbackStats();
+			m_readbackStats.readbackCount += readbackStats.readbackCount;
+			m_readbackStats.stallCount += readbackStats.stallCount;
+			m_readbackStats.stallTime += readbackStats.stallTime;
+
+			auto textureCacheStats = gs->TakeTextureCacheStats();
+			m_textureCacheStats.decodeLookupCount += textureCacheStats.decodeLookupCount;
+			m_textureCacheStats.decodeHitCount += textureCacheStats.decodeHitCount;
+		}
+
+		m_frameDurations.push_back(virtualMachine->GetLastFrameDuration());
+		m_emulatedTime += virtualMachine->GetNominalFrameDuration();
+		m_elapsedTime += virtualMachine->GetLastFrameDuration();
 	}
 
 #ifdef PROFILE
@@ -64,6 +105,44 @@ CPS2VM::CPU_UTILISATION_INFO CStatsManager::GetCpuUtilisationInfo()
 	return m_cpuUtilisation;
 }
 
+CMipsExecutor::BLOCK_COMPILE_STATS CStatsManager::GetBlockCompileStats()
+{
+	std::lock_guard<std::mutex> statsLock(m_statsMutex);
+	return m_blockCompileStats;
+}
+
+CGSHandler::READBACK_STATS CStatsManager::GetReadbackStats()
+{
+	std::lock_guard<std::mutex> statsLock(m_statsMutex);
+	return m_readbackStats;
+}
+
+CGSHandler::TEXTURE_CACHE_STATS CStatsManager::GetTextureCacheStats()
+{
+	std::lock_guard<std::mutex> statsLock(m_statsMutex);
+	return m_textureCacheStats;
+}
+
+float CStatsManager::GetSpeedMultiplier()
+{
+	std::lock_guard<std::mutex> statsLock(m_statsMutex);
+	if(m_elapsedTime == 0) return 0;
+	return static_cast<float>(static_cast<double>(m_emulatedTime) / static_cast<double>(m_elapsedTime));
+}
+
+uint32 CStatsManager::GetFrameDurationPercentile(float ratio)
+{
+	std::vector<uint32> frameDurations;
+	{
+		std::lock_guard<std::mutex> statsLock(m_statsMutex);
+		frameDurations = m_frameDurations;
+	}
+	if(frameDurations.empty()) return 0;
+	size_t index = std::min<size_t>(static_cast<size_t>(ratio * frameDurations.size()), frameDurations.size() - 1);
+	std::nth_element(frameDurations.begin(), frameDurations.begin() + index, frameDurations.end());
+	return frameDurations[index];
+}
+
 #ifdef PROFILE
 
 std::string CStatsManager::GetProfilingInfo()
@@ -105,6 +184,54 @@ std::string CStatsManager::GetProfilingInfo()
 
 		result += string_format("EE Usage:  %6.2f%%\r\n", eeUsageRatio);
 		result += string_format("IOP Usage: %6.2f%%\r\n", iopUsageRatio);
+
+		uint32 frames = std::max<uint32>(m_frames, 1);
+		result += string_format("Slices:    %d/frame (%d with fixed steps), %d events/frame\r\n",
+		                        m_cpuUtilisation.sliceCount / frames, m_cpuUtilisation.tickStepCount / frames,
+		                        m_cpuUtilisation.eventCount / frames);
+		int32 avgIopSyncTicks = (m_cpuUtilisation.iopSyncCount != 0) ? (m_cpuUtilisation.iopSyncTicks / m_cpuUtilisation.iopSyncCount) : 0;
+		result += string_format("IOP Sync:  %d/frame, %d ticks avg (max %d)\r\n",
+		                        m_cpuUtilisation.iopSyncCount / frames, avgIopSyncTicks, m_cpuUtilisation.maxIopSyncTicks);
+	}
+
+	{
+		const auto& compileStats = m_blockCompileStats;
+		uint32 backgroundCount = compileStats.backgroundCompiledBlockCount;
+		float compileMs = static_cast<double>(compileStats.compileTime) / static_cast<double>(timeScale);
+		float maxCompileMs = static_cast<double>(compileStats.maxCompileTime) / static_cast<double>(timeScale);
+		float avgLatencyMs = (backgroundCount != 0) ? static_cast<double>(compileStats.backgroundLatency) / static_cast<double>(backgroundCount * timeScale) : 0;
+		float maxLatencyMs = static_cast<double>(compileStats.maxBackgroundLatency) / static_cast<double>(timeScale);
+
+		result += string_format("JIT Blocks: %d (+%d bg, %d super)\r\n", compileStats.compiledBlockCount, backgroundCount, compileStats.superBlockCount);
+		result += string_format("JIT Stall:  %6.2fms (max %6.2fms)\r\n", compileMs, maxCompileMs);
+		result += string_format("JIT Queue:  %d (max %d), latency %6.2fms (max %6.2fms)\r\n",
+		                        compileStats.queueDepth, compileStats.maxQueueDepth, avgLatencyMs, maxLatencyMs);
+		result += string_format("JIT SMC:    %d faults, %d guarded pages, %d guard misses\r\n",
+		                        compileStats.smcFaultCount, compileStats.smcGuardedPageCount, compileStats.smcGuardMissCount);
+		result += string_format("JIT Fastmem: %d emulated accesses\r\n", compileStats.fastMemoryFaultCount);
+		result += string_format("JIT Consts: %d folded instructions, %d resolved accesses, %d handler calls\r\n",
+		                        compileStats.constantFoldedInstructionCount, compileStats.constantResolvedAccessCount,
+		                        compileStats.constantHandlerCallCount);
+	}
+
+	{
+		float stallMs = static_cast<double>(m_readbackStats.stallTime) / static_cast<double>(timeScale);
+		result += string_format("GS Readback: %d transfers, %d stalls (%6.2fms)\r\n",
+		                        m_readbackStats.readbackCount, m_readbackStats.stallCount, stallMs);
+
+		uint32 frames = std::max<uint32>(m_frames, 1);
+		uint32 decodeLookupCount = m_textureCacheStats.decodeLookupCount;
+		uint32 decodeHitCount = m_textureCacheStats.decodeHitCount;
+		float decodeHitRatio = (decodeLookupCount != 0) ? static_cast<float>(decodeHitCount) / static_cast<float>(decodeLookupCount) : 0;
+		result += string_format("GS Decode Cache: %d/%d hits/frame (%6.2f%%)\r\n",
+		                        decodeHitCount / frames, decodeLookupCount / frames, decodeHitRatio * 100.f);
+	}
+
+	{
+		float p50Ms = static_cast<float>(GetFrameDurationPercentile(0.50f)) / 1000.f;
+		float p99Ms = static_cast<float>(GetFrameDurationPercentile(0.99f)) / 1000.f;
+		result += string_format("Frame Time: p50 %6.2fms, p99 %6.2fms\r\n", p50Ms, p99Ms);
+		result += string_format("Speed:      %6.2fx\r\n", GetSpeedMultiplier());
 	}
 
 	return result;
@@ -118,6 +245,12 @@ void CStatsManager::ClearStats()
 	m_frames = 0;
 	m_drawCalls = 0;
 	m_cpuUtilisation = CPS2VM::CPU_UTILISATION_INFO();
+	m_blockCompileStats = CMipsExecutor::BLOCK_COMPILE_STATS();
+	m_readbackStats = CGSHandler::READBACK_STATS();
+	m_textureCacheStats = CGSHandler::TEXTURE_CACHE_STATS();
+	m_frameDurations.clear();
+	m_emulatedTime = 0;
+	m_elapsedTime = 0;
 #ifdef PROFILE
 	for(auto& zonePair : m_profilerZones)
 	{
@@ -2,6 +2,7 @@
 
 #include <mutex>
 #include <map>
+#include <vector>
 #include "Types.h"
 #include "Singleton.h"
 #include "Profiler.h"
@@ -18,6 +19,13 @@ public:
 	uint32 GetFrames();
 	uint32 GetDrawCalls();
 	CPS2VM::CPU_UTILISATION_INFO GetCpuUtilisationInfo();
+	CMipsExecutor::BLOCK_COMPILE_STATS GetBlockCompileStats();
+	CGSHandler::READBACK_STATS GetReadbackStats();
+	CGSHandler::TEXTURE_CACHE_STATS GetTextureCacheStats();
+	//Returns the frame duration (in microseconds) below which the given ratio of frames fall
+	uint32 GetFrameDurationPercentile(float);
+	//Ratio of emulated time over elapsed time
+	float GetSpeedMultiplier();
 #ifdef PROFILE
 	std::string GetProfilingInfo();
 #endif
@@ -31,6 +39,12 @@ private:
 	uint32 m_drawCalls = 0;
 
 	CPS2VM::CPU_UTILISATION_INFO m_cpuUtilisation;
+	CMipsExecutor::BLOCK_COMPILE_STATS m_blockCompileStats;
+	CGSHandler::READBACK_STATS m_readbackStats;
+	CGSHandler::TEXTURE_CACHE_STATS m_textureCacheStats;
+	std::vector<uint32> m_frameDurations;
+	uint64 m_emulatedTime = 0;
+	uint64 m_elapsedTime = 0;
 
 #ifdef PROFILE
 	struct ZONEINFO
@@ -19,10 +19,15 @@ void CJUnitTestReportWriter::ReportTestEntry(const std::string& testName, const
 {
 	auto testCaseNode = std::make_unique<Framework::Xml::CNode>("testcase", true);
 	testCaseNode->InsertAttribute("name", testName.c_str());
+	testCaseNode->InsertAttribute("time", string_format("%.3f", result.duration).c_str());
 
 	if(!result.succeeded)
 	{
 		std::string failureDetails;
+		if(result.timedOut)
+		{
+			failureDetails += "Test timed out.\r\n\r\n";
+		}
 		for(const auto& lineDiff : result.lineDiffs)
 		{
 			auto failureLine = string_format(
@@ -35,6 +40,7 @@ void CJUnitTestReportWriter::ReportTestEntry(const std::string& testName, const
 		auto resultNode = std::make_unique<Framework::Xml::CNode>("failure", true);
 		resultNode->InsertTextNode(failureDetails.c_str());
 		testCaseNode->InsertNode(std::move(resultNode));
+		m_failureCount++;
 	}
 
 	m_testSuiteNode->InsertNode(std::move(testCaseNode));
@@ -45,6 +51,7 @@ void CJUnitTestReportWriter::ReportTestEntry(const std::string& testName, const
 void CJUnitTestReportWriter::Write(const fs::path& reportPath)
 {
 	m_testSuiteNode->InsertAttribute("tests", string_format("%d", m_testCount).c_str());
+	m_testSuiteNode->InsertAttribute("failures", string_format("%d", m_failureCount).c_str());
 	auto testOutputFileStream = Framework::CreateOutputStdStream(reportPath.native());
 	Framework::Xml::CWriter::WriteDocument(testOutputFileStream, m_reportNode.get());
 }
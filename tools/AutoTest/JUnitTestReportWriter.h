@@ -18,4 +18,5 @@ private:
 	NodePtr m_reportNode;
 	Framework::Xml::CNode* m_testSuiteNode = nullptr;
 	unsigned int m_testCount = 0;
+	unsigned int m_failureCount = 0;
 };
@@ -1,3 +1,6 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include "PS2VM.h"
 #include "filesystem_def.h"
 #include "StdStream.h"
@@ -15,6 +18,10 @@
 #define GS_HANDLER_NAME_D3D9 "d3d9"
 
 #define DEFAULT_GS_HANDLER_NAME GS_HANDLER_NAME_NULL
+#define DEFAULT_TEST_TIMEOUT 60
+
+//Frames with draw calls a disc image needs to produce to pass
+#define DISC_TEST_FRAME_COUNT 300
 
 static std::set<std::string> g_validGsHandlersNames =
     {
@@ -25,6 +32,19 @@ static std::set<std::string> g_validGsHandlersNames =
 #endif
 };
 
+enum class TEST_TYPE
+{
+	EE,
+	IOP,
+	DISC,
+};
+
+struct TEST
+{
+	fs::path path;
+	TEST_TYPE type;
+};
+
 #ifdef _WIN32
 
 class CTestWindow : public Framework::Win32::CWindow, public CSingleton<CTestWindow>
@@ -110,40 +130,94 @@ TESTRESULT GetTestResult(const fs::path& testFilePath)
 	return result;
 }
 
-void ExecuteEeTest(const fs::path& testFilePath, const std::string& gsHandlerName)
+//Virtual machines share some process wide state (ie.: preferences) while they're created or destroyed
+static std::mutex g_vmLifetimeMutex;
+
+std::unique_ptr<CPS2VM> CreateVirtualMachine(const std::string& gsHandlerName)
+{
+	std::lock_guard<std::mutex> lifetimeLock(g_vmLifetimeMutex);
+	auto virtualMachine = std::make_unique<CPS2VM>();
+	virtualMachine->Initialize();
+	virtualMachine->CreateGSHandler(GetGsHandlerFactoryFunction(gsHandlerName));
+	return virtualMachine;
+}
+
+void DestroyVirtualMachine(std::unique_ptr<CPS2VM>& virtualMachine)
+{
+	virtualMachine->Pause();
+	std::lock_guard<std::mutex> lifetimeLock(g_vmLifetimeMutex);
+	virtualMachine->DestroyGSHandler();
+	virtualMachine->Destroy();
+	virtualMachine.reset();
+}
+
+//Stops and destroys the virtual machine if a test throws before getting to DestroyVirtualMachine
+class CVirtualMachineGuard
+{
+public:
+	CVirtualMachineGuard(std::unique_ptr<CPS2VM>& virtualMachine)
+	    : m_virtualMachine(virtualMachine)
+	{
+	}
+
+	~CVirtualMachineGuard()
+	{
+		if(m_virtualMachine)
+		{
+			DestroyVirtualMachine(m_virtualMachine);
+		}
+	}
+
+	CVirtualMachineGuard(const CVirtualMachineGuard&) = delete;
+	CVirtualMachineGuard& operator=(const CVirtualMachineGuard&) = delete;
+
+private:
+	std::unique_ptr<CPS2VM>& m_virtualMachine;
+};
+
+bool WaitForExecution(const std::atomic<bool>& executionOver, const std::chrono::seconds& timeout)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	while(!executionOver)
+	{
+		if((timeout.count() != 0) && ((std::chrono::steady_clock::now() - startTime) >= timeout))
+		{
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	return true;
+}
+
+bool ExecuteEeTest(const fs::path& testFilePath, const std::string& gsHandlerName, const std::chrono::seconds& timeout)
 {
 	auto resultFilePath = testFilePath;
 	resultFilePath.replace_extension(".result");
 	auto resultStream = new Framework::CStdStream(resultFilePath.string().c_str(), "wb");
 
-	bool executionOver = false;
+	std::atomic<bool> executionOver = {false};
 
 	//Setup virtual machine
-	CPS2VM virtualMachine;
-	virtualMachine.Initialize();
-	virtualMachine.CreateGSHandler(GetGsHandlerFactoryFunction(gsHandlerName));
-	auto connection = virtualMachine.m_ee->m_os->OnRequestExit.Connect(
+	auto virtualMachine = CreateVirtualMachine(gsHandlerName);
+	CVirtualMachineGuard virtualMachineGuard(virtualMachine);
+	auto connection = virtualMachine->m_ee->m_os->OnRequestExit.Connect(
 	    [&executionOver]() {
 		    executionOver = true;
 	    });
-	virtualMachine.m_ee->m_os->BootFromFile(testFilePath);
+	virtualMachine->m_ee->m_os->BootFromFile(testFilePath);
 	{
-		auto iopOs = dynamic_cast<CIopBios*>(virtualMachine.m_iop->m_bios.get());
+		auto iopOs = dynamic_cast<CIopBios*>(virtualMachine->m_iop->m_bios.get());
 		iopOs->GetIoman()->SetFileStream(Iop::CIoman::FID_STDOUT, resultStream);
 	}
-	virtualMachine.Resume();
+	virtualMachine->Resume();
 
-	while(!executionOver)
-	{
-		std::this_thread::sleep_for(std::chrono::milliseconds(100));
-	}
+	bool completed = WaitForExecution(executionOver, timeout);
 
-	virtualMachine.Pause();
-	virtualMachine.DestroyGSHandler();
-	virtualMachine.Destroy();
+	DestroyVirtualMachine(virtualMachine);
+	return completed;
 }
 
-void ExecuteIopTest(const fs::path& testFilePath)
+bool ExecuteIopTest(const fs::path& testFilePath, const std::chrono::seconds& timeout)
 {
 	//Read in the module data
 	std::vector<uint8> moduleData;
@@ -158,14 +232,13 @@ void ExecuteIopTest(const fs::path& testFilePath)
 	resultFilePath.replace_extension(".result");
 	auto resultStream = new Framework::CStdStream(resultFilePath.string().c_str(), "wb");
 
-	bool executionOver = false;
+	std::atomic<bool> executionOver = {false};
 	CIopBios::ModuleStartedEvent::Connection connection;
 	//Setup virtual machine
-	CPS2VM virtualMachine;
-	virtualMachine.Initialize();
-	virtualMachine.CreateGSHandler(CGSH_Null::GetFactoryFunction());
+	auto virtualMachine = CreateVirtualMachine(GS_HANDLER_NAME_NULL);
+	CVirtualMachineGuard virtualMachineGuard(virtualMachine);
 	{
-		auto iopOs = dynamic_cast<CIopBios*>(virtualMachine.m_iop->m_bios.get());
+		auto iopOs = dynamic_cast<CIopBios*>(virtualMachine->m_iop->m_bios.get());
 		int32 rootModuleId = iopOs->LoadModuleFromHost(moduleData.data());
 		connection = iopOs->OnModuleStarted.Connect(
 		    [&executionOver, rootModuleId](uint32 moduleId) {
@@ -177,18 +250,68 @@ void ExecuteIopTest(const fs::path& testFilePath)
 		iopOs->StartModule(CIopBios::MODULESTARTREQUEST_SOURCE::REMOTE, rootModuleId, "", nullptr, 0);
 		iopOs->GetIoman()->SetFileStream(Iop::CIoman::FID_STDOUT, resultStream);
 	}
-	virtualMachine.Resume();
+	virtualMachine->Resume();
 
-	while(!executionOver)
+	bool completed = WaitForExecution(executionOver, timeout);
+
+	DestroyVirtualMachine(virtualMachine);
+	return completed;
+}
+
+//Disc images don't have expected output, they pass if the game gets to draw a few frames before the timeout
+bool ExecuteDiscTest(const fs::path& testFilePath, const std::string& gsHandlerName, const std::chrono::seconds& timeout)
+{
+	std::atomic<bool> executionOver = {false};
+	uint32 drawnFrameCount = 0;
+
+	auto virtualMachine = CreateVirtualMachine(gsHandlerName);
+	CVirtualMachineGuard virtualMachineGuard(virtualMachine);
+	auto connection = virtualMachine->GetGSHandler()->OnNewFrame.Connect(
+	    [&executionOver, &drawnFrameCount](uint32 drawCallCount) {
+		    if(drawCallCount == 0) return;
+		    drawnFrameCount++;
+		    if(drawnFrameCount == DISC_TEST_FRAME_COUNT)
+		    {
+			    executionOver = true;
+		    }
+	    });
+	virtualMachine->CDROM0_SetPathOverride(testFilePath);
+	virtualMachine->Reset();
+	virtualMachine->m_ee->m_os->BootFromCDROM();
+	virtualMachine->Resume();
+
+	bool completed = WaitForExecution(executionOver, timeout);
+
+	DestroyVirtualMachine(virtualMachine);
+	return completed;
+}
+
+TESTRESULT ExecuteTest(const TEST& test, const std::string& gsHandlerName, const std::chrono::seconds& timeout)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	TESTRESULT result;
+	bool completed = false;
+	switch(test.type)
 	{
-		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	case TEST_TYPE::EE:
+		completed = ExecuteEeTest(test.path, gsHandlerName, timeout);
+		if(completed) result = GetTestResult(test.path);
+		break;
+	case TEST_TYPE::IOP:
+		completed = ExecuteIopTest(test.path, timeout);
+		if(completed) result = GetTestResult(test.path);
+		break;
+	case TEST_TYPE::DISC:
+		completed = ExecuteDiscTest(test.path, gsHandlerName, timeout);
+		result.succeeded = completed;
+		break;
 	}
-
-	virtualMachine.Pause();
-	virtualMachine.Destroy();
+	result.timedOut = !completed;
+	result.duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return result;
 }
 
-void ScanAndExecuteTests(const fs::path& testDirPath, const TestReportWriterPtr& testReportWriter, const std::string& gsHandlerName)
+void ScanTests(const fs::path& testDirPath, std::vector<TEST>& tests)
 {
 	fs::directory_iterator endIterator;
 	for(auto testPathIterator = fs::directory_iterator(testDirPath);
@@ -197,30 +320,70 @@ void ScanAndExecuteTests(const fs::path& testDirPath, const TestReportWriterPtr&
 		auto testPath = testPathIterator->path();
 		if(fs::is_directory(testPath))
 		{
-			ScanAndExecuteTests(testPath, testReportWriter, gsHandlerName);
+			ScanTests(testPath, tests);
 			continue;
 		}
 		if(testPath.extension() == ".elf")
 		{
-			printf("Testing '%s': ", testPath.string().c_str());
-			ExecuteEeTest(testPath, gsHandlerName);
-			auto result = GetTestResult(testPath);
-			printf("%s.\r\n", result.succeeded ? "SUCCEEDED" : "FAILED");
-			if(testReportWriter)
-			{
-				testReportWriter->ReportTestEntry(testPath.string(), result);
-			}
+			tests.push_back({testPath, TEST_TYPE::EE});
 		}
 		else if(testPath.extension() == ".irx")
 		{
-			printf("Testing '%s': ", testPath.string().c_str());
-			ExecuteIopTest(testPath);
-			auto result = GetTestResult(testPath);
-			printf("%s.\r\n", result.succeeded ? "SUCCEEDED" : "FAILED");
-			if(testReportWriter)
-			{
-				testReportWriter->ReportTestEntry(testPath.string(), result);
-			}
+			tests.push_back({testPath, TEST_TYPE::IOP});
+		}
+		else if(testPath.extension() == ".iso")
+		{
+			tests.push_back({testPath, TEST_TYPE::DISC});
+		}
+	}
+}
+
+void ExecuteTests(const std::vector<TEST>& tests, const TestReportWriterPtr& testReportWriter, const std::string& gsHandlerName,
+                  unsigned int jobCount, const std::chrono::seconds& timeout)
+{
+	//Every worker runs its own virtual machine and picks the next test when it's done with one
+	std::vector<TESTRESULT> results(tests.size());
+	std::atomic<size_t> nextTestIndex = {0};
+	std::mutex printMutex;
+
+	auto workerProc =
+	    [&]() {
+		    while(1)
+		    {
+			    size_t testIndex = nextTestIndex++;
+			    if(testIndex >= tests.size()) break;
+			    const auto& test = tests[testIndex];
+			    auto& result = results[testIndex];
+			    try
+			    {
+				    result = ExecuteTest(test, gsHandlerName, timeout);
+			    }
+			    catch(const std::exception& exception)
+			    {
+				    std::lock_guard<std::mutex> printLock(printMutex);
+				    printf("Error: Failed to execute '%s': %s\r\n", test.path.string().c_str(), exception.what());
+			    }
+			    std::lock_guard<std::mutex> printLock(printMutex);
+			    printf("Testing '%s': %s%s.\r\n", test.path.string().c_str(),
+			           result.succeeded ? "SUCCEEDED" : "FAILED", result.timedOut ? " (timed out)" : "");
+		    }
+	    };
+
+	std::vector<std::thread> workers;
+	for(unsigned int i = 0; i < jobCount; i++)
+	{
+		workers.emplace_back(workerProc);
+	}
+	for(auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	if(testReportWriter)
+	{
+		for(unsigned int i = 0; i < tests.size(); i++)
+		{
+			testReportWriter->ReportTestEntry(tests[i].path.string(), results[i]);
 		}
 	}
 }
@@ -249,6 +412,9 @@ int main(int argc, const char** argv)
 		printf("\t --junitreport <path>\t Writes JUnit format report at <path>.\r\n");
 		printf("\t --gshandler <%s>\tSelects which GS handler to instantiate (default is '%s').\r\n",
 		       validGsHandlerNamesString.c_str(), DEFAULT_GS_HANDLER_NAME);
+		printf("\t --jobs <count>\t Runs <count> virtual machines in parallel (default is one per core).\r\n");
+		printf("\t --timeout <seconds>\t Fails tests that run longer than <seconds>, 0 disables (default is %d).\r\n",
+		       DEFAULT_TEST_TIMEOUT);
 		return -1;
 	}
 
@@ -256,6 +422,8 @@ int main(int argc, const char** argv)
 	fs::path autoTestRoot;
 	fs::path reportPath;
 	std::string gsHandlerName = DEFAULT_GS_HANDLER_NAME;
+	unsigned int jobCount = std::max<unsigned int>(std::thread::hardware_concurrency(), 1);
+	auto timeout = std::chrono::seconds(DEFAULT_TEST_TIMEOUT);
 	assert(g_validGsHandlersNames.find(gsHandlerName) != std::end(g_validGsHandlersNames));
 
 	for(int i = 1; i < argc; i++)
@@ -286,6 +454,31 @@ int main(int argc, const char** argv)
 			}
 			i++;
 		}
+		else if(!strcmp(argv[i], "--jobs"))
+		{
+			if((i + 1) >= argc)
+			{
+				printf("Error: Count must be specified for --jobs option.\r\n");
+				return -1;
+			}
+			jobCount = atoi(argv[i + 1]);
+			if(jobCount == 0)
+			{
+				printf("Error: Invalid job count '%s'.\r\n", argv[i + 1]);
+				return -1;
+			}
+			i++;
+		}
+		else if(!strcmp(argv[i], "--timeout"))
+		{
+			if((i + 1) >= argc)
+			{
+				printf("Error: Duration must be specified for --timeout option.\r\n");
+				return -1;
+			}
+			timeout = std::chrono::seconds(atoi(argv[i + 1]));
+			i++;
+		}
 		else
 		{
 			autoTestRoot = argv[i];
@@ -299,9 +492,17 @@ int main(int argc, const char** argv)
 		return -1;
 	}
 
+	if(gsHandlerName != GS_HANDLER_NAME_NULL)
+	{
+		//Other GS handlers all share the same window
+		jobCount = 1;
+	}
+
 	try
 	{
-		ScanAndExecuteTests(autoTestRoot, testReportWriter, gsHandlerName);
+		std::vector<TEST> tests;
+		ScanTests(autoTestRoot, tests);
+		ExecuteTests(tests, testReportWriter, gsHandlerName, jobCount, timeout);
 	}
 	catch(const std::exception& exception)
 	{
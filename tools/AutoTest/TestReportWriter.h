@@ -16,6 +16,8 @@ struct TESTRESULT
 	typedef std::vector<LINEDIFF> LineDiffArray;
 
 	bool succeeded = false;
+	bool timedOut = false;
+	double duration = 0; //In seconds
 	LineDiffArray lineDiffs;
 };
 
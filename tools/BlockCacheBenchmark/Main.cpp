@@ -0,0 +1,206 @@
+#include <cstdio>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+#include "BlockCacheIndex.h"
+
+//Replays block creation sequences similar to what executors see (resident code
+//recreated after SMC faults and overlays swapped in and out) against the
+//previous std::multimap based cache and CBlockCacheIndex.
+
+struct BLOCK
+{
+	uint32 begin = 0;
+	uint32 end = 0;
+};
+typedef std::shared_ptr<BLOCK> BlockPtr;
+typedef CBlockCacheIndex<BlockPtr> BlockCacheIndex;
+typedef BlockCacheIndex::KEY BlockKey;
+
+struct BLOCK_CREATION
+{
+	BlockKey key;
+	uint32 begin = 0;
+	uint32 end = 0;
+};
+typedef std::vector<BLOCK_CREATION> BlockCreationArray;
+
+enum
+{
+	RESIDENT_BLOCK_COUNT = 0x4000,
+	OVERLAY_COUNT = 8,
+	OVERLAY_BLOCK_COUNT = 0x1000,
+	OVERLAY_SWITCH_COUNT = 64,
+	FAULTS_PER_OVERLAY_SWITCH = 0x2000,
+	OVERLAY_BASE_ADDRESS = 0x01000000,
+};
+
+static BlockCreationArray MakeBlocks(std::mt19937_64& random, uint32 baseAddress, uint32 count)
+{
+	BlockCreationArray blocks;
+	blocks.reserve(count);
+	uint32 address = baseAddress;
+	for(uint32 i = 0; i < count; i++)
+	{
+		BLOCK_CREATION block;
+		block.key.hash.nD0 = random();
+		block.key.hash.nD1 = random();
+		block.key.size = static_cast<uint32>(((random() % 32) + 1) * 4);
+		block.begin = address;
+		block.end = address + block.key.size - 4;
+		address += block.key.size;
+		blocks.push_back(block);
+	}
+	return blocks;
+}
+
+static BlockCreationArray MakeSequence()
+{
+	std::mt19937_64 random(0x1234);
+	auto residentBlocks = MakeBlocks(random, 0x00100000, RESIDENT_BLOCK_COUNT);
+	std::vector<BlockCreationArray> overlays;
+	for(uint32 i = 0; i < OVERLAY_COUNT; i++)
+	{
+		overlays.push_back(MakeBlocks(random, OVERLAY_BASE_ADDRESS, OVERLAY_BLOCK_COUNT));
+	}
+
+	BlockCreationArray sequence;
+	sequence.insert(std::end(sequence), std::begin(residentBlocks), std::end(residentBlocks));
+	for(uint32 i = 0; i < OVERLAY_SWITCH_COUNT; i++)
+	{
+		const auto& overlay = overlays[random() % OVERLAY_COUNT];
+		sequence.insert(std::end(sequence), std::begin(overlay), std::end(overlay));
+		for(uint32 j = 0; j < FAULTS_PER_OVERLAY_SWITCH; j++)
+		{
+			sequence.push_back(residentBlocks[random() % RESIDENT_BLOCK_COUNT]);
+		}
+	}
+	return sequence;
+}
+
+struct RESULT
+{
+	double time = 0;
+	uint32 hitCount = 0;
+	uint32 exactHitCount = 0;
+	uint32 entryCount = 0;
+};
+
+static RESULT ReplayMap(const BlockCreationArray& sequence)
+{
+	struct KeyLess
+	{
+		bool operator()(const BlockKey& k1, const BlockKey& k2) const
+		{
+			return std::tie(k1.hash, k1.size) < std::tie(k2.hash, k2.size);
+		}
+	};
+	std::multimap<BlockKey, BlockPtr, KeyLess> cache;
+
+	RESULT result;
+	auto startTime = std::chrono::steady_clock::now();
+	for(const auto& creation : sequence)
+	{
+		auto beginIterator = cache.lower_bound(creation.key);
+		auto endIterator = cache.upper_bound(creation.key);
+		if(beginIterator != endIterator)
+		{
+			result.hitCount++;
+			for(auto blockIterator = beginIterator; blockIterator != endIterator; blockIterator++)
+			{
+				const auto& block = blockIterator->second;
+				if(block->begin == creation.begin && block->end == creation.end)
+				{
+					result.exactHitCount++;
+					break;
+				}
+			}
+			continue;
+		}
+		auto block = std::make_shared<BLOCK>();
+		block->begin = creation.begin;
+		block->end = creation.end;
+		cache.insert(std::make_pair(creation.key, std::move(block)));
+	}
+	result.time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	result.entryCount = static_cast<uint32>(cache.size());
+	return result;
+}
+
+static RESULT ReplayIndex(const BlockCreationArray& sequence, uint32 maxEntries, BlockCacheIndex::STATS& stats)
+{
+	BlockCacheIndex cache(maxEntries);
+
+	RESULT result;
+	auto startTime = std::chrono::steady_clock::now();
+	for(const auto& creation : sequence)
+	{
+		auto cachedBlock = cache.Find(creation.key,
+		                              [&](const BlockPtr& block) {
+			                              return block->begin == creation.begin && block->end == creation.end;
+		                              });
+		if(cachedBlock)
+		{
+			result.hitCount++;
+			const auto& block = *cachedBlock;
+			if(block->begin == creation.begin && block->end == creation.end)
+			{
+				result.exactHitCount++;
+			}
+			continue;
+		}
+		auto block = std::make_shared<BLOCK>();
+		block->begin = creation.begin;
+		block->end = creation.end;
+		cache.Insert(creation.key, std::move(block));
+	}
+	result.time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	result.entryCount = cache.GetEntryCount();
+	stats = cache.GetStats();
+	return result;
+}
+
+static void PrintResult(const char* name, const BlockCreationArray& sequence, const RESULT& result)
+{
+	printf("%-24s %8.2fms %8.1fns/op hits: %6.2f%% entries: %d\n",
+	       name, result.time, (result.time * 1000000.0) / sequence.size(),
+	       (100.0 * result.hitCount) / sequence.size(), result.entryCount);
+}
+
+int main(int argc, const char** argv)
+{
+	auto sequence = MakeSequence();
+	printf("Replaying %d block creations.\n", static_cast<uint32>(sequence.size()));
+
+	auto mapResult = ReplayMap(sequence);
+	PrintResult("std::multimap", sequence, mapResult);
+
+	bool succeeded = true;
+	static const uint32 capacities[] = {0x10000, 0x8000, 0x4000};
+	for(auto capacity : capacities)
+	{
+		BlockCacheIndex::STATS stats;
+		auto indexResult = ReplayIndex(sequence, capacity, stats);
+		char name[32];
+		snprintf(name, sizeof(name), "CBlockCacheIndex(0x%X)", capacity);
+		PrintResult(name, sequence, indexResult);
+		printf("%-24s evictions: %d\n", "", stats.evictionCount);
+
+		//When nothing needs to be evicted, results must be identical to the map's
+		if(stats.evictionCount == 0)
+		{
+			if((indexResult.hitCount != mapResult.hitCount) ||
+			   (indexResult.exactHitCount != mapResult.exactHitCount) ||
+			   (indexResult.entryCount != mapResult.entryCount))
+			{
+				printf("Mismatch between std::multimap and CBlockCacheIndex results.\n");
+				succeeded = false;
+			}
+		}
+	}
+
+	return succeeded ? 0 : 1;
+}
@@ -0,0 +1,311 @@
+#include <cstdio>
+#include <vector>
+#include "GsSwizzleTest.h"
+#include "TestUtils.h"
+#include "gs/GSHandler.h"
+#include "gs/GsPixelFormats.h"
+#include "gs/GsSwizzle.h"
+
+//Converts an area with the column functions and with the pixel indexor, both need to give the same
+//results. Throughput of both methods is also reported for every format.
+
+enum
+{
+	AREA_BUFPTR = 0x100000,
+	AREA_WIDTH = 256,
+	AREA_HEIGHT = 256,
+};
+
+struct PSMCT32_TRAITS
+{
+	typedef CGsPixelFormats::STORAGEPSMCT32 Storage;
+	static constexpr const char* name = "PSMCT32";
+	static constexpr uint32 bitsPerPixel = 32;
+	static bool WriteColumn(uint8* column, const uint8* src, uint32 srcPitch, uint32)
+	{
+		return GsSwizzle::WriteColumnPSMCT32(column, src, srcPitch);
+	}
+	static void ReadColumn(uint8* dst, uint32 dstPitch, const uint8* column, uint32)
+	{
+		GsSwizzle::ReadColumnPSMCT32(dst, dstPitch, column);
+	}
+};
+
+struct PSMZ32_TRAITS : public PSMCT32_TRAITS
+{
+	typedef CGsPixelFormats::STORAGEPSMZ32 Storage;
+	static constexpr const char* name = "PSMZ32";
+};
+
+struct PSMCT16_TRAITS
+{
+	typedef CGsPixelFormats::STORAGEPSMCT16 Storage;
+	static constexpr const char* name = "PSMCT16";
+	static constexpr uint32 bitsPerPixel = 16;
+	static bool WriteColumn(uint8* column, const uint8* src, uint32 srcPitch, uint32)
+	{
+		return GsSwizzle::WriteColumnPSMCT16(column, src, srcPitch);
+	}
+	static void ReadColumn(uint8* dst, uint32 dstPitch, const uint8* column, uint32)
+	{
+		GsSwizzle::ReadColumnPSMCT16(dst, dstPitch, column);
+	}
+};
+
+struct PSMCT16S_TRAITS : public PSMCT16_TRAITS
+{
+	typedef CGsPixelFormats::STORAGEPSMCT16S Storage;
+	static constexpr const char* name = "PSMCT16S";
+};
+
+struct PSMZ16S_TRAITS : public PSMCT16_TRAITS
+{
+	typedef CGsPixelFormats::STORAGEPSMZ16S Storage;
+	static constexpr const char* name = "PSMZ16S";
+};
+
+struct PSMT8_TRAITS
+{
+	typedef CGsPixelFormats::STORAGEPSMT8 Storage;
+	static constexpr const char* name = "PSMT8";
+	static constexpr uint32 bitsPerPixel = 8;
+	static bool WriteColumn(uint8* column, const uint8* src, uint32 srcPitch, uint32 columnParity)
+	{
+		return GsSwizzle::WriteColumnPSMT8(column, src, srcPitch, columnParity);
+	}
+	static void ReadColumn(uint8* dst, uint32 dstPitch, const uint8* column, uint32 columnParity)
+	{
+		GsSwizzle::ReadColumnPSMT8(dst, dstPitch, column, columnParity);
+	}
+};
+
+struct PSMT4_TRAITS
+{
+	typedef CGsPixelFormats::STORAGEPSMT4 Storage;
+	static constexpr const char* name = "PSMT4";
+	static constexpr uint32 bitsPerPixel = 4;
+	static bool WriteColumn(uint8* column, const uint8* src, uint32 srcPitch, uint32 columnParity)
+	{
+		return GsSwizzle::WriteColumnPSMT4(column, src, srcPitch, columnParity);
+	}
+};
+
+template <typename Traits>
+static uint32 GetAreaPitch()
+{
+	return (AREA_WIDTH * Traits::bitsPerPixel) / 8;
+}
+
+template <typename Traits>
+static uint32 GetLinearPixel(const uint8* area, uint32 x, uint32 y)
+{
+	const uint8* row = area + (y * GetAreaPitch<Traits>());
+	switch(Traits::bitsPerPixel)
+	{
+	case 4:
+		return (row[x / 2] >> ((x & 1) * 4)) & 0x0F;
+	case 8:
+		return row[x];
+	case 16:
+		return reinterpret_cast<const uint16*>(row)[x];
+	default:
+		return reinterpret_cast<const uint32*>(row)[x];
+	}
+}
+
+template <typename Traits>
+static void SetLinearPixel(uint8* area, uint32 x, uint32 y, uint32 pixel)
+{
+	uint8* row = area + (y * GetAreaPitch<Traits>());
+	switch(Traits::bitsPerPixel)
+	{
+	case 4:
+		row[x / 2] &= ~(0x0F << ((x & 1) * 4));
+		row[x / 2] |= pixel << ((x & 1) * 4);
+		break;
+	case 8:
+		row[x] = static_cast<uint8>(pixel);
+		break;
+	case 16:
+		reinterpret_cast<uint16*>(row)[x] = static_cast<uint16>(pixel);
+		break;
+	default:
+		reinterpret_cast<uint32*>(row)[x] = pixel;
+		break;
+	}
+}
+
+//Calls 'columnHandler' for every column of the area along with the offset of its first row in linear data
+template <typename Traits, typename ColumnHandler>
+static void ForEachColumn(uint8* ram, const ColumnHandler& columnHandler)
+{
+	typedef typename Traits::Storage Storage;
+	CGsPixelFormats::CPixelIndexor<Storage> indexor(ram, AREA_BUFPTR, AREA_WIDTH / 64);
+	for(uint32 y = 0; y < AREA_HEIGHT; y += Storage::COLUMNHEIGHT)
+	{
+		for(uint32 x = 0; x < AREA_WIDTH; x += Storage::COLUMNWIDTH)
+		{
+			unsigned int columnX = x;
+			unsigned int columnY = y;
+			uint8* column = ram + indexor.GetColumnAddress(columnX, columnY);
+			uint32 areaOffset = (y * GetAreaPitch<Traits>()) + ((x * Traits::bitsPerPixel) / 8);
+			columnHandler(column, areaOffset, (y / Storage::COLUMNHEIGHT) & 1);
+		}
+	}
+}
+
+template <typename Traits>
+static void WriteTest()
+{
+	typedef typename Traits::Storage Storage;
+
+	uint32 areaSize = GetAreaPitch<Traits>() * AREA_HEIGHT;
+	std::vector<uint8> area(areaSize);
+	FillPattern(area, 0x1234);
+
+	std::vector<uint8> indexorRam(CGSHandler::RAMSIZE);
+	std::vector<uint8> columnRam(CGSHandler::RAMSIZE);
+	FillPattern(indexorRam, 0x5678);
+	columnRam = indexorRam;
+
+	auto writeIndexor =
+	    [&]() {
+		    CGsPixelFormats::CPixelIndexor<Storage> indexor(indexorRam.data(), AREA_BUFPTR, AREA_WIDTH / 64);
+		    for(uint32 y = 0; y < AREA_HEIGHT; y++)
+		    {
+			    for(uint32 x = 0; x < AREA_WIDTH; x++)
+			    {
+				    indexor.SetPixel(x, y, static_cast<typename Storage::Unit>(GetLinearPixel<Traits>(area.data(), x, y)));
+			    }
+		    }
+	    };
+
+	bool dirty = false;
+	auto writeColumns =
+	    [&]() {
+		    ForEachColumn<Traits>(columnRam.data(),
+		                          [&](uint8* column, uint32 areaOffset, uint32 columnParity) {
+			                          dirty |= Traits::WriteColumn(column, area.data() + areaOffset, GetAreaPitch<Traits>(), columnParity);
+		                          });
+	    };
+
+	writeIndexor();
+	writeColumns();
+	TEST_VERIFY(dirty);
+	TEST_VERIFY(indexorRam == columnRam);
+
+	//Writing the same data again shouldn't change anything
+	dirty = false;
+	writeColumns();
+	TEST_VERIFY(!dirty);
+
+	double indexorThroughput = MeasureThroughput(areaSize, writeIndexor);
+	double columnThroughput = MeasureThroughput(areaSize, writeColumns);
+	printf("%-8s write: %8.1f MB/s (indexor: %8.1f MB/s)\r\n", Traits::name, columnThroughput, indexorThroughput);
+}
+
+//Changing a single byte of the area must only report the column holding it as changed,
+//wherever the byte is within the column
+template <typename Traits>
+static void WriteDirtinessTest()
+{
+	typedef typename Traits::Storage Storage;
+
+	uint32 areaSize = GetAreaPitch<Traits>() * AREA_HEIGHT;
+	std::vector<uint8> area(areaSize);
+	FillPattern(area, 0x4321);
+
+	std::vector<uint8> ram(CGSHandler::RAMSIZE);
+	auto writeColumns =
+	    [&](std::vector<uint32>& dirtyOffsets) {
+		    ForEachColumn<Traits>(ram.data(),
+		                          [&](uint8* column, uint32 areaOffset, uint32 columnParity) {
+			                          if(Traits::WriteColumn(column, area.data() + areaOffset, GetAreaPitch<Traits>(), columnParity))
+			                          {
+				                          dirtyOffsets.push_back(areaOffset);
+			                          }
+		                          });
+	    };
+
+	std::vector<uint32> dirtyOffsets;
+	writeColumns(dirtyOffsets);
+
+	uint32 columnRowSize = (Storage::COLUMNWIDTH * Traits::bitsPerPixel) / 8;
+	for(uint32 row = 0; row < Storage::COLUMNHEIGHT; row++)
+	{
+		for(uint32 rowOffset = 0; rowOffset < columnRowSize; rowOffset++)
+		{
+			//Pick a column in the middle of the area, its row parity alternates with 'row'
+			uint32 columnY = (AREA_HEIGHT / 2) + ((row & 1) * Storage::COLUMNHEIGHT);
+			uint32 columnOffset = (columnY * GetAreaPitch<Traits>()) + (columnRowSize * 3);
+			area[columnOffset + (row * GetAreaPitch<Traits>()) + rowOffset] ^= 0x81;
+
+			dirtyOffsets.clear();
+			writeColumns(dirtyOffsets);
+			TEST_VERIFY(dirtyOffsets.size() == 1);
+			TEST_VERIFY(dirtyOffsets[0] == columnOffset);
+		}
+	}
+}
+
+template <typename Traits>
+static void ReadTest()
+{
+	typedef typename Traits::Storage Storage;
+
+	uint32 areaSize = GetAreaPitch<Traits>() * AREA_HEIGHT;
+	std::vector<uint8> ram(CGSHandler::RAMSIZE);
+	FillPattern(ram, 0x9ABC);
+
+	std::vector<uint8> indexorArea(areaSize);
+	std::vector<uint8> columnArea(areaSize);
+
+	auto readIndexor =
+	    [&]() {
+		    CGsPixelFormats::CPixelIndexor<Storage> indexor(ram.data(), AREA_BUFPTR, AREA_WIDTH / 64);
+		    for(uint32 y = 0; y < AREA_HEIGHT; y++)
+		    {
+			    for(uint32 x = 0; x < AREA_WIDTH; x++)
+			    {
+				    SetLinearPixel<Traits>(indexorArea.data(), x, y, indexor.GetPixel(x, y));
+			    }
+		    }
+	    };
+
+	auto readColumns =
+	    [&]() {
+		    ForEachColumn<Traits>(ram.data(),
+		                          [&](uint8* column, uint32 areaOffset, uint32 columnParity) {
+			                          Traits::ReadColumn(columnArea.data() + areaOffset, GetAreaPitch<Traits>(), column, columnParity);
+		                          });
+	    };
+
+	readIndexor();
+	readColumns();
+	TEST_VERIFY(indexorArea == columnArea);
+
+	double indexorThroughput = MeasureThroughput(areaSize, readIndexor);
+	double columnThroughput = MeasureThroughput(areaSize, readColumns);
+	printf("%-8s read:  %8.1f MB/s (indexor: %8.1f MB/s)\r\n", Traits::name, columnThroughput, indexorThroughput);
+}
+
+void CGsSwizzleTest::Execute()
+{
+	WriteTest<PSMCT32_TRAITS>();
+	WriteTest<PSMCT16_TRAITS>();
+	WriteTest<PSMCT16S_TRAITS>();
+	WriteTest<PSMT8_TRAITS>();
+	WriteTest<PSMT4_TRAITS>();
+
+	WriteDirtinessTest<PSMCT32_TRAITS>();
+	WriteDirtinessTest<PSMCT16_TRAITS>();
+	WriteDirtinessTest<PSMT8_TRAITS>();
+	WriteDirtinessTest<PSMT4_TRAITS>();
+
+	ReadTest<PSMCT32_TRAITS>();
+	ReadTest<PSMZ32_TRAITS>();
+	ReadTest<PSMCT16_TRAITS>();
+	ReadTest<PSMCT16S_TRAITS>();
+	ReadTest<PSMZ16S_TRAITS>();
+	ReadTest<PSMT8_TRAITS>();
+}
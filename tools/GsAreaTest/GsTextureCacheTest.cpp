@@ -0,0 +1,184 @@
+#include "GsTextureCacheTest.h"
+#include "gs/GsTextureCache.h"
+
+typedef CGsTextureCache<uint32> TextureCache;
+
+static CGSHandler::TEX0 MakeTex0(uint32 psm, uint32 bufPtr, uint32 bufWidth, uint32 widthLog2, uint32 heightLog2)
+{
+	assert((bufPtr & 0xFF) == 0);
+	assert((bufWidth & 0x3F) == 0);
+
+	auto tex0 = make_convertible<CGSHandler::TEX0>(0);
+	tex0.nPsm = psm;
+	tex0.nBufPtr = bufPtr / 0x100;
+	tex0.nBufWidth = bufWidth / 0x40;
+	tex0.nWidth = widthLog2;
+	tex0.nPad0 = heightLog2 & 0x03;
+	tex0.nPad1 = heightLog2 >> 2;
+	return tex0;
+}
+
+static bool IsCached(TextureCache& cache, const CGSHandler::TEX0& tex0, uint32 textureHandle)
+{
+	auto texture = cache.Search(tex0);
+	return texture && (texture->m_textureHandle == textureHandle);
+}
+
+void CGsTextureCacheTest::Execute()
+{
+	CheckLookup();
+	CheckEvictionOrder();
+	CheckPageInvalidation();
+}
+
+void CGsTextureCacheTest::CheckLookup()
+{
+	TextureCache cache(4);
+
+	auto tex0A = MakeTex0(CGSHandler::PSMCT32, 0x100000, 64, 6, 5);
+	auto tex0B = MakeTex0(CGSHandler::PSMT8, 0x100000, 128, 7, 7);
+	TEST_VERIFY(cache.Search(tex0A) == nullptr);
+
+	cache.Insert(tex0A, 1);
+	cache.Insert(tex0B, 2);
+
+	{
+		auto texture = cache.Search(tex0A);
+		TEST_VERIFY(texture != nullptr);
+		TEST_VERIFY(texture->m_live);
+		TEST_VERIFY(texture->m_textureHandle == 1);
+		TEST_VERIFY(!texture->m_cachedArea.HasDirtyPages());
+	}
+
+	//CLUT information is not part of the key
+	{
+		auto tex0 = tex0A;
+		tex0.nCBP = 0x1234;
+		tex0.nCSA = 3;
+		tex0.nCLD = 1;
+		TEST_VERIFY(IsCached(cache, tex0, 1));
+	}
+
+	//Everything else is
+	{
+		auto tex0 = tex0A;
+		tex0.nBufPtr++;
+		TEST_VERIFY(cache.Search(tex0) == nullptr);
+		tex0 = tex0A;
+		tex0.nWidth++;
+		TEST_VERIFY(cache.Search(tex0) == nullptr);
+		tex0 = tex0A;
+		tex0.nPsm = CGSHandler::PSMCT16;
+		TEST_VERIFY(cache.Search(tex0) == nullptr);
+	}
+
+	//Inserting a texture with the same key replaces the existing one
+	cache.Insert(tex0A, 3);
+	TEST_VERIFY(IsCached(cache, tex0A, 3));
+	TEST_VERIFY(IsCached(cache, tex0B, 2));
+
+	cache.Flush();
+	TEST_VERIFY(cache.Search(tex0A) == nullptr);
+	TEST_VERIFY(cache.Search(tex0B) == nullptr);
+}
+
+void CGsTextureCacheTest::CheckEvictionOrder()
+{
+	TextureCache cache(3);
+
+	auto tex0A = MakeTex0(CGSHandler::PSMCT32, 0x000000, 64, 6, 5);
+	auto tex0B = MakeTex0(CGSHandler::PSMCT32, 0x002000, 64, 6, 5);
+	auto tex0C = MakeTex0(CGSHandler::PSMCT32, 0x004000, 64, 6, 5);
+	auto tex0D = MakeTex0(CGSHandler::PSMCT32, 0x006000, 64, 6, 5);
+	auto tex0E = MakeTex0(CGSHandler::PSMCT32, 0x008000, 64, 6, 5);
+
+	cache.Insert(tex0A, 1);
+	cache.Insert(tex0B, 2);
+	cache.Insert(tex0C, 3);
+
+	//A becomes the most recently used texture, B is the least recently used one
+	TEST_VERIFY(IsCached(cache, tex0A, 1));
+
+	cache.Insert(tex0D, 4);
+	TEST_VERIFY(cache.Search(tex0B) == nullptr);
+
+	//Lookups above made C the least recently used
+	cache.Insert(tex0E, 5);
+	TEST_VERIFY(cache.Search(tex0C) == nullptr);
+
+	TEST_VERIFY(IsCached(cache, tex0D, 4));
+	TEST_VERIFY(IsCached(cache, tex0E, 5));
+	TEST_VERIFY(IsCached(cache, tex0A, 1));
+
+	//Replacing a texture with the same key keeps the others
+	cache.Insert(tex0D, 6);
+	TEST_VERIFY(IsCached(cache, tex0A, 1));
+	TEST_VERIFY(IsCached(cache, tex0D, 6));
+	TEST_VERIFY(IsCached(cache, tex0E, 5));
+}
+
+void CGsTextureCacheTest::CheckPageInvalidation()
+{
+	TextureCache cache(2);
+
+	//One PSMCT32 page is 64x32 pixels, the second texture covers 2x2 pages
+	uint32 singlePagePtr = 0x100000;
+	uint32 multiPagePtr = 0x200000;
+	auto singlePageTex0 = MakeTex0(CGSHandler::PSMCT32, singlePagePtr, 64, 6, 5);
+	auto multiPageTex0 = MakeTex0(CGSHandler::PSMCT32, multiPagePtr, 128, 7, 6);
+
+	cache.Insert(singlePageTex0, 1);
+	cache.Insert(multiPageTex0, 2);
+
+	auto singlePageTexture = cache.Search(singlePageTex0);
+	auto multiPageTexture = cache.Search(multiPageTex0);
+	TEST_VERIFY(singlePageTexture && multiPageTexture);
+	TEST_VERIFY(multiPageTexture->m_cachedArea.GetPageCount() == 4);
+
+	//Writes outside of both textures
+	cache.InvalidateRange(0, CGsPixelFormats::PAGESIZE);
+	cache.InvalidateRange(multiPagePtr + (CGsPixelFormats::PAGESIZE * 4), CGsPixelFormats::PAGESIZE);
+	TEST_VERIFY(!singlePageTexture->m_cachedArea.HasDirtyPages());
+	TEST_VERIFY(!multiPageTexture->m_cachedArea.HasDirtyPages());
+
+	//Write to the last page of the multi page texture only
+	cache.InvalidateRange(multiPagePtr + (CGsPixelFormats::PAGESIZE * 3) + 0x100, 0x100);
+	TEST_VERIFY(!singlePageTexture->m_cachedArea.HasDirtyPages());
+	TEST_VERIFY(!multiPageTexture->m_cachedArea.IsPageDirty(0));
+	TEST_VERIFY(!multiPageTexture->m_cachedArea.IsPageDirty(1));
+	TEST_VERIFY(!multiPageTexture->m_cachedArea.IsPageDirty(2));
+	TEST_VERIFY(multiPageTexture->m_cachedArea.IsPageDirty(3));
+	multiPageTexture->m_cachedArea.ClearDirtyPages();
+
+	//Write covering the second and third pages
+	cache.InvalidateRange(multiPagePtr + CGsPixelFormats::PAGESIZE, CGsPixelFormats::PAGESIZE * 2);
+	TEST_VERIFY(!multiPageTexture->m_cachedArea.IsPageDirty(0));
+	TEST_VERIFY(multiPageTexture->m_cachedArea.IsPageDirty(1));
+	TEST_VERIFY(multiPageTexture->m_cachedArea.IsPageDirty(2));
+	TEST_VERIFY(!multiPageTexture->m_cachedArea.IsPageDirty(3));
+	multiPageTexture->m_cachedArea.ClearDirtyPages();
+
+	//Write covering both textures
+	cache.InvalidateRange(singlePagePtr, multiPagePtr + (CGsPixelFormats::PAGESIZE * 4) - singlePagePtr);
+	TEST_VERIFY(singlePageTexture->m_cachedArea.IsPageDirty(0));
+	{
+		auto dirtyRect = multiPageTexture->m_cachedArea.GetDirtyPageRect();
+		TEST_VERIFY(dirtyRect.width == 2);
+		TEST_VERIFY(dirtyRect.height == 2);
+	}
+	singlePageTexture->m_cachedArea.ClearDirtyPages();
+	multiPageTexture->m_cachedArea.ClearDirtyPages();
+
+	//Evicting the multi page texture must stop its pages from affecting the texture taking its place
+	auto otherTex0 = MakeTex0(CGSHandler::PSMCT32, 0x300000, 64, 6, 5);
+	TEST_VERIFY(IsCached(cache, singlePageTex0, 1));
+	cache.Insert(otherTex0, 3);
+	TEST_VERIFY(cache.Search(multiPageTex0) == nullptr);
+	auto otherTexture = cache.Search(otherTex0);
+	TEST_VERIFY(otherTexture == multiPageTexture);
+	cache.InvalidateRange(multiPagePtr, CGsPixelFormats::PAGESIZE * 4);
+	TEST_VERIFY(!otherTexture->m_cachedArea.HasDirtyPages());
+	cache.InvalidateRange(0x300000, 0x100);
+	TEST_VERIFY(otherTexture->m_cachedArea.HasDirtyPages());
+	TEST_VERIFY(!singlePageTexture->m_cachedArea.HasDirtyPages());
+}
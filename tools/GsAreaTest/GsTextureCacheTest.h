@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Test.h"
+
+class CGsTextureCacheTest : public CTest
+{
+public:
+	void Execute() override;
+
+private:
+	void CheckLookup();
+	void CheckEvictionOrder();
+	void CheckPageInvalidation();
+};
@@ -0,0 +1,154 @@
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include "GsTextureConvertTest.h"
+#include "TestUtils.h"
+#include "gs/GSHandler.h"
+#include "gs/GsPixelFormats.h"
+#include "gs/GsTextureConvert.h"
+
+//Converts texture areas with the texture converters and with a pixel by pixel reference
+//implementation, both need to give the same results. Throughput of both is also reported.
+
+enum
+{
+	BENCHMARK_BUFPTR = 0x100000,
+	BENCHMARK_SIZE = 256,
+};
+
+struct AREA
+{
+	uint32 bufPtr;
+	uint32 bufWidth;
+	uint32 texX;
+	uint32 texY;
+	uint32 texWidth;
+	uint32 texHeight;
+};
+
+// clang-format off
+static const AREA s_areas[] =
+{
+	{0x000000, 4, 0,  0,  256, 256},
+	{0x0A0000, 2, 64, 32, 64,  32 },
+	{0x3F0000, 8, 0,  0,  512, 64 },
+	{0x020000, 1, 0,  0,  64,  128},
+	{0x004000, 3, 32, 64, 128, 64 },
+	{0x008000, 1, 0,  0,  16,  16 },
+	{0x020000, 2, 48, 4,  16,  8  },
+	{0x030000, 2, 24, 8,  8,   16 },
+	{0x008000, 1, 0,  0,  8,   8  },
+	{0x010000, 1, 0,  0,  4,   4  },
+	{0x012300, 2, 3,  1,  13,  7  },
+};
+// clang-format on
+
+typedef std::function<void(uint8*, uint32, uint8*, const AREA&)> ConvertFunction;
+
+template <typename IndexorType, typename PixelType, typename PixelConverter>
+static void ReferenceConvert(uint8* dst, uint32 dstPitch, uint8* ram, const AREA& area, const PixelConverter& pixelConverter)
+{
+	IndexorType indexor(ram, area.bufPtr, area.bufWidth);
+	for(uint32 y = 0; y < area.texHeight; y++)
+	{
+		auto rowDst = reinterpret_cast<PixelType*>(dst + (y * dstPitch));
+		for(uint32 x = 0; x < area.texWidth; x++)
+		{
+			rowDst[x] = pixelConverter(indexor.GetPixel(area.texX + x, area.texY + y));
+		}
+	}
+}
+
+static void ConvertTest(const char* name, uint32 bytesPerPixel, const ConvertFunction& convert, const ConvertFunction& referenceConvert)
+{
+	std::vector<uint8> ram(CGSHandler::RAMSIZE);
+	FillPattern(ram, 0x2468);
+
+	for(const auto& area : s_areas)
+	{
+		uint32 dstPitch = area.texWidth * bytesPerPixel;
+		std::vector<uint8> dst(dstPitch * area.texHeight, 0xCC);
+		std::vector<uint8> referenceDst(dstPitch * area.texHeight, 0x33);
+		convert(dst.data(), dstPitch, ram.data(), area);
+		referenceConvert(referenceDst.data(), dstPitch, ram.data(), area);
+		TEST_VERIFY(dst == referenceDst);
+	}
+
+	AREA benchmarkArea = {BENCHMARK_BUFPTR, BENCHMARK_SIZE / 64, 0, 0, BENCHMARK_SIZE, BENCHMARK_SIZE};
+	uint32 dstPitch = BENCHMARK_SIZE * bytesPerPixel;
+	uint32 areaSize = dstPitch * BENCHMARK_SIZE;
+	std::vector<uint8> dst(areaSize);
+	double throughput = MeasureThroughput(areaSize, [&]() { convert(dst.data(), dstPitch, ram.data(), benchmarkArea); });
+	double referenceThroughput = MeasureThroughput(areaSize, [&]() { referenceConvert(dst.data(), dstPitch, ram.data(), benchmarkArea); });
+	printf("%-16s convert: %8.1f MB/s (reference: %8.1f MB/s)\r\n", name, throughput, referenceThroughput);
+}
+
+template <typename IndexorType>
+static void ConvertPsm16Test(const char* name, GsTextureConvert::COLOR16_FORMAT format)
+{
+	ConvertTest(
+	    name, 2,
+	    [format](uint8* dst, uint32 dstPitch, uint8* ram, const AREA& area) {
+		    GsTextureConvert::ConvertPsm16<IndexorType>(dst, dstPitch, ram, area.bufPtr, area.bufWidth, area.texX, area.texY, area.texWidth, area.texHeight, format);
+	    },
+	    [format](uint8* dst, uint32 dstPitch, uint8* ram, const AREA& area) {
+		    ReferenceConvert<IndexorType, uint16>(dst, dstPitch, ram, area,
+		                                          [format](uint16 pixel) {
+			                                          if(format == GsTextureConvert::COLOR16_FORMAT_RGBA5551)
+			                                          {
+				                                          return static_cast<uint16>(
+				                                              (((pixel & 0x001F) >> 0) << 11) |
+				                                              (((pixel & 0x03E0) >> 5) << 6) |
+				                                              (((pixel & 0x7C00) >> 10) << 1) |
+				                                              (pixel >> 15));
+			                                          }
+			                                          else
+			                                          {
+				                                          return static_cast<uint16>(
+				                                              (((pixel & 0x001F) >> 0) << 10) |
+				                                              (((pixel & 0x03E0) >> 5) << 5) |
+				                                              (((pixel & 0x7C00) >> 10) << 0) |
+				                                              (((pixel & 0x8000) >> 15) << 15));
+			                                          }
+		                                          });
+	    });
+}
+
+template <typename IndexorType>
+static void ConvertPsm48Test(const char* name)
+{
+	ConvertTest(
+	    name, 1,
+	    [](uint8* dst, uint32 dstPitch, uint8* ram, const AREA& area) {
+		    GsTextureConvert::ConvertPsm48<IndexorType>(dst, dstPitch, ram, area.bufPtr, area.bufWidth, area.texX, area.texY, area.texWidth, area.texHeight);
+	    },
+	    [](uint8* dst, uint32 dstPitch, uint8* ram, const AREA& area) {
+		    ReferenceConvert<IndexorType, uint8>(dst, dstPitch, ram, area, [](uint8 pixel) { return pixel; });
+	    });
+}
+
+template <uint32 shiftAmount, uint32 mask>
+static void ConvertPsm48HTest(const char* name)
+{
+	ConvertTest(
+	    name, 1,
+	    [](uint8* dst, uint32 dstPitch, uint8* ram, const AREA& area) {
+		    GsTextureConvert::ConvertPsm48H<shiftAmount, mask>(dst, dstPitch, ram, area.bufPtr, area.bufWidth, area.texX, area.texY, area.texWidth, area.texHeight);
+	    },
+	    [](uint8* dst, uint32 dstPitch, uint8* ram, const AREA& area) {
+		    ReferenceConvert<CGsPixelFormats::CPixelIndexorPSMCT32, uint8>(dst, dstPitch, ram, area,
+		                                                                   [](uint32 pixel) { return static_cast<uint8>((pixel >> shiftAmount) & mask); });
+	    });
+}
+
+void CGsTextureConvertTest::Execute()
+{
+	ConvertPsm16Test<CGsPixelFormats::CPixelIndexorPSMCT16>("PSMCT16 RGBA5551", GsTextureConvert::COLOR16_FORMAT_RGBA5551);
+	ConvertPsm16Test<CGsPixelFormats::CPixelIndexorPSMCT16>("PSMCT16 ARGB1555", GsTextureConvert::COLOR16_FORMAT_ARGB1555);
+	ConvertPsm16Test<CGsPixelFormats::CPixelIndexorPSMCT16S>("PSMCT16S", GsTextureConvert::COLOR16_FORMAT_RGBA5551);
+	ConvertPsm48Test<CGsPixelFormats::CPixelIndexorPSMT8>("PSMT8");
+	ConvertPsm48Test<CGsPixelFormats::CPixelIndexorPSMT4>("PSMT4");
+	ConvertPsm48HTest<24, 0xFF>("PSMT8H");
+	ConvertPsm48HTest<24, 0x0F>("PSMT4HL");
+	ConvertPsm48HTest<28, 0x0F>("PSMT4HH");
+}
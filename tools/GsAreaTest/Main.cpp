@@ -1,6 +1,9 @@
 #include <functional>
 #include "GsCachedAreaTest.h"
 #include "GsSpriteRegionTest.h"
+#include "GsSwizzleTest.h"
+#include "GsTextureCacheTest.h"
+#include "GsTextureConvertTest.h"
 #include "GsTransferInvalidationTest.h"
 
 typedef std::function<CTest*()> TestFactoryFunction;
@@ -10,6 +13,9 @@ static const TestFactoryFunction s_factories[] =
 {
 	[]() { return new CGsCachedAreaTest(); },
 	[]() { return new CGsSpriteRegionTest(); },
+	[]() { return new CGsSwizzleTest(); },
+	[]() { return new CGsTextureCacheTest(); },
+	[]() { return new CGsTextureConvertTest(); },
 	[]() { return new CGsTransferInvalidationTest(); }
 };
 // clang-format on
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <vector>
+#include "Types.h"
+
+//Helpers shared by tests that compare GS RAM conversion paths and report their throughput
+
+//Fills 'buffer' with a deterministic pseudo random pattern
+inline void FillPattern(std::vector<uint8>& buffer, uint32 seed)
+{
+	for(auto& value : buffer)
+	{
+		seed = (seed * 1103515245) + 12345;
+		value = static_cast<uint8>(seed >> 16);
+	}
+}
+
+//Runs 'work' a few times and returns the throughput in MB/s, 'areaSize' being the amount of bytes processed by every run
+inline double MeasureThroughput(uint32 areaSize, const std::function<void()>& work)
+{
+	static const uint32 iterationCount = 16;
+	auto startTime = std::chrono::steady_clock::now();
+	for(uint32 i = 0; i < iterationCount; i++)
+	{
+		work();
+	}
+	auto endTime = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(endTime - startTime).count();
+	return (static_cast<double>(areaSize) * iterationCount) / (seconds * 1000000.0);
+}
@@ -0,0 +1,200 @@
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "MemoryMap.h"
+#include "Ps2Const.h"
+
+//Hammers hardware register reads through an EE-like memory map, comparing the page
+//table lookup with the linear scan of map elements that was used before. Also compares
+//handler dispatch through std::function with plain function handlers.
+
+enum
+{
+	//Hardware registers (see CDMAC, CINTC and CGIF)
+	DMAC_D_CTRL = 0x1000E000,
+	DMAC_D_STAT = 0x1000E010,
+	DMAC_D_PCR = 0x1000E020,
+	INTC_STAT = 0x1000F000,
+	INTC_MASK = 0x1000F010,
+	GIF_CTRL = 0x10003000,
+	GIF_STAT = 0x10003020,
+	VU1_STAT = 0x1100C000,
+	GS_CSR = 0x12001000,
+};
+
+enum
+{
+	READ_COUNT = 0x1000000,
+};
+
+class CBenchmarkMemoryMap : public CMemoryMap_LSBF
+{
+public:
+	uint32 GetWordScan(uint32 address)
+	{
+		const auto e = ScanMap(m_readMap, address);
+		if(!e) return 0xCCCCCCCC;
+		switch(e->nType)
+		{
+		case MEMORYMAP_TYPE_MEMORY:
+			return *reinterpret_cast<uint32*>(reinterpret_cast<uint8*>(e->pPointer) + (address - e->nStart));
+		case MEMORYMAP_TYPE_FUNCTION:
+			return e->CallHandler(address, 0);
+		default:
+			return 0xCCCCCCCC;
+		}
+	}
+
+	const MEMORYMAPELEMENT* GetReadMapScan(uint32 address) const
+	{
+		return ScanMap(m_readMap, address);
+	}
+
+	bool IsLookupConsistent(uint32 address) const
+	{
+		return GetReadMap(address) == ScanMap(m_readMap, address);
+	}
+
+	const MemoryMapListType& GetReadMaps() const
+	{
+		return m_readMap;
+	}
+};
+
+static uint32 IoPortReadHandler(uint32 address, uint32)
+{
+	return address ^ 0xA5A5A5A5;
+}
+
+static uint32 IoPortReadHandlerFunction(void*, uint32 address, uint32 value)
+{
+	return IoPortReadHandler(address, value);
+}
+
+template <typename ReadFunction, typename ChecksumType>
+static double MeasureReads(const ReadFunction& readFunction, ChecksumType& checksum)
+{
+	static const uint32 registers[] = {DMAC_D_CTRL, DMAC_D_STAT, DMAC_D_PCR, INTC_STAT, INTC_MASK, GIF_CTRL, GIF_STAT, VU1_STAT, GS_CSR};
+	static const uint32 registerCount = sizeof(registers) / sizeof(registers[0]);
+	auto startTime = std::chrono::steady_clock::now();
+	for(uint32 i = 0; i < READ_COUNT; i++)
+	{
+		checksum += readFunction(registers[i % registerCount]);
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+int main(int argc, const char** argv)
+{
+	std::vector<uint8> ram(PS2::EE_RAM_SIZE);
+	std::vector<uint8> spr(PS2::EE_SPR_SIZE);
+	std::vector<uint8> microMem0(PS2::MICROMEM0SIZE);
+	std::vector<uint8> vuMem0(PS2::VUMEM0SIZE);
+	std::vector<uint8> microMem1(PS2::MICROMEM1SIZE);
+	std::vector<uint8> vuMem1(PS2::VUMEM1SIZE);
+	std::vector<uint8> fakeIopRam(0x1001);
+	std::vector<uint8> bios(PS2::EE_BIOS_SIZE);
+
+	//Same layout as the EE's read map
+	CBenchmarkMemoryMap memoryMap;
+	memoryMap.InsertReadMap(0x00000000, PS2::EE_RAM_SIZE - 1, ram.data(), 0x00);
+	memoryMap.InsertReadMap(PS2::EE_SPR_ADDR, PS2::EE_SPR_ADDR + PS2::EE_SPR_SIZE - 1, spr.data(), 0x01);
+	memoryMap.InsertReadMap(0x10000000, 0x10FFFFFF, &IoPortReadHandler, 0x02);
+	memoryMap.InsertReadMap(PS2::MICROMEM0ADDR, PS2::MICROMEM0ADDR + PS2::MICROMEM0SIZE - 1, microMem0.data(), 0x03);
+	memoryMap.InsertReadMap(PS2::VUMEM0ADDR, PS2::VUMEM0ADDR + PS2::VUMEM0SIZE - 1, vuMem0.data(), 0x04);
+	memoryMap.InsertReadMap(PS2::MICROMEM1ADDR, PS2::MICROMEM1ADDR + PS2::MICROMEM1SIZE - 1, microMem1.data(), 0x05);
+	memoryMap.InsertReadMap(PS2::VUMEM1ADDR, PS2::VUMEM1ADDR + PS2::VUMEM1SIZE - 1, vuMem1.data(), 0x06);
+	memoryMap.InsertReadMap(0x12000000, 0x12FFFFFF, &IoPortReadHandler, 0x07);
+	memoryMap.InsertReadMap(0x1C000000, 0x1C001000, fakeIopRam.data(), 0x08);
+	memoryMap.InsertReadMap(PS2::EE_BIOS_ADDR, PS2::EE_BIOS_ADDR + PS2::EE_BIOS_SIZE - 1, bios.data(), 0x09);
+
+	//Lookup must give the same results as scanning around every map boundary and at random addresses
+	bool succeeded = true;
+	{
+		std::vector<uint32> addresses;
+		for(const auto& element : memoryMap.GetReadMaps())
+		{
+			for(uint32 address : {element.nStart, element.nEnd})
+			{
+				addresses.push_back(address - 1);
+				addresses.push_back(address);
+				addresses.push_back(address + 1);
+			}
+		}
+		std::mt19937 random(0x1234);
+		for(uint32 i = 0; i < 0x100000; i++)
+		{
+			addresses.push_back(static_cast<uint32>(random()) & 0x1FFFFFFF);
+		}
+		for(auto address : addresses)
+		{
+			if(!memoryMap.IsLookupConsistent(address))
+			{
+				printf("Lookup mismatch at 0x%08X.\n", address);
+				succeeded = false;
+			}
+		}
+	}
+
+	//Elements partially covering pages, overlapping and inserted out of order
+	{
+		std::vector<uint8> memory(0x4000);
+		CBenchmarkMemoryMap overlapMemoryMap;
+		overlapMemoryMap.InsertReadMap(0x03000800, 0x03000FFF, memory.data(), 0x00);
+		overlapMemoryMap.InsertReadMap(0x02FFF000, 0x03001FFF, memory.data(), 0x01);
+		overlapMemoryMap.InsertReadMap(0x02FFE100, 0x02FFE1FF, memory.data(), 0x02);
+		overlapMemoryMap.InsertReadMap(0x03002400, 0x030033FF, memory.data(), 0x03);
+		for(uint32 address = 0x02FFD000; address < 0x03005000; address += 0x80)
+		{
+			if(!overlapMemoryMap.IsLookupConsistent(address))
+			{
+				printf("Lookup mismatch at 0x%08X with overlapping elements.\n", address);
+				succeeded = false;
+			}
+		}
+	}
+
+	uint32 scanChecksum = 0;
+	uint32 lookupChecksum = 0;
+	double scanTime = MeasureReads([&](uint32 address) { return memoryMap.GetWordScan(address); }, scanChecksum);
+	double lookupTime = MeasureReads([&](uint32 address) { return memoryMap.GetWord(address); }, lookupChecksum);
+
+	//Map resolution only, without the cost of calling the handler
+	uintptr_t scanMapChecksum = 0;
+	uintptr_t lookupMapChecksum = 0;
+	double scanMapTime = MeasureReads([&](uint32 address) { return reinterpret_cast<uintptr_t>(memoryMap.GetReadMapScan(address)); }, scanMapChecksum);
+	double lookupMapTime = MeasureReads([&](uint32 address) { return reinterpret_cast<uintptr_t>(memoryMap.GetReadMap(address)); }, lookupMapChecksum);
+
+	//Handler dispatch only, std::function against function pointer with context
+	CMemoryMap::MEMORYMAPELEMENT stdFunctionElement;
+	stdFunctionElement.handler = &IoPortReadHandler;
+	CMemoryMap::MEMORYMAPELEMENT functionElement;
+	functionElement.handlerFunction = &IoPortReadHandlerFunction;
+	uint32 stdFunctionChecksum = 0;
+	uint32 functionChecksum = 0;
+	double stdFunctionTime = MeasureReads([&](uint32 address) { return stdFunctionElement.CallHandler(address, 0); }, stdFunctionChecksum);
+	double functionTime = MeasureReads([&](uint32 address) { return functionElement.CallHandler(address, 0); }, functionChecksum);
+
+	printf("%d hardware register reads.\n", READ_COUNT);
+	printf("Scan:          %8.2fms %6.2fns/read\n", scanTime, (scanTime * 1000000.0) / READ_COUNT);
+	printf("Lookup:        %8.2fms %6.2fns/read\n", lookupTime, (lookupTime * 1000000.0) / READ_COUNT);
+	printf("Scan (map):    %8.2fms %6.2fns/read\n", scanMapTime, (scanMapTime * 1000000.0) / READ_COUNT);
+	printf("Lookup (map):  %8.2fms %6.2fns/read\n", lookupMapTime, (lookupMapTime * 1000000.0) / READ_COUNT);
+	printf("std::function: %8.2fms %6.2fns/read\n", stdFunctionTime, (stdFunctionTime * 1000000.0) / READ_COUNT);
+	printf("Function:      %8.2fms %6.2fns/read\n", functionTime, (functionTime * 1000000.0) / READ_COUNT);
+
+	if((scanChecksum != lookupChecksum) || (scanMapChecksum != lookupMapChecksum))
+	{
+		printf("Read results differ between scan and lookup.\n");
+		succeeded = false;
+	}
+
+	if(stdFunctionChecksum != functionChecksum)
+	{
+		printf("Read results differ between handler types.\n");
+		succeeded = false;
+	}
+
+	return succeeded ? 0 : 1;
+}
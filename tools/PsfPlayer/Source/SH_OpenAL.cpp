@@ -1,6 +1,7 @@
 #include "SH_OpenAL.h"
 #include "alloca_def.h"
 #include <assert.h>
+#include <algorithm>
 
 //#define LOGGING
 #define SAMPLE_RATE 44100
@@ -47,6 +48,8 @@ void CSH_OpenAL::Reset()
 	CHECK_AL_ERROR();
 	m_availableBuffers.clear();
 	m_availableBuffers.insert(m_availableBuffers.begin(), m_bufferNames, m_bufferNames + MAX_BUFFERS);
+	m_queuedBufferSampleCounts.clear();
+	m_queuedSampleCount = 0;
 }
 
 void CSH_OpenAL::RecycleBuffers()
@@ -59,9 +62,24 @@ void CSH_OpenAL::RecycleBuffers()
 		alSourceUnqueueBuffers(m_source, bufferCount, bufferNames);
 		CHECK_AL_ERROR();
 		m_availableBuffers.insert(m_availableBuffers.begin(), bufferNames, bufferNames + bufferCount);
+		for(unsigned int i = 0; (i < bufferCount) && !m_queuedBufferSampleCounts.empty(); i++)
+		{
+			m_queuedSampleCount -= m_queuedBufferSampleCounts.front();
+			m_queuedBufferSampleCounts.pop_front();
+		}
 	}
 }
 
+int32 CSH_OpenAL::GetQueuedSampleCount()
+{
+	//Offset is in sample frames of the buffer being played
+	ALint sampleOffset = 0;
+	alGetSourcei(m_source, AL_SAMPLE_OFFSET, &sampleOffset);
+	CHECK_AL_ERROR();
+	uint32 playedSampleCount = std::min<uint32>(sampleOffset * 2, m_queuedSampleCount);
+	return m_queuedSampleCount - playedSampleCount;
+}
+
 bool CSH_OpenAL::HasFreeBuffers()
 {
 	return m_availableBuffers.size() != 0;
@@ -84,6 +102,8 @@ void CSH_OpenAL::Write(int16* samples, unsigned int sampleCount, unsigned int sa
 
 	alSourceQueueBuffers(m_source, 1, &buffer);
 	CHECK_AL_ERROR();
+	m_queuedBufferSampleCounts.push_back(sampleCount);
+	m_queuedSampleCount += sampleCount;
 
 	ALint sourceState = m_source.GetState();
 	if(sourceState != AL_PLAYING)
@@ -24,17 +24,21 @@ public:
 	void Write(int16*, unsigned int, unsigned int) override;
 	bool HasFreeBuffers() override;
 	void RecycleBuffers() override;
+	int32 GetQueuedSampleCount() override;
 
 	uint32 GetFreeBufferCount() const;
 
 private:
 	typedef std::deque<ALuint> BufferList;
+	typedef std::deque<uint32> SampleCountList;
 
 	OpenAl::CDevice m_device;
 	OpenAl::CContext m_context;
 	OpenAl::CSource m_source;
 
 	BufferList m_availableBuffers;
+	SampleCountList m_queuedBufferSampleCounts;
+	uint32 m_queuedSampleCount = 0;
 	uint64 m_lastUpdateTime;
 	bool m_mustSync;
 	ALuint m_bufferNames[MAX_BUFFERS];
@@ -17,5 +17,11 @@ public:
 	virtual bool HasFreeBuffers() = 0;
 	virtual void RecycleBuffers() = 0;
 
+	//Amount of samples written that weren't played yet, negative if not known
+	virtual int32 GetQueuedSampleCount()
+	{
+		return -1;
+	}
+
 private:
 };
@@ -0,0 +1,329 @@
+#include <cstdio>
+#include <exception>
+#include <vector>
+#include "ReplayLog.h"
+#include "StdStreamUtils.h"
+
+#define CHECK(condition)        \
+	if(!(condition))            \
+	{                           \
+		throw std::exception(); \
+	}
+
+static const char* g_recordedLogPath = "./replaylog_recorded.bin";
+static const char* g_replayedLogPath = "./replaylog_replayed.bin";
+
+struct INPUT
+{
+	unsigned int frame;
+	ReplayLog::EVENT_TYPE type;
+	PS2::CControllerInfo::BUTTON button;
+	uint8 value;
+};
+
+struct CDVD_COMPLETION
+{
+	unsigned int frame;
+	uint32 command;
+};
+
+static const INPUT g_inputs[] =
+    {
+        {0, ReplayLog::EVENT_PAD_BUTTON, PS2::CControllerInfo::START, 1},
+        {1, ReplayLog::EVENT_PAD_BUTTON, PS2::CControllerInfo::START, 0},
+        {1, ReplayLog::EVENT_PAD_AXIS, PS2::CControllerInfo::ANALOG_LEFT_X, 0xFF},
+        {1, ReplayLog::EVENT_PAD_BUTTON, PS2::CControllerInfo::CROSS, 1},
+        {4, ReplayLog::EVENT_PAD_AXIS, PS2::CControllerInfo::ANALOG_LEFT_X, 0x7F},
+        {4, ReplayLog::EVENT_PAD_BUTTON, PS2::CControllerInfo::CROSS, 0},
+        {6, ReplayLog::EVENT_PAD_AXIS, PS2::CControllerInfo::ANALOG_RIGHT_Y, 0x00},
+};
+
+//Completions happen while the frame is emulated, before pad input is polled on vblank
+static const CDVD_COMPLETION g_cdvdCompletions[] =
+    {
+        {0, 0x06},
+        {2, 0x06},
+        {2, 0x0C},
+        {5, 0x06},
+};
+
+static const unsigned int g_frameCount = 8;
+static const int64 g_recordHostTimeBase = 1000000;
+static const int64 g_replayHostTimeBase = 2000000;
+
+//Stands in for the emulated pad handler, keeps a trace of everything it received
+class CPadListener : public CPadInterface
+{
+public:
+	void SetButtonState(unsigned int pad, PS2::CControllerInfo::BUTTON button, bool pressed, uint8*) override
+	{
+		ReplayLog::EVENT event;
+		event.type = ReplayLog::EVENT_PAD_BUTTON;
+		event.pad = static_cast<uint8>(pad);
+		event.button = static_cast<uint8>(button);
+		event.value = pressed ? 1 : 0;
+		m_events.push_back(event);
+	}
+
+	void SetAxisState(unsigned int pad, PS2::CControllerInfo::BUTTON button, uint8 value, uint8*) override
+	{
+		ReplayLog::EVENT event;
+		event.type = ReplayLog::EVENT_PAD_AXIS;
+		event.pad = static_cast<uint8>(pad);
+		event.button = static_cast<uint8>(button);
+		event.value = value;
+		m_events.push_back(event);
+	}
+
+	void GetVibration(unsigned int, uint8& largeMotor, uint8& smallMotor) override
+	{
+		largeMotor = 0;
+		smallMotor = 0;
+	}
+
+	void NotifyFrameEnd()
+	{
+		m_events.push_back(ReplayLog::EVENT());
+	}
+
+	const std::vector<ReplayLog::EVENT>& GetEvents() const
+	{
+		return m_events;
+	}
+
+private:
+	std::vector<ReplayLog::EVENT> m_events;
+};
+
+//Drives the relay, reader and writer the same way CPS2VM does
+class CSession
+{
+public:
+	CSession(ReplayLog::CWriter* writer, ReplayLog::CReader* reader)
+	    : m_writer(writer)
+	    , m_reader(reader)
+	{
+		m_padRelay.InsertListener(&m_listener);
+		m_padRelay.SetWriter(m_writer);
+	}
+
+	void Run(int64 hostTimeBase)
+	{
+		for(unsigned int frame = 0; frame < g_frameCount; frame++)
+		{
+			GetHostTime(hostTimeBase + frame);
+			for(const auto& completion : g_cdvdCompletions)
+			{
+				if(completion.frame != frame) continue;
+				OnCdvdCommandCompleted(completion.command);
+			}
+			if(m_reader)
+			{
+				ReplayFrameInput();
+			}
+			else
+			{
+				UpdateLiveInput(frame);
+			}
+			if(m_writer)
+			{
+				m_writer->WriteFrameEnd();
+			}
+			m_listener.NotifyFrameEnd();
+		}
+	}
+
+	const std::vector<ReplayLog::EVENT>& GetReceivedEvents() const
+	{
+		return m_listener.GetEvents();
+	}
+
+	const std::vector<int64>& GetHostTimes() const
+	{
+		return m_hostTimes;
+	}
+
+	unsigned int GetDivergenceCount() const
+	{
+		return m_divergenceCount;
+	}
+
+private:
+	void UpdateLiveInput(unsigned int frame)
+	{
+		for(const auto& input : g_inputs)
+		{
+			if(input.frame != frame) continue;
+			if(input.type == ReplayLog::EVENT_PAD_BUTTON)
+			{
+				m_padRelay.SetButtonState(0, input.button, input.value != 0, nullptr);
+			}
+			else
+			{
+				m_padRelay.SetAxisState(0, input.button, input.value, nullptr);
+			}
+		}
+	}
+
+	void ReplayFrameInput()
+	{
+		while(!m_reader->IsEnd())
+		{
+			auto event = m_reader->PeekEvent();
+			m_reader->SkipEvent();
+			switch(event.type)
+			{
+			case ReplayLog::EVENT_FRAME_END:
+				return;
+			case ReplayLog::EVENT_PAD_BUTTON:
+				m_padRelay.SetButtonState(event.pad, static_cast<PS2::CControllerInfo::BUTTON>(event.button), event.value != 0, nullptr);
+				break;
+			case ReplayLog::EVENT_PAD_AXIS:
+				m_padRelay.SetAxisState(event.pad, static_cast<PS2::CControllerInfo::BUTTON>(event.button), event.value, nullptr);
+				break;
+			default:
+				m_divergenceCount++;
+				break;
+			}
+		}
+	}
+
+	void GetHostTime(int64 liveTime)
+	{
+		auto time = liveTime;
+		if(m_reader)
+		{
+			if(!m_reader->IsEnd() && (m_reader->PeekEvent().type == ReplayLog::EVENT_HOST_TIME))
+			{
+				time = static_cast<int64>(m_reader->PeekEvent().data);
+				m_reader->SkipEvent();
+			}
+			else
+			{
+				m_divergenceCount++;
+			}
+		}
+		if(m_writer)
+		{
+			m_writer->WriteHostTime(time);
+		}
+		m_hostTimes.push_back(time);
+	}
+
+	void OnCdvdCommandCompleted(uint32 command)
+	{
+		if(m_writer)
+		{
+			m_writer->WriteCdvdCommandCompleted(command);
+		}
+		if(m_reader)
+		{
+			bool matches = !m_reader->IsEnd() &&
+			               (m_reader->PeekEvent().type == ReplayLog::EVENT_CDVD_COMMAND_COMPLETED) &&
+			               (m_reader->PeekEvent().data == command);
+			if(matches)
+			{
+				m_reader->SkipEvent();
+			}
+			else
+			{
+				m_divergenceCount++;
+			}
+		}
+	}
+
+	ReplayLog::CWriter* m_writer = nullptr;
+	ReplayLog::CReader* m_reader = nullptr;
+	ReplayLog::CPadRelay m_padRelay;
+	CPadListener m_listener;
+	std::vector<int64> m_hostTimes;
+	unsigned int m_divergenceCount = 0;
+};
+
+static ReplayLog::StreamPtr OpenInputLog(const char* path)
+{
+	return std::make_unique<Framework::CStdStream>(Framework::CreateInputStdStream(path));
+}
+
+static ReplayLog::StreamPtr OpenOutputLog(const char* path)
+{
+	return std::make_unique<Framework::CStdStream>(Framework::CreateOutputStdStream(path));
+}
+
+static std::vector<ReplayLog::EVENT> ReadLogEvents(const char* path)
+{
+	std::vector<ReplayLog::EVENT> events;
+	ReplayLog::CReader reader(OpenInputLog(path));
+	while(!reader.IsEnd())
+	{
+		events.push_back(reader.PeekEvent());
+		reader.SkipEvent();
+	}
+	return events;
+}
+
+static bool AreEventsEqual(const ReplayLog::EVENT& event1, const ReplayLog::EVENT& event2)
+{
+	return (event1.type == event2.type) &&
+	       (event1.pad == event2.pad) &&
+	       (event1.button == event2.button) &&
+	       (event1.value == event2.value) &&
+	       (event1.data == event2.data);
+}
+
+static void CheckEventStreamsEqual(const std::vector<ReplayLog::EVENT>& events1, const std::vector<ReplayLog::EVENT>& events2)
+{
+	CHECK(events1.size() == events2.size());
+	for(size_t i = 0; i < events1.size(); i++)
+	{
+		CHECK(AreEventsEqual(events1[i], events2[i]));
+	}
+}
+
+int main(int argc, const char** argv)
+{
+	try
+	{
+		std::vector<ReplayLog::EVENT> recordedEvents;
+		std::vector<int64> recordedHostTimes;
+		{
+			ReplayLog::CWriter writer(OpenOutputLog(g_recordedLogPath));
+			CSession session(&writer, nullptr);
+			session.Run(g_recordHostTimeBase);
+			recordedEvents = session.GetReceivedEvents();
+			recordedHostTimes = session.GetHostTimes();
+		}
+
+		{
+			//Replay the log while recording it again, host time must come from the log, not from the live clock
+			ReplayLog::CReader reader(OpenInputLog(g_recordedLogPath));
+			ReplayLog::CWriter writer(OpenOutputLog(g_replayedLogPath));
+			CSession session(&writer, &reader);
+			session.Run(g_replayHostTimeBase);
+			CHECK(reader.IsEnd());
+			CHECK(session.GetDivergenceCount() == 0);
+			CheckEventStreamsEqual(session.GetReceivedEvents(), recordedEvents);
+			CHECK(session.GetHostTimes() == recordedHostTimes);
+		}
+
+		auto recordedLog = ReadLogEvents(g_recordedLogPath);
+		auto replayedLog = ReadLogEvents(g_replayedLogPath);
+		CHECK(!recordedLog.empty());
+		CheckEventStreamsEqual(recordedLog, replayedLog);
+
+		{
+			//Disc completions are logged where they happened, ahead of the frame's pad input
+			ReplayLog::CReader reader(OpenInputLog(g_recordedLogPath));
+			reader.SkipEvent();
+			CHECK(reader.PeekEvent().type == ReplayLog::EVENT_CDVD_COMMAND_COMPLETED);
+			CHECK(reader.PeekEvent().data == g_cdvdCompletions[0].command);
+		}
+	}
+	catch(...)
+	{
+		printf("Replay log round trip failed.\r\n");
+		return -1;
+	}
+	printf("Replay log round trip succeeded.\r\n");
+	return 0;
+}
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <future>
+#include <thread>
+#include <vector>
+#include "SpscMailBox.h"
+
+#define CHECK(condition)        \
+	if(!(condition))            \
+	{                           \
+		throw std::exception(); \
+	}
+
+typedef std::vector<uint32> SequenceArray;
+
+enum LANE
+{
+	LANE_FAST,
+	LANE_LOCKED,
+	LANE_LOCKED_WAIT,
+};
+
+static const uint32 g_threadedCallCount = CSpscMailBox::FAST_CALL_QUEUE_SIZE * 16;
+static const uint32 g_wakeIterationCount = 200;
+static const auto g_wakeTimeOut = std::chrono::seconds(5);
+
+//Calls record their index, they must be received in the order they were sent
+static void SendSequenceCall(CSpscMailBox& mailBox, SequenceArray& received, uint32 index, LANE lane)
+{
+	auto call = [&received, index]() { received.push_back(index); };
+	switch(lane)
+	{
+	case LANE_FAST:
+		mailBox.SendFastCall(call);
+		break;
+	case LANE_LOCKED:
+		mailBox.SendCall(call);
+		break;
+	case LANE_LOCKED_WAIT:
+		mailBox.SendCall(call, true);
+		break;
+	}
+}
+
+static void CheckSequence(const SequenceArray& received, uint32 count)
+{
+	CHECK(received.size() == count);
+	for(uint32 i = 0; i < count; i++)
+	{
+		CHECK(received[i] == i);
+	}
+}
+
+//Sends twice as many calls as the ring holds without receiving any, fast calls past
+//the ring's capacity fall back to the locked queue and still keep their place
+static void TestRingFull()
+{
+	static const uint32 callCount = CSpscMailBox::FAST_CALL_QUEUE_SIZE * 2;
+
+	CSpscMailBox mailBox;
+	SequenceArray received;
+	CHECK(!mailBox.IsPending());
+
+	for(uint32 i = 0; i < callCount; i++)
+	{
+		auto lane = ((i % 5) == 4) ? LANE_LOCKED : LANE_FAST;
+		SendSequenceCall(mailBox, received, i, lane);
+		CHECK(mailBox.IsPending());
+	}
+
+	while(mailBox.IsPending())
+	{
+		mailBox.ReceiveCall();
+	}
+	CheckSequence(received, callCount);
+}
+
+//Producer thread sends bursts of calls through both lanes while this thread receives them
+static void TestThreadedOrder()
+{
+	CSpscMailBox mailBox;
+	SequenceArray received;
+
+	std::thread producer(
+	    [&]() {
+		    uint32 seed = 0x12345678;
+		    uint32 index = 0;
+		    while(index != g_threadedCallCount)
+		    {
+			    seed = (seed * 1103515245) + 12345;
+			    uint32 burstSize = std::min<uint32>((seed >> 16) % (CSpscMailBox::FAST_CALL_QUEUE_SIZE * 2), g_threadedCallCount - index);
+			    for(uint32 i = 0; i < burstSize; i++, index++)
+			    {
+				    seed = (seed * 1103515245) + 12345;
+				    uint32 laneSelect = (seed >> 16) % 64;
+				    auto lane = (laneSelect == 0) ? LANE_LOCKED_WAIT : (laneSelect < 16) ? LANE_LOCKED : LANE_FAST;
+				    SendSequenceCall(mailBox, received, index, lane);
+			    }
+			    std::this_thread::yield();
+		    }
+	    });
+
+	while(received.size() != g_threadedCallCount)
+	{
+		mailBox.WaitForCall();
+		while(mailBox.IsPending())
+		{
+			mailBox.ReceiveCall();
+		}
+	}
+	producer.join();
+
+	CHECK(!mailBox.IsPending());
+	CheckSequence(received, g_threadedCallCount);
+}
+
+//Fast calls don't take the lock, they need to wake up a receiver waiting without a time out
+static void TestWakeReceiver()
+{
+	for(uint32 iteration = 0; iteration < g_wakeIterationCount; iteration++)
+	{
+		CSpscMailBox mailBox;
+		bool called = false;
+
+		auto receiver = std::async(std::launch::async,
+		                           [&]() {
+			                           mailBox.WaitForCall();
+			                           mailBox.ReceiveCall();
+		                           });
+
+		//Alternate between sending right away and letting the receiver go to sleep first
+		if(iteration & 1)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		mailBox.SendFastCall([&called]() { called = true; });
+
+		bool woken = (receiver.wait_for(g_wakeTimeOut) == std::future_status::ready);
+		if(!woken)
+		{
+			//Wake up the receiver through the locked queue to be able to leave
+			mailBox.SendCall([]() {});
+		}
+		receiver.wait();
+		CHECK(woken);
+		CHECK(called);
+	}
+}
+
+int main(int argc, const char** argv)
+{
+	try
+	{
+		TestRingFull();
+		TestWakeReceiver();
+		TestThreadedOrder();
+	}
+	catch(...)
+	{
+		printf("SpscMailBox test failed.\r\n");
+		return -1;
+	}
+	printf("SpscMailBox test succeeded.\r\n");
+	return 0;
+}
@@ -1,6 +1,7 @@
 #include <functional>
 #include "KeyOnOffTest.h"
 #include "MultiCoreIrqTest.h"
+#include "ResamplerTest.h"
 #include "SetRepeatTest.h"
 #include "SetRepeatTest2.h"
 #include "SimpleIrqTest.h"
@@ -13,6 +14,7 @@ static const TestFactoryFunction s_factories[] =
 {
 	[]() { return new CKeyOnOffTest(); },
 	[]() { return new CMultiCoreIrqTest(); },
+	[]() { return new CResamplerTest(); },
 	[]() { return new CSetRepeatTest(); },
 	[]() { return new CSetRepeatTest2(); },
 	[]() { return new CSimpleIrqTest(); },
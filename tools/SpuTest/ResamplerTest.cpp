@@ -0,0 +1,81 @@
+#include "ResamplerTest.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "AudioResampler.h"
+
+void CResamplerTest::Execute()
+{
+	//Resamples a smooth signal split into buffers of various sizes. Output must keep the right
+	//length overall and must not jump where buffers are joined.
+
+	static const float ratios[] = {0.5f, 0.95f, 1.0f, 1.05f, 2.0f};
+	static const uint32 bufferFrameCounts[] = {512, 300, 1, 1000, 2, 777, 64};
+	static const double pi = 3.14159265358979323846;
+	static const double period = 200;
+	static const double amplitude = 8000;
+
+	//Biggest difference between two input frames, output frames are at most one input frame apart
+	int32 maxInputDelta = static_cast<int32>(std::ceil(amplitude * 2 * pi / period));
+
+	uint32 totalFrameCount = 0;
+	for(auto frameCount : bufferFrameCounts)
+	{
+		totalFrameCount += frameCount;
+	}
+
+	std::vector<int16> input(totalFrameCount * 2);
+	for(uint32 i = 0; i < totalFrameCount; i++)
+	{
+		double angle = 2 * pi * static_cast<double>(i) / period;
+		input[(i * 2) + 0] = static_cast<int16>(std::lround(amplitude * std::sin(angle)));
+		input[(i * 2) + 1] = static_cast<int16>(std::lround(amplitude * std::cos(angle)));
+	}
+
+	for(auto ratio : ratios)
+	{
+		CAudioResampler resampler;
+		std::vector<int16> output;
+		std::vector<int16> buffer;
+		std::vector<uint32> joinFrames;
+
+		uint32 inputFrame = 0;
+		for(auto frameCount : bufferFrameCounts)
+		{
+			resampler.Resample(input.data() + (inputFrame * 2), frameCount * 2, ratio, buffer);
+			TEST_VERIFY((buffer.size() % 2) == 0);
+			joinFrames.push_back(static_cast<uint32>(output.size() / 2));
+			output.insert(output.end(), buffer.begin(), buffer.end());
+			inputFrame += frameCount;
+		}
+
+		//One output frame per step over the input, however it was split
+		uint32 outputFrameCount = static_cast<uint32>(output.size() / 2);
+		double expectedFrameCount = static_cast<double>(totalFrameCount - 1) * ratio;
+		TEST_VERIFY(std::abs(static_cast<double>(outputFrameCount) - expectedFrameCount) <= 1.0);
+
+		int32 maxOutputDelta = static_cast<int32>(std::ceil(maxInputDelta * std::max(1.0f / ratio, 1.0f))) + 1;
+		for(auto joinFrame : joinFrames)
+		{
+			if((joinFrame == 0) || (joinFrame >= outputFrameCount)) continue;
+			for(uint32 channel = 0; channel < 2; channel++)
+			{
+				int32 before = output[((joinFrame - 1) * 2) + channel];
+				int32 after = output[(joinFrame * 2) + channel];
+				TEST_VERIFY(std::abs(after - before) <= maxOutputDelta);
+			}
+		}
+
+		//Buffers joined together must give the same result as one big buffer
+		CAudioResampler referenceResampler;
+		std::vector<int16> reference;
+		referenceResampler.Resample(input.data(), totalFrameCount * 2, ratio, reference);
+		TEST_VERIFY(std::abs(static_cast<int32>(reference.size()) - static_cast<int32>(output.size())) <= 2);
+		size_t compareSize = std::min(reference.size(), output.size());
+		for(size_t i = 0; i < compareSize; i++)
+		{
+			TEST_VERIFY(std::abs(static_cast<int32>(reference[i]) - static_cast<int32>(output[i])) <= 1);
+		}
+	}
+}